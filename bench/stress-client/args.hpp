@@ -81,18 +81,19 @@ public:
         : deletes(1), updates(4),
           inserts(8), reads(64), range_reads(0),
           appends(0), prepends(0),
-          verifies(0)
+          verifies(0), batch_inserts(0), sindex_reads(0)
         {}
 
-    op_ratios_t(int d, int u, int i, int r, int a, int p, int v, int rr)
+    op_ratios_t(int d, int u, int i, int r, int a, int p, int v, int rr, int bi = 0, int sr = 0)
         : deletes(d), updates(u),
           inserts(i), reads(r), range_reads(rr),
           appends(a), prepends(p),
-          verifies(v)
+          verifies(v), batch_inserts(bi), sindex_reads(sr)
         {}
 
     enum load_op_t {
         delete_op, update_op, insert_op, read_op, range_read_op, append_op, prepend_op, verify_op,
+        batch_insert_op, sindex_read_op,
     };
 
     void parse(char *str) {
@@ -124,8 +125,14 @@ public:
             case 7:
                 range_reads = atoi(tok);
                 break;
+            case 8:
+                batch_inserts = atoi(tok);
+                break;
+            case 9:
+                sindex_reads = atoi(tok);
+                break;
             default:
-                fprintf(stderr, "Invalid load format (use D/U/I/R/A/P/V/RR)\n");
+                fprintf(stderr, "Invalid load format (use D/U/I/R/A/P/V/RR/BI/SR)\n");
                 exit(-1);
                 break;
             }
@@ -133,13 +140,16 @@ public:
             c++;
         }
         if(c < 4) {
-            fprintf(stderr, "Invalid load format (use D/U/I/R/A/P/V/RR)\n");
+            fprintf(stderr, "Invalid load format (use D/U/I/R/A/P/V/RR/BI/SR)\n");
             exit(-1);
         }
     }
 
     void print() {
         printf("%d/%d/%d/%d/%d/%d/%d/%d", deletes, updates, inserts, reads,appends, prepends, verifies, range_reads);
+        if (batch_inserts > 0 || sindex_reads > 0) {
+            printf("/%d/%d", batch_inserts, sindex_reads);
+        }
     }
 
 public:
@@ -151,6 +161,8 @@ public:
     int appends;
     int prepends;
     int verifies;
+    int batch_inserts;
+    int sindex_reads;
 };
 
 /* Defines a client configuration, including sensible default
@@ -230,8 +242,10 @@ public:
 /* List supported protocols. */
 void list_protocols() {
     // I'll just cheat here.
-    printf("rethinkdb");
     printf("sockmemcached,");
+#ifdef USE_RETHINKDB
+    printf("rethinkdb,");
+#endif
 #ifdef USE_MYSQL
     printf("mysql,");
 #endif
@@ -260,7 +274,7 @@ void usage(const char *name) {
     printf("\t-c, --clients\n\t\tNumber of concurrent clients. Defaults to [%d].\n", _d.clients);
     printf("\t--client-suffix\n\t\tAppend a per-client id to key names.\n");
     printf("\t--ignore-protocol-errors\n\t\tDo not quit if the protocol throws errors.\n");
-    printf("\t-w, --workload\n\t\tTarget load to generate. Expects a value in format D/U/I/R/A/P/V/RR, where\n" \
+    printf("\t-w, --workload\n\t\tTarget load to generate. Expects a value in format D/U/I/R/A/P/V/RR/BI/SR, where\n" \
            "\t\t\tD - number of deletes\n" \
            "\t\t\tU - number of updates\n" \
            "\t\t\tI - number of inserts\n" \
@@ -269,6 +283,8 @@ void usage(const char *name) {
            "\t\t\tP - number of prepends\n" \
            "\t\t\tV - number of verifications\n" \
            "\t\t\tRR - number of range reads\n" \
+           "\t\t\tBI - number of batched inserts (optional)\n" \
+           "\t\t\tSR - number of secondary index reads (optional)\n" \
            "\t\tDefaults to [");
     _d.op_ratios.print();
     printf("]\n");
@@ -286,7 +302,7 @@ void usage(const char *name) {
     _d.duration.print();
     printf("].\n");
     printf("\t-b, --batch-factor\n\t\tA range in DISTR format for average number of reads\n" \
-           "\t\tto perform in one shot. Defaults to [");
+           "\t\t(or batched inserts) to perform in one shot. Defaults to [");
     _d.batch_factor.print();
     printf("].\n");
     printf("\t-R, --range-size\n\t\tA range in DISTR format for average number of values\n" \
@@ -465,12 +481,24 @@ void parse(config_t *config, int argc, char *argv[]) {
 
     //validation:
     bool only_sockmemcached = true;
+#ifdef USE_RETHINKDB
+    bool only_rethinkdb = true;
+#endif
     for (size_t i = 0; i < config->servers.size(); i++) {
         if(config->servers[i].protocol != protocol_sockmemcached) {
             only_sockmemcached = false;
-            break;
         }
+#ifdef USE_RETHINKDB
+        if(config->servers[i].protocol != protocol_rethinkdb) {
+            only_rethinkdb = false;
+        }
+#endif
     }
+#ifdef USE_RETHINKDB
+    /* The rethinkdb protocol matches responses up by token, so mutations don't
+    interfere with pipelined reads. */
+    if (only_rethinkdb) return;
+#endif
     if (config->pipeline_limit > 0) {
         if (config->op_ratios.deletes > 0 ||
             config->op_ratios.updates > 0 ||
@@ -479,9 +507,12 @@ void parse(config_t *config, int argc, char *argv[]) {
             config->op_ratios.appends > 0 ||
             config->op_ratios.prepends > 0 ||
             config->op_ratios.verifies > 0 ||
+            config->op_ratios.batch_inserts > 0 ||
+            config->op_ratios.sindex_reads > 0 ||
             !only_sockmemcached)
         {
-            fprintf(stderr, "Pipelining can only be used with read operations on a sockmemcached protocol.\n");
+            fprintf(stderr, "Pipelining can only be used with read operations on a sockmemcached protocol,\n"
+                            "or with any operations on a rethinkdb protocol.\n");
             usage(argv[0]);
         }
     }
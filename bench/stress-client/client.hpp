@@ -21,9 +21,10 @@ struct client_t {
         print_further_protocol_errors(true)
         { }
 
-    void add_op(int freq, op_generator_t *op_gen) {
+    void add_op(int freq, op_generator_t *op_gen, const char *name = "") {
         ops.push_back(op_gen);
         freqs.push_back(freq);
+        op_names.push_back(name);
         total_freq += freq;
     }
 
@@ -60,6 +61,7 @@ struct client_t {
     // The ops that we are running against the database
     std::vector<op_generator_t *> ops;
     std::vector<int> freqs;   // One entry in freqs for each entry in ops
+    std::vector<const char *> op_names;   // Likewise, used for reporting
     int total_freq;
 
     int pipeline_limit;
@@ -16,6 +16,9 @@
 #ifdef USE_MYSQL
 #include "protocols/mysql_protocol.hpp"   // For initialize_mysql_table()
 #endif
+#ifdef USE_RETHINKDB
+#include "protocols/rethinkdb_protocol.hpp"   // For initialize_rethinkdb_table()
+#endif
 
 using namespace std;
 
@@ -69,6 +72,15 @@ int main(int argc, char *argv[])
     }
 #endif
 
+#ifdef USE_RETHINKDB
+    /* Initialize any RethinkDB tables */
+    for (int i = 0; i < (int)config.servers.size(); i++) {
+        if (config.servers[i].protocol == protocol_rethinkdb) {
+            initialize_rethinkdb_table(config.servers[i].host);
+        }
+    }
+#endif
+
     /* Create client objects */
 
     struct client_stuff_t {
@@ -84,12 +96,14 @@ int main(int argc, char *argv[])
 
         consecutive_seed_model_t::insert_chooser_t insert_chooser;
         insert_op_generator_t insert_op_generator;
+        batch_insert_op_generator_t batch_insert_op_generator;
 
         consecutive_seed_model_t::delete_chooser_t delete_chooser;
         delete_op_generator_t delete_op_generator;
 
         consecutive_seed_model_t::live_chooser_t live_chooser;
         read_op_generator_t read_op_generator;
+        sindex_read_op_generator_t sindex_read_op_generator;
         update_op_generator_t update_op_generator;
         append_prepend_op_generator_t append_op_generator;
         append_prepend_op_generator_t prepend_op_generator;
@@ -128,12 +142,14 @@ int main(int argc, char *argv[])
             /* Set up the various operations */
             insert_chooser(&model),
             insert_op_generator(config->pipeline_limit + 1, &kg, &insert_chooser, &sqlite_mirror, protocol, config->values),
+            batch_insert_op_generator(config->pipeline_limit + 1, &kg, &insert_chooser, &sqlite_mirror, protocol, config->batch_factor, config->values),
 
             delete_chooser(&model),
             delete_op_generator(config->pipeline_limit + 1, &kg, &delete_chooser, &sqlite_mirror, protocol),
 
             live_chooser(&model, config->distr, config->mu),
             read_op_generator(config->pipeline_limit + 1, &kg, &live_chooser, protocol, config->batch_factor),
+            sindex_read_op_generator(config->pipeline_limit + 1, &kg, &live_chooser, protocol, config->batch_factor),
             update_op_generator(config->pipeline_limit + 1, &kg, &live_chooser, &sqlite_mirror, protocol, config->values),
             append_op_generator(config->pipeline_limit + 1, &kg, &live_chooser, &sqlite_mirror, protocol, true, config->values),
             prepend_op_generator(config->pipeline_limit + 1, &kg, &live_chooser, &sqlite_mirror, protocol, false, config->values),
@@ -148,18 +164,21 @@ int main(int argc, char *argv[])
             int expected_batch_factor = (config->batch_factor.min + config->batch_factor.max) / 2;
 
             /* We multiply the ratio by expected_batch_factor to get nicer rounding for reads (instead of dividing the reads frequency) */
-            client.add_op(config->op_ratios.inserts * expected_batch_factor, &insert_op_generator);
+            client.add_op(config->op_ratios.inserts * expected_batch_factor, &insert_op_generator, "insert");
+            /* Batched inserts handle several keys at once, just like reads */
+            client.add_op(config->op_ratios.batch_inserts, &batch_insert_op_generator, "batch_insert");
 
-            client.add_op(config->op_ratios.deletes * expected_batch_factor, &delete_op_generator);
+            client.add_op(config->op_ratios.deletes * expected_batch_factor, &delete_op_generator, "delete");
 
-            client.add_op(config->op_ratios.reads, &read_op_generator);
-            client.add_op(config->op_ratios.updates * expected_batch_factor, &update_op_generator);
-            client.add_op(config->op_ratios.appends * expected_batch_factor, &append_op_generator);
-            client.add_op(config->op_ratios.prepends * expected_batch_factor, &prepend_op_generator);
+            client.add_op(config->op_ratios.reads, &read_op_generator, "read");
+            client.add_op(config->op_ratios.sindex_reads, &sindex_read_op_generator, "sindex_read");
+            client.add_op(config->op_ratios.updates * expected_batch_factor, &update_op_generator, "update");
+            client.add_op(config->op_ratios.appends * expected_batch_factor, &append_op_generator, "append");
+            client.add_op(config->op_ratios.prepends * expected_batch_factor, &prepend_op_generator, "prepend");
 
-            client.add_op(config->op_ratios.verifies * expected_batch_factor, &verify_op_generator);
+            client.add_op(config->op_ratios.verifies * expected_batch_factor, &verify_op_generator, "verify");
 
-            client.add_op(config->op_ratios.range_reads * expected_batch_factor, &range_read_op_generator);
+            client.add_op(config->op_ratios.range_reads * expected_batch_factor, &range_read_op_generator, "range_read");
         }
 
         ~client_stuff_t() {
@@ -225,6 +244,10 @@ int main(int argc, char *argv[])
     ticks_t start_time = get_ticks();
 
     query_stats_t total_stats;
+    /* Every client has the same ops in the same order, so we can also keep totals
+    per kind of operation. */
+    int num_ops = clients[0]->client.ops.size();
+    query_stats_t *op_totals = new query_stats_t[num_ops];
     int total_time = 0, total_inserts_minus_deletes = 0;
 
     // TODO: If an workload contains contains no inserts and there are no keys available for a
@@ -258,6 +281,7 @@ int main(int argc, char *argv[])
             the Python interface. */
             for (int j = 0; j < (int)c->client.ops.size(); j++) {
                 round_stats.aggregate(c->client.ops[j]->query_stats);
+                op_totals[j].aggregate(c->client.ops[j]->query_stats);
             }
 
             /* Count total number of keys inserted and deleted (we will use this if our
@@ -327,6 +351,7 @@ int main(int argc, char *argv[])
         client_stuff_t *c = clients[i];
         for (int j = 0; j < (int)c->client.ops.size(); j++) {
             total_stats.aggregate(c->client.ops[j]->query_stats);
+            op_totals[j].aggregate(c->client.ops[j]->query_stats);
         }
         total_inserts_minus_deletes += c->insert_op_generator.query_stats.queries - c->delete_op_generator.query_stats.queries;
     }
@@ -335,6 +360,23 @@ int main(int argc, char *argv[])
     printf("Total operations: %d\n", total_stats.queries);
     printf("Total keys inserted minus keys deleted: %d\n", total_inserts_minus_deletes);
 
+    /* Per-operation throughput and latency percentiles (in us), from the histograms */
+    float running_secs = ticks_to_secs(get_ticks() - start_time);
+    printf("%-14s %10s %10s %10s %10s %10s %10s %12s\n",
+        "operation", "count", "ops/sec", "p50", "p90", "p99", "p99.9", "worst");
+    for (int j = 0; j < num_ops; j++) {
+        const query_stats_t &s = op_totals[j];
+        if (s.queries == 0) continue;
+        printf("%-14s %10d %10.0f %10llu %10llu %10llu %10llu %12.0f\n",
+            clients[0]->client.op_names[j], s.queries, s.queries / running_secs,
+            (unsigned long long)s.latency_histogram.percentile(0.5),
+            (unsigned long long)s.latency_histogram.percentile(0.9),
+            (unsigned long long)s.latency_histogram.percentile(0.99),
+            (unsigned long long)s.latency_histogram.percentile(0.999),
+            ticks_to_us(s.worst_latency));
+    }
+    delete[] op_totals;
+
     // Dump key vectors if we have an out file
     if(config.out_file[0] != 0) {
         FILE *out_file = fopen(config.out_file, "w");
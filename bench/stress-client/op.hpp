@@ -12,6 +12,10 @@ struct query_stats_t {
     bool enable_latency_samples;
     reservoir_sample_t<ticks_t> latency_samples;
 
+    /* Unlike the samples, the histogram records every query; it's cheap enough
+    to always keep. */
+    latency_histogram_t latency_histogram;
+
 
     query_stats_t() : queries(0), worst_latency(0), enable_latency_samples(true) { }
 
@@ -20,6 +24,7 @@ struct query_stats_t {
         worst_latency = 0;
 
         latency_samples.clear();
+        latency_histogram.clear();
     }
 
     void push(ticks_t latency, int batch_count) {
@@ -29,6 +34,7 @@ struct query_stats_t {
         if (enable_latency_samples) {
             for (int i = 0; i < batch_count; i++) latency_samples.push(latency);
         }
+        latency_histogram.add(ticks_to_us(latency), batch_count);
         lock.unlock();
     }
 
@@ -36,6 +42,7 @@ struct query_stats_t {
         queries += other.queries;
         worst_latency = std::max(worst_latency, other.worst_latency);
         latency_samples += other.latency_samples;
+        latency_histogram += other.latency_histogram;
     }
 
     void set_enable_latency_samples(bool val) {
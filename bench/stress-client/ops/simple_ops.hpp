@@ -300,5 +300,132 @@ public:
     }
 };
 
+/* batch_insert_op_t inserts several new keys with a single request, using
+protocol_t::insert_batch(). The number of keys per batch is drawn from the same
+batch_factor range as reads. */
+
+struct batch_insert_op_t : public op_t {
+    batch_insert_op_t(seed_key_generator_t *kg, seed_chooser_t *sc, value_watcher_t *vw, protocol_t *p, distr_t bf, distr_t vs, query_stats_t *qs) :
+            op_t(qs),
+            kg(kg), sc(sc), vw(vw), p(p), batch_factor(bf), valuesize(vs) {
+        keys.resize(bf.max, payload_t(kg->max_key_size()));
+        values.resize(bf.max, payload_t(vs.max));
+        for (int i = 0; i < bf.max; i++) memset(values[i].first, 'A', values[i].buffer_size);
+    }
+    seed_key_generator_t *kg;
+    seed_chooser_t *sc;
+    value_watcher_t *vw;
+    protocol_t *p;
+    distr_t batch_factor;
+    distr_t valuesize;
+    std::vector<payload_t> keys;
+    std::vector<payload_t> values;
+
+    void start() {
+        seed_t seeds[batch_factor.max];
+        int nkeys = sc->choose_seeds(seeds, xrandom(batch_factor.min, batch_factor.max));
+        if (nkeys == 0) {
+            return;
+        }
+
+        for (int i = 0; i < nkeys; i++) {
+            kg->gen_key(seeds[i], &keys[i]);
+            values[i].second = xrandom(valuesize.min, valuesize.max);
+            if (vw) vw->on_key_change(seeds[i], &values[i]);
+        }
+
+        ticks_t start_time = get_ticks();
+        p->insert_batch(keys.data(), values.data(), nkeys);
+        ticks_t end_time = get_ticks();
+
+        push_stats(end_time - start_time, nkeys);
+    }
+
+    bool end_maybe() {
+        return true;
+    }
+
+    void end() { }
+};
+
+class batch_insert_op_generator_t : public op_generator_t {
+public:
+    batch_insert_op_generator_t(int max_concurrent_opts, seed_key_generator_t *kg, seed_chooser_t *sc, value_watcher_t *vw, protocol_t *p, distr_t bf, distr_t vs)
+        : head(0)
+    {
+        opts.resize(max_concurrent_opts, batch_insert_op_t(kg, sc, vw, p, bf, vs, &query_stats));
+    }
+
+private:
+    std::vector<batch_insert_op_t> opts;
+    int head;
+
+public:
+    op_t *generate() {
+        op_t *res =  &opts[head];
+        head++;
+        head %= opts.size();
+        return res;
+    }
+};
+
+/* sindex_read_op_t is like read_op_t, except that it looks the keys up through
+protocol_t::sindex_read() and is not pipelined. */
+
+struct sindex_read_op_t : public op_t {
+    sindex_read_op_t(seed_key_generator_t *kg, seed_chooser_t *sc, protocol_t *p, distr_t bf, query_stats_t *qs) :
+            op_t(qs),
+            kg(kg), sc(sc), p(p), batch_factor(bf) {
+        keys.resize(bf.max, payload_t(kg->max_key_size()));
+    }
+    seed_key_generator_t *kg;
+    seed_chooser_t *sc;
+    protocol_t *p;
+    distr_t batch_factor;
+    std::vector<payload_t> keys;
+
+    void start() {
+        seed_t seeds[batch_factor.max];
+        int nkeys = sc->choose_seeds(seeds, xrandom(batch_factor.min, batch_factor.max));
+        if (nkeys == 0) {
+            return;
+        }
+
+        for (int i = 0; i < nkeys; i++) kg->gen_key(seeds[i], &keys[i]);
+
+        ticks_t start_time = get_ticks();
+        p->sindex_read(keys.data(), nkeys);
+        ticks_t end_time = get_ticks();
+
+        push_stats(end_time - start_time, nkeys);
+    }
+
+    bool end_maybe() {
+        return true;
+    }
+
+    void end() { }
+};
+
+struct sindex_read_op_generator_t : public op_generator_t {
+    sindex_read_op_generator_t(int max_concurrent_ops, seed_key_generator_t *kg, seed_chooser_t *sc, protocol_t *p, distr_t bf)
+        : head(0)
+    {
+        opts.resize(max_concurrent_ops, sindex_read_op_t(kg, sc, p, bf, &query_stats));
+    }
+private:
+    std::vector<sindex_read_op_t> opts;
+    int head;
+
+    op_t *generate() {
+        op_t *res = &opts[head];
+
+        head++;
+        head %= opts.size();
+
+        return res;
+    }
+};
+
 #endif /* __STRESS_CLIENT_OPS_SIMPLE_OPS_HPP__ */
 
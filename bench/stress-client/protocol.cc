@@ -8,12 +8,19 @@
 #ifdef USE_MYSQL
 #  include "protocols/mysql_protocol.hpp"
 #endif
+#ifdef USE_RETHINKDB
+#  include "protocols/rethinkdb_protocol.hpp"
+#endif
 #include "protocols/sqlite_protocol.hpp"
 
 protocol_t *server_t::connect() {
     switch (protocol) {
     case protocol_sockmemcached:
         return new memcached_sock_protocol_t(host);
+#ifdef USE_RETHINKDB
+    case protocol_rethinkdb:
+        return new rethinkdb_protocol_t(host);
+#endif
 #ifdef USE_MYSQL
     case protocol_mysql:
         return new mysql_protocol_t(host);
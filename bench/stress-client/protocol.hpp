@@ -23,6 +23,20 @@ struct protocol_t {
 
     virtual void read(payload_t *keys, int count, payload_t *values = NULL) = 0;
 
+    /* Inserts several keys with one request. By default this is just stubbed out
+     * in terms of insert. */
+    virtual void insert_batch(payload_t *keys, payload_t *values, int count) {
+        for (int i = 0; i < count; i++) {
+            insert(keys[i].first, keys[i].second, values[i].first, values[i].second);
+        }
+    }
+
+    /* Reads keys by looking them up through a secondary index instead of the
+     * primary key. Protocols without secondary indexes just do a normal read. */
+    virtual void sindex_read(payload_t *keys, int count, payload_t *values = NULL) {
+        read(keys, count, values);
+    }
+
 
     /* These functions allow reads to be pipelined to the server meaning there
      * will be several reads sent over the socket and the client will not block
@@ -59,6 +73,9 @@ public:
 
 enum protocol_enum_t {
     protocol_sockmemcached,
+#ifdef USE_RETHINKDB
+    protocol_rethinkdb,
+#endif
 #ifdef USE_MYSQL
     protocol_mysql,
 #endif
@@ -76,6 +93,10 @@ struct server_t {
     protocol_enum_t parse_protocol(const char *name) {
         if (strcmp(name, "sockmemcached") == 0) {
             return protocol_sockmemcached;
+#ifdef USE_RETHINKDB
+        } else if (strcmp(name, "rethinkdb") == 0) {
+            return protocol_rethinkdb;
+#endif
 #ifdef USE_MYSQL
         } else if (strcmp(name, "mysql") == 0) {
             return protocol_mysql;
@@ -110,6 +131,10 @@ struct server_t {
     void print_protocol() {
         if (protocol == protocol_sockmemcached) {
             printf("sockmemcached");
+#ifdef USE_RETHINKDB
+        } else if (protocol == protocol_rethinkdb) {
+            printf("rethinkdb");
+#endif
 #ifdef USE_MYSQL
         } else if (protocol == protocol_mysql) {
             printf("mysql");
@@ -0,0 +1,667 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef USE_RETHINKDB
+#error "This file shouldn't be included if USE_RETHINKDB is not set."
+#endif
+
+#ifndef __STRESS_CLIENT_PROTOCOLS_RETHINKDB_PROTOCOL_HPP__
+#define __STRESS_CLIENT_PROTOCOLS_RETHINKDB_PROTOCOL_HPP__
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "protocol.hpp"
+#include "ql2.pb.h"
+
+#define RETHINKDB_CONN_STR_MESSAGE ("The connection string for RethinkDB should be of the form " \
+    "\"host:port\" or \"host:port/database/table\".")
+
+#define RETHINKDB_DEFAULT_DB "test"
+#define RETHINKDB_DEFAULT_TABLE "stress"
+
+/* Every key is stored as a document of the form {id: KEY, key: KEY, value: VALUE}.
+The "key" field duplicates the primary key so that there is something to put a
+secondary index on; sindex_read() goes through that index. */
+#define RETHINKDB_SINDEX_NAME "key"
+
+class rethinkdb_query_error_t : public protocol_error_t {
+public:
+    rethinkdb_query_error_t(Response::ResponseType type, const std::string &message)
+        : protocol_error_t(type_name(type) + ": " + message), response_type(type) { }
+    virtual ~rethinkdb_query_error_t() throw () { }
+
+    Response::ResponseType response_type;
+
+private:
+    static std::string type_name(Response::ResponseType type) {
+        switch (type) {
+        case Response::CLIENT_ERROR: return "Client error";
+        case Response::COMPILE_ERROR: return "Compile error";
+        case Response::RUNTIME_ERROR: return "Runtime error";
+        default: return "Unexpected response";
+        }
+    }
+};
+
+/* Helpers for building ReQL terms by hand. They all fill in a term that has
+already been allocated inside the query being built. */
+
+inline void ql_string(Term *t, const char *str, size_t size) {
+    t->set_type(Term::DATUM);
+    Datum *d = t->mutable_datum();
+    d->set_type(Datum::R_STR);
+    d->set_r_str(str, size);
+}
+
+inline void ql_string(Term *t, const std::string &str) {
+    ql_string(t, str.data(), str.size());
+}
+
+inline void ql_number(Term *t, double num) {
+    t->set_type(Term::DATUM);
+    Datum *d = t->mutable_datum();
+    d->set_type(Datum::R_NUM);
+    d->set_r_num(num);
+}
+
+inline void ql_bool(Term *t, bool b) {
+    t->set_type(Term::DATUM);
+    Datum *d = t->mutable_datum();
+    d->set_type(Datum::R_BOOL);
+    d->set_r_bool(b);
+}
+
+inline Term *ql_optarg(Term *t, const char *key) {
+    Term::AssocPair *pair = t->add_optargs();
+    pair->set_key(key);
+    return pair->mutable_val();
+}
+
+inline void ql_db(Term *t, const std::string &db) {
+    t->set_type(Term::DB);
+    ql_string(t->add_args(), db);
+}
+
+inline void ql_table(Term *t, const std::string &db, const std::string &table) {
+    t->set_type(Term::TABLE);
+    ql_db(t->add_args(), db);
+    ql_string(t->add_args(), table);
+}
+
+/* Fills in {id: KEY, key: KEY, value: VALUE}. */
+inline void ql_document(Term *t, const char *key, size_t key_size,
+                        const char *value, size_t value_size) {
+    t->set_type(Term::MAKE_OBJ);
+    ql_string(ql_optarg(t, "id"), key, key_size);
+    ql_string(ql_optarg(t, RETHINKDB_SINDEX_NAME), key, key_size);
+    ql_string(ql_optarg(t, "value"), value, value_size);
+}
+
+/* Returns the "value" field of a document datum, or NULL if the datum is not a
+document (for example because the key was missing and we got back null). */
+inline const std::string *ql_document_value(const Datum &d) {
+    if (d.type() != Datum::R_OBJECT) return NULL;
+    for (int i = 0; i < d.r_object_size(); i++) {
+        if (d.r_object(i).key() == "value" && d.r_object(i).val().type() == Datum::R_STR) {
+            return &d.r_object(i).val().r_str();
+        }
+    }
+    return NULL;
+}
+
+/* rethinkdb_protocol_t speaks the same protobuf wire protocol (ql2.proto) as the
+official drivers. Every request carries its own token and the server is free to
+answer out of order, so reads can be pipelined: enqueue_read() just sends a query
+and remembers its token, and responses are matched back up by token as they come
+in. Mutations are sent synchronously but only wait for their own response, so
+they don't have to drain the read pipeline first. */
+
+struct rethinkdb_protocol_t : public protocol_t {
+
+    static bool parse_conn_str(char *conn_str, const char **host, int *port,
+            const char **database, const char **table) {
+        *database = RETHINKDB_DEFAULT_DB;
+        *table = RETHINKDB_DEFAULT_TABLE;
+
+        *host = conn_str;
+        conn_str = strchr(conn_str, ':');
+        if (!conn_str) return false;
+        *conn_str++ = '\0';
+
+        const char *port_str = conn_str;
+        conn_str = strchr(conn_str, '/');
+        if (conn_str) {
+            *conn_str++ = '\0';
+
+            *database = conn_str;
+            conn_str = strchr(conn_str, '/');
+            if (!conn_str) return false;
+            *conn_str++ = '\0';
+
+            *table = conn_str;
+            if (**database == '\0' || **table == '\0') return false;
+        }
+
+        *port = atoi(port_str);
+        return *port != 0;
+    }
+
+    rethinkdb_protocol_t(const char *conn_str)
+        : sockfd(-1), next_token(1), recv_start(0), recv_end(0)
+    {
+        char buffer[MAX_HOST];
+        strncpy(buffer, conn_str, sizeof(buffer));
+        buffer[sizeof(buffer) - 1] = '\0';
+
+        const char *host_str, *db_str, *table_str;
+        int port;
+        if (!parse_conn_str(buffer, &host_str, &port, &db_str, &table_str)) {
+            fprintf(stderr, "%s Your input was \"%s\".\n", RETHINKDB_CONN_STR_MESSAGE, conn_str);
+            exit(-1);
+        }
+        db = db_str;
+        table = table_str;
+
+        // Setup the host/port data structures
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof(sin));
+        struct hostent *host = gethostbyname(host_str);
+        if (!host) {
+            herror("Could not gethostbyname()");
+            exit(-1);
+        }
+        memcpy(&sin.sin_addr.s_addr, host->h_addr, host->h_length);
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(port);
+
+        // Connect to server
+        sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (sockfd < 0) {
+            fprintf(stderr, "Could not create socket\n");
+            exit(-1);
+        }
+        int res = ::connect(sockfd, (struct sockaddr *)&sin, sizeof(sin));
+        if (res < 0) {
+            int err = errno;
+            fprintf(stderr, "Could not connect to server (%d)\n", err);
+            exit(-1);
+        }
+
+        handshake();
+    }
+
+    virtual ~rethinkdb_protocol_t() {
+        if (sockfd != -1) {
+            int res = close(sockfd);
+            if (res != 0) {
+                fprintf(stderr, "Could not close socket\n");
+                exit(-1);
+            }
+        }
+    }
+
+    virtual void remove(const char *key, size_t key_size) {
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::DELETE);
+        get_term(t->add_args(), key, key_size);
+        run(&q);
+    }
+
+    virtual void update(const char *key, size_t key_size,
+                        const char *value, size_t value_size) {
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::UPDATE);
+        get_term(t->add_args(), key, key_size);
+        Term *obj = t->add_args();
+        obj->set_type(Term::MAKE_OBJ);
+        ql_string(ql_optarg(obj, "value"), value, value_size);
+        run(&q);
+    }
+
+    virtual void insert(const char *key, size_t key_size,
+                        const char *value, size_t value_size) {
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::INSERT);
+        ql_table(t->add_args(), db, table);
+        ql_document(t->add_args(), key, key_size, value, value_size);
+        ql_bool(ql_optarg(t, "upsert"), true);
+        run(&q);
+    }
+
+    virtual void insert_batch(payload_t *keys, payload_t *values, int count) {
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::INSERT);
+        ql_table(t->add_args(), db, table);
+        Term *docs = t->add_args();
+        docs->set_type(Term::MAKE_ARRAY);
+        for (int i = 0; i < count; i++) {
+            ql_document(docs->add_args(), keys[i].first, keys[i].second,
+                        values[i].first, values[i].second);
+        }
+        ql_bool(ql_optarg(t, "upsert"), true);
+        run(&q);
+    }
+
+    virtual void read(payload_t *keys, int count, payload_t *values = NULL) {
+        enqueue_read(keys, count, values);
+        dequeue_read(keys, count, values);
+    }
+
+    virtual void sindex_read(payload_t *keys, int count, payload_t *values = NULL) {
+        Query q;
+        Term *t = start_query(&q);
+        get_all_term(t, keys, count, RETHINKDB_SINDEX_NAME);
+
+        std::vector<Datum> docs;
+        run_sequence(&q, &docs);
+        if (values) {
+            verify_documents(keys, count, values, docs);
+        }
+    }
+
+    /* add a read to the pipeline */
+    virtual void enqueue_read(payload_t *keys, int count, UNUSED payload_t *values = NULL) {
+        Query q;
+        Term *t = start_query(&q);
+        if (count == 1) {
+            get_term(t, keys[0].first, keys[0].second);
+        } else {
+            get_all_term(t, keys, count, NULL);
+        }
+        send_query(q);
+        outstanding_reads.push_back(q.token());
+    }
+
+    /* Check whether the oldest pipelined read has been answered without blocking
+    on the socket. */
+    virtual bool dequeue_read_maybe(payload_t *keys, int count, payload_t *values = NULL) {
+        assert(!outstanding_reads.empty());
+        while (responses.find(outstanding_reads.front()) == responses.end()) {
+            if (!read_response(false)) return false;
+        }
+        dequeue_read(keys, count, values);
+        return true;
+    }
+
+    /* Wait until the oldest pipelined read has been returned */
+    virtual void dequeue_read(payload_t *keys, int count, payload_t *values = NULL) {
+        assert(!outstanding_reads.empty());
+        int64_t token = outstanding_reads.front();
+        outstanding_reads.pop_front();
+
+        std::vector<Datum> docs;
+        collect_sequence(token, &docs);
+        if (values) {
+            verify_documents(keys, count, values, docs);
+        }
+    }
+
+    virtual void range_read(char* lkey, size_t lkey_size, char* rkey, size_t rkey_size, int count_limit, payload_t *values = NULL) {
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::LIMIT);
+        Term *between = t->add_args();
+        between->set_type(Term::BETWEEN);
+        ql_table(between->add_args(), db, table);
+        ql_string(between->add_args(), lkey, lkey_size);
+        ql_string(between->add_args(), rkey, rkey_size);
+        ql_string(ql_optarg(between, "right_bound"), "closed");
+        ql_number(t->add_args(), count_limit);
+
+        std::vector<Datum> docs;
+        run_sequence(&q, &docs);
+
+        if (values) {
+            fprintf(stderr, "Value verification not implemented for range reads\n");
+        }
+    }
+
+    virtual void append(const char *key, size_t key_size,
+                        const char *value, size_t value_size) {
+        append_prepend(true, key, key_size, value, value_size);
+    }
+
+    virtual void prepend(const char *key, size_t key_size,
+                          const char *value, size_t value_size) {
+        append_prepend(false, key, key_size, value, value_size);
+    }
+
+    /* Creates the database, the table and the secondary index that the other
+    operations expect, unless they already exist. */
+    void create_table() {
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::DB_CREATE);
+        ql_string(t->add_args(), db);
+        run_ignoring_runtime_errors(&q);
+
+        t = start_query(&q);
+        t->set_type(Term::TABLE_CREATE);
+        ql_db(t->add_args(), db);
+        ql_string(t->add_args(), table);
+        run_ignoring_runtime_errors(&q);
+
+        t = start_query(&q);
+        t->set_type(Term::INDEX_CREATE);
+        ql_table(t->add_args(), db, table);
+        ql_string(t->add_args(), RETHINKDB_SINDEX_NAME);
+        run_ignoring_runtime_errors(&q);
+
+        t = start_query(&q);
+        t->set_type(Term::INDEX_WAIT);
+        ql_table(t->add_args(), db, table);
+        ql_string(t->add_args(), RETHINKDB_SINDEX_NAME);
+        run(&q);
+    }
+
+private:
+    int sockfd;
+    std::string db, table;
+
+    int64_t next_token;
+    // Tokens of the pipelined reads, oldest first
+    std::deque<int64_t> outstanding_reads;
+    // Responses that arrived before anyone asked for them
+    std::map<int64_t, Response> responses;
+
+    std::string send_buffer;
+    std::vector<char> recv_buffer;
+    size_t recv_start, recv_end;
+
+    void handshake() {
+        char buf[8];
+        int32_t magic = VersionDummy::V0_2;
+        int32_t auth_key_size = 0;
+        memcpy(buf, &magic, sizeof(magic));
+        memcpy(buf + sizeof(magic), &auth_key_size, sizeof(auth_key_size));
+        send_all(buf, sizeof(buf));
+
+        // The server answers with a null-terminated string
+        std::string reply;
+        char c;
+        do {
+            recv_exactly(&c, 1);
+            reply.push_back(c);
+        } while (c != '\0');
+        reply.resize(reply.size() - 1);
+
+        if (reply != "SUCCESS") {
+            fprintf(stderr, "Server rejected the connection: %s\n", reply.c_str());
+            exit(-1);
+        }
+    }
+
+    Term *start_query(Query *q) {
+        q->Clear();
+        q->set_type(Query::START);
+        q->set_token(next_token++);
+        return q->mutable_query();
+    }
+
+    void get_term(Term *t, const char *key, size_t key_size) {
+        t->set_type(Term::GET);
+        ql_table(t->add_args(), db, table);
+        ql_string(t->add_args(), key, key_size);
+    }
+
+    void get_all_term(Term *t, payload_t *keys, int count, const char *index) {
+        t->set_type(Term::GET_ALL);
+        ql_table(t->add_args(), db, table);
+        for (int i = 0; i < count; i++) {
+            ql_string(t->add_args(), keys[i].first, keys[i].second);
+        }
+        if (index) {
+            ql_string(ql_optarg(t, "index"), index);
+        }
+    }
+
+    void append_prepend(bool append, const char *key, size_t key_size,
+                        const char *value, size_t value_size) {
+        // get(key).update(func(row) { return {value: row("value") + value}; })
+        Query q;
+        Term *t = start_query(&q);
+        t->set_type(Term::UPDATE);
+        get_term(t->add_args(), key, key_size);
+
+        const int row_var = 1;
+        Term *func = t->add_args();
+        func->set_type(Term::FUNC);
+        Term *params = func->add_args();
+        params->set_type(Term::MAKE_ARRAY);
+        ql_number(params->add_args(), row_var);
+
+        Term *body = func->add_args();
+        body->set_type(Term::MAKE_OBJ);
+        Term *sum = ql_optarg(body, "value");
+        sum->set_type(Term::ADD);
+
+        Term *old_value = append ? sum->add_args() : NULL;
+        ql_string(sum->add_args(), value, value_size);
+        if (!old_value) old_value = sum->add_args();
+
+        old_value->set_type(Term::GET_FIELD);
+        Term *row = old_value->add_args();
+        row->set_type(Term::VAR);
+        ql_number(row->add_args(), row_var);
+        ql_string(old_value->add_args(), "value");
+
+        run(&q);
+    }
+
+    void verify_documents(payload_t *keys, int count, payload_t *values, const std::vector<Datum> &docs) {
+        std::map<std::string, std::string> found;
+        for (size_t i = 0; i < docs.size(); i++) {
+            const std::string *value = ql_document_value(docs[i]);
+            if (!value) continue;
+            for (int j = 0; j < docs[i].r_object_size(); j++) {
+                if (docs[i].r_object(j).key() == "id") {
+                    found[docs[i].r_object(j).val().r_str()] = *value;
+                }
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            const std::string &value = found[std::string(keys[i].first, keys[i].second)];
+            if (value != std::string(values[i].first, values[i].second)) {
+                fprintf(stderr, "Got unexpected value: %s instead of %.*s\n",
+                        value.c_str(), static_cast<int>(values[i].second), values[i].first);
+            }
+        }
+    }
+
+    /* Runs a query whose result we don't look at. */
+    void run(Query *q) {
+        send_query(*q);
+        Response r;
+        wait_for_response(q->token(), &r);
+        check_response(r);
+    }
+
+    void run_ignoring_runtime_errors(Query *q) {
+        try {
+            run(q);
+        } catch (rethinkdb_query_error_t &e) {
+            if (e.response_type != Response::RUNTIME_ERROR) throw;
+        }
+    }
+
+    /* Runs a query and collects every datum it returns, following up with CONTINUE
+    queries if the server hands the result back in several batches. */
+    void run_sequence(Query *q, std::vector<Datum> *out) {
+        send_query(*q);
+        collect_sequence(q->token(), out);
+    }
+
+    void collect_sequence(int64_t token, std::vector<Datum> *out) {
+        for (;;) {
+            Response r;
+            wait_for_response(token, &r);
+            check_response(r);
+
+            if (r.type() == Response::SUCCESS_ATOM && r.response_size() == 1 &&
+                r.response(0).type() == Datum::R_ARRAY) {
+                for (int i = 0; i < r.response(0).r_array_size(); i++) {
+                    out->push_back(r.response(0).r_array(i));
+                }
+            } else {
+                for (int i = 0; i < r.response_size(); i++) {
+                    out->push_back(r.response(i));
+                }
+            }
+
+            if (r.type() != Response::SUCCESS_PARTIAL) break;
+
+            Query more;
+            more.set_type(Query::CONTINUE);
+            more.set_token(token);
+            send_query(more);
+        }
+    }
+
+    void check_response(const Response &r) {
+        switch (r.type()) {
+        case Response::SUCCESS_ATOM:
+        case Response::SUCCESS_SEQUENCE:
+        case Response::SUCCESS_PARTIAL:
+            return;
+        default: {
+            std::string message = "(no message)";
+            if (r.response_size() > 0 && r.response(0).type() == Datum::R_STR) {
+                message = r.response(0).r_str();
+            }
+            throw rethinkdb_query_error_t(r.type(), message);
+        }
+        }
+    }
+
+    void send_query(const Query &q) {
+        // Leave room for the size prefix and fill it in once we know the size
+        send_buffer.assign(sizeof(int32_t), '\0');
+        if (!q.AppendToString(&send_buffer)) {
+            throw protocol_error_t("Could not serialize query");
+        }
+        int32_t size = send_buffer.size() - sizeof(size);
+        memcpy(&send_buffer[0], &size, sizeof(size));
+        send_all(send_buffer.data(), send_buffer.size());
+    }
+
+    void wait_for_response(int64_t token, Response *out) {
+        std::map<int64_t, Response>::iterator it;
+        while ((it = responses.find(token)) == responses.end()) {
+            read_response(true);
+        }
+        out->Swap(&it->second);
+        responses.erase(it);
+    }
+
+    /* Parses one response off the socket and files it away by token. If `block`
+    is false and a whole response isn't available yet, returns false instead of
+    waiting for it. */
+    bool read_response(bool block) {
+        int32_t size;
+        while (!buffered_bytes_at_least(sizeof(size))) {
+            if (!fill_recv_buffer(block)) return false;
+        }
+        memcpy(&size, recv_buffer.data() + recv_start, sizeof(size));
+        if (size < 0) {
+            throw protocol_error_t("Got a response with a negative size");
+        }
+        while (!buffered_bytes_at_least(sizeof(size) + size)) {
+            if (!fill_recv_buffer(block)) return false;
+        }
+
+        Response r;
+        if (!r.ParseFromArray(recv_buffer.data() + recv_start + sizeof(size), size)) {
+            throw protocol_error_t("Could not parse response");
+        }
+        recv_start += sizeof(size) + size;
+
+        int64_t token = r.token();
+        responses[token].Swap(&r);
+        return true;
+    }
+
+    bool buffered_bytes_at_least(size_t n) {
+        return recv_end - recv_start >= n;
+    }
+
+    bool fill_recv_buffer(bool block) {
+        // Move whatever we haven't parsed yet to the front of the buffer
+        if (recv_start > 0) {
+            memmove(recv_buffer.data(), recv_buffer.data() + recv_start, recv_end - recv_start);
+            recv_end -= recv_start;
+            recv_start = 0;
+        }
+        if (recv_buffer.size() - recv_end < 4096) {
+            recv_buffer.resize(std::max<size_t>(recv_buffer.size() * 2, recv_end + 4096));
+        }
+
+        ssize_t res = recv(sockfd, recv_buffer.data() + recv_end, recv_buffer.size() - recv_end,
+                           block ? 0 : MSG_DONTWAIT);
+        if (res == -1 && !block && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        } else if (res == 0) {
+            fprintf(stderr, "rethinkdb_protocol: error: server closed the connection\n");
+            exit(-1);
+        } else if (res < 0) {
+            perror("Unable to read from socket");
+            exit(-1);
+        }
+        recv_end += res;
+        return true;
+    }
+
+    void recv_exactly(char *buf, size_t size) {
+        while (size > 0) {
+            ssize_t res = recv(sockfd, buf, size, 0);
+            if (res <= 0) {
+                perror("Unable to read from socket");
+                exit(-1);
+            }
+            buf += res;
+            size -= res;
+        }
+    }
+
+    void send_all(const char *buf, size_t size) {
+        while (size > 0) {
+            ssize_t res = send(sockfd, buf, size, 0);
+            if (res < 0) {
+                if (errno == EINTR) continue;
+                perror("Could not send command");
+                exit(-1);
+            }
+            buf += res;
+            size -= res;
+        }
+    }
+};
+
+/* Like initialize_mysql_table(): the protocol_t assumes that the table it works on
+already exists, so this sets it up before the clients are started. */
+
+inline void initialize_rethinkdb_table(const char *conn_str) {
+    rethinkdb_protocol_t proto(conn_str);
+    try {
+        proto.create_table();
+    } catch (protocol_error_t &e) {
+        fprintf(stderr, "Could not set up the RethinkDB table: %s\n", e.c_str());
+        exit(-1);
+    }
+}
+
+#endif  // __STRESS_CLIENT_PROTOCOLS_RETHINKDB_PROTOCOL_HPP__
@@ -4,6 +4,8 @@
 
 #include <assert.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <string.h>
 #include <algorithm>
 
 #define UNUSED __attribute__((unused))
@@ -185,5 +187,69 @@ struct reservoir_sample_t {
     }
 };
 
+/* The reservoir sample above is good for plotting latencies over time, but with only
+100 samples per second it can't say anything useful about the tail. latency_histogram_t
+counts every single latency instead, in log-linear buckets: each power of two is split
+into 16 equal sub-buckets, so any reported percentile is within about 6% of the true
+value no matter how large it is. Values are in microseconds. */
+struct latency_histogram_t {
+
+    static const int sub_buckets = 16;
+    static const int sub_bucket_bits = 4;
+    static const int num_buckets = sub_buckets + (64 - sub_bucket_bits) * sub_buckets;
+
+    uint64_t counts[num_buckets];
+    uint64_t total;
+
+    latency_histogram_t() {
+        clear();
+    }
+
+    void add(uint64_t us, uint64_t count = 1) {
+        counts[bucket_of(us)] += count;
+        total += count;
+    }
+
+    latency_histogram_t &operator+=(const latency_histogram_t &h) {
+        for (int i = 0; i < num_buckets; i++) counts[i] += h.counts[i];
+        total += h.total;
+        return *this;
+    }
+
+    /* Returns the (upper bound of the bucket holding the) latency below which the
+    given fraction of all recorded latencies fall, e.g. percentile(0.99) for p99. */
+    uint64_t percentile(double fraction) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(fraction * total);
+        if (rank >= total) rank = total - 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < num_buckets; i++) {
+            seen += counts[i];
+            if (seen > rank) return bucket_upper_bound(i);
+        }
+        return bucket_upper_bound(num_buckets - 1);
+    }
+
+    void clear() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+    }
+
+    static int bucket_of(uint64_t v) {
+        if (v < static_cast<uint64_t>(sub_buckets)) return v;
+        int msb = 63 - __builtin_clzll(v);
+        int sub = (v >> (msb - sub_bucket_bits)) - sub_buckets;
+        return (msb - sub_bucket_bits + 1) * sub_buckets + sub;
+    }
+
+    static uint64_t bucket_upper_bound(int bucket) {
+        if (bucket < sub_buckets) return bucket;
+        int msb = bucket / sub_buckets + sub_bucket_bits - 1;
+        uint64_t sub = bucket % sub_buckets + sub_buckets;
+        uint64_t width = 1ULL << (msb - sub_bucket_bits);
+        return sub * width + (width - 1);
+    }
+};
+
 #endif // __STRESS_CLIENT_UTILS_HPP__
 
@@ -401,8 +401,8 @@ class RqlQuery(object):
     def between(self, left=None, right=None, left_bound=(), right_bound=(), index=()):
         return Between(self, left, right, left_bound=left_bound, right_bound=right_bound, index=index)
 
-    def distinct(self):
-        return Distinct(self)
+    def distinct(self, **kwargs):
+        return Distinct(self, **kwargs)
 
     # NB: Can't overload __len__ because Python doesn't
     #     allow us to return a non-integer
@@ -932,8 +932,8 @@ class DB(RqlTopLevelQuery):
     def table_list(self):
         return TableList(self)
 
-    def table_create(self, table_name, primary_key=(), datacenter=(), cache_size=(), durability=()):
-        return TableCreate(self, table_name, primary_key=primary_key, datacenter=datacenter, cache_size=cache_size, durability=durability)
+    def table_create(self, table_name, primary_key=(), datacenter=(), cache_size=(), durability=(), compress_blocks=()):
+        return TableCreate(self, table_name, primary_key=primary_key, datacenter=datacenter, cache_size=cache_size, durability=durability, compress_blocks=compress_blocks)
 
     def table_drop(self, table_name):
         return TableDrop(self, table_name)
@@ -81,7 +81,7 @@ rethinkdb.ast.Table.index_drop.__func__.__doc__ = u"Delete a previously created
 rethinkdb.ast.Table.index_list.__func__.__doc__ = u"List all the secondary indexes of this table.\n\n*Example* List the available secondary indexes for this table.\n\n>>> r.table('marvel').index_list().run(conn)\n"
 rethinkdb.ast.Table.index_status.__func__.__doc__ = u"Get the status of the specified indexes on this table, or the status\nof all indexes on this table if no indexes are specified.\n\n*Example* Get the status of all the indexes on `test`:\n\n>>> r.table('test').index_status().run(conn)\n\n*Example* Get the status of the `timestamp` index:\n\n>>> r.table('test').index_status('timestamp').run(conn)\n"
 rethinkdb.ast.Table.index_wait.__func__.__doc__ = u"Wait for the specified indexes on this table to be ready, or for all\nindexes on this table to be ready if no indexes are specified.\n\n*Example* Wait for all indexes on the table `test` to be ready:\n\n>>> r.table('test').index_wait().run(conn)\n\n*Example* Wait for the index `timestamp` to be ready:\n\n>>> r.table('test').index_wait('timestamp').run(conn)\n"
-rethinkdb.ast.DB.table_create.__func__.__doc__ = u"Create a table. A RethinkDB table is a collection of JSON documents.\n\nIf successful, the operation returns an object: `{created: 1}`. If a table with the same\nname already exists, the operation throws `RqlRuntimeError`.\n\nNote: that you can only use alphanumeric characters and underscores for the table name.\n\nWhen creating a table you can specify the following options:\n\n- `primary_key`: the name of the primary key. The default primary key is id;\n- `durability`: if set to `soft`, this enables _soft durability_ on this table:\nwrites will be acknowledged by the server immediately and flushed to disk in the\nbackground. Default is `hard` (acknowledgement of writes happens after data has been\nwritten to disk);\n- `cache_size`: set the cache size (in bytes) to be used by the table. The\ndefault is 1073741824 (1024MB);\n- `datacenter`: the name of the datacenter this table should be assigned to.\n\n*Example* Create a table named 'dc_universe' with the default settings.\n\n>>> r.db('test').table_create('dc_universe').run(conn)\n\n*Example* Create a table named 'dc_universe' using the field 'name' as primary key.\n\n>>> r.db('test').table_create('dc_universe', primary_key='name').run(conn)\n\n*Example* Create a table to log the very fast actions of the heroes.\n\n>>> r.db('test').table_create('hero_actions', durability='soft').run(conn)\n\n"
+rethinkdb.ast.DB.table_create.__func__.__doc__ = u"Create a table. A RethinkDB table is a collection of JSON documents.\n\nIf successful, the operation returns an object: `{created: 1}`. If a table with the same\nname already exists, the operation throws `RqlRuntimeError`.\n\nNote: that you can only use alphanumeric characters and underscores for the table name.\n\nWhen creating a table you can specify the following options:\n\n- `primary_key`: the name of the primary key. The default primary key is id;\n- `durability`: if set to `soft`, this enables _soft durability_ on this table:\nwrites will be acknowledged by the server immediately and flushed to disk in the\nbackground. Default is `hard` (acknowledgement of writes happens after data has been\nwritten to disk);\n- `cache_size`: set the cache size (in bytes) to be used by the table. The\ndefault is 1073741824 (1024MB);\n- `compress_blocks`: if set to `True`, the table's blocks are compressed when they\nare written to disk. Default is `False`;\n- `datacenter`: the name of the datacenter this table should be assigned to.\n\n*Example* Create a table named 'dc_universe' with the default settings.\n\n>>> r.db('test').table_create('dc_universe').run(conn)\n\n*Example* Create a table named 'dc_universe' using the field 'name' as primary key.\n\n>>> r.db('test').table_create('dc_universe', primary_key='name').run(conn)\n\n*Example* Create a table to log the very fast actions of the heroes.\n\n>>> r.db('test').table_create('hero_actions', durability='soft').run(conn)\n\n"
 rethinkdb.ast.DB.table_drop.__func__.__doc__ = u'Drop a table. The table and all its data will be deleted.\n\nIf succesful, the operation returns an object: {"dropped": 1}. If the specified table\ndoesn\'t exist a `RqlRuntimeError` is thrown.\n\n*Example* Drop a table named \'dc_universe\'.\n\n>>> r.db(\'test\').table_drop(\'dc_universe\').run(conn)\n\n'
 rethinkdb.ast.DB.table_list.__func__.__doc__ = u"List all table names in a database. The result is a list of strings.\n\n*Example* List all tables of the 'test' database.\n\n>>> r.db('test').table_list().run(conn)\n... \n"
 rethinkdb.ast.RqlQuery.__add__.__func__.__doc__ = u'Sum two numbers, concatenate two strings, or concatenate 2 arrays.\n\n*Example:* It\'s as easy as 2 + 2 = 4.\n\n>>> (r.expr(2) + 2).run(conn)\n\n*Example:* Strings can be concatenated too.\n\n>>> (r.expr("foo") + "bar").run(conn)\n\n*Example:* Arrays can be concatenated too.\n\n>>> (r.expr(["foo", "bar"]) + ["buzz"]).run(conn)\n\n*Example:* Create a date one year from now.\n\n>>> r.now() + 365*24*60*60\n\n'
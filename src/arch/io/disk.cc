@@ -17,6 +17,7 @@
 #include "config/args.hpp"
 #include "backtrace.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/io/disk/aio.hpp"
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk/pool.hpp"
 #include "arch/io/disk/conflict_resolving.hpp"
@@ -44,14 +45,31 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         io_backend_t io_backend,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
         accounter(batch_factor),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        switch (io_backend) {
+        case io_backend_t::pool:
+            pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                                 max_concurrent_io_requests));
+            pool_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                               &backend_stats, ph::_1);
+            break;
+        case io_backend_t::native:
+            aio_backend.init(new aio_diskmgr_t(queue, backend_stats.producer,
+                                               max_concurrent_io_requests));
+            aio_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                              &backend_stats, ph::_1);
+            break;
+        default:
+            unreachable();
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -60,8 +78,7 @@ public:
         conflict_resolver.submit_fun = std::bind(&accounting_diskmgr_t::submit,
                                                  &accounter, ph::_1);
 
-        /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        /* Hook up everything's `done_fun`. (The backend's was hooked up above.) */
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -161,7 +178,8 @@ private:
     holding back operations that must be run after other, currently-running, operations.
     Then it goes to the account manager, which queues up running IO operations according
     to which account they are part of. Finally the "backend" pops the IO operations
-    from the queue.
+    from the queue.  The backend is either a `pool_diskmgr_t` or an `aio_diskmgr_t`,
+    depending on the `io_backend_t` we were given; exactly one of them is non-null.
 
     At two points in the process--once as soon as it is submitted, and again right
     as the backend pops it off the queue--its statistics are recorded. The "stack stats"
@@ -174,7 +192,8 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+    scoped_ptr_t<aio_diskmgr_t> aio_backend;
 
 
     int outstanding_txn;
@@ -183,11 +202,13 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               io_backend_t io_backend)
     : direct_io_mode(_direct_io_mode),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
+                                       io_backend,
                                        &stats)) { }
 
 io_backender_t::~io_backender_t() { }
@@ -232,6 +253,35 @@ void linux_file_t::set_size_at_least(int64_t size) {
     }
 }
 
+static void preallocate_blocking(fd_t fd, int64_t size, int *errsv_out) {
+    int res;
+#ifndef __MACH__
+    do {
+        res = fallocate(fd, 0, 0, size);
+    } while (res == -1 && get_errno() == EINTR);
+    if (res == 0 || (get_errno() != EOPNOTSUPP && get_errno() != ENOSYS)) {
+        *errsv_out = res == 0 ? 0 : get_errno();
+        return;
+    }
+    // The file system can't reserve blocks, so just make the file bigger.
+#endif  // __MACH__
+    do {
+        res = ftruncate(fd, size);
+    } while (res == -1 && get_errno() == EINTR);
+    *errsv_out = res == 0 ? 0 : get_errno();
+}
+
+void linux_file_t::preallocate(int64_t size) {
+    if (file_size >= size) {
+        return;
+    }
+    int errsv;
+    thread_pool_t::run_in_blocker_pool(
+        std::bind(&preallocate_blocking, fd.get(), size, &errsv));
+    guarantee_xerr(errsv == 0, errsv, "Could not preallocate file");
+    file_size = size;
+}
+
 void linux_file_t::read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *callback) {
     rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
     verify_aligned_file_access(file_size, offset, length, buf);
@@ -28,7 +28,8 @@ public:
     // stops us from specifying this on a file-by-file basis, but right now there's no desire for
     // that.  See https://github.com/rethinkdb/rethinkdb/issues/97#issuecomment-19778177 .
     io_backender_t(file_direct_io_mode_t direct_io_mode,
-                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS);
+                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                   io_backend_t io_backend = io_backend_t::pool);
     ~io_backender_t();
     linux_disk_manager_t *get_diskmgr_ptr() { return diskmgr.get(); }
     file_direct_io_mode_t get_direct_io_mode() const;
@@ -71,6 +72,7 @@ public:
     int64_t get_size();
     void set_size(int64_t size);
     void set_size_at_least(int64_t size);
+    void preallocate(int64_t size);
 
     void read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *cb);
     void write_async(int64_t offset, size_t length, const void *buf, file_account_t *account, linux_iocallback_t *cb,
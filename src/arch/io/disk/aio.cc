@@ -0,0 +1,326 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/io/disk/aio.hpp"
+
+#include <limits.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <functional>
+
+#include "arch/io/disk.hpp"
+#include "logger.hpp"
+
+// How many threads the fallback pool gets when the kernel's AIO interface works.
+// The pool then only sees the occasional datasync-wrapped write.
+static const int NATIVE_AIO_FALLBACK_IO_REQUESTS = 4;
+
+// How many completions we reap with one `io_getevents()` call.
+static const long MAX_AIO_EVENTS_PER_REAP = 64;  // NOLINT(runtime/int)
+
+#if NATIVE_AIO_AVAILABLE
+
+// glibc doesn't wrap the AIO syscalls, and we don't want to depend on libaio for
+// four one-liners.
+static int sys_io_setup(unsigned nr_events, aio_context_t *ctx_out) {
+    return syscall(__NR_io_setup, nr_events, ctx_out);
+}
+
+static int sys_io_destroy(aio_context_t ctx) {
+    return syscall(__NR_io_destroy, ctx);
+}
+
+static int sys_io_submit(aio_context_t ctx, long nr, iocb **iocbpp) {  // NOLINT(runtime/int)
+    return syscall(__NR_io_submit, ctx, nr, iocbpp);
+}
+
+static int sys_io_getevents(aio_context_t ctx, long min_nr, long nr,  // NOLINT(runtime/int)
+                            io_event *events, timespec *timeout) {
+    return syscall(__NR_io_getevents, ctx, min_nr, nr, events, timeout);
+}
+
+#endif  // NATIVE_AIO_AVAILABLE
+
+aio_diskmgr_t::aio_diskmgr_t(linux_event_queue_t *queue,
+                             passive_producer_t<action_t *> *source,
+                             int max_concurrent_io_requests)
+    :
+#if NATIVE_AIO_AVAILABLE
+      queue_(queue),
+      aio_context_(0),
+#endif
+      source_(source),
+      queue_depth_(max_concurrent_io_requests),
+      n_pending_(0) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(max_concurrent_io_requests < MAXIMUM_MAX_CONCURRENT_IO_REQUESTS);
+
+#if NATIVE_AIO_AVAILABLE
+    int res = sys_io_setup(queue_depth_, &aio_context_);
+    if (res == 0) {
+        iocbs_.init(queue_depth_);
+        transferred_.init(queue_depth_);
+        remaining_vecs_.init(queue_depth_);
+        free_iocbs_.reserve(queue_depth_);
+        for (int i = 0; i < queue_depth_; ++i) {
+            free_iocbs_.push_back(&iocbs_[i]);
+        }
+        queue_->watch_resource(completion_event_.get_notify_fd(), poll_event_in, this);
+    } else {
+        aio_context_ = 0;
+        logWRN("Could not set up native asynchronous I/O (%s). "
+               "Falling back to the thread pool.\n", errno_string(get_errno()).c_str());
+    }
+#else
+    logWRN("Native asynchronous I/O is not supported on this platform. "
+           "Falling back to the thread pool.\n");
+#endif
+
+    fallback_.init(new pool_diskmgr_t(queue, &fallback_queue_,
+                                      is_native()
+                                      ? NATIVE_AIO_FALLBACK_IO_REQUESTS
+                                      : max_concurrent_io_requests));
+    fallback_->done_fun = std::bind(&aio_diskmgr_t::fallback_done, this, ph::_1);
+
+    if (source_->available->get()) { pump(); }
+    source_->available->set_callback(this);
+}
+
+aio_diskmgr_t::~aio_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending_ == 0);
+    source_->available->unset_callback();
+#if NATIVE_AIO_AVAILABLE
+    if (is_native()) {
+        queue_->forget_resource(completion_event_.get_notify_fd(), this);
+        int res = sys_io_destroy(aio_context_);
+        guarantee_err(res == 0, "Could not destroy AIO context");
+    }
+#endif
+}
+
+bool aio_diskmgr_t::is_native() const {
+#if NATIVE_AIO_AVAILABLE
+    return aio_context_ != 0;
+#else
+    return false;
+#endif
+}
+
+void aio_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source_->available->get()) pump();
+}
+
+void aio_diskmgr_t::fallback_done(action_t *a) {
+    assert_thread();
+    n_pending_--;
+    pump();
+    done_fun(a);
+}
+
+#if NATIVE_AIO_AVAILABLE
+
+void aio_diskmgr_t::pump() {
+    assert_thread();
+    std::vector<iocb *> batch;
+    while (source_->available->get() && n_pending_ < queue_depth_) {
+        action_t *a = source_->pop();
+        n_pending_++;
+        if (needs_fallback(a)) {
+            fallback_queue_.push(a);
+        } else {
+            rassert(!free_iocbs_.empty());
+            iocb *cb = free_iocbs_.back();
+            free_iocbs_.pop_back();
+            prepare_iocb(a, cb);
+            batch.push_back(cb);
+        }
+    }
+    if (!batch.empty()) {
+        submit(&batch);
+    }
+}
+
+bool aio_diskmgr_t::needs_fallback(action_t *a) {
+    if (!is_native() || a->wrap_in_datasyncs) {
+        return true;
+    }
+    iovec *vecs;
+    size_t vecs_len;
+    a->get_bufs(&vecs, &vecs_len);
+    return vecs_len > IOV_MAX;
+}
+
+void aio_diskmgr_t::prepare_iocb(action_t *a, iocb *cb) {
+    iovec *vecs;
+    size_t vecs_len;
+    a->get_bufs(&vecs, &vecs_len);
+
+    transferred_[slot_of(cb)] = 0;
+    memset(cb, 0, sizeof(*cb));
+    cb->aio_data = reinterpret_cast<uintptr_t>(a);
+    cb->aio_fildes = a->get_fd();
+    cb->aio_offset = a->get_offset();
+    if (vecs_len == 1) {
+        cb->aio_lio_opcode = a->get_is_read() ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
+        cb->aio_buf = reinterpret_cast<uintptr_t>(vecs[0].iov_base);
+        cb->aio_nbytes = vecs[0].iov_len;
+    } else {
+        cb->aio_lio_opcode = a->get_is_read() ? IOCB_CMD_PREADV : IOCB_CMD_PWRITEV;
+        cb->aio_buf = reinterpret_cast<uintptr_t>(vecs);
+        cb->aio_nbytes = vecs_len;
+    }
+    cb->aio_flags = IOCB_FLAG_RESFD;
+    cb->aio_resfd = completion_event_.get_notify_fd();
+}
+
+void aio_diskmgr_t::prepare_remainder(action_t *a, iocb *cb) {
+    const size_t slot = slot_of(cb);
+    int64_t skip = transferred_[slot];
+    rassert(skip > 0 && skip < static_cast<int64_t>(a->get_count()));
+
+    iovec *vecs;
+    size_t vecs_len;
+    a->get_bufs(&vecs, &vecs_len);
+    size_t first = 0;
+    while (skip >= static_cast<int64_t>(vecs[first].iov_len)) {
+        skip -= vecs[first].iov_len;
+        ++first;
+    }
+
+    // The action's own buffers have to stay untouched, so the partially
+    // transferred ones are described by a copy.
+    std::vector<iovec> *rest = &remaining_vecs_[slot];
+    rest->assign(vecs + first, vecs + vecs_len);
+    (*rest)[0].iov_base = static_cast<char *>((*rest)[0].iov_base) + skip;
+    (*rest)[0].iov_len -= skip;
+
+    memset(cb, 0, sizeof(*cb));
+    cb->aio_data = reinterpret_cast<uintptr_t>(a);
+    cb->aio_fildes = a->get_fd();
+    cb->aio_offset = a->get_offset() + transferred_[slot];
+    if (rest->size() == 1) {
+        cb->aio_lio_opcode = a->get_is_read() ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
+        cb->aio_buf = reinterpret_cast<uintptr_t>((*rest)[0].iov_base);
+        cb->aio_nbytes = (*rest)[0].iov_len;
+    } else {
+        cb->aio_lio_opcode = a->get_is_read() ? IOCB_CMD_PREADV : IOCB_CMD_PWRITEV;
+        cb->aio_buf = reinterpret_cast<uintptr_t>(rest->data());
+        cb->aio_nbytes = rest->size();
+    }
+    cb->aio_flags = IOCB_FLAG_RESFD;
+    cb->aio_resfd = completion_event_.get_notify_fd();
+}
+
+size_t aio_diskmgr_t::slot_of(iocb *cb) const {
+    rassert(cb >= iocbs_.data() && cb < iocbs_.data() + iocbs_.size());
+    return cb - iocbs_.data();
+}
+
+void aio_diskmgr_t::submit(std::vector<iocb *> *batch) {
+    size_t submitted = 0;
+    while (submitted < batch->size()) {
+        int res = sys_io_submit(aio_context_, batch->size() - submitted,
+                                batch->data() + submitted);
+        if (res > 0) {
+            submitted += res;
+        } else if (res == -1 && get_errno() == EINTR) {
+            continue;
+        } else {
+            // The kernel won't take the next request (maybe it's out of
+            // resources, or the file doesn't support AIO).  The thread pool can
+            // still run it and everything after it.
+            break;
+        }
+    }
+
+    for (size_t i = submitted; i < batch->size(); ++i) {
+        iocb *cb = (*batch)[i];
+        action_t *a = reinterpret_cast<action_t *>(static_cast<uintptr_t>(cb->aio_data));
+        free_iocbs_.push_back(cb);
+        fallback_queue_.push(a);
+    }
+}
+
+void aio_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in, "Unexpected event on the AIO eventfd: %d", events);
+    completion_event_.consume_wakey_wakeys();
+    reap();
+}
+
+void aio_diskmgr_t::reap() {
+    io_event events[MAX_AIO_EVENTS_PER_REAP];
+    timespec no_wait;
+    no_wait.tv_sec = 0;
+    no_wait.tv_nsec = 0;
+
+    for (;;) {
+        int res = sys_io_getevents(aio_context_, 0, MAX_AIO_EVENTS_PER_REAP,
+                                   events, &no_wait);
+        if (res == -1 && get_errno() == EINTR) {
+            continue;
+        }
+        guarantee_err(res >= 0, "io_getevents failed");
+
+        std::vector<action_t *> completed;
+        std::vector<iocb *> resubmit;
+        completed.reserve(res);
+        for (int i = 0; i < res; ++i) {
+            iocb *cb = reinterpret_cast<iocb *>(static_cast<uintptr_t>(events[i].obj));
+            action_t *a = reinterpret_cast<action_t *>(static_cast<uintptr_t>(events[i].data));
+            const int64_t result = events[i].res;
+            const int64_t count = a->get_count();
+            int64_t *transferred = &transferred_[slot_of(cb)];
+            if (result < 0) {
+                a->io_result = result;
+            } else if (result == 0) {
+                // No progress at all: we're reading past the end of the file, or
+                // the device can't take any more data.
+                a->io_result = -EIO;
+            } else if (*transferred + result < count) {
+                // A short transfer.  Send the rest of the request back to the
+                // kernel.
+                *transferred += result;
+                prepare_remainder(a, cb);
+                resubmit.push_back(cb);
+                continue;
+            } else {
+                rassert(*transferred + result == count);
+                a->io_result = count;
+            }
+            free_iocbs_.push_back(cb);
+            n_pending_--;
+            completed.push_back(a);
+        }
+
+        if (!resubmit.empty()) {
+            submit(&resubmit);
+        }
+        // Refill the kernel's queue before running the callbacks, so the disk
+        // stays busy while we're doing that.
+        pump();
+        for (auto it = completed.begin(); it != completed.end(); ++it) {
+            done_fun(*it);
+        }
+
+        if (res < MAX_AIO_EVENTS_PER_REAP) {
+            break;
+        }
+    }
+}
+
+#else  // NATIVE_AIO_AVAILABLE
+
+void aio_diskmgr_t::pump() {
+    assert_thread();
+    while (source_->available->get() && n_pending_ < queue_depth_) {
+        n_pending_++;
+        fallback_queue_.push(source_->pop());
+    }
+}
+
+#endif  // NATIVE_AIO_AVAILABLE
@@ -0,0 +1,99 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_AIO_HPP_
+#define ARCH_IO_DISK_AIO_HPP_
+
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/function.hpp>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+#if defined(__linux) && !defined(NO_EVENTFD)
+#define NATIVE_AIO_AVAILABLE 1
+#include <linux/aio_abi.h>
+#include "arch/runtime/system_event/eventfd_event.hpp"
+#else
+#define NATIVE_AIO_AVAILABLE 0
+#endif
+
+/* The AIO disk manager hands IO requests straight to the kernel's asynchronous IO
+interface instead of running blocking syscalls on a thread pool.  Everything it can
+pull off its source is submitted with a single `io_submit()`, and completions are
+reaped on the event loop when the kernel pings an eventfd.  This only really pays
+off for files opened with O_DIRECT; for buffered files the kernel does the IO
+synchronously inside `io_submit()`.
+
+It takes the same `pool_diskmgr_action_t`s as `pool_diskmgr_t`, so it can take its
+place at the bottom of the IO stack.  Requests the kernel interface can't express
+(writes wrapped in datasyncs, and writevs with more than IOV_MAX buffers) and
+requests the kernel refuses are run on an internal `pool_diskmgr_t` instead.  If
+the kernel doesn't support AIO at all, everything goes to that pool.
+
+The kernel may complete a request with fewer bytes than asked for.  We resubmit
+the rest of it until it has all been transferred; only a completion that makes no
+progress at all is reported as an error. */
+
+class aio_diskmgr_t : private availability_callback_t,
+#if NATIVE_AIO_AVAILABLE
+                      private linux_event_callback_t,
+#endif
+                      public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* The `aio_diskmgr_t` will draw actions to run from `source`, keeping at most
+    `max_concurrent_io_requests` of them in flight. It will call `done_fun` on each
+    one when it's done. */
+    aio_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                  int max_concurrent_io_requests);
+    boost::function<void(action_t *)> done_fun;
+    ~aio_diskmgr_t();
+
+    // False if the kernel's AIO interface couldn't be set up, and every request
+    // runs on the thread pool.
+    bool is_native() const;
+
+private:
+    void on_source_availability_changed();
+    void pump();
+    void fallback_done(action_t *a);
+
+#if NATIVE_AIO_AVAILABLE
+    bool needs_fallback(action_t *a);
+    void prepare_iocb(action_t *a, iocb *cb);
+    void prepare_remainder(action_t *a, iocb *cb);
+    size_t slot_of(iocb *cb) const;
+    void submit(std::vector<iocb *> *batch);
+    void on_event(int events);
+    void reap();
+
+    linux_event_queue_t *const queue_;
+    // Zero if we're not using the kernel's AIO interface.
+    aio_context_t aio_context_;
+    eventfd_event_t completion_event_;
+    scoped_array_t<iocb> iocbs_;
+    std::vector<iocb *> free_iocbs_;
+    // Per iocb: how many bytes of its action have been transferred by earlier
+    // (short) completions, and the leftover buffers for resubmitting the rest.
+    scoped_array_t<int64_t> transferred_;
+    scoped_array_t<std::vector<iovec> > remaining_vecs_;
+#endif
+
+    passive_producer_t<action_t *> *const source_;
+    const int queue_depth_;
+    // Actions taken off `source_` that haven't been passed to `done_fun` yet,
+    // including the ones on the thread pool.
+    int n_pending_;
+
+    unlimited_fifo_queue_t<action_t *> fallback_queue_;
+    scoped_ptr_t<pool_diskmgr_t> fallback_;
+
+    DISABLE_COPYING(aio_diskmgr_t);
+};
+
+#endif /* ARCH_IO_DISK_AIO_HPP_ */
@@ -4,6 +4,7 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
@@ -20,6 +21,7 @@
 #include "arch/timing.hpp"
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/printf_buffer.hpp"
 #include "logger.hpp"
@@ -325,7 +327,9 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != NULL) {
+    if (operation->iov != NULL) {
+        parent->perform_writev(operation->iov, operation->iovcnt);
+    } else if (operation->buffer != NULL) {
         parent->perform_write(operation->buffer, operation->size);
         if (operation->dealloc != NULL) {
             parent->release_write_buffer(operation->dealloc);
@@ -351,6 +355,8 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
     op->buffer = current_write_buffer->buffer;
     op->size = current_write_buffer->size;
     op->dealloc = current_write_buffer.release();
+    op->iov = NULL;
+    op->iovcnt = 0;
     op->cond = NULL;
     op->keepalive = auto_drainer_t::lock_t(drainer.get());
     current_write_buffer.init(get_write_buffer());
@@ -365,6 +371,13 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
 }
 
 void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
+    iovec iov;
+    iov.iov_base = const_cast<void *>(buf);
+    iov.iov_len = size;
+    perform_writev(&iov, 1);
+}
+
+void linux_tcp_conn_t::perform_writev(iovec *iov, size_t iovcnt) {
     assert_thread();
 
     if (write_closed.is_pulsed()) {
@@ -374,8 +387,14 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         return;
     }
 
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    while (iovcnt > 0) {
+        if (iov->iov_len == 0) {
+            ++iov;
+            --iovcnt;
+            continue;
+        }
+
+        ssize_t res = ::writev(sock.get(), iov, std::min<size_t>(iovcnt, IOV_MAX));
 
         if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
@@ -413,10 +432,23 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) write_perfmon->record(res);
+
+            /* Skip over whatever the kernel accepted; it may have stopped in
+            the middle of a buffer. */
+            size_t written = res;
+            while (written > 0) {
+                rassert(iovcnt > 0);
+                if (written >= iov->iov_len) {
+                    written -= iov->iov_len;
+                    ++iov;
+                    --iovcnt;
+                } else {
+                    iov->iov_base = reinterpret_cast<char *>(iov->iov_base) + written;
+                    iov->iov_len -= written;
+                    written = 0;
+                }
+            }
         }
     }
 }
@@ -437,6 +469,8 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     op.buffer = buf;
     op.size = size;
     op.dealloc = NULL;
+    op.iov = NULL;
+    op.iovcnt = 0;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
 
@@ -448,6 +482,34 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     if (write_closed.is_pulsed()) throw tcp_conn_write_closed_exc_t();
 }
 
+void linux_tcp_conn_t::writev(const iovec *iov, size_t iovcnt, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    write_op_wrapper_t sentry(this, closer);
+
+    write_queue_op_t op;
+    cond_t to_signal_when_done;
+
+    /* Flush out any data that's been buffered, so that things don't get out of order */
+    if (current_write_buffer->size > 0) internal_flush_write_buffer();
+
+    /* `perform_writev()` advances the entries as it goes, so it gets its own
+    copy. The buffers themselves are not copied. */
+    std::vector<iovec> iov_copy(iov, iov + iovcnt);
+
+    op.buffer = NULL;
+    op.size = 0;
+    op.dealloc = NULL;
+    op.iov = iov_copy.data();
+    op.iovcnt = iov_copy.size();
+    op.cond = &to_signal_when_done;
+    write_queue.push(&op);
+
+    /* As in `write()`, the cond gets pulsed even if the connection is closed
+    before or during our write. */
+    to_signal_when_done.wait();
+
+    if (write_closed.is_pulsed()) throw tcp_conn_write_closed_exc_t();
+}
+
 void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
@@ -496,6 +558,8 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     cond_t to_signal_when_done;
     op.buffer = NULL;
     op.dealloc = NULL;
+    op.iov = NULL;
+    op.iovcnt = 0;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
     to_signal_when_done.wait();
@@ -633,10 +697,12 @@ void linux_tcp_conn_descriptor_t::make_overcomplicated(linux_tcp_conn_t **tcp_co
 /* Network listener object */
 linux_nonthrowing_tcp_listener_t::linux_nonthrowing_tcp_listener_t(
         const std::set<ip_address_t> &bind_addresses, int _port,
-        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &cb) :
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &cb,
+        bool _reuse_port) :
     callback(cb),
     local_addresses(bind_addresses),
     port(_port),
+    reuse_port(_reuse_port),
     bound(false),
     socks(),
     last_used_socket_index(0),
@@ -707,6 +773,15 @@ int linux_nonthrowing_tcp_listener_t::init_sockets() {
         int res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &sockoptval, sizeof(sockoptval));
         guarantee_err(res != -1, "Could not set REUSEADDR option");
 
+        if (reuse_port) {
+#ifdef SO_REUSEPORT
+            res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &sockoptval, sizeof(sockoptval));
+            guarantee_err(res != -1, "Could not set REUSEPORT option");
+#else
+            crash("SO_REUSEPORT is not supported on this platform");
+#endif
+        }
+
         /* XXX Making our socket NODELAY prevents the problem where responses to
          * pipelined requests are delayed, since the TCP Nagle algorithm will
          * notice when we send multiple small packets and try to coalesce them. But
@@ -975,6 +1050,99 @@ int linux_tcp_listener_t::get_port() const {
     return listener->get_port();
 }
 
+bool linux_tcp_reuse_port_supported() {
+#ifdef SO_REUSEPORT
+    scoped_fd_t sock(socket(AF_INET, SOCK_STREAM, 0));
+    if (sock.get() == INVALID_FD) {
+        return false;
+    }
+    int sockoptval = 1;
+    int res = setsockopt(sock.get(), SOL_SOCKET, SO_REUSEPORT, &sockoptval, sizeof(sockoptval));
+    return res == 0;
+#else
+    return false;
+#endif
+}
+
+linux_per_thread_tcp_listener_t::linux_per_thread_tcp_listener_t(
+    const std::set<ip_address_t> &bind_addresses, int _port, int num_threads,
+    const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback) :
+        per_thread(listens_per_thread(num_threads)),
+        port(_port)
+{
+    if (num_threads > 1 && !per_thread) {
+        logWRN("SO_REUSEPORT is not supported, so connections on port %d will be "
+               "accepted on a single thread.", port);
+    }
+    listeners.init(per_thread ? num_threads : 1);
+
+    if (per_thread) {
+        // Sockets with SO_REUSEPORT don't notice when the port is already taken by
+        // another socket that has it set, e.g. another server of ours.  So first
+        // bind once without it, which fails if anybody has the port.  This also
+        // picks the port if we were given ANY_PORT.  The probe has to be closed
+        // before our listeners can bind, though, so a server that probes between
+        // then and our first listener binding still ends up sharing the port with
+        // us.  This only makes that window small.
+        linux_tcp_bound_socket_t probe(bind_addresses, port);
+        port = probe.get_port();
+    }
+
+    // The listeners are created one at a time so that the first one can pick the
+    // port if we were given ANY_PORT; the others then bind to the same port.
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        bool listening = false;
+        scoped_ptr_t<tcp_socket_exc_t> socket_exc;
+        {
+            on_thread_t thread_switcher(listener_thread(i));
+            listeners[i].init(new linux_nonthrowing_tcp_listener_t(
+                bind_addresses, port, callback, per_thread));
+            // Don't let the exception escape while we're on another thread.
+            try {
+                listening = listeners[i]->begin_listening();
+            } catch (const tcp_socket_exc_t &ex) {
+                socket_exc.init(new tcp_socket_exc_t(ex));
+            }
+            port = listeners[i]->get_port();
+        }
+        if (!listening) {
+            pmap(i + 1, std::bind(&linux_per_thread_tcp_listener_t::destroy_listener,
+                                  this, ph::_1));
+            if (socket_exc.has()) {
+                throw *socket_exc;
+            }
+            throw address_in_use_exc_t("localhost", port);
+        }
+    }
+}
+
+linux_per_thread_tcp_listener_t::~linux_per_thread_tcp_listener_t() {
+    assert_thread();
+    pmap(listeners.size(), std::bind(&linux_per_thread_tcp_listener_t::destroy_listener,
+                                     this, ph::_1));
+}
+
+int linux_per_thread_tcp_listener_t::get_port() const {
+    return port;
+}
+
+int linux_per_thread_tcp_listener_t::num_listening_threads() const {
+    return listeners.size();
+}
+
+bool linux_per_thread_tcp_listener_t::listens_per_thread(int num_threads) {
+    return num_threads > 1 && linux_tcp_reuse_port_supported();
+}
+
+threadnum_t linux_per_thread_tcp_listener_t::listener_thread(int i) const {
+    return per_thread ? threadnum_t(i) : home_thread();
+}
+
+void linux_per_thread_tcp_listener_t::destroy_listener(int i) {
+    on_thread_t thread_switcher(listener_thread(i));
+    listeners[i].reset();
+}
+
 linux_repeated_nonthrowing_tcp_listener_t::linux_repeated_nonthrowing_tcp_listener_t(
     const std::set<ip_address_t> &bind_addresses,
     int port,
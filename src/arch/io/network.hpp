@@ -8,6 +8,7 @@
 #include <ifaddrs.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
 
 #include <set>
 #include <stdexcept>
@@ -105,6 +106,11 @@ public:
     pipe and throws `tcp_conn_write_closed_exc_t`. */
     void write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    /* writev() is like write(), but gathers the data from `iovcnt` separate
+    buffers and hands them to the kernel together, so that many small buffers
+    cost one system call instead of one each. */
+    void writev(const iovec *iov, size_t iovcnt, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
+
     /* write_buffered() is like write(), but it might not send the data until
     flush_buffer*() or write() is called. Internally, it bundles together the
     buffered writes; this may improve performance. */
@@ -244,6 +250,10 @@ private:
         write_buffer_t *dealloc;
         const void *buffer;
         size_t size;
+        /* If `iov` is non-NULL, `buffer` and `size` are ignored and the data
+        is gathered from the `iovcnt` buffers in `iov` instead. */
+        iovec *iov;
+        size_t iovcnt;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
     };
@@ -302,6 +312,10 @@ private:
     `size` bytes from `buffer` to the socket. */
     void perform_write(const void *buffer, size_t size);
 
+    /* Like `perform_write()`, but for a gathered write. Modifies the entries of
+    `iov` as data gets written. */
+    void perform_writev(iovec *iov, size_t iovcnt);
+
     scoped_ptr_t<auto_drainer_t> drainer;
 };
 
@@ -328,12 +342,15 @@ private:
 
 /* The linux_nonthrowing_tcp_listener_t is used to listen on a network port for incoming
 connections. Create a linux_nonthrowing_tcp_listener_t with some port and then call set_callback();
-the provided callback will be called in a new coroutine every time something connects. */
+the provided callback will be called in a new coroutine every time something connects.
+If `reuse_port` is set, the sockets are bound with SO_REUSEPORT, so several listeners
+can share a port; check `linux_tcp_reuse_port_supported()` first. */
 
 class linux_nonthrowing_tcp_listener_t : private linux_event_callback_t {
 public:
     linux_nonthrowing_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int _port,
-        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback);
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback,
+        bool _reuse_port = false);
 
     ~linux_nonthrowing_tcp_listener_t();
 
@@ -373,6 +390,9 @@ private:
     // The port we're asked to bind to
     int port;
 
+    // Whether to set SO_REUSEPORT on the sockets
+    bool reuse_port;
+
     // Inidicates successful binding to a port
     bool bound;
 
@@ -413,6 +433,46 @@ private:
     scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
 };
 
+/* Returns true if the kernel lets several sockets listen on the same port with
+SO_REUSEPORT, spreading incoming connections between them. */
+bool linux_tcp_reuse_port_supported();
+
+/* Listens on a port with one listener on each of the threads [0, num_threads), all
+bound with SO_REUSEPORT, so that the kernel spreads incoming connections across the
+threads instead of one thread accepting all of them. The callback is called on the
+thread that accepted the connection. Where SO_REUSEPORT isn't supported this falls
+back to a single listener on the constructing thread. Throws like
+linux_tcp_listener_t, including when another socket with SO_REUSEPORT already has the
+port. */
+class linux_per_thread_tcp_listener_t : public home_thread_mixin_t {
+public:
+    linux_per_thread_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
+        int num_threads,
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback);
+    ~linux_per_thread_tcp_listener_t();
+
+    int get_port() const;
+
+    // The number of threads accepting connections; 1 after falling back.
+    int num_listening_threads() const;
+
+    // Whether a listener for `num_threads` threads accepts connections on each of
+    // them, i.e. whether `num_listening_threads()` will be greater than 1.  The
+    // callback can get connections before the constructor returns, so it has to
+    // ask this instead.
+    static bool listens_per_thread(int num_threads);
+
+private:
+    threadnum_t listener_thread(int i) const;
+    void destroy_listener(int i);
+
+    scoped_array_t<scoped_ptr_t<linux_nonthrowing_tcp_listener_t> > listeners;
+    bool per_thread;
+    int port;
+
+    DISABLE_COPYING(linux_per_thread_tcp_listener_t);
+};
+
 /* Like a linux tcp listener but repeatedly tries to bind to its port until successful */
 class linux_repeated_nonthrowing_tcp_listener_t {
 public:
@@ -2,7 +2,6 @@
 #include "arch/runtime/context_switching.hpp"
 
 #include <pthread.h>
-#include <sys/mman.h>
 #include <unistd.h>
 
 #ifndef NDEBUG
@@ -38,14 +37,12 @@ bool artificial_stack_context_ref_t::is_nil() {
     return pointer == NULL;
 }
 
-artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size)
-    : stack_size(_stack_size) {
-    /* Allocate the stack */
-    stack = malloc_aligned(stack_size, getpagesize());
-
-    /* Protect the end of the stack so that we crash when we get a stack
-    overflow instead of corrupting memory. */
-    mprotect(stack, getpagesize(), PROT_NONE);
+artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size,
+                                       artificial_stack_allocator_t *_allocator)
+    : allocator(_allocator), stack_size(_stack_size) {
+    /* Allocate the stack.  Its lowest page is already protected, so that we
+    crash when we get a stack overflow instead of corrupting memory. */
+    stack = allocator->allocate(stack_size);
 
     /* Register our stack with Valgrind so that it understands what's going on
     and doesn't create spurious errors */
@@ -135,11 +132,8 @@ artificial_stack_t::~artificial_stack_t() {
 #endif
 #endif
 
-    /* Undo protections changes */
-    mprotect(stack, getpagesize(), PROT_READ | PROT_WRITE);
-
     /* Release the stack we allocated */
-    free(stack);
+    allocator->release(stack, stack_size);
 }
 
 bool artificial_stack_t::address_in_stack(void *addr) {
@@ -370,9 +364,10 @@ void threaded_context_ref_t::store_virtual_thread() {
     my_thread = linux_thread_pool_t::get_thread();
 }
 
-threaded_stack_t::threaded_stack_t(void (*initial_fun_)(void), size_t stack_size) :
+threaded_stack_t::threaded_stack_t(void (*initial_fun_)(void), size_t stack_size,
+                                   artificial_stack_allocator_t *allocator) :
     initial_fun(initial_fun_),
-    dummy_stack(initial_fun, stack_size) {
+    dummy_stack(initial_fun, stack_size, allocator) {
 
     scoped_ptr_t<system_mutex_t::lock_t> possible_lock_acq;
     if (!coro_t::self()) {
@@ -7,6 +7,7 @@
 #include "errors.hpp"
 
 #include "arch/io/concurrency.hpp"
+#include "arch/runtime/stack_allocator.hpp"
 #include "containers/scoped.hpp"
 
 
@@ -46,8 +47,10 @@ public:
     /* `artificial_stack_t()` sets up an artificial context. Once it is set up,
     you can use `context` to swap into and out of it. When you call
     `~artificial_stack_t()`, the original context must have been returned to
-    `context` again. */
-    artificial_stack_t(void (*initial_fun)(void), size_t stack_size);
+    `context` again.  The stack's memory comes from `allocator`, which must
+    outlive it. */
+    artificial_stack_t(void (*initial_fun)(void), size_t stack_size,
+                       artificial_stack_allocator_t *allocator);
     ~artificial_stack_t();
 
     artificial_stack_context_ref_t context;
@@ -65,7 +68,10 @@ public:
     /* Returns the end of the stack */
     void *get_stack_bound() { return stack; }
 
+    size_t get_stack_size() const { return stack_size; }
+
 private:
+    artificial_stack_allocator_t *allocator;
     void *stack;
     size_t stack_size;
 #ifdef VALGRIND
@@ -156,7 +162,8 @@ void context_switch(threaded_context_ref_t *current_context,
 class threaded_stack_t {
 public:
 
-    threaded_stack_t(void (*initial_fun_)(void), size_t stack_size);
+    threaded_stack_t(void (*initial_fun_)(void), size_t stack_size,
+                     artificial_stack_allocator_t *allocator);
     ~threaded_stack_t();
 
     threaded_context_ref_t context;
@@ -174,6 +181,8 @@ public:
     /* Returns the end of the stack */
     void *get_stack_bound();
 
+    size_t get_stack_size() const { return dummy_stack.get_stack_size(); }
+
 private:
     static void *internal_run(void *p);
     void get_stack_addr_size(void **stackaddr_out, size_t *stacksize_out);
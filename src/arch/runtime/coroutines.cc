@@ -3,7 +3,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <functional>
 #ifndef NDEBUG
 #include <map>
@@ -17,6 +19,7 @@
 #include "arch/runtime/thread_pool.hpp"
 #include "config/args.hpp"
 #include "do_on_thread.hpp"
+#include "math.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rethinkdb_backtrace.hpp"
 #include "thread_local.hpp"
@@ -40,8 +43,12 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
-    intrusive_list_t<coro_t> free_coros;
+    /* Where the coroutines' stacks come from.  The destructor deletes all the
+    coroutines, giving their stacks back, before this gets destroyed. */
+    artificial_stack_allocator_t stack_allocator;
+
+    /* Lists of coro_t objects that are not in use, one per `coro_stack_class_t`. */
+    intrusive_list_t<coro_t> free_coros[NUM_CORO_STACK_CLASSES];
 
 #ifndef NDEBUG
 
@@ -80,9 +87,11 @@ struct coro_globals_t {
         rassert(!current_coro);
 
         /* Destroy remaining coroutines */
-        while (coro_t *s = free_coros.head()) {
-            free_coros.remove(s);
-            delete s;
+        for (int i = 0; i < NUM_CORO_STACK_CLASSES; ++i) {
+            while (coro_t *s = free_coros[i].head()) {
+                free_coros[i].remove(s);
+                delete s;
+            }
         }
     }
 
@@ -94,9 +103,15 @@ TLS_with_init(coro_globals_t *, cglobals, NULL);
 // construction depends on coro_t::coroutines_have_been_initialized() which in turn
 // depends on cglobals.
 static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines;
+static perfmon_counter_t pm_coroutine_stack_bytes;
+// How deep a coroutine's stack has been when it called `wait()`.  It's sampled
+// there because that's cheap; a coroutine can of course go deeper in between.
+static perfmon_high_water_t pm_coroutine_stack_high_water;
 static perfmon_multi_membership_t pm_coroutines_membership(&get_global_perfmon_collection(),
     &pm_active_coroutines, "active_coroutines",
-    &pm_allocated_coroutines, "allocated_coroutines");
+    &pm_allocated_coroutines, "allocated_coroutines",
+    &pm_coroutine_stack_bytes, "allocated_coroutine_stack_bytes",
+    &pm_coroutine_stack_high_water, "coroutine_stack_high_water");
 
 coro_runtime_t::coro_runtime_t() {
     rassert(!TLS_get_cglobals(), "coro runtime initialized twice on this thread");
@@ -122,8 +137,10 @@ void coro_runtime_t::get_coroutine_counts(std::map<std::string, size_t> *dest) {
 TLS_with_init(int64_t, coro_selfname_counter, 0);
 #endif
 
-coro_t::coro_t() :
-    stack(&coro_t::run, coro_stack_size),
+coro_t::coro_t(coro_stack_class_t stack_class) :
+    stack_class_(stack_class),
+    stack(&coro_t::run, get_stack_size(stack_class),
+          &TLS_get_cglobals()->stack_allocator),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
     waiting_(false)
@@ -139,6 +156,7 @@ coro_t::coro_t() :
 #endif
 {
     ++pm_allocated_coroutines;
+    pm_coroutine_stack_bytes += stack.get_stack_size();
 
 #ifndef NDEBUG
     TLS_get_cglobals()->coro_count++;
@@ -149,14 +167,15 @@ coro_t::coro_t() :
 }
 
 void coro_t::return_coro_to_free_list(coro_t *coro) {
-    TLS_get_cglobals()->free_coros.push_back(coro);
+    TLS_get_cglobals()->free_coros[static_cast<int>(coro->stack_class_)].push_back(coro);
 }
 
-void coro_t::maybe_evict_from_free_list() {
-    coro_globals_t *cglobals = TLS_get_cglobals();
-    while (cglobals->free_coros.size() > COROUTINE_FREE_LIST_SIZE) {
-        coro_t *coro_to_delete = cglobals->free_coros.tail();
-        cglobals->free_coros.remove(coro_to_delete);
+void coro_t::maybe_evict_from_free_list(coro_stack_class_t stack_class) {
+    intrusive_list_t<coro_t> *free_coros
+        = &TLS_get_cglobals()->free_coros[static_cast<int>(stack_class)];
+    while (free_coros->size() > COROUTINE_FREE_LIST_SIZE) {
+        coro_t *coro_to_delete = free_coros->tail();
+        free_coros->remove(coro_to_delete);
         delete coro_to_delete;
     }
 }
@@ -169,6 +188,7 @@ coro_t::~coro_t() {
     TLS_get_cglobals()->coro_count--;
 #endif
     --pm_allocated_coroutines;
+    pm_coroutine_stack_bytes -= stack.get_stack_size();
 }
 
 void coro_t::run() {
@@ -246,6 +266,12 @@ void coro_t::wait() {   /* class method */
     rassert(!self()->waiting_);
     self()->waiting_ = true;
 
+#ifndef THREADED_COROUTINES
+    char dummy;
+    pm_coroutine_stack_high_water.record(
+        static_cast<char *>(self()->stack.get_stack_base()) - &dummy);
+#endif
+
     PROFILER_CORO_YIELD(1);
     if (TLS_get_cglobals()->prev_coro) {
         context_switch(&self()->stack.context, &TLS_get_cglobals()->prev_coro->stack.context);
@@ -357,6 +383,25 @@ void coro_t::set_coroutine_stack_size(size_t size) {
     coro_stack_size = size;
 }
 
+size_t coro_t::get_stack_size(coro_stack_class_t stack_class) {
+    size_t size;
+    switch (stack_class) {
+    case coro_stack_class_t::SMALL:
+        size = std::min<size_t>(SMALL_COROUTINE_STACK_SIZE, coro_stack_size);
+        break;
+    case coro_stack_class_t::REGULAR:
+        size = coro_stack_size;
+        break;
+    case coro_stack_class_t::LARGE:
+        size = std::max<size_t>(LARGE_COROUTINE_STACK_SIZE, coro_stack_size);
+        break;
+    default:
+        unreachable();
+    }
+    // Stacks are made of whole pages.
+    return ceil_aligned(size, getpagesize());
+}
+
 coro_stack_t* coro_t::get_stack() {
     return &stack;
 }
@@ -373,15 +418,17 @@ bool coroutines_have_been_initialized() {
     return TLS_get_cglobals() != NULL;
 }
 
-coro_t * coro_t::get_coro() {
+coro_t * coro_t::get_coro(coro_stack_class_t stack_class) {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (TLS_get_cglobals()->free_coros.size() == 0) {
-        coro = new coro_t();
+    intrusive_list_t<coro_t> *free_coros
+        = &TLS_get_cglobals()->free_coros[static_cast<int>(stack_class)];
+    if (free_coros->size() == 0) {
+        coro = new coro_t(stack_class);
     } else {
-        coro = TLS_get_cglobals()->free_coros.tail();
-        TLS_get_cglobals()->free_coros.remove(coro);
+        coro = free_coros->tail();
+        free_coros->remove(coro);
 
         /* We cannot easily delete coroutines at the time where we return
         them to the free list, because coro_t::run() requires the coro_t pointer to remain
@@ -393,7 +440,7 @@ coro_t * coro_t::get_coro() {
         Instead, we delete unused coroutines from the free list here. It's not perfect,
         but the important thing is that unused coroutines get evicted eventually
         so we can reclaim the memory. */
-        maybe_evict_from_free_list();
+        maybe_evict_from_free_list(stack_class);
     }
 
     rassert(!coro->intrusive_list_node_t<coro_t>::in_a_list());
@@ -23,6 +23,19 @@ const size_t MAX_COROUTINE_STACK_SIZE = 8*1024*1024;
 threadnum_t get_thread_id();
 struct coro_globals_t;
 
+/* Which size of stack a coroutine gets.  `REGULAR` stacks are
+`COROUTINE_STACK_SIZE` (or whatever `coro_t::set_coroutine_stack_size()` set).
+`SMALL` ones suit coroutines that don't recurse or call into deep library code,
+and `LARGE` ones coroutines that might recurse more deeply than usual.  Since
+stack pages are only committed when they're touched, a large stack costs address
+space more than it costs memory.  Each class has its own free list. */
+enum class coro_stack_class_t {
+    SMALL = 0,
+    REGULAR = 1,
+    LARGE = 2
+};
+const int NUM_CORO_STACK_CLASSES = 3;
+
 
 struct coro_profiler_mixin_t {
 #ifdef ENABLE_CORO_PROFILER
@@ -48,14 +61,18 @@ public:
     friend bool is_coroutine_stack_overflow(void *);
 
     template<class Callable>
-    static void spawn_now_dangerously(const Callable &action) {
-        coro_t *coro = get_and_init_coro(action);
+    static void spawn_now_dangerously(
+            const Callable &action,
+            coro_stack_class_t stack_class = coro_stack_class_t::REGULAR) {
+        coro_t *coro = get_and_init_coro(action, stack_class);
         coro->notify_now_deprecated();
     }
 
     template<class Callable>
-    static coro_t *spawn_sometime(const Callable &action) {
-        coro_t *coro = get_and_init_coro(action);
+    static coro_t *spawn_sometime(
+            const Callable &action,
+            coro_stack_class_t stack_class = coro_stack_class_t::REGULAR) {
+        coro_t *coro = get_and_init_coro(action, stack_class);
         coro->notify_sometime();
         return coro;
     }
@@ -64,15 +81,19 @@ public:
     `spawn_later_ordered()` (or `spawn_ordered()`). `spawn_later_ordered()` does not
     honor scheduler priorities. */
     template<class Callable>
-    static coro_t *spawn_later_ordered(const Callable &action) {
-        coro_t *coro = get_and_init_coro(action);
+    static coro_t *spawn_later_ordered(
+            const Callable &action,
+            coro_stack_class_t stack_class = coro_stack_class_t::REGULAR) {
+        coro_t *coro = get_and_init_coro(action, stack_class);
         coro->notify_later_ordered();
         return coro;
     }
 
     template<class Callable>
-    static void spawn_ordered(const Callable &action) {
-        spawn_later_ordered(action);
+    static void spawn_ordered(
+            const Callable &action,
+            coro_stack_class_t stack_class = coro_stack_class_t::REGULAR) {
+        spawn_later_ordered(action, stack_class);
     }
 
     // Use coro_t::spawn_*(std::bind(...)) for spawning with parameters.
@@ -134,6 +155,9 @@ public:
 
     static void set_coroutine_stack_size(size_t size);
 
+    // The size of the stacks coroutines of the given class get.
+    static size_t get_stack_size(coro_stack_class_t stack_class);
+
     coro_stack_t *get_stack();
 
     void set_priority(int _priority) {
@@ -158,15 +182,16 @@ private:
 
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
-    coro_t();
+    explicit coro_t(coro_stack_class_t stack_class);
 
     // Generates a spawn-time backtrace and stores it into `spawn_backtrace`.
     void grab_spawn_backtrace();
 
     // If this function footprint ever changes, you may need to update the parse_coroutine_info function
     template<class Callable>
-    static coro_t * get_and_init_coro(const Callable &action) {
-        coro_t *coro = get_coro();
+    static coro_t * get_and_init_coro(const Callable &action,
+                                      coro_stack_class_t stack_class) {
+        coro_t *coro = get_coro(stack_class);
 #ifndef NDEBUG
         coro->parse_coroutine_type(__PRETTY_FUNCTION__);
 #endif
@@ -185,10 +210,10 @@ private:
         return coro;
     }
 
-    static coro_t * get_coro();
+    static coro_t * get_coro(coro_stack_class_t stack_class);
 
     static void return_coro_to_free_list(coro_t *coro);
-    static void maybe_evict_from_free_list();
+    static void maybe_evict_from_free_list(coro_stack_class_t stack_class);
 
     static void run() NORETURN;
 
@@ -198,6 +223,7 @@ private:
 
     virtual void on_thread_switch();
 
+    const coro_stack_class_t stack_class_;
     coro_stack_t stack;
 
     threadnum_t current_thread_;
@@ -20,6 +20,7 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
                                          threadnum_t current_thread)
     : queue_(queue),
       thread_pool_(thread_pool),
+      incoming_messages_(NULL),
       is_woken_up_(false),
       current_thread_(current_thread) {
 
@@ -44,7 +45,7 @@ linux_message_hub_t::~linux_message_hub_t() {
         guarantee(get_priority_msg_list(p).empty());
     }
 
-    guarantee(incoming_messages_.empty());
+    guarantee(incoming_messages_ == NULL);
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
@@ -91,15 +92,30 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
-    }
+    rassert(msg->next_incoming_ == NULL);
+    push_incoming_messages(msg, msg);
+}
+
+void linux_message_hub_t::push_incoming_messages(linux_thread_message_t *newest,
+                                                 linux_thread_message_t *oldest) {
+    linux_thread_message_t *head;
+    do {
+        head = incoming_messages_;
+        oldest->next_incoming_ = head;
+    } while (!__sync_bool_compare_and_swap(&incoming_messages_, head, newest));
+
+    wake_up();
+}
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
+void linux_message_hub_t::wake_up() {
+    // Reading the flag first keeps senders from bouncing its cache line around
+    // while the thread is already awake.  This read and the compare-and-swap are
+    // ordered after the push above, and `sort_incoming_messages_by_priority()`
+    // clears the flag before taking the messages, so a message can't be left
+    // behind without a wakeup.
+    if (!__atomic_load_n(&is_woken_up_, __ATOMIC_SEQ_CST)
+        && __sync_bool_compare_and_swap(&is_woken_up_, false, true)) {
+        // Wakey wakey eggs and bakey
         event_.wakey_wakey();
     }
 }
@@ -175,36 +191,33 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
-                event_.wakey_wakey();
-            }
+            wake_up();
             break;
         }
     }
 }
 
 void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
-
-    // 1. Pull the messages
-    msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
+    // 1. Pull the messages.  The flag must be cleared first: anybody who pushes
+    // after the swap below will then see it cleared and wake us up again.
+    __atomic_store_n(&is_woken_up_, false, __ATOMIC_SEQ_CST);
+    linux_thread_message_t *newest_first
+        = __sync_lock_test_and_set(&incoming_messages_, NULL);
+
+    // 2. The stack is newest first; put the messages back in the order they were
+    // sent, which is what keeps ordered messages ordered.
+    linux_thread_message_t *oldest_first = NULL;
+    while (newest_first != NULL) {
+        linux_thread_message_t *m = newest_first;
+        newest_first = m->next_incoming_;
+        m->next_incoming_ = oldest_first;
+        oldest_first = m;
     }
 
-    // 2. Sort the messages into their respective priority queues
-    while (linux_thread_message_t *m = new_messages.head()) {
-        new_messages.remove(m);
+    // 3. Sort the messages into their respective priority queues
+    while (linux_thread_message_t *m = oldest_first) {
+        oldest_first = m->next_incoming_;
+        m->next_incoming_ = NULL;
         int effective_priority = m->priority;
         if (m->is_ordered) {
             // Ordered messages are treated as if they had
@@ -218,12 +231,6 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
     }
 }
 
-bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
-}
-
 // Pushes messages collected locally global lists available to all
 // threads.
 void linux_message_hub_t::push_messages() {
@@ -232,24 +239,19 @@ void linux_message_hub_t::push_messages() {
         // message list.
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
-            // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
+            // Chain the messages together newest first, so the whole batch can be
+            // handed to the other core with one compare-and-swap.
+            linux_thread_message_t *oldest = queue->msg_local_list.head();
+            linux_thread_message_t *newest = NULL;
+            while (linux_thread_message_t *m = queue->msg_local_list.head()) {
+                queue->msg_local_list.remove(m);
+                rassert(m->next_incoming_ == NULL);
+                m->next_incoming_ = newest;
+                newest = m;
             }
 
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
-            }
+            // Transfer messages to the other core
+            thread_pool_->threads[i]->message_hub.push_incoming_messages(newest, oldest);
         }
     }
 }
@@ -8,7 +8,6 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
 #include "threading.hpp"
@@ -69,16 +68,28 @@ private:
     struct thread_queue_t {
         //TODO this doesn't need to be a class anymore
 
-        /* Messages are cached here before being pushed to the global list so that we don't
-        have to acquire the spinlock as often */
+        /* Messages are cached here before being pushed to the other thread's incoming
+        messages so that we don't have to touch its queue as often */
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
-    bool check_and_set_is_woken_up();
+    /* Called on other threads.  Pushes a chain of messages linked through
+    `next_incoming_` (from `newest` back to `oldest`) onto `incoming_messages_`,
+    and signals `event_` unless it's already signalled. */
+    void push_incoming_messages(linux_thread_message_t *newest,
+                                linux_thread_message_t *oldest);
+    void wake_up();
+
+    /* Messages other threads have sent us, newest first, linked through their
+    `next_incoming_` fields.  It's a lock-free stack: senders push a whole batch
+    with one compare-and-swap, and `sort_incoming_messages_by_priority()` takes
+    everything with one swap. */
+    linux_thread_message_t *incoming_messages_;
+
+    /* True from the time someone signals `event_` until we next drain
+    `incoming_messages_`, so that only the first of a burst of senders writes to
+    the eventfd. */
     bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -0,0 +1,115 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/runtime/stack_allocator.hpp"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "config/args.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+artificial_stack_allocator_t::artificial_stack_allocator_t()
+    : bytes_in_use_(0), use_madv_dontneed_(false) { }
+
+artificial_stack_allocator_t::~artificial_stack_allocator_t() {
+    rassert(bytes_in_use_ == 0, "Destroying the stack allocator with stacks still in use.");
+    for (auto it = size_classes_.begin(); it != size_classes_.end(); ++it) {
+        if (it->second.num_allocated != 0) {
+            /* Some coroutine is still running on one of these stacks.  Leak the
+            regions rather than pulling the memory out from under it. */
+            continue;
+        }
+        const size_t region_size = it->second.stacks_per_region * it->first;
+        for (auto jt = it->second.regions.begin(); jt != it->second.regions.end(); ++jt) {
+            int res = munmap(*jt, region_size);
+            guarantee_err(res == 0, "munmap failed");
+        }
+    }
+}
+
+void artificial_stack_allocator_t::map_region(size_t stack_size,
+                                              size_class_t *size_class) {
+    const size_t region_size = size_class->stacks_per_region * stack_size;
+    // Nothing is committed until it's touched; `MAP_NORESERVE` keeps the kernel
+    // from accounting for the whole region up front, too.
+    void *region = mmap(NULL, region_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        crash_oom();
+    }
+    size_class->regions.push_back(region);
+
+    const size_t page_size = getpagesize();
+    // Push the stacks so that the lowest one gets handed out first.
+    for (size_t i = size_class->stacks_per_region; i-- > 0;) {
+        char *stack = static_cast<char *>(region) + i * stack_size;
+        /* Protect the end of the stack so that we crash when we get a stack
+        overflow instead of corrupting memory. */
+        int res = mprotect(stack, page_size, PROT_NONE);
+        guarantee_err(res == 0, "mprotect failed");
+        size_class->free_stacks.push_back(stack);
+    }
+}
+
+void *artificial_stack_allocator_t::allocate(size_t stack_size) {
+    const size_t page_size = getpagesize();
+    guarantee(stack_size > page_size && divides(page_size, stack_size),
+              "Bad coroutine stack size: %zu", stack_size);
+
+    auto it = size_classes_.find(stack_size);
+    if (it == size_classes_.end()) {
+        size_class_t size_class;
+        size_class.stacks_per_region
+            = std::max<size_t>(1, COROUTINE_STACK_REGION_SIZE / stack_size);
+        size_class.num_allocated = 0;
+        it = size_classes_.insert(std::make_pair(stack_size, size_class)).first;
+    }
+    size_class_t *size_class = &it->second;
+
+    if (size_class->free_stacks.empty()) {
+        map_region(stack_size, size_class);
+    }
+    void *stack = size_class->free_stacks.back();
+    size_class->free_stacks.pop_back();
+    ++size_class->num_allocated;
+    bytes_in_use_ += stack_size;
+    return stack;
+}
+
+void artificial_stack_allocator_t::release(void *stack, size_t stack_size) {
+    auto it = size_classes_.find(stack_size);
+    guarantee(it != size_classes_.end());
+    size_class_t *size_class = &it->second;
+
+    // Everything above the guard page can go back to the kernel.
+    const size_t page_size = getpagesize();
+    char *pages = static_cast<char *>(stack) + page_size;
+    const size_t pages_size = stack_size - page_size;
+#ifdef MADV_FREE
+    if (!use_madv_dontneed_) {
+        int res = madvise(pages, pages_size, MADV_FREE);
+        if (res != 0 && get_errno() == EINVAL) {
+            // The kernel is older than `MADV_FREE`.
+            use_madv_dontneed_ = true;
+        } else {
+            guarantee_err(res == 0, "madvise failed");
+        }
+    }
+    if (use_madv_dontneed_) {
+        int res = madvise(pages, pages_size, MADV_DONTNEED);
+        guarantee_err(res == 0, "madvise failed");
+    }
+#else
+    int res = madvise(pages, pages_size, MADV_DONTNEED);
+    guarantee_err(res == 0, "madvise failed");
+#endif
+
+    size_class->free_stacks.push_back(stack);
+    rassert(size_class->num_allocated > 0);
+    --size_class->num_allocated;
+    rassert(bytes_in_use_ >= stack_size);
+    bytes_in_use_ -= stack_size;
+}
@@ -0,0 +1,63 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_STACK_ALLOCATOR_HPP_
+#define ARCH_RUNTIME_STACK_ALLOCATOR_HPP_
+
+#include <map>
+#include <vector>
+
+#include "errors.hpp"
+
+/* `artificial_stack_allocator_t` hands out the memory for `artificial_stack_t`s.
+
+Stacks are carved out of large regions of address space that get mapped once, so
+a stack's pages are only committed when the coroutine running on it first touches
+them, and handing out or taking back a stack doesn't take an `mmap()`,
+`mprotect()`, or `munmap()`.  Every stack has a guard page at its low end, which
+is protected when the region is mapped.  When a stack is given back, its pages are
+released with `MADV_FREE` (or `MADV_DONTNEED`, where that's not supported), so the
+kernel can reclaim them if it needs to while the stack sits in the free list.
+Stacks are only given back when their `coro_t` is deleted; the idle coroutines
+that `coro_t` keeps on its own free lists hold on to their stacks' pages.
+
+There is one per thread (see `coro_globals_t`); it's not thread-safe. */
+
+class artificial_stack_allocator_t {
+public:
+    artificial_stack_allocator_t();
+
+    /* All stacks should have been released by now.  Regions that still have
+    stacks in use are leaked rather than unmapped. */
+    ~artificial_stack_allocator_t();
+
+    /* Returns the low end of a stack of `stack_size` bytes, the first page of
+    which is the protected guard page.  `stack_size` must be a multiple of the
+    page size. */
+    void *allocate(size_t stack_size);
+
+    /* Gives back a stack that `allocate()` returned for the same size. */
+    void release(void *stack, size_t stack_size);
+
+    /* The total size of the stacks that are currently handed out. */
+    size_t bytes_in_use() const { return bytes_in_use_; }
+
+private:
+    struct size_class_t {
+        std::vector<void *> free_stacks;
+        // The mapped regions, each `stacks_per_region * stack_size` bytes long.
+        std::vector<void *> regions;
+        size_t stacks_per_region;
+        size_t num_allocated;
+    };
+
+    void map_region(size_t stack_size, size_class_t *size_class);
+
+    std::map<size_t, size_class_t> size_classes_;
+    size_t bytes_in_use_;
+
+    // Set once `MADV_FREE` turns out not to be supported by the kernel.
+    bool use_madv_dontneed_;
+
+    DISABLE_COPYING(artificial_stack_allocator_t);
+};
+
+#endif  // ARCH_RUNTIME_STACK_ALLOCATOR_HPP_
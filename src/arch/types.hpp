@@ -87,6 +87,9 @@ typedef linux_nonthrowing_tcp_listener_t non_throwing_tcp_listener_t;
 class linux_tcp_listener_t;
 typedef linux_tcp_listener_t tcp_listener_t;
 
+class linux_per_thread_tcp_listener_t;
+typedef linux_per_thread_tcp_listener_t per_thread_tcp_listener_t;
+
 class linux_repeated_nonthrowing_tcp_listener_t;
 typedef linux_repeated_nonthrowing_tcp_listener_t repeated_nonthrowing_tcp_listener_t;
 
@@ -101,6 +104,24 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which disk manager runs the I/O requests at the bottom of the I/O stack.
+enum class io_backend_t {
+    // Blocking syscalls on a thread pool.
+    pool,
+    // The kernel's asynchronous I/O interface, falling back to `pool` if it's not
+    // available.
+    native
+};
+
+// Which thread an accepted client connection is served on.
+enum class conn_placement_t {
+    // The thread that accepted it.  The kernel spreads connections across the
+    // threads' listening sockets; without SO_REUSEPORT this is round-robin.
+    accepting_thread,
+    // The thread currently serving the fewest connections.
+    least_loaded_thread
+};
+
 
 
 class semantic_checking_file_t {
@@ -128,6 +149,9 @@ public:
     virtual int64_t get_size() = 0;
     virtual void set_size(int64_t size) = 0;
     virtual void set_size_at_least(int64_t size) = 0;
+    /* Grows the file to at least `size` bytes and reserves the blocks on disk,
+    without syncing anything.  Must be called from a coroutine. */
+    virtual void preallocate(int64_t size) = 0;
 
     virtual void read_async(int64_t offset, size_t length, void *buf,
                             file_account_t *account, linux_iocallback_t *cb) = 0;
@@ -4,6 +4,7 @@
 #include <functional>
 
 #include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "containers/scoped.hpp"
 #include "utils.hpp"
 
@@ -56,3 +57,34 @@ progress_completion_fraction_t traversal_progress_combiner_t::guess_completion()
 
     return progress_completion_fraction_t(released, total);
 }
+
+void traversal_progress_combiner_t::get_constituent_transferred(int i, std::vector<std::pair<int64_t, int64_t> > *outputs) const {
+    guarantee(size_t(i) < constituents.size());
+    rassert(size_t(i) < outputs->size());
+    guarantee(!is_destructing);
+
+    on_thread_t th(constituents[i]->home_thread());
+    (*outputs)[i] = std::make_pair(constituents[i]->get_keys_transferred(),
+                                   constituents[i]->get_bytes_transferred());
+}
+
+backfill_throughput_t traversal_progress_combiner_t::guess_throughput() const {
+    assert_thread();
+    guarantee(!is_destructing);
+
+    std::vector<std::pair<int64_t, int64_t> > transferred(constituents.size());
+    pmap(transferred.size(), std::bind(&traversal_progress_combiner_t::get_constituent_transferred, this, ph::_1, &transferred));
+
+    int64_t keys = get_keys_transferred();
+    int64_t bytes = get_bytes_transferred();
+    for (auto it = transferred.begin(); it != transferred.end(); ++it) {
+        keys += it->first;
+        bytes += it->second;
+    }
+
+    const double secs = ticks_to_secs(get_ticks() - start_ticks);
+    if (secs <= 0) {
+        return backfill_throughput_t();
+    }
+    return backfill_throughput_t(keys / secs, bytes / (secs * MEGABYTE));
+}
@@ -2,10 +2,13 @@
 #ifndef BACKFILL_PROGRESS_HPP_
 #define BACKFILL_PROGRESS_HPP_
 
+#include <utility>
 #include <vector>
 
 #include "errors.hpp"
+#include "rpc/serialize_macros.hpp"
 #include "threading.hpp"
+#include "time.hpp"
 
 template <class> class scoped_ptr_t;
 
@@ -22,33 +25,63 @@ struct progress_completion_fraction_t {
     bool invalid() const { return estimate_of_total_nodes == -1; }
 };
 
+// How fast a backfill has been sending rows so far, averaged over the whole backfill.
+struct backfill_throughput_t {
+    backfill_throughput_t() : keys_per_sec(0), mb_per_sec(0) { }
+    backfill_throughput_t(double _keys_per_sec, double _mb_per_sec)
+        : keys_per_sec(_keys_per_sec), mb_per_sec(_mb_per_sec) { }
+
+    double keys_per_sec;
+    double mb_per_sec;
+
+    RDB_MAKE_ME_SERIALIZABLE_2(keys_per_sec, mb_per_sec);
+};
+
 // TODO: Rename this to traversal_progress_t after it has been pushed
 // and merged into rdb_protocol.
 class traversal_progress_t : public home_thread_mixin_t {
 public:
-    traversal_progress_t() { }
+    traversal_progress_t() : keys_transferred(0), bytes_transferred(0) { }
     explicit traversal_progress_t(threadnum_t specified_home_thread)
-        : home_thread_mixin_t(specified_home_thread) { }
+        : home_thread_mixin_t(specified_home_thread),
+          keys_transferred(0), bytes_transferred(0) { }
 
     virtual progress_completion_fraction_t guess_completion() const = 0;
 
+    // Called by whoever hands the traversed rows on (e.g. to a backfillee).
+    void record_transferred(int64_t keys, int64_t bytes) {
+        assert_thread();
+        keys_transferred += keys;
+        bytes_transferred += bytes;
+    }
+    int64_t get_keys_transferred() const { assert_thread(); return keys_transferred; }
+    int64_t get_bytes_transferred() const { assert_thread(); return bytes_transferred; }
+
     // This actually gets used, by traversal_progress_combiner_t.
     virtual ~traversal_progress_t() { }
 private:
+    int64_t keys_transferred;
+    int64_t bytes_transferred;
+
     DISABLE_COPYING(traversal_progress_t);
 };
 
 class traversal_progress_combiner_t : public traversal_progress_t {
 public:
     explicit traversal_progress_combiner_t(threadnum_t specified_home_thread)
-        : traversal_progress_t(specified_home_thread), is_destructing(false) { }
-    traversal_progress_combiner_t() : is_destructing(false) { }
+        : traversal_progress_t(specified_home_thread),
+          start_ticks(get_ticks()), is_destructing(false) { }
+    traversal_progress_combiner_t() : start_ticks(get_ticks()), is_destructing(false) { }
     ~traversal_progress_combiner_t();
 
     // The constituent is welcome to have a different home thread.
     void add_constituent(scoped_ptr_t<traversal_progress_t> *constituent);
     progress_completion_fraction_t guess_completion() const;
 
+    // Sums up what the constituents have transferred since this combiner was
+    // constructed.
+    backfill_throughput_t guess_throughput() const;
+
 private:
     // Used in a pmap by the destructor.
     void destroy_constituent(int i);
@@ -57,9 +90,14 @@ private:
     // constituent's home thread.
     void get_constituent_fraction(int i, std::vector<progress_completion_fraction_t> *outputs) const;
 
+    // Used by guess_throughput in the same way.
+    void get_constituent_transferred(int i, std::vector<std::pair<int64_t, int64_t> > *outputs) const;
+
     // constituents _owns_ these pointers.
     std::vector<traversal_progress_t *> constituents;
 
+    ticks_t start_ticks;
+
     bool is_destructing;
 
     DISABLE_COPYING(traversal_progress_combiner_t);
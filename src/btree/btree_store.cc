@@ -4,6 +4,7 @@
 #include "btree/operations.hpp"
 #include "btree/secondary_operations.hpp"
 #include "buffer_cache/alt/alt.hpp"
+#include "buffer_cache/alt/cache_balancer.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/disk_backed_queue.hpp"
@@ -26,6 +27,7 @@ template <class protocol_t>
 btree_store_t<protocol_t>::btree_store_t(serializer_t *serializer,
                                          const std::string &perfmon_name,
                                          int64_t cache_target,
+                                         alt_cache_balancer_t *balancer,
                                          bool create,
                                          perfmon_collection_t *parent_perfmon_collection,
                                          typename protocol_t::context_t *,
@@ -34,12 +36,26 @@ btree_store_t<protocol_t>::btree_store_t(serializer_t *serializer,
     : store_view_t<protocol_t>(protocol_t::region_t::universe()),
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
-      perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name)
+      perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
+      pm_read_latency(secs_to_ticks(10)),
+      pm_write_latency(secs_to_ticks(10)),
+      pm_latency_membership(&perfmon_collection,
+                            &pm_read_latency, "read_latency",
+                            &pm_write_latency, "write_latency")
 {
     {
         alt_cache_config_t config;
         config.page_config.memory_limit = cache_target;
-        cache.init(new cache_t(serializer, config, &perfmon_collection));
+        // Table caches see both point queries and whole-table traversals.
+        config.page_config.eviction_policy = eviction_policy_t::two_queue;
+        // If there's a balancer it moves memory between this table and the
+        // others, within the bounds the server was started with.
+        if (balancer != NULL) {
+            balancer->bounds().memory_limits_for(cache_target,
+                                                 &config.page_config.min_memory_limit,
+                                                 &config.page_config.max_memory_limit);
+        }
+        cache.init(new cache_t(serializer, config, balancer, &perfmon_collection));
         general_cache_conn.init(new cache_conn_t(cache.get()));
     }
 
@@ -105,6 +121,7 @@ void btree_store_t<protocol_t>::read(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    block_pm_histogram latency(&pm_read_latency);
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> superblock;
 
@@ -130,6 +147,7 @@ void btree_store_t<protocol_t>::write(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    block_pm_histogram latency(&pm_write_latency);
 
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> real_superblock;
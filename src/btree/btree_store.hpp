@@ -25,6 +25,7 @@
 
 struct rdb_protocol_t;
 template <class T> class btree_store_t;
+class alt_cache_balancer_t;
 class btree_slice_t;
 class cache_conn_t;
 class cache_t;
@@ -51,6 +52,7 @@ public:
     btree_store_t(serializer_t *serializer,
                   const std::string &perfmon_name,
                   int64_t cache_target,
+                  alt_cache_balancer_t *balancer,
                   bool create,
                   perfmon_collection_t *parent_perfmon_collection,
                   typename protocol_t::context_t *,
@@ -343,6 +345,9 @@ public:
     io_backender_t *io_backender_;
     base_path_t base_path_;
     perfmon_membership_t perfmon_collection_membership;
+    // Time spent in `read()` and `write()`, including the superblock wait.
+    perfmon_histogram_t pm_read_latency, pm_write_latency;
+    perfmon_multi_membership_t pm_latency_membership;
 
     boost::ptr_map<const std::string, btree_slice_t> secondary_index_slices;
 
@@ -0,0 +1,167 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "btree/bulk_load.hpp"
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/operations.hpp"
+
+btree_bulk_loader_t::btree_bulk_loader_t(value_sizer_t<void> *sizer)
+    : sizer_(sizer), superblock_(NULL), started_(false), keys_added_(0),
+      population_change_(0) { }
+
+void btree_bulk_loader_t::begin(superblock_t *superblock) {
+    guarantee(superblock_ == NULL, "btree_bulk_loader_t::begin called twice.");
+    superblock_ = superblock;
+
+    if (!started_) {
+        guarantee(superblock_->get_root_block_id() == NULL_BLOCK_ID,
+                  "Bulk loading into a btree that isn't empty.");
+        started_ = true;
+        return;
+    }
+
+    if (spine_ids_.empty()) {
+        return;
+    }
+
+    guarantee(superblock_->get_root_block_id() == spine_ids_.back(),
+              "The btree got modified while it was being bulk loaded.");
+    // Acquire the spine top-down, like any other write would.
+    spine_.resize(spine_ids_.size());
+    for (size_t i = spine_ids_.size(); i-- > 0;) {
+        if (i + 1 == spine_ids_.size()) {
+            spine_[i] = buf_lock_t(superblock_->expose_buf(), spine_ids_[i],
+                                   access_t::write);
+        } else {
+            spine_[i] = buf_lock_t(&spine_[i + 1], spine_ids_[i], access_t::write);
+        }
+    }
+}
+
+void btree_bulk_loader_t::add(const btree_key_t *key, const void *value) {
+    rassert(superblock_ != NULL);
+
+    if (spine_.empty()) {
+        buf_lock_t leaf = create_leaf();
+        spine_ids_.push_back(leaf.block_id());
+        spine_.push_back(std::move(leaf));
+    } else {
+        rassert(btree_key_cmp(last_key_.btree_key(), key) < 0,
+                "Keys must be bulk loaded in ascending order.");
+        bool full;
+        {
+            buf_read_t read(&spine_[0]);
+            full = leaf::is_full(sizer_,
+                                 static_cast<const leaf_node_t *>(read.get_data_read()),
+                                 key, value);
+        }
+        if (full) {
+            // Equality takes the left branch, so the last key of the full leaf
+            // separates it from the new one.
+            add_to_level(1, create_leaf(), last_key_.btree_key());
+        }
+    }
+
+    {
+        buf_write_t write(&spine_[0]);
+        leaf::insert(sizer_, static_cast<leaf_node_t *>(write.get_data_write()),
+                     key, value, repli_timestamp_t::distant_past,
+                     key_modification_proof_t::real_proof());
+    }
+
+    last_key_.assign(key);
+    ++keys_added_;
+    ++population_change_;
+}
+
+void btree_bulk_loader_t::end() {
+    rassert(superblock_ != NULL);
+
+    if (!spine_ids_.empty()
+        && superblock_->get_root_block_id() != spine_ids_.back()) {
+        insert_root(spine_ids_.back(), superblock_);
+    }
+
+    if (population_change_ != 0) {
+        ensure_stat_block(superblock_);
+        // The stat block is detached from the rest of the btree, see
+        // `apply_keyvalue_change`.
+        buf_lock_t stat_block(buf_parent_t(superblock_->expose_buf().txn()),
+                              superblock_->get_stat_block_id(), access_t::write);
+        buf_write_t stat_block_write(&stat_block);
+        static_cast<btree_statblock_t *>(stat_block_write.get_data_write())->population
+            += population_change_;
+        population_change_ = 0;
+    }
+
+    spine_.clear();
+    superblock_ = NULL;
+}
+
+buf_lock_t btree_bulk_loader_t::create_leaf() {
+    buf_lock_t leaf(superblock_->expose_buf(), alt_create_t::create);
+    buf_write_t write(&leaf);
+    leaf::init(sizer_, static_cast<leaf_node_t *>(write.get_data_write()));
+    return leaf;
+}
+
+void btree_bulk_loader_t::add_to_level(size_t level, buf_lock_t &&child,
+                                       const btree_key_t *separator) {
+    rassert(level > 0 && level <= spine_.size());
+    const block_size_t block_size = sizer_->block_size();
+    const block_id_t child_id = child.block_id();
+
+    if (level == spine_.size()) {
+        // The tree grows a level.
+        buf_lock_t root(superblock_->expose_buf(), alt_create_t::create);
+        {
+            buf_write_t write(&root);
+            internal_node_t *node = static_cast<internal_node_t *>(write.get_data_write());
+            internal_node::init(block_size, node);
+            const bool inserted = internal_node::insert(block_size, node, separator,
+                                                        spine_ids_[level - 1], child_id);
+            guarantee(inserted);
+        }
+        spine_ids_.push_back(root.block_id());
+        spine_.push_back(std::move(root));
+    } else {
+        bool sealed = false;
+        store_key_t upper_bound;
+        {
+            buf_write_t write(&spine_[level]);
+            internal_node_t *node = static_cast<internal_node_t *>(write.get_data_write());
+            if (!internal_node::is_full(node)) {
+                const bool inserted = internal_node::insert(block_size, node, separator,
+                                                            spine_ids_[level - 1],
+                                                            child_id);
+                guarantee(inserted);
+            } else {
+                // The open node is done.  Its last child moves over to the next
+                // node, and the key in front of it becomes the node's upper bound.
+                rassert(node->npairs >= 2);
+                upper_bound.assign(
+                    &internal_node::get_pair_by_index(node, node->npairs - 2)->key);
+                internal_node::remove(block_size, node, separator);
+                sealed = true;
+            }
+        }
+
+        if (sealed) {
+            buf_lock_t sibling(superblock_->expose_buf(), alt_create_t::create);
+            {
+                buf_write_t write(&sibling);
+                internal_node_t *node
+                    = static_cast<internal_node_t *>(write.get_data_write());
+                internal_node::init(block_size, node);
+                const bool inserted = internal_node::insert(block_size, node, separator,
+                                                            spine_ids_[level - 1],
+                                                            child_id);
+                guarantee(inserted);
+            }
+            add_to_level(level + 1, std::move(sibling), upper_bound.btree_key());
+        }
+    }
+
+    spine_ids_[level - 1] = child_id;
+    spine_[level - 1] = std::move(child);
+}
@@ -0,0 +1,63 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef BTREE_BULK_LOAD_HPP_
+#define BTREE_BULK_LOAD_HPP_
+
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "btree/node.hpp"
+#include "buffer_cache/alt/alt.hpp"
+
+class superblock_t;
+
+/* `btree_bulk_loader_t` builds a btree bottom-up out of keys that come in sorted
+order, instead of inserting them one by one.  Leaves get filled up completely
+before the next one is started, and internal nodes likewise, so the resulting tree
+is as small and as shallow as it gets.
+
+Only the right-most node of each level (the "spine") is ever open.  The loading can
+be spread over many transactions: call `begin()` with the tree's superblock at the
+start of each one and `end()` before it gets committed.  The tree is consistent
+after every `end()`, so if we crash in between we're left with a smaller but valid
+tree.  Nothing else may modify the tree while it's being loaded. */
+class btree_bulk_loader_t {
+public:
+    explicit btree_bulk_loader_t(value_sizer_t<void> *sizer);
+
+    // Acquires the spine.  The first call expects the tree to be empty.
+    void begin(superblock_t *superblock);
+
+    // Appends a key-value pair to the tree.  `key` must be greater than all keys
+    // that were added before.
+    void add(const btree_key_t *key, const void *value);
+
+    // Sets the root, updates the stat block and releases the spine.
+    void end();
+
+    int64_t keys_added() const { return keys_added_; }
+
+private:
+    buf_lock_t create_leaf();
+    // Adds `child` to the open node at `level`, right after the current last child,
+    // with `separator` in between them.  Seals the open node and starts a new one if
+    // it's full.
+    void add_to_level(size_t level, buf_lock_t &&child, const btree_key_t *separator);
+
+    value_sizer_t<void> *sizer_;
+
+    superblock_t *superblock_;
+    // `spine_[0]` is the open leaf, and `spine_.back()` the root.  The block ids
+    // are kept across transactions, the locks only between `begin()` and `end()`.
+    std::vector<block_id_t> spine_ids_;
+    std::vector<buf_lock_t> spine_;
+
+    bool started_;
+    store_key_t last_key_;
+    int64_t keys_added_;
+    // Keys added since the last `end()`, for the stat block.
+    int64_t population_change_;
+
+    DISABLE_COPYING(btree_bulk_loader_t);
+};
+
+#endif  // BTREE_BULK_LOAD_HPP_
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 
+#include "btree/key_search_index.hpp"
 #include "btree/node.hpp"
 
 //In this tree, less than or equal takes the left-hand branch and greater than takes the right hand branch
@@ -47,6 +48,33 @@ block_id_t lookup(const internal_node_t *node, const btree_key_t *key) {
     return get_pair_by_index(node, index)->lnode;
 }
 
+// Gives `key_search_index_t` the keys of an internal node, in order, leaving out
+// the last pair's empty key.
+class pair_key_at_t {
+public:
+    explicit pair_key_at_t(const internal_node_t *node) : node_(node) { }
+    const btree_key_t *operator()(int i) const {
+        return &get_pair_by_index(node_, i)->key;
+    }
+private:
+    const internal_node_t *node_;
+};
+
+void build_key_search_index(const internal_node_t *node, key_search_index_t *index) {
+    index->build(node->npairs - 1, pair_key_at_t(node));
+}
+
+block_id_t lookup(const internal_node_t *node, const btree_key_t *key,
+                  const key_search_index_t *search_index) {
+    if (search_index == NULL) {
+        return lookup(node, key);
+    }
+    rassert(search_index->num_keys() == node->npairs - 1);
+    bool equal;
+    int index = search_index->lower_bound(key, pair_key_at_t(node), &equal);
+    return get_pair_by_index(node, index)->lnode;
+}
+
 // TODO: If it's unused, let's get rid of it.
 bool insert(UNUSED block_size_t block_size, internal_node_t *node, const btree_key_t *key, block_id_t lnode, block_id_t rnode) {
     //TODO: write a unit test for this
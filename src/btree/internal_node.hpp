@@ -7,6 +7,7 @@
 #include "utils.hpp"
 
 struct internal_node_t;
+class key_search_index_t;
 
 // See internal_node_t in node.hpp
 
@@ -29,6 +30,11 @@ void init(block_size_t block_size, internal_node_t *node);
 void init(block_size_t block_size, internal_node_t *node, const internal_node_t *lnode, const uint16_t *offsets, int numpairs);
 
 block_id_t lookup(const internal_node_t *node, const btree_key_t *key);
+// Like `lookup()`, but searches with `index` if it isn't NULL.  `index` must have
+// been built from `node` by `build_key_search_index()`.
+block_id_t lookup(const internal_node_t *node, const btree_key_t *key,
+                  const key_search_index_t *index);
+void build_key_search_index(const internal_node_t *node, key_search_index_t *index);
 bool insert(block_size_t block_size, internal_node_t *node, const btree_key_t *key, block_id_t lnode, block_id_t rnode);
 bool remove(block_size_t block_size, internal_node_t *node, const btree_key_t *key);
 void split(block_size_t block_size, internal_node_t *node, internal_node_t *rnode, btree_key_t *median);
@@ -0,0 +1,45 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "btree/key_search_index.hpp"
+
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "buffer_cache/alt/alt.hpp"
+
+static void build_key_search_index(const leaf_node_t *node, key_search_index_t *index) {
+    leaf::build_key_search_index(node, index);
+}
+
+static void build_key_search_index(const internal_node_t *node, key_search_index_t *index) {
+    internal_node::build_key_search_index(node, index);
+}
+
+template <class node_t>
+const key_search_index_t *get_key_search_index_impl(buf_read_t *read,
+                                                    const node_t *node) {
+    if (!read->keeps_aux_data()) {
+        return NULL;
+    }
+    page_aux_data_t *aux = read->get_aux_data();
+    if (aux == NULL) {
+        scoped_ptr_t<key_search_index_t> index = make_scoped<key_search_index_t>();
+        build_key_search_index(node, index.get());
+        const key_search_index_t *res = index.get();
+        read->set_aux_data(std::move(index));
+        return res;
+    }
+
+    // Search indexes are the only aux data btree pages get.
+    rassert(dynamic_cast<key_search_index_t *>(aux) != NULL);
+    return static_cast<key_search_index_t *>(aux);
+}
+
+const key_search_index_t *get_key_search_index(buf_read_t *read,
+                                               const leaf_node_t *node) {
+    return get_key_search_index_impl(read, node);
+}
+
+const key_search_index_t *get_key_search_index(buf_read_t *read,
+                                               const internal_node_t *node) {
+    return get_key_search_index_impl(read, node);
+}
@@ -0,0 +1,156 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef BTREE_KEY_SEARCH_INDEX_HPP_
+#define BTREE_KEY_SEARCH_INDEX_HPP_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "buffer_cache/alt/page_aux_data.hpp"
+#include "containers/scoped.hpp"
+
+class buf_read_t;
+struct internal_node_t;
+struct leaf_node_t;
+
+/* A `key_search_index_t` speeds up key searches in one btree node.  Searching a
+node directly means chasing a pair offset into the node body and comparing full
+keys at every step of the binary search, which touches a different cache line each
+time.  The index keeps, in one contiguous array, the eight bytes of every key that
+follow the prefix all of the node's keys share.  Most searches are settled by a
+binary search of that array, and only compare full keys when several keys have
+the same eight bytes there.
+
+The index is attached to the node's page with `buf_read_t::set_aux_data()`, so
+it is built once and reused until the page is modified or evicted.  Its memory
+counts against the cache's memory limit. */
+class key_search_index_t : public page_aux_data_t {
+public:
+    // Makes an index that hasn't been built yet.
+    key_search_index_t() : built_(false), common_prefix_size_(0) { }
+
+    // `key_at(i)` returns the i'th of `num_keys` keys, which must be in ascending
+    // order.
+    template <class key_at_t>
+    void build(int num_keys, const key_at_t &key_at);
+
+    bool is_built() const { return built_; }
+    int num_keys() const { return windows_.size(); }
+
+    size_t memory_usage() const {
+        return sizeof(*this) + windows_.capacity() * sizeof(uint64_t);
+    }
+
+    // Returns the index of the first key that is not less than `key` (like
+    // `std::lower_bound`), and sets `*equal_out` to whether that key is equal to
+    // `key`.  `key_at` must give the same keys that were passed to `build()`.
+    template <class key_at_t>
+    int lower_bound(const btree_key_t *key, const key_at_t &key_at,
+                    bool *equal_out) const;
+
+private:
+    // The bytes of `contents` at `offset` through `offset + 7`, big-endian, with
+    // zeros past the end of the key.  Comparing two windows compares those bytes
+    // of the keys, except that a key that ends inside the window compares equal
+    // to the same key followed by zero bytes.
+    static uint64_t window(const uint8_t *contents, int size, int offset) {
+        uint64_t res = 0;
+        for (int i = offset; i < offset + 8; ++i) {
+            res = (res << 8) | (i < size ? contents[i] : 0);
+        }
+        return res;
+    }
+
+    bool built_;
+    // Every key in the node begins with these bytes.
+    uint8_t common_prefix_size_;
+    uint8_t common_prefix_[MAX_KEY_SIZE];
+    // The window of each key just after the common prefix.
+    std::vector<uint64_t> windows_;
+
+    DISABLE_COPYING(key_search_index_t);
+};
+
+template <class key_at_t>
+void key_search_index_t::build(int num_keys, const key_at_t &key_at) {
+    rassert(!built_);
+    built_ = true;
+    if (num_keys == 0) {
+        return;
+    }
+
+    // The keys are sorted, so what the first and last key have in common, all of
+    // them have.
+    const btree_key_t *first = key_at(0);
+    const btree_key_t *last = key_at(num_keys - 1);
+    int prefix = 0;
+    const int max_prefix = std::min(first->size, last->size);
+    while (prefix < max_prefix && first->contents[prefix] == last->contents[prefix]) {
+        ++prefix;
+    }
+    common_prefix_size_ = prefix;
+    memcpy(common_prefix_, first->contents, prefix);
+
+    windows_.resize(num_keys);
+    for (int i = 0; i < num_keys; ++i) {
+        const btree_key_t *k = key_at(i);
+        windows_[i] = window(k->contents, k->size, prefix);
+    }
+}
+
+template <class key_at_t>
+int key_search_index_t::lower_bound(const btree_key_t *key, const key_at_t &key_at,
+                                    bool *equal_out) const {
+    rassert(built_);
+    *equal_out = false;
+    const int n = windows_.size();
+    if (n == 0) {
+        return 0;
+    }
+
+    // Keys that don't start with the common prefix sort before or after all the
+    // node's keys.
+    const int cmp_size = std::min<int>(key->size, common_prefix_size_);
+    const int prefix_res = memcmp(key->contents, common_prefix_, cmp_size);
+    if (prefix_res < 0 || (prefix_res == 0 && key->size < common_prefix_size_)) {
+        return 0;
+    } else if (prefix_res > 0) {
+        return n;
+    }
+
+    // Keys whose window is less than `key`'s are less than `key`, and keys whose
+    // window is greater are greater.  Only keys with an equal window need a full
+    // comparison.
+    const uint64_t w = window(key->contents, key->size, common_prefix_size_);
+    std::vector<uint64_t>::const_iterator lo_it
+        = std::lower_bound(windows_.begin(), windows_.end(), w);
+    int lo = lo_it - windows_.begin();
+    int hi = std::upper_bound(lo_it, windows_.end(), w) - windows_.begin();
+
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const btree_key_t *k = key_at(mid);
+        const int res = sized_strcmp(k->contents, k->size, key->contents, key->size);
+        if (res < 0) {
+            lo = mid + 1;
+        } else {
+            // Keys are unique, so if `k` equals `key` it's the lower bound.
+            *equal_out = (res == 0);
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Return the search index attached to the node being read by `read`, building and
+attaching it if the node doesn't have one yet.  Returns NULL for locks that don't
+have read access. */
+const key_search_index_t *get_key_search_index(buf_read_t *read,
+                                               const leaf_node_t *node);
+const key_search_index_t *get_key_search_index(buf_read_t *read,
+                                               const internal_node_t *node);
+
+#endif  // BTREE_KEY_SEARCH_INDEX_HPP_
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 
+#include "btree/key_search_index.hpp"
 #include "btree/node.hpp"
 #include "repli_timestamp.hpp"
 #include "utils.hpp"
@@ -1121,6 +1122,33 @@ bool is_mergable(value_sizer_t<void> *sizer, const leaf_node_t *node, const leaf
 // for the key, or to the index the key would have if it were
 // inserted.  Returns true if the key at said index is actually equal.
 bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
+    return find_key(node, key, NULL, index_out);
+}
+
+// Gives `key_search_index_t` the keys of a leaf node, in order.
+class entry_key_at_t {
+public:
+    explicit entry_key_at_t(const leaf_node_t *node) : node_(node) { }
+    const btree_key_t *operator()(int i) const {
+        return entry_key(get_entry(node_, node_->pair_offsets[i]));
+    }
+private:
+    const leaf_node_t *node_;
+};
+
+void build_key_search_index(const leaf_node_t *node, key_search_index_t *index) {
+    index->build(node->num_pairs, entry_key_at_t(node));
+}
+
+bool find_key(const leaf_node_t *node, const btree_key_t *key,
+              const key_search_index_t *index, int *index_out) {
+    if (index != NULL) {
+        rassert(index->num_keys() == node->num_pairs);
+        bool equal;
+        *index_out = index->lower_bound(key, entry_key_at_t(node), &equal);
+        return equal;
+    }
+
     int beg = 0;
     int end = node->num_pairs;
 
@@ -1156,8 +1184,13 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
 }
 
 bool lookup(value_sizer_t<void> *sizer, const leaf_node_t *node, const btree_key_t *key, void *value_out) {
+    return lookup(sizer, node, key, NULL, value_out);
+}
+
+bool lookup(value_sizer_t<void> *sizer, const leaf_node_t *node, const btree_key_t *key,
+            const key_search_index_t *search_index, void *value_out) {
     int index;
-    if (find_key(node, key, &index)) {
+    if (find_key(node, key, search_index, &index)) {
         const entry_t *ent = get_entry(node, node->pair_offsets[index]);
         if (entry_is_live(ent)) {
             const void *val = entry_value(ent);
@@ -12,6 +12,7 @@
 template <class> class value_sizer_t;
 struct btree_key_t;
 class repli_timestamp_t;
+class key_search_index_t;
 
 // TODO: Could key_modification_proof_t not go in this file?
 
@@ -137,8 +138,18 @@ bool is_mergable(value_sizer_t<void> *sizer, const leaf_node_t *node, const leaf
 
 bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out);
 
+// Like `find_key()`, but searches with `index` if it isn't NULL.  `index` must have
+// been built from `node` by `build_key_search_index()`.
+bool find_key(const leaf_node_t *node, const btree_key_t *key,
+              const key_search_index_t *index, int *index_out);
+
 bool lookup(value_sizer_t<void> *sizer, const leaf_node_t *node, const btree_key_t *key, void *value_out);
 
+bool lookup(value_sizer_t<void> *sizer, const leaf_node_t *node, const btree_key_t *key,
+            const key_search_index_t *index, void *value_out);
+
+void build_key_search_index(const leaf_node_t *node, key_search_index_t *index);
+
 void insert(value_sizer_t<void> *sizer, leaf_node_t *node, const btree_key_t *key, const void *value, repli_timestamp_t tstamp, UNUSED key_modification_proof_t km_proof);
 
 void remove(value_sizer_t<void> *sizer, leaf_node_t *node, const btree_key_t *key, repli_timestamp_t tstamp, key_modification_proof_t km_proof);
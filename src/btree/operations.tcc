@@ -2,6 +2,7 @@
 #include "btree/operations.hpp"
 
 #include "btree/internal_node.hpp"
+#include "btree/key_search_index.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "btree/slice.hpp"
@@ -163,8 +164,9 @@ void find_keyvalue_location_for_read(
                 break;
             }
 
-            node_id = internal_node::lookup(static_cast<const internal_node_t *>(data),
-                                            key);
+            const internal_node_t *node = static_cast<const internal_node_t *>(data);
+            node_id = internal_node::lookup(node, key,
+                                            get_key_search_index(&read, node));
         }
         rassert(node_id != NULL_BLOCK_ID && node_id != SUPERBLOCK_ID);
 
@@ -190,7 +192,8 @@ void find_keyvalue_location_for_read(
         buf_read_t read(&buf);
         const leaf_node_t *leaf
             = static_cast<const leaf_node_t *>(read.get_data_read());
-        value_found = leaf::lookup(&sizer, leaf, key, value.get());
+        value_found = leaf::lookup(&sizer, leaf, key,
+                                   get_key_search_index(&read, leaf), value.get());
     }
     if (value_found) {
         keyvalue_location_out->buf = std::move(buf);
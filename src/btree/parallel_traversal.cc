@@ -340,11 +340,34 @@ struct internal_node_releaser_t : public parent_releaser_t {
     virtual ~internal_node_releaser_t() { }
 };
 
+/* Pages touched by a traversal are rarely touched again soon. Unless the caller
+has picked an account of its own, the traversal reads them through the cache's
+one-pass account so that they don't push the working set out of the cache. */
+class one_pass_account_setter_t {
+public:
+    explicit one_pass_account_setter_t(txn_t *txn)
+        : txn_(txn), old_account_(txn->account()) {
+        if (old_account_ == txn_->cache()->default_reads_account()) {
+            txn_->set_account(txn_->cache()->default_one_pass_reads_account());
+        }
+    }
+    ~one_pass_account_setter_t() {
+        txn_->set_account(old_account_);
+    }
+private:
+    txn_t *const txn_;
+    cache_account_t *const old_account_;
+
+    DISABLE_COPYING(one_pass_account_setter_t);
+};
+
 void btree_parallel_traversal(superblock_t *superblock,
                               btree_traversal_helper_t *helper,
                               signal_t *interruptor,
                               bool release_superblock)
     THROWS_ONLY(interrupted_exc_t) {
+    one_pass_account_setter_t account_setter(superblock->expose_buf().txn());
+
     traversal_state_t state(superblock->cache()->max_block_size(),
                             helper, interruptor);
 
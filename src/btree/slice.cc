@@ -36,6 +36,7 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent,
                              const std::string &identifier)
     : stats(parent, identifier),
       cache_(c),
-      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) { }
+      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY,
+                                                      eviction_hint_t::one_pass)) { }
 
 btree_slice_t::~btree_slice_t() { }
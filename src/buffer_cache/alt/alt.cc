@@ -77,10 +77,12 @@ void alt_memory_tracker_t::end_txn(UNUSED tracker_acq_t acq) {
 }
 
 cache_t::cache_t(serializer_t *serializer, const alt_cache_config_t &config,
+                 alt_cache_balancer_t *balancer,
                  perfmon_collection_t *perfmon_collection)
     : stats_(make_scoped<alt_cache_stats_t>(perfmon_collection)),
       tracker_(),
-      page_cache_(serializer, config.page_config, &tracker_) { }
+      page_cache_(serializer, config.page_config, &tracker_, balancer,
+                  stats_.get()) { }
 
 cache_t::~cache_t() { }
 
@@ -88,8 +90,9 @@ block_size_t cache_t::max_block_size() const {
     return page_cache_.max_block_size();
 }
 
-cache_account_t cache_t::create_cache_account(int priority) {
-    return page_cache_.create_cache_account(priority);
+cache_account_t cache_t::create_cache_account(int priority,
+                                              eviction_hint_t eviction_hint) {
+    return page_cache_.create_cache_account(priority, eviction_hint);
 }
 
 alt_snapshot_node_t *
@@ -746,6 +749,28 @@ const void *buf_read_t::get_data_read(uint32_t *block_size_out) {
     return page_acq_.get_buf_read();
 }
 
+bool buf_read_t::keeps_aux_data() const {
+    return lock_->access() == access_t::read;
+}
+
+page_aux_data_t *buf_read_t::get_aux_data() {
+    if (!keeps_aux_data()) {
+        return NULL;
+    }
+    uint32_t block_size;
+    get_data_read(&block_size);
+    return page_acq_.get_aux_data();
+}
+
+void buf_read_t::set_aux_data(scoped_ptr_t<page_aux_data_t> &&aux_data) {
+    if (!keeps_aux_data()) {
+        return;
+    }
+    uint32_t block_size;
+    get_data_read(&block_size);
+    page_acq_.set_aux_data(std::move(aux_data));
+}
+
 buf_write_t::buf_write_t(buf_lock_t *lock)
     : lock_(lock) {
     guarantee(lock_->access() == access_t::write);
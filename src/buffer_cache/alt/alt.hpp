@@ -14,6 +14,7 @@
 class serializer_t;
 
 class buf_lock_t;
+class alt_cache_balancer_t;
 class alt_cache_config_t;
 class alt_cache_stats_t;
 class alt_snapshot_node_t;
@@ -41,21 +42,37 @@ private:
 
 class cache_t : public home_thread_mixin_t {
 public:
-    explicit cache_t(serializer_t *serializer,
-                     const alt_cache_config_t &dynamic_config,
-                     perfmon_collection_t *perfmon_collection);
+    // `balancer` may be NULL, in which case the cache keeps the memory limit it
+    // was configured with.
+    cache_t(serializer_t *serializer,
+            const alt_cache_config_t &dynamic_config,
+            alt_cache_balancer_t *balancer,
+            perfmon_collection_t *perfmon_collection);
     ~cache_t();
 
     block_size_t max_block_size() const;
     // KSI: Remove this.
     block_size_t get_block_size() const { return max_block_size(); }
 
+    // The number of bytes the cache is currently allowed to use.  This changes over
+    // time if the cache has a balancer.
+    uint64_t memory_limit() const { return page_cache_.memory_limit(); }
+
     // These todos come from the mirrored cache.  The real problem is that whole
     // cache account / priority thing is just one ghetto hack amidst a dozen other
     // throttling systems.  TODO: Come up with a consistent priority scheme,
     // i.e. define a "default" priority etc.  TODO: As soon as we can support it, we
     // might consider supporting a mem_cap paremeter.
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(int priority, eviction_hint_t eviction_hint);
+
+    // The accounts txns use unless they are given another one with
+    // `txn_t::set_account()`.
+    cache_account_t *default_reads_account() {
+        return page_cache_.default_reads_account();
+    }
+    cache_account_t *default_one_pass_reads_account() {
+        return page_cache_.default_one_pass_reads_account();
+    }
 
 private:
     friend class txn_t;
@@ -325,6 +342,14 @@ public:
         return data;
     }
 
+    // Data derived from the block that a previous reader attached with
+    // `set_aux_data()`, or NULL.  Aux data is only kept for locks with read
+    // access: for other locks `get_aux_data()` returns NULL and `set_aux_data()`
+    // drops its argument, because the block may still change under them.
+    page_aux_data_t *get_aux_data();
+    void set_aux_data(scoped_ptr_t<page_aux_data_t> &&aux_data);
+    bool keeps_aux_data() const;
+
 private:
     buf_lock_t *lock_;
     alt::page_acq_t page_acq_;
@@ -3,31 +3,37 @@
 #include "arch/types.hpp"
 
 cache_account_t::cache_account_t()
-    : thread_(-1), io_account_(NULL) { }
+    : thread_(-1), io_account_(NULL), eviction_hint_(eviction_hint_t::normal) { }
 
 cache_account_t::cache_account_t(cache_account_t &&movee)
-    : thread_(movee.thread_), io_account_(movee.io_account_) {
+    : thread_(movee.thread_), io_account_(movee.io_account_),
+      eviction_hint_(movee.eviction_hint_) {
     movee.thread_ = threadnum_t(-1);
     movee.io_account_ = NULL;
+    movee.eviction_hint_ = eviction_hint_t::normal;
 }
 
 cache_account_t &cache_account_t::operator=(cache_account_t &&movee) {
     cache_account_t tmp(std::move(movee));
     std::swap(thread_, tmp.thread_);
     std::swap(io_account_, tmp.io_account_);
+    std::swap(eviction_hint_, tmp.eviction_hint_);
     return *this;
 }
 
-void cache_account_t::init(threadnum_t thread, file_account_t *io_account) {
+void cache_account_t::init(threadnum_t thread, file_account_t *io_account,
+                           eviction_hint_t eviction_hint) {
     rassert(io_account_ == NULL);
     rassert(io_account != NULL);
     io_account_ = io_account;
     thread_ = thread;
+    eviction_hint_ = eviction_hint;
 }
 
 
-cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account)
-    : thread_(thread), io_account_(io_account) {
+cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account,
+                                 eviction_hint_t eviction_hint)
+    : thread_(thread), io_account_(io_account), eviction_hint_(eviction_hint) {
     rassert(io_account != NULL);
 }
 
@@ -9,6 +9,12 @@ namespace alt {
 class page_cache_t;
 }
 
+// Tells the evicter whether pages acquired through an account are likely to be
+// acquired again soon.  Traversals of a whole table (backfills, sindex
+// post-construction, ...) use `one_pass` so that they don't displace the
+// working set.
+enum class eviction_hint_t { normal, one_pass };
+
 class cache_account_t {
 public:
     cache_account_t();
@@ -19,16 +25,23 @@ public:
     file_account_t *get() const {
         return io_account_;
     }
+
+    eviction_hint_t eviction_hint() const {
+        return eviction_hint_;
+    }
 private:
     friend class alt::page_cache_t;
-    void init(threadnum_t thread, file_account_t *io_account);
-    cache_account_t(threadnum_t thread, file_account_t *io_account);
+    void init(threadnum_t thread, file_account_t *io_account,
+              eviction_hint_t eviction_hint);
+    cache_account_t(threadnum_t thread, file_account_t *io_account,
+                    eviction_hint_t eviction_hint);
     void reset();
 
     // KSI: I hate having this thread_ variable, and it looks like the file_account_t
     // already worries about going to the right thread anyway.
     threadnum_t thread_;
     file_account_t *io_account_;
+    eviction_hint_t eviction_hint_;
     DISABLE_COPYING(cache_account_t);
 };
 
@@ -0,0 +1,221 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "buffer_cache/alt/cache_balancer.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "arch/runtime/coroutines.hpp"
+#include "buffer_cache/alt/evicter.hpp"
+#include "concurrency/pmap.hpp"
+
+// How often the balancer redistributes memory.
+static const int64_t REBALANCE_INTERVAL_MS = 1000;
+
+// A miss costs a disk read, so it counts this many times as much as an access
+// that was served from memory.
+static const double MISS_WEIGHT = 8.0;
+
+void allocate_cache_memory(uint64_t budget,
+                           std::vector<cache_balancer_demand_t> *caches) {
+    uint64_t remaining = budget;
+    std::vector<size_t> growable;
+    for (size_t i = 0; i < caches->size(); ++i) {
+        cache_balancer_demand_t *c = &(*caches)[i];
+        c->max_memory_limit = std::max(c->max_memory_limit, c->min_memory_limit);
+        c->memory_limit = c->min_memory_limit;
+        remaining -= std::min(remaining, c->min_memory_limit);
+        if (c->memory_limit < c->max_memory_limit) {
+            growable.push_back(i);
+        }
+    }
+
+    // Hand out the remaining memory by weight.  Whenever a cache's share would
+    // take it past its maximum, it gets its maximum instead and we divide up
+    // what's left among the others again.
+    while (remaining > 0 && !growable.empty()) {
+        double total_weight = 0;
+        for (auto it = growable.begin(); it != growable.end(); ++it) {
+            total_weight += (*caches)[*it].weight;
+        }
+        const bool split_evenly = !(total_weight > 0);
+        if (split_evenly) {
+            total_weight = growable.size();
+        }
+
+        bool capped_any = false;
+        std::vector<size_t> still_growable;
+        for (auto it = growable.begin(); it != growable.end(); ++it) {
+            cache_balancer_demand_t *c = &(*caches)[*it];
+            const double weight = split_evenly ? 1.0 : c->weight;
+            const double share = remaining * (weight / total_weight);
+            const uint64_t room = c->max_memory_limit - c->memory_limit;
+            if (share >= room) {
+                c->memory_limit = c->max_memory_limit;
+                remaining -= room;
+                capped_any = true;
+            } else {
+                still_growable.push_back(*it);
+            }
+        }
+        growable.swap(still_growable);
+
+        if (!capped_any) {
+            // Nobody hit their maximum, so everybody gets their share.  Rounding
+            // may leave a few bytes over; they stay unallocated.
+            for (auto it = growable.begin(); it != growable.end(); ++it) {
+                cache_balancer_demand_t *c = &(*caches)[*it];
+                const double weight = split_evenly ? 1.0 : c->weight;
+                c->memory_limit += static_cast<uint64_t>(remaining * (weight / total_weight));
+            }
+            break;
+        }
+    }
+}
+
+// Returns `percent` percent of `limit`, saturating at UINT64_MAX.
+static uint64_t percent_of(uint64_t limit, uint64_t percent) {
+    // Divide first so that large limits don't overflow.
+    const uint64_t hundredth = limit / 100;
+    const uint64_t rest = limit % 100;
+    if (percent != 0 && hundredth > (UINT64_MAX - percent) / percent) {
+        return UINT64_MAX;
+    }
+    return hundredth * percent + rest * percent / 100;
+}
+
+void cache_balancer_bounds_t::memory_limits_for(uint64_t initial_limit,
+                                                uint64_t *min_out,
+                                                uint64_t *max_out) const {
+    *min_out = percent_of(initial_limit, min_percent);
+    *max_out = max_percent == 0
+        ? UINT64_MAX
+        : std::max(*min_out, percent_of(initial_limit, max_percent));
+}
+
+alt_cache_balancer_t::alt_cache_balancer_t(perfmon_collection_t *parent,
+                                           const cache_balancer_bounds_t &bounds)
+    : bounds_(bounds),
+      rebalance_in_progress_(false),
+      last_budget_(0),
+      last_num_caches_(0),
+      stats_membership_(parent, &stats_collection_, "cache_balancer"),
+      stats_collection_membership_(&stats_collection_,
+                                   &pm_budget_, "budget",
+                                   &pm_caches_, "caches",
+                                   &pm_rebalances_, "rebalances"),
+      rebalance_timer_(REBALANCE_INTERVAL_MS, this) { }
+
+alt_cache_balancer_t::~alt_cache_balancer_t() {
+    assert_thread();
+}
+
+void alt_cache_balancer_t::add_evicter(alt::evicter_t *evicter) {
+    evicter->assert_thread();
+    thread_info_t *info = thread_info_.get();
+    auto res = info->evicters.insert(evicter);
+    guarantee(res.second);
+    info->budget += evicter->initial_memory_limit();
+}
+
+void alt_cache_balancer_t::remove_evicter(alt::evicter_t *evicter) {
+    evicter->assert_thread();
+    thread_info_t *info = thread_info_.get();
+    size_t erased = info->evicters.erase(evicter);
+    guarantee(erased == 1);
+    guarantee(info->budget >= evicter->initial_memory_limit());
+    info->budget -= evicter->initial_memory_limit();
+}
+
+void alt_cache_balancer_t::on_ring() {
+    assert_thread();
+    if (rebalance_in_progress_) {
+        return;
+    }
+    rebalance_in_progress_ = true;
+    coro_t::spawn_sometime(std::bind(&alt_cache_balancer_t::rebalance,
+                                     this, drainer_.lock()));
+}
+
+void alt_cache_balancer_t::collect_from_thread(
+        int thread,
+        std::vector<std::vector<cache_info_t> > *caches,
+        std::vector<uint64_t> *budgets) {
+    on_thread_t th((threadnum_t(thread)));
+    ASSERT_NO_CORO_WAITING;
+
+    const thread_info_t *info = thread_info_.get();
+    (*budgets)[thread] = info->budget;
+    std::vector<cache_info_t> *out = &(*caches)[thread];
+    for (auto it = info->evicters.begin(); it != info->evicters.end(); ++it) {
+        alt::evicter_t *evicter = *it;
+        uint64_t accesses, misses;
+        evicter->take_balancer_counts(&accesses, &misses);
+
+        cache_info_t c;
+        c.evicter = evicter;
+        c.demand.min_memory_limit = evicter->min_memory_limit();
+        c.demand.max_memory_limit = evicter->max_memory_limit();
+        c.demand.weight = accesses + MISS_WEIGHT * misses;
+        out->push_back(c);
+    }
+}
+
+void alt_cache_balancer_t::apply_on_thread(
+        int thread,
+        const std::vector<std::vector<cache_info_t> > *caches) {
+    on_thread_t th((threadnum_t(thread)));
+    ASSERT_NO_CORO_WAITING;
+
+    const thread_info_t *info = thread_info_.get();
+    const std::vector<cache_info_t> &cs = (*caches)[thread];
+    for (auto it = cs.begin(); it != cs.end(); ++it) {
+        // The cache might have gone away while we were computing.
+        if (info->evicters.count(it->evicter) == 1) {
+            it->evicter->set_memory_limit(it->demand.memory_limit);
+        }
+    }
+}
+
+void alt_cache_balancer_t::rebalance(auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    rassert(rebalance_in_progress_);
+
+    std::vector<std::vector<cache_info_t> > caches(get_num_threads());
+    std::vector<uint64_t> budgets(get_num_threads(), 0);
+    pmap(get_num_threads(),
+         std::bind(&alt_cache_balancer_t::collect_from_thread,
+                   this, ph::_1, &caches, &budgets));
+
+    uint64_t budget = 0;
+    std::vector<cache_balancer_demand_t> demands;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        budget += budgets[i];
+        for (auto it = caches[i].begin(); it != caches[i].end(); ++it) {
+            demands.push_back(it->demand);
+        }
+    }
+
+    allocate_cache_memory(budget, &demands);
+
+    size_t n = 0;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        for (auto it = caches[i].begin(); it != caches[i].end(); ++it) {
+            it->demand = demands[n];
+            ++n;
+        }
+    }
+
+    if (!keepalive.get_drain_signal()->is_pulsed()) {
+        pmap(get_num_threads(),
+             std::bind(&alt_cache_balancer_t::apply_on_thread,
+                       this, ph::_1, &caches));
+    }
+
+    pm_budget_ += static_cast<int64_t>(budget) - last_budget_;
+    last_budget_ = budget;
+    pm_caches_ += static_cast<int64_t>(demands.size()) - last_num_caches_;
+    last_num_caches_ = demands.size();
+    ++pm_rebalances_;
+
+    rebalance_in_progress_ = false;
+}
@@ -0,0 +1,131 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_ALT_CACHE_BALANCER_HPP_
+#define BUFFER_CACHE_ALT_CACHE_BALANCER_HPP_
+
+#include <stdint.h>
+
+#include <set>
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/one_per_thread.hpp"
+#include "perfmon/perfmon.hpp"
+#include "threading.hpp"
+
+namespace alt {
+class evicter_t;
+}  // namespace alt
+
+// What the balancer knows about one cache when it divides up the budget.
+struct cache_balancer_demand_t {
+    cache_balancer_demand_t()
+        : min_memory_limit(0), max_memory_limit(0), weight(0), memory_limit(0) { }
+
+    uint64_t min_memory_limit;
+    uint64_t max_memory_limit;
+    // How badly the cache wants memory.  Only the ratios between the caches'
+    // weights matter.
+    double weight;
+
+    // The output of `allocate_cache_memory`.
+    uint64_t memory_limit;
+};
+
+// Gives every cache its `min_memory_limit`, then hands out the rest of `budget`
+// in proportion to the caches' weights, without giving any cache more than its
+// `max_memory_limit`.  If no cache that could use more memory has a weight, the
+// rest is split evenly between them.  If the minimums add up to more than
+// `budget`, the caches get their minimums anyway.
+void allocate_cache_memory(uint64_t budget,
+                           std::vector<cache_balancer_demand_t> *caches);
+
+// How far a balancer may move a cache's memory limit away from the limit the
+// cache was created with (for a table, its configured cache size).  Set from
+// the `--cache-min-percent` and `--cache-max-percent` startup options.
+struct cache_balancer_bounds_t {
+    cache_balancer_bounds_t() : min_percent(25), max_percent(0) { }
+
+    // Computes the `min_memory_limit` and `max_memory_limit` for a cache created
+    // with `initial_limit`.
+    void memory_limits_for(uint64_t initial_limit,
+                           uint64_t *min_out, uint64_t *max_out) const;
+
+    // A cache never shrinks below this percentage of its initial limit.
+    uint64_t min_percent;
+    // A cache never grows past this percentage of its initial limit.  0 means it
+    // may grow as far as the shared budget allows.
+    uint64_t max_percent;
+};
+
+/* `alt_cache_balancer_t` shares one memory budget between all the page caches
+that are created with it.  Periodically it looks at how many page acquisitions
+and misses each cache has seen since the last time, and moves memory towards the
+caches that are busy and missing.  Idle caches shrink down to their
+`min_memory_limit`.
+
+The budget is the sum of the `memory_limit`s the caches were created with, so a
+balancer never makes the process use more memory than it would without one. */
+class alt_cache_balancer_t : public home_thread_mixin_t,
+                             private repeating_timer_callback_t {
+public:
+    alt_cache_balancer_t(perfmon_collection_t *parent,
+                         const cache_balancer_bounds_t &bounds);
+    ~alt_cache_balancer_t();
+
+    // Safe to call from any thread.
+    const cache_balancer_bounds_t &bounds() const { return bounds_; }
+
+    // These are called by `evicter_t` on the evicter's home thread.
+    void add_evicter(alt::evicter_t *evicter);
+    void remove_evicter(alt::evicter_t *evicter);
+
+private:
+    struct thread_info_t {
+        thread_info_t() : budget(0) { }
+        std::set<alt::evicter_t *> evicters;
+        // The sum of the initial memory limits of `evicters`.
+        uint64_t budget;
+    };
+
+    struct cache_info_t {
+        alt::evicter_t *evicter;
+        cache_balancer_demand_t demand;
+    };
+
+    void on_ring();
+    void rebalance(auto_drainer_t::lock_t keepalive);
+    void collect_from_thread(int thread,
+                             std::vector<std::vector<cache_info_t> > *caches,
+                             std::vector<uint64_t> *budgets);
+    void apply_on_thread(int thread,
+                         const std::vector<std::vector<cache_info_t> > *caches);
+
+    const cache_balancer_bounds_t bounds_;
+
+    one_per_thread_t<thread_info_t> thread_info_;
+
+    // True while a `rebalance()` coroutine is running.
+    bool rebalance_in_progress_;
+
+    // What we last reported to `pm_budget_` and `pm_caches_`.
+    int64_t last_budget_;
+    int64_t last_num_caches_;
+
+    perfmon_collection_t stats_collection_;
+    perfmon_counter_t pm_budget_;
+    perfmon_counter_t pm_caches_;
+    perfmon_counter_t pm_rebalances_;
+    perfmon_membership_t stats_membership_;
+    perfmon_multi_membership_t stats_collection_membership_;
+
+    auto_drainer_t drainer_;
+
+    // Destroyed before `drainer_`, so no new `rebalance()` gets started while
+    // the drainer waits for the last one.
+    repeating_timer_t rebalance_timer_;
+
+    DISABLE_COPYING(alt_cache_balancer_t);
+};
+
+#endif  // BUFFER_CACHE_ALT_CACHE_BALANCER_HPP_
@@ -6,6 +6,20 @@
 #include "containers/archive/archive.hpp"
 #include "rpc/serialize_macros.hpp"
 
+// Which pages the evicter picks when the cache is over its memory limit.
+enum class eviction_policy_t {
+    // Evict the least recently accessed out of a few randomly sampled pages.
+    sampled_lru = 0,
+    // Like 2Q: pages start out on probation and are only protected once they get
+    // acquired again, or reloaded soon after being evicted.  Probationary pages
+    // are evicted first, so a one-off scan can't flush the working set.
+    two_queue = 1
+};
+
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(eviction_policy_t, int8_t,
+                                      eviction_policy_t::sampled_lru,
+                                      eviction_policy_t::two_queue);
+
 // KSI: Maybe this config struct can just go away completely.  For now we have it to
 // conform to some aspects of the interface of the mirrored cache, putting off until
 // later whether certain configuration options may be removed.
@@ -15,13 +29,22 @@ public:
     page_cache_config_t()
         : io_priority_reads(CACHE_READS_IO_PRIORITY),
           io_priority_writes(CACHE_WRITES_IO_PRIORITY),
-          memory_limit(GIGABYTE) { }
+          memory_limit(GIGABYTE),
+          min_memory_limit(0),
+          max_memory_limit(UINT64_MAX),
+          eviction_policy(eviction_policy_t::sampled_lru) { }
 
     int32_t io_priority_reads;
     int32_t io_priority_writes;
     uint64_t memory_limit;
+    // The range an `alt_cache_balancer_t` may move `memory_limit` in.  Ignored if
+    // the cache doesn't have a balancer.
+    uint64_t min_memory_limit;
+    uint64_t max_memory_limit;
+    eviction_policy_t eviction_policy;
 
-    RDB_MAKE_ME_SERIALIZABLE_3(io_priority_reads, io_priority_writes, memory_limit);
+    RDB_MAKE_ME_SERIALIZABLE_6(io_priority_reads, io_priority_writes, memory_limit,
+                               min_memory_limit, max_memory_limit, eviction_policy);
 };
 
 class alt_cache_config_t {
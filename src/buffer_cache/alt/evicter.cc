@@ -1,15 +1,59 @@
 #include "buffer_cache/alt/evicter.hpp"
 
+#include "buffer_cache/alt/cache_account.hpp"
+#include "buffer_cache/alt/cache_balancer.hpp"
 #include "buffer_cache/alt/page.hpp"
+#include "buffer_cache/alt/stats.hpp"
 
 namespace alt {
 
-evicter_t::evicter_t(memory_tracker_t *tracker, uint64_t memory_limit)
-    : tracker_(tracker), memory_limit_(memory_limit),
-      access_time_counter_(INITIAL_ACCESS_TIME) { }
+// With `eviction_policy_t::two_queue`, probationary pages are evicted first as
+// long as they take up more than 1/PROBATION_SHARE_DIVISOR of the memory limit.
+static const uint64_t PROBATION_SHARE_DIVISOR = 4;
+
+evicter_t::evicter_t(memory_tracker_t *tracker,
+                     const page_cache_config_t &config,
+                     alt_cache_balancer_t *balancer,
+                     alt_cache_stats_t *stats)
+    : tracker_(tracker), memory_limit_(config.memory_limit),
+      initial_memory_limit_(config.memory_limit),
+      min_memory_limit_(config.min_memory_limit),
+      max_memory_limit_(config.max_memory_limit),
+      balancer_(balancer), balancer_accesses_(0), balancer_misses_(0),
+      policy_(config.eviction_policy), stats_(stats),
+      access_time_counter_(INITIAL_ACCESS_TIME),
+      evicted_bytes_(0),
+      aux_data_size_(0) {
+    guarantee(stats_ != NULL);
+    stats_->pm_memory_limit += memory_limit_;
+    if (balancer_ != NULL) {
+        balancer_->add_evicter(this);
+    }
+}
 
 evicter_t::~evicter_t() {
     assert_thread();
+    if (balancer_ != NULL) {
+        balancer_->remove_evicter(this);
+    }
+    stats_->pm_memory_limit -= memory_limit_;
+}
+
+void evicter_t::set_memory_limit(uint64_t new_memory_limit) {
+    assert_thread();
+    stats_->pm_memory_limit += new_memory_limit;
+    stats_->pm_memory_limit -= memory_limit_;
+    memory_limit_ = new_memory_limit;
+    inform_tracker();
+    evict_if_necessary();
+}
+
+void evicter_t::take_balancer_counts(uint64_t *accesses_out, uint64_t *misses_out) {
+    assert_thread();
+    *accesses_out = balancer_accesses_;
+    *misses_out = balancer_misses_;
+    balancer_accesses_ = 0;
+    balancer_misses_ = 0;
 }
 
 
@@ -75,7 +119,9 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->buf_.has()) {
         return &evicted_;
     } else if (page->block_token_.has()) {
-        return &evictable_disk_backed_;
+        return page->eviction_protected_
+            ? &evictable_protected_
+            : &evictable_disk_backed_;
     } else {
         return &evictable_unbacked_;
     }
@@ -87,15 +133,77 @@ void evicter_t::remove_page(page_t *page) {
     rassert(page->snapshot_refcount_ == 0);
     eviction_bag_t *bag = correct_eviction_category(page);
     bag->remove(page, page->ser_buf_size_);
+    page->reset_aux_data(this);
     inform_tracker();
     evict_if_necessary();
 }
 
+void evicter_t::add_aux_data_size(uint64_t size) {
+    assert_thread();
+    aux_data_size_ += size;
+    inform_tracker();
+    evict_if_necessary();
+}
+
+void evicter_t::remove_aux_data_size(uint64_t size) {
+    assert_thread();
+    rassert(aux_data_size_ >= size);
+    aux_data_size_ -= size;
+}
+
+void evicter_t::note_acquisition(page_t *page, eviction_bag_t *current_bag,
+                                 cache_account_t *account) {
+    assert_thread();
+    rassert(current_bag->has_page(page));
+
+    // Pages touched by one-pass traversals never get protected.  If they did, a
+    // big enough traversal would still flush out the working set.
+    const bool may_protect = policy_ == eviction_policy_t::two_queue
+        && (account == NULL
+            || account->eviction_hint() != eviction_hint_t::one_pass);
+
+    ++balancer_accesses_;
+    if (page->buf_.has()) {
+        ++stats_->pm_cache_hits;
+        // This is at least the second time the page has been wanted since it was
+        // loaded.
+        if (may_protect) {
+            page->eviction_protected_ = true;
+        }
+    } else {
+        ++stats_->pm_cache_misses;
+        ++balancer_misses_;
+        if (current_bag == &evicted_ && is_ghost(page)) {
+            // We evicted this page and now need it back, so it was wanted again
+            // before it could age out of the ghost list.
+            ++stats_->pm_cache_ghost_hits;
+            if (may_protect) {
+                page->eviction_protected_ = true;
+            }
+        }
+    }
+}
+
+void evicter_t::note_page_load(ticks_t start_ticks) {
+    assert_thread();
+    stats_->pm_page_load_latency.record(ticks_to_secs(get_ticks() - start_ticks));
+}
+
 uint64_t evicter_t::in_memory_size() const {
     assert_thread();
     return unevictable_.size()
         + evictable_disk_backed_.size()
-        + evictable_unbacked_.size();
+        + evictable_protected_.size()
+        + evictable_unbacked_.size()
+        + aux_data_size_;
+}
+
+bool evicter_t::is_ghost(page_t *page) const {
+    assert_thread();
+    // The ghost list holds as many bytes of evicted pages as the cache holds
+    // live ones, like 2Q's A1out queue.
+    return page->evicted_at_ != 0
+        && evicted_bytes_ - page->evicted_at_ < memory_limit_;
 }
 
 bool evicter_t::interested_in_read_ahead_block(uint32_t ser_block_size) const {
@@ -111,12 +219,35 @@ void evicter_t::evict_if_necessary() {
 
     page_t *page;
     while (in_memory_size() > memory_limit_
-           && evictable_disk_backed_.remove_oldish(&page, access_time_counter_)) {
+           && remove_eviction_victim(&page)) {
+        // An evicted page has to earn its protection again.
+        page->eviction_protected_ = false;
+        evicted_bytes_ += page->ser_buf_size_;
+        page->evicted_at_ = evicted_bytes_;
         evicted_.add(page, page->ser_buf_size_);
+        page->reset_aux_data(this);
         page->evict_self();
     }
 }
 
+bool evicter_t::remove_eviction_victim(page_t **page_out) {
+    switch (policy_) {
+    case eviction_policy_t::sampled_lru:
+        rassert(evictable_protected_.size() == 0);
+        return evictable_disk_backed_.remove_oldish(page_out, access_time_counter_);
+    case eviction_policy_t::two_queue:
+        if (evictable_protected_.size() == 0
+            || evictable_disk_backed_.size() > memory_limit_ / PROBATION_SHARE_DIVISOR) {
+            if (evictable_disk_backed_.remove_oldish(page_out, access_time_counter_)) {
+                return true;
+            }
+        }
+        return evictable_protected_.remove_oldish(page_out, access_time_counter_);
+    default:
+        unreachable();
+    }
+}
+
 void evicter_t::inform_tracker() const {
     tracker_->inform_memory_change(in_memory_size(),
                                    memory_limit_);
@@ -3,8 +3,14 @@
 
 #include <stdint.h>
 
+#include "buffer_cache/alt/config.hpp"
 #include "buffer_cache/alt/eviction_bag.hpp"
 #include "threading.hpp"
+#include "time.hpp"
+
+class alt_cache_balancer_t;
+class alt_cache_stats_t;
+class cache_account_t;
 
 class memory_tracker_t {
 public:
@@ -28,12 +34,40 @@ public:
     eviction_bag_t *unevictable_category() { return &unevictable_; }
     void remove_page(page_t *page);
 
-    explicit evicter_t(memory_tracker_t *tracker,
-                       uint64_t memory_limit);
+    // Called when aux data (see page_aux_data_t) taking up `size` bytes is
+    // attached to or dropped from a page, so that it counts against the memory
+    // limit like the page's buffer.
+    void add_aux_data_size(uint64_t size);
+    void remove_aux_data_size(uint64_t size);
+
+    // Called when a waiter is added to `page`, before it is moved out of
+    // `current_bag`.  Updates the hit/miss stats and decides whether the page
+    // joins the protected set.
+    void note_acquisition(page_t *page, eviction_bag_t *current_bag,
+                          cache_account_t *account);
+
+    // Called when a page load that began at `start_ticks` has read its block.
+    void note_page_load(ticks_t start_ticks);
+
+    // `balancer` may be NULL, in which case the memory limit stays at
+    // `config.memory_limit`.
+    evicter_t(memory_tracker_t *tracker,
+              const page_cache_config_t &config,
+              alt_cache_balancer_t *balancer,
+              alt_cache_stats_t *stats);
     ~evicter_t();
 
     bool interested_in_read_ahead_block(uint32_t ser_block_size) const;
 
+    // These are used by `alt_cache_balancer_t`.
+    uint64_t memory_limit() const { return memory_limit_; }
+    uint64_t initial_memory_limit() const { return initial_memory_limit_; }
+    uint64_t min_memory_limit() const { return min_memory_limit_; }
+    uint64_t max_memory_limit() const { return max_memory_limit_; }
+    void set_memory_limit(uint64_t new_memory_limit);
+    // Returns the number of page acquisitions and misses since the last call.
+    void take_balancer_counts(uint64_t *accesses_out, uint64_t *misses_out);
+
     uint64_t next_access_time() {
         return ++access_time_counter_;
     }
@@ -42,13 +76,28 @@ public:
 
 private:
     void evict_if_necessary();
+    // Removes the page that should be evicted next from its eviction bag.
+    bool remove_eviction_victim(page_t **page_out);
     uint64_t in_memory_size() const;
+    // True if `page` was evicted recently enough that wanting it again means it
+    // should have stayed in memory.
+    bool is_ghost(page_t *page) const;
 
     void inform_tracker() const;
 
-    // LSI: Implement issue 97.
     memory_tracker_t *const tracker_;
     uint64_t memory_limit_;
+    const uint64_t initial_memory_limit_;
+    const uint64_t min_memory_limit_;
+    const uint64_t max_memory_limit_;
+
+    alt_cache_balancer_t *const balancer_;
+    // Acquisitions and misses since `balancer_` last asked.
+    uint64_t balancer_accesses_;
+    uint64_t balancer_misses_;
+
+    const eviction_policy_t policy_;
+    alt_cache_stats_t *const stats_;
 
     // This gets incremented every time a page is accessed.
     uint64_t access_time_counter_;
@@ -56,8 +105,19 @@ private:
     // These track whether every page's eviction status.
     eviction_bag_t unevictable_;
     eviction_bag_t evictable_disk_backed_;
+    // Disk-backed pages that have been acquired again since they were loaded.
+    // Only used with `eviction_policy_t::two_queue`; otherwise all disk-backed
+    // pages live in `evictable_disk_backed_`.
+    eviction_bag_t evictable_protected_;
     eviction_bag_t evictable_unbacked_;
+    // Evicted pages.  Every page_t stays here until the page is deleted, but only
+    // the ones evicted within the last cache's worth of evictions (see
+    // `is_ghost`) make up the two-queue policy's ghost list.
     eviction_bag_t evicted_;
+    // Total bytes evicted so far; `page_t::evicted_at_` is stamped from this.
+    uint64_t evicted_bytes_;
+    // The memory used by aux data attached to pages in memory.
+    uint64_t aux_data_size_;
 
     DISABLE_COPYING(evicter_t);
 };
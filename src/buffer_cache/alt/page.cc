@@ -39,6 +39,8 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache)
     : loader_(NULL),
       ser_buf_size_(0),
       access_time_(page_cache->evicter().next_access_time()),
+      eviction_protected_(false),
+      evicted_at_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -53,6 +55,8 @@ page_t::page_t(block_id_t block_id, page_cache_t *page_cache,
     : loader_(NULL),
       ser_buf_size_(0),
       access_time_(page_cache->evicter().next_access_time()),
+      eviction_protected_(false),
+      evicted_at_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -69,6 +73,8 @@ page_t::page_t(block_size_t block_size, scoped_malloc_t<ser_buffer_t> buf,
       ser_buf_size_(block_size.ser_value()),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      eviction_protected_(false),
+      evicted_at_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -82,6 +88,8 @@ page_t::page_t(scoped_malloc_t<ser_buffer_t> buf,
       buf_(std::move(buf)),
       block_token_(block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      eviction_protected_(false),
+      evicted_at_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -91,6 +99,8 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : loader_(NULL),
       ser_buf_size_(0),
       access_time_(page_cache->evicter().next_access_time()),
+      eviction_protected_(false),
+      evicted_at_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -225,6 +235,7 @@ void page_t::catch_up_with_deferred_load(
     // the deferred loader has gotten back to this thread, so we can do that.
     deferred_loader->abandon_page();
 
+    const ticks_t start_ticks = get_ticks();
     scoped_malloc_t<ser_buffer_t> buf;
     {
         serializer_t *const serializer = page_cache->serializer_;
@@ -248,6 +259,7 @@ void page_t::catch_up_with_deferred_load(
         return;
     }
 
+    page_cache->evicter().note_page_load(start_ticks);
     page_t::finish_load_with_block_id(page, page_cache,
                                       std::move(block_token_ptr->token),
                                       std::move(buf));
@@ -311,6 +323,7 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
 
     auto_drainer_t::lock_t lock(page_cache->drainer_.get());
 
+    const ticks_t start_ticks = get_ticks();
     scoped_malloc_t<ser_buffer_t> buf;
     counted_t<standard_block_token_t> block_token;
 
@@ -333,6 +346,7 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
         return;
     }
 
+    page_cache->evicter().note_page_load(start_ticks);
     page_t::finish_load_with_block_id(page, page_cache,
                                       std::move(block_token),
                                       std::move(buf));
@@ -383,6 +397,7 @@ void page_t::pulse_waiters_or_make_evictable(page_cache_t *page_cache) {
 void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
     eviction_bag_t *old_bag
         = acq->page_cache()->evicter().correct_eviction_category(this);
+    acq->page_cache()->evicter().note_acquisition(this, old_bag, account);
     waiters_.push_back(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
     if (buf_.has()) {
@@ -476,9 +491,27 @@ void page_t::evict_self() {
     rassert(waiters_.empty());
     rassert(block_token_.has());
     rassert(buf_.has());
+    rassert(!aux_data_.has());
     buf_.reset();
 }
 
+void page_t::set_aux_data(evicter_t *evicter,
+                          scoped_ptr_t<page_aux_data_t> &&aux_data) {
+    rassert(buf_.has());
+    reset_aux_data(evicter);
+    aux_data_ = std::move(aux_data);
+    if (aux_data_.has()) {
+        evicter->add_aux_data_size(aux_data_->memory_usage());
+    }
+}
+
+void page_t::reset_aux_data(evicter_t *evicter) {
+    if (aux_data_.has()) {
+        evicter->remove_aux_data_size(aux_data_->memory_usage());
+        aux_data_.reset();
+    }
+}
+
 
 page_acq_t::page_acq_t() : page_(NULL), page_cache_(NULL) {
 }
@@ -516,6 +549,8 @@ uint32_t page_acq_t::get_buf_size() {
 void *page_acq_t::get_buf_write() {
     buf_ready_signal_.wait();
     page_->reset_block_token();
+    // The caller is about to change the buffer.
+    page_->reset_aux_data(&page_cache_->evicter());
     return page_->get_page_buf(page_cache_);
 }
 
@@ -524,6 +559,16 @@ const void *page_acq_t::get_buf_read() {
     return page_->get_page_buf(page_cache_);
 }
 
+page_aux_data_t *page_acq_t::get_aux_data() {
+    buf_ready_signal_.wait();
+    return page_->get_aux_data();
+}
+
+void page_acq_t::set_aux_data(scoped_ptr_t<page_aux_data_t> &&aux_data) {
+    buf_ready_signal_.wait();
+    page_->set_aux_data(&page_cache_->evicter(), std::move(aux_data));
+}
+
 page_ptr_t::page_ptr_t() : page_(NULL), page_cache_(NULL) {
 }
 
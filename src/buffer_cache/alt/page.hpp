@@ -1,6 +1,7 @@
 #ifndef BUFFER_CACHE_ALT_PAGE_HPP_
 #define BUFFER_CACHE_ALT_PAGE_HPP_
 
+#include "buffer_cache/alt/page_aux_data.hpp"
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "repli_timestamp.hpp"
@@ -12,6 +13,7 @@ namespace alt {
 
 class page_cache_t;
 class page_acq_t;
+class evicter_t;
 
 class page_loader_t;
 class deferred_page_loader_t;
@@ -46,6 +48,13 @@ public:
     void reset_block_token();
     uint32_t get_page_buf_size();
 
+    // See page_aux_data_t.  May not be called until the page_acq_t's
+    // buf_ready_signal is pulsed, either.  The evicter is told about the aux
+    // data's memory usage.
+    page_aux_data_t *get_aux_data() { return aux_data_.get_or_null(); }
+    void set_aux_data(evicter_t *evicter, scoped_ptr_t<page_aux_data_t> &&aux_data);
+    void reset_aux_data(evicter_t *evicter);
+
 private:
     friend class page_ptr_t;
     friend class deferred_page_loader_t;
@@ -96,8 +105,21 @@ private:
     scoped_malloc_t<ser_buffer_t> buf_;
     counted_t<standard_block_token_t> block_token_;
 
+    // Derived from buf_, and reset whenever buf_ is evicted or acquired for write.
+    scoped_ptr_t<page_aux_data_t> aux_data_;
+
     uint64_t access_time_;
 
+    // True if the page has been acquired again since it was loaded, or was
+    // reloaded soon after being evicted.  Used by `eviction_policy_t::two_queue`
+    // to tell the working set apart from pages that were only touched once.
+    bool eviction_protected_;
+
+    // The evicter's `evicted_bytes_` count right after this page was last
+    // evicted, or 0 if it never was.  A reload only counts as a ghost hit while
+    // less than a cache's worth of data has been evicted since.
+    uint64_t evicted_at_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -206,6 +228,8 @@ public:
     uint32_t get_buf_size();
     void *get_buf_write();
     const void *get_buf_read();
+    page_aux_data_t *get_aux_data();
+    void set_aux_data(scoped_ptr_t<page_aux_data_t> &&aux_data);
 
 private:
     friend class page_t;
@@ -0,0 +1,22 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef BUFFER_CACHE_ALT_PAGE_AUX_DATA_HPP_
+#define BUFFER_CACHE_ALT_PAGE_AUX_DATA_HPP_
+
+#include <stddef.h>
+
+/* Something a user of the cache derived from a page's contents (such as a search
+index over a btree node) and attached to the page, so the next reader of the same
+page can reuse it.  The page throws it away whenever its buffer is acquired for
+write or evicted, so it never describes contents that have since changed.  Its
+`memory_usage()` counts against the cache's memory limit while it is attached, so
+it must not change in that time. */
+class page_aux_data_t {
+public:
+    page_aux_data_t() { }
+    virtual ~page_aux_data_t() { }
+
+    // How many bytes of memory this takes up, including the object itself.
+    virtual size_t memory_usage() const = 0;
+};
+
+#endif  // BUFFER_CACHE_ALT_PAGE_AUX_DATA_HPP_
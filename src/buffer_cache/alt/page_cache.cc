@@ -140,11 +140,13 @@ void page_cache_t::read_ahead_cb_is_destroyed() {
 
 page_cache_t::page_cache_t(serializer_t *serializer,
                            const page_cache_config_t &config,
-                           memory_tracker_t *tracker)
+                           memory_tracker_t *tracker,
+                           alt_cache_balancer_t *balancer,
+                           alt_cache_stats_t *stats)
     : dynamic_config_(config),
       serializer_(serializer),
       free_list_(serializer),
-      evicter_(tracker, config.memory_limit),
+      evicter_(tracker, config, balancer, stats),
       read_ahead_cb_(NULL),
       drainer_(make_scoped<auto_drainer_t>()) {
 
@@ -160,7 +162,12 @@ page_cache_t::page_cache_t(serializer_t *serializer,
                                                       config.memory_limit);
         }
         default_reads_account_.init(serializer->home_thread(),
-                                    serializer->make_io_account(config.io_priority_reads));
+                                    serializer->make_io_account(config.io_priority_reads),
+                                    eviction_hint_t::normal);
+        default_one_pass_reads_account_.init(
+                serializer->home_thread(),
+                serializer->make_io_account(config.io_priority_reads),
+                eviction_hint_t::one_pass);
         writes_io_account_.init(serializer->make_io_account(config.io_priority_writes));
         index_write_sink_.init(new fifo_enforcer_sink_t);
         recencies_ = serializer->get_all_recencies();
@@ -184,6 +191,7 @@ page_cache_t::~page_cache_t() {
         // of making its destructor switch back to the serializer thread a second
         // time.
         default_reads_account_.reset();
+        default_one_pass_reads_account_.reset();
         writes_io_account_.reset();
         index_write_sink_.reset();
     }
@@ -309,7 +317,8 @@ block_size_t page_cache_t::max_block_size() const {
     return serializer_->max_block_size();
 }
 
-cache_account_t page_cache_t::create_cache_account(int priority) {
+cache_account_t page_cache_t::create_cache_account(int priority,
+                                                   eviction_hint_t eviction_hint) {
     // We assume that a priority of 100 means that the transaction should have the
     // same priority as all the non-accounted transactions together. Not sure if this
     // makes sense.
@@ -330,7 +339,7 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
                                                   outstanding_requests_limit);
     }
 
-    return cache_account_t(serializer_->home_thread(), io_account);
+    return cache_account_t(serializer_->home_thread(), io_account, eviction_hint);
 }
 
 
@@ -26,6 +26,8 @@
 #include "repli_timestamp.hpp"
 #include "serializer/types.hpp"
 
+class alt_cache_balancer_t;
+class alt_cache_stats_t;
 class alt_memory_tracker_t;
 class auto_drainer_t;
 class cache_t;
@@ -292,7 +294,9 @@ class page_cache_t : public home_thread_mixin_t {
 public:
     page_cache_t(serializer_t *serializer,
                  const page_cache_config_t &config,
-                 memory_tracker_t *tracker);
+                 memory_tracker_t *tracker,
+                 alt_cache_balancer_t *balancer,
+                 alt_cache_stats_t *stats);
     ~page_cache_t();
 
     // Takes a txn to be flushed.  Calls on_flush_complete() (which resets the
@@ -312,12 +316,20 @@ public:
 
     block_size_t max_block_size() const;
 
-    cache_account_t create_cache_account(int priority);
+    // The number of bytes the cache is currently allowed to use.
+    uint64_t memory_limit() const { return evicter_.memory_limit(); }
+
+    cache_account_t create_cache_account(int priority, eviction_hint_t eviction_hint);
 
     cache_account_t *default_reads_account() {
         return &default_reads_account_;
     }
 
+    // Like `default_reads_account()`, but with `eviction_hint_t::one_pass`.
+    cache_account_t *default_one_pass_reads_account() {
+        return &default_one_pass_reads_account_;
+    }
+
 private:
     friend class page_read_ahead_cb_t;
     void add_read_ahead_buf(block_id_t block_id,
@@ -332,6 +344,7 @@ private:
     current_page_t *internal_page_for_new_chosen(block_id_t block_id);
 
     friend class page_t;
+    friend class page_acq_t;
     evicter_t &evicter() { return evicter_; }
 
     // KSI: Maybe just have txn_t hold a single list of block_change_t objects.
@@ -406,6 +419,7 @@ private:
     // have to wait for previous ones to flush before they can proceed, so this
     // separation might be tricky in practice.
     cache_account_t default_reads_account_;
+    cache_account_t default_one_pass_reads_account_;
     scoped_ptr_t<file_account_t> writes_io_account_;
 
     // This fifo enforcement pair ensures ordering of index_write operations after we
@@ -6,5 +6,11 @@
 alt_cache_stats_t::alt_cache_stats_t(perfmon_collection_t *parent)
     : cache_collection(),
       cache_membership(parent, &cache_collection, "cache"),
-      cache_collection_membership(&cache_collection) { }
+      pm_page_load_latency(secs_to_ticks(10)),
+      cache_collection_membership(&cache_collection,
+                                  &pm_cache_hits, "hits",
+                                  &pm_cache_misses, "misses",
+                                  &pm_cache_ghost_hits, "ghost_hits",
+                                  &pm_memory_limit, "memory_limit",
+                                  &pm_page_load_latency, "page_load_latency") { }
 
@@ -11,9 +11,17 @@ public:
     perfmon_collection_t cache_collection;
     perfmon_membership_t cache_membership;
 
-    /*
-      LSI: insert perfmons here
-    */
+    // Page acquisitions that found the page in memory, or had to load it.
+    perfmon_counter_t pm_cache_hits;
+    perfmon_counter_t pm_cache_misses;
+    // Misses on pages that had been evicted earlier, and so might have stayed in
+    // memory with a better eviction policy.
+    perfmon_counter_t pm_cache_ghost_hits;
+    // The cache's current memory limit, which can change if the cache belongs to
+    // an `alt_cache_balancer_t`.
+    perfmon_counter_t pm_memory_limit;
+    // How long pages take to come back from the serializer on a miss.
+    perfmon_histogram_t pm_page_load_latency;
 
     perfmon_multi_membership_t cache_collection_membership;
 };
@@ -22,14 +22,25 @@ static const char * PROGRESS_REQ_TIMEOUT_PARAM = "timeout";
 static const uint64_t DEFAULT_PROGRESS_REQ_TIMEOUT_MS = 2000;
 static const uint64_t MAX_PROGRESS_REQ_TIMEOUT_MS = 60*1000;
 
+/* What a backfiller tells us about a backfill: how many nodes it has released
+ * out of how many, and how fast it has been sending. */
+typedef std::pair<std::pair<int, int>, backfill_throughput_t> progress_response_t;
+typedef mailbox_t<void(std::pair<int, int>, backfill_throughput_t)> progress_response_mailbox_t;
+
+static void pulse_progress_response(promise_t<progress_response_t> *promise,
+                                    std::pair<int, int> fraction,
+                                    backfill_throughput_t throughput) {
+    promise->pulse(std::make_pair(fraction, throughput));
+}
+
 /* A record of a request made to another peer for progress on a backfill. */
 class request_record_t {
 public:
-    scoped_ptr_t<promise_t<std::pair<int, int> > > promise;
-    scoped_ptr_t<mailbox_t<void(std::pair<int, int>)> > resp_mbox;
+    scoped_ptr_t<promise_t<progress_response_t> > promise;
+    scoped_ptr_t<progress_response_mailbox_t> resp_mbox;
 
     // TODO: We take ownership of these pointers?  Look at users.
-    request_record_t(promise_t<std::pair<int, int> > *_promise, mailbox_t<void(std::pair<int, int>)> *_resp_mbox)
+    request_record_t(promise_t<progress_response_t> *_promise, progress_response_mailbox_t *_resp_mbox)
         : promise(_promise), resp_mbox(_resp_mbox)
     { }
 };
@@ -149,10 +160,10 @@ void send_backfill_requests_t::handle_request_internal(const reactor_business_ca
 
     boost::optional<backfiller_business_card_t<rdb_protocol_t> > backfiller = boost::apply_visitor(get_backfiller_business_card_t<rdb_protocol_t>(), region_activity_entry.activity);
     if (backfiller) {
-        promise_t<std::pair<int, int> > *value = new promise_t<std::pair<int, int> >;
-        mailbox_t<void(std::pair<int, int>)> *resp_mbox = new mailbox_t<void(std::pair<int, int>)>(
+        promise_t<progress_response_t> *value = new promise_t<progress_response_t>;
+        progress_response_mailbox_t *resp_mbox = new progress_response_mailbox_t(
             mbox_manager,
-            boost::bind(&promise_t<std::pair<int, int> >::pulse, value, _1));
+            boost::bind(&pulse_progress_response, value, _1, _2));
 
         send(mbox_manager, backfiller->request_progress_mailbox, loc.backfill_session_id, resp_mbox->get_address());
 
@@ -368,10 +379,13 @@ void progress_app_t::handle(const http_req_t &req, http_res_t *result, signal_t
 
                     if (r_it->second->promise->get_ready_signal()->is_pulsed()) {
                         /* The promise is pulsed, we got an answer. */
-                        std::pair<int, int> response = r_it->second->promise->wait();
+                        progress_response_t response = r_it->second->promise->wait();
+                        /* [released, total, keys per second, MB per second] */
                         cJSON *pair = cJSON_CreateArray();
-                        cJSON_AddItemToArray(pair, cJSON_CreateNumber(response.first));
-                        cJSON_AddItemToArray(pair, cJSON_CreateNumber(response.second));
+                        cJSON_AddItemToArray(pair, cJSON_CreateNumber(response.first.first));
+                        cJSON_AddItemToArray(pair, cJSON_CreateNumber(response.first.second));
+                        cJSON_AddItemToArray(pair, cJSON_CreateNumber(response.second.keys_per_sec));
+                        cJSON_AddItemToArray(pair, cJSON_CreateNumber(response.second.mb_per_sec));
                         cJSON_AddItemToArray(region_info, pair);
                     } else if (interruptor->is_pulsed()) {
                         throw interrupted_exc_t();
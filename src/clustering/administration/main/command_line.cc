@@ -308,15 +308,21 @@ public:
     serve_info_t(const std::vector<host_and_port_t> &_joins,
                  service_address_ports_t _ports,
                  std::string _web_assets,
+                 const cache_balancer_bounds_t &_cache_bounds,
+                 int _js_batch_workers,
                  boost::optional<std::string> _config_file):
         joins(&_joins),
         ports(_ports),
         web_assets(_web_assets),
+        cache_bounds(_cache_bounds),
+        js_batch_workers(_js_batch_workers),
         config_file(_config_file) { }
 
     const std::vector<host_and_port_t> *joins;
     service_address_ports_t ports;
     std::string web_assets;
+    cache_balancer_bounds_t cache_bounds;
+    int js_batch_workers;
     boost::optional<std::string> config_file;
 };
 
@@ -585,6 +591,58 @@ peer_address_t get_canonical_addresses(const std::map<std::string, options::valu
     return peer_address_t(result);
 }
 
+conn_placement_t parse_driver_conn_placement_option(const std::map<std::string, options::values_t> &opts) {
+    std::string source;
+    const std::string placement = get_single_option(opts, "--driver-conn-placement", &source);
+    if (placement == "accepting-thread") {
+        return conn_placement_t::accepting_thread;
+    } else if (placement == "least-loaded") {
+        return conn_placement_t::least_loaded_thread;
+    }
+    throw options::value_error_t(source, "--driver-conn-placement",
+                                 strprintf("Option '--driver-conn-placement' must be "
+                                           "'accepting-thread' or 'least-loaded', not '%s'",
+                                           placement.c_str()));
+}
+
+cache_balancer_bounds_t parse_cache_bounds_options(const std::map<std::string, options::values_t> &opts) {
+    cache_balancer_bounds_t bounds;
+    std::string source;
+    get_single_option(opts, "--cache-min-percent", &source);
+    const int min_percent = get_single_int(opts, "--cache-min-percent");
+    if (min_percent < 0 || min_percent > 100) {
+        throw options::value_error_t(source, "--cache-min-percent",
+                                     strprintf("Option '--cache-min-percent' must be "
+                                               "between 0 and 100, not %d",
+                                               min_percent));
+    }
+    get_single_option(opts, "--cache-max-percent", &source);
+    const int max_percent = get_single_int(opts, "--cache-max-percent");
+    if (max_percent != 0 && (max_percent < min_percent || max_percent > 10000)) {
+        throw options::value_error_t(source, "--cache-max-percent",
+                                     strprintf("Option '--cache-max-percent' must be 0 "
+                                               "or between --cache-min-percent (%d) "
+                                               "and 10000, not %d",
+                                               min_percent, max_percent));
+    }
+    bounds.min_percent = min_percent;
+    bounds.max_percent = max_percent;
+    return bounds;
+}
+
+int parse_js_batch_workers_option(const std::map<std::string, options::values_t> &opts) {
+    std::string source;
+    get_single_option(opts, "--js-batch-workers", &source);
+    const int js_batch_workers = get_single_int(opts, "--js-batch-workers");
+    if (js_batch_workers < 1 || js_batch_workers > MAX_JS_BATCH_WORKERS) {
+        throw options::value_error_t(source, "--js-batch-workers",
+                                     strprintf("Option '--js-batch-workers' must be "
+                                               "between 1 and %d, not %d",
+                                               MAX_JS_BATCH_WORKERS, js_batch_workers));
+    }
+    return js_batch_workers;
+}
+
 service_address_ports_t get_service_address_ports(const std::map<std::string, options::values_t> &opts) {
     const int port_offset = get_single_int(opts, "--port-offset");
     const int cluster_port = offseted_port(get_single_int(opts, "--cluster-port"), port_offset);
@@ -595,6 +653,7 @@ service_address_ports_t get_service_address_ports(const std::map<std::string, op
                                    exists_option(opts, "--no-http-admin"),
                                    offseted_port(get_single_int(opts, "--http-port"), port_offset),
                                    offseted_port(get_single_int(opts, "--driver-port"), port_offset),
+                                   parse_driver_conn_placement_option(opts),
                                    port_offset);
 }
 
@@ -603,6 +662,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           const name_string_t &machine_name,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const io_backend_t io_backend,
                           bool *const result_out) {
     machine_id_t our_machine_id = generate_uuid();
 
@@ -614,7 +674,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
     machine_semilattice_metadata.datacenter = vclock_t<datacenter_id_t>(nil_uuid(), our_machine_id);
     cluster_metadata.machines.machines.insert(std::make_pair(our_machine_id, make_deletable(machine_semilattice_metadata)));
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -709,6 +769,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const serve_info_t &serve_info,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const io_backend_t io_backend,
                          const machine_id_t *our_machine_id,
                          const cluster_semilattice_metadata_t *cluster_metadata,
                          directory_lock_t *data_directory_lock,
@@ -719,7 +780,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logINF("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -764,6 +825,8 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                             look_up_peers_addresses(*serve_info.joins),
                             serve_info.ports,
                             serve_info.web_assets,
+                            serve_info.cache_bounds,
+                            serve_info.js_batch_workers,
                             &sigint_cond,
                             serve_info.config_file);
 
@@ -780,13 +843,14 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const name_string_t &machine_name,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const io_backend_t io_backend,
                              const bool new_directory,
                              const serve_info_t &serve_info,
                              directory_lock_t *data_directory_lock,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info,
-                            direct_io_mode, max_concurrent_io_requests,
+                            direct_io_mode, max_concurrent_io_requests, io_backend,
                             NULL, NULL, data_directory_lock,
                             result_out);
     } else {
@@ -819,7 +883,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         }
 
         run_rethinkdb_serve(base_path, serve_info,
-                            direct_io_mode, max_concurrent_io_requests,
+                            direct_io_mode, max_concurrent_io_requests, io_backend,
                             &our_machine_id, &cluster_metadata,
                             data_directory_lock, result_out);
     }
@@ -833,6 +897,7 @@ void run_rethinkdb_proxy(const serve_info_t &serve_info, bool *const result_out)
         *result_out = serve_proxy(look_up_peers_addresses(*serve_info.joins),
                                   serve_info.ports,
                                   serve_info.web_assets,
+                                  serve_info.js_batch_workers,
                                   &sigint_cond,
                                   serve_info.config_file);
     } catch (const host_lookup_exc_t &ex) {
@@ -875,6 +940,40 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
     options_out->push_back(options::option_t(options::names_t("--no-direct-io"),
                                              options::OPTIONAL_NO_PARAMETER));
     help.add("--no-direct-io", "disable direct I/O");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend {pool,native}",
+             "run disk I/O on a thread pool, or submit it to the kernel's asynchronous "
+             "I/O interface (native works best with direct I/O)");
+    return help;
+}
+
+options::help_section_t get_cache_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Cache options");
+    options_out->push_back(options::option_t(options::names_t("--cache-min-percent"),
+                                             options::OPTIONAL,
+                                             "25"));
+    help.add("--cache-min-percent n",
+             "the smallest a table's cache may shrink to while other tables need the "
+             "memory, as a percentage of the table's cache size");
+    options_out->push_back(options::option_t(options::names_t("--cache-max-percent"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--cache-max-percent n",
+             "the largest a busy table's cache may grow to, as a percentage of the "
+             "table's cache size; 0 for no limit other than the server's total");
+    return help;
+}
+
+options::help_section_t get_js_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("JavaScript options");
+    options_out->push_back(options::option_t(options::names_t("--js-batch-workers"),
+                                             options::OPTIONAL,
+                                             "1"));
+    help.add("--js-batch-workers n",
+             "the number of JavaScript worker processes that may evaluate one batch "
+             "of a map, filter or concatMap in parallel");
     return help;
 }
 
@@ -935,6 +1034,13 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              strprintf("%d", port_defaults::reql_port)));
     help.add("--driver-port port", "port for rethinkdb protocol client drivers");
 
+    options_out->push_back(options::option_t(options::names_t("--driver-conn-placement"),
+                                             options::OPTIONAL,
+                                             "accepting-thread"));
+    help.add("--driver-conn-placement {accepting-thread,least-loaded}",
+             "serve each client driver connection on the thread that accepted it, or on "
+             "the thread with the fewest connections");
+
     options_out->push_back(options::option_t(options::names_t("--port-offset", "-o"),
                                              options::OPTIONAL,
                                              strprintf("%d", port_defaults::port_offset)));
@@ -1021,6 +1127,8 @@ void get_rethinkdb_serve_options(std::vector<options::help_section_t> *help_out,
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_cache_options(options_out));
+    help_out->push_back(get_js_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1032,6 +1140,7 @@ void get_rethinkdb_proxy_options(std::vector<options::help_section_t> *help_out,
                                  std::vector<options::option_t> *options_out) {
     help_out->push_back(get_network_options(true, options_out));
     help_out->push_back(get_web_options(options_out));
+    help_out->push_back(get_js_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1073,6 +1182,8 @@ void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_cache_options(options_out));
+    help_out->push_back(get_js_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1152,6 +1263,20 @@ file_direct_io_mode_t parse_direct_io_mode_option(const std::map<std::string, op
         file_direct_io_mode_t::direct_desired;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      io_backend_t *io_backend_out) {
+    const std::string io_backend = get_single_option(opts, "--io-backend");
+    if (io_backend == "pool") {
+        *io_backend_out = io_backend_t::pool;
+    } else if (io_backend == "native") {
+        *io_backend_out = io_backend_t::native;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be 'pool' or 'native'\n");
+        return false;
+    }
+    return true;
+}
+
 int main_rethinkdb_create(int argc, char *argv[]) {
     std::vector<options::option_t> options;
     std::vector<options::help_section_t> help;
@@ -1182,6 +1307,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         const int num_workers = get_cpu_count();
 
         bool is_new_directory = false;
@@ -1203,6 +1333,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      machine_name,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -1293,6 +1424,14 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        const cache_balancer_bounds_t cache_bounds = parse_cache_bounds_options(opts);
+        const int js_batch_workers = parse_js_batch_workers_option(opts);
+
         // Open and lock the directory, but do not create it
         bool is_new_directory = false;
         directory_lock_t data_directory_lock(base_path, false, &is_new_directory);
@@ -1319,6 +1458,8 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         extproc_spawner_t extproc_spawner;
 
         serve_info_t serve_info(joins, address_ports, web_path,
+                                cache_bounds,
+                                js_batch_workers,
                                 get_optional_option(opts, "--config-file"));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
@@ -1328,6 +1469,7 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      serve_info,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      static_cast<machine_id_t*>(NULL),
                                      static_cast<cluster_semilattice_metadata_t*>(NULL),
                                      &data_directory_lock,
@@ -1419,6 +1561,7 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
 
         const std::string web_path = get_web_path(opts, argv);
         const int num_workers = get_cpu_count();
+        const int js_batch_workers = parse_js_batch_workers_option(opts);
 
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
@@ -1436,6 +1579,8 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
         extproc_spawner_t extproc_spawner;
 
         serve_info_t serve_info(joins, address_ports, web_path,
+                                cache_balancer_bounds_t(),
+                                js_batch_workers,
                                 get_optional_option(opts, "--config-file"));
 
         bool result;
@@ -1549,6 +1694,14 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        const cache_balancer_bounds_t cache_bounds = parse_cache_bounds_options(opts);
+        const int js_batch_workers = parse_js_batch_workers_option(opts);
+
         // Attempt to create the directory early so that the log file can use it.
         // If we create the file, it will be cleaned up unless directory_initialized()
         // is called on it.  This will be done after the metadata files have been created.
@@ -1579,6 +1732,8 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         extproc_spawner_t extproc_spawner;
 
         serve_info_t serve_info(joins, address_ports, web_path,
+                                cache_bounds,
+                                js_batch_workers,
                                 get_optional_option(opts, "--config-file"));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
@@ -1589,6 +1744,7 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      machine_name,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      is_new_directory,
                                      serve_info,
                                      &data_directory_lock,
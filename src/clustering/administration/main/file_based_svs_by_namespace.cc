@@ -15,10 +15,12 @@ template <class protocol_t>
 struct store_args_t {
     store_args_t(io_backender_t *_io_backender, const base_path_t &_base_path,
             namespace_id_t _namespace_id, int64_t _cache_size,
+            alt_cache_balancer_t *_balancer,
             perfmon_collection_t *_serializers_perfmon_collection, typename
             protocol_t::context_t *_ctx)
         : io_backender(_io_backender), base_path(_base_path),
           namespace_id(_namespace_id), cache_size(_cache_size),
+          balancer(_balancer),
           serializers_perfmon_collection(_serializers_perfmon_collection),
           ctx(_ctx)
     { }
@@ -27,6 +29,7 @@ struct store_args_t {
     base_path_t base_path;
     namespace_id_t namespace_id;
     int64_t cache_size;
+    alt_cache_balancer_t *balancer;
     perfmon_collection_t *serializers_perfmon_collection;
     typename protocol_t::context_t *ctx;
 };
@@ -50,7 +53,7 @@ void do_construct_existing_store(
     // TODO: Can we pass serializers_perfmon_collection across threads like this?
     typename protocol_t::store_t *store = new typename protocol_t::store_t(
         multiplexer->proxies[thread_offset], hash_shard_perfmon_name(thread_offset),
-        store_args.cache_size, false, store_args.serializers_perfmon_collection,
+        store_args.cache_size, store_args.balancer, false, store_args.serializers_perfmon_collection,
         store_args.ctx, store_args.io_backender, store_args.base_path);
     (*stores_out_stores)[thread_offset].init(store);
     store_views[thread_offset] = store;
@@ -68,7 +71,7 @@ void do_create_new_store(
     on_thread_t th(threads[thread_offset]);
     typename protocol_t::store_t *store = new typename protocol_t::store_t(
         multiplexer->proxies[thread_offset], hash_shard_perfmon_name(thread_offset),
-        store_args.cache_size, true, store_args.serializers_perfmon_collection,
+        store_args.cache_size, store_args.balancer, true, store_args.serializers_perfmon_collection,
         store_args.ctx, store_args.io_backender, store_args.base_path);
     (*stores_out_stores)[thread_offset].init(store);
     store_views[thread_offset] = store;
@@ -80,6 +83,7 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
             perfmon_collection_t *serializers_perfmon_collection,
             namespace_id_t namespace_id,
             int64_t cache_size,
+            bool compress_blocks,
             stores_lifetimer_t<protocol_t> *stores_out,
             scoped_ptr_t<multistore_ptr_t<protocol_t> > *svs_out,
             typename protocol_t::context_t *ctx) {
@@ -117,8 +121,11 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
         int res = access(serializer_filepath.permanent_path().c_str(), R_OK | W_OK);
         store_args_t<protocol_t> store_args(io_backender_, base_path_,
                                             namespace_id, cache_size / num_stores,
+                                            balancer_,
                                             serializers_perfmon_collection, ctx);
         filepath_file_opener_t file_opener(serializer_filepath, io_backender_);
+        standard_serializer_t::dynamic_config_t serializer_config;
+        serializer_config.compress_blocks = compress_blocks;
         if (res == 0) {
             // TODO: Could we handle failure when loading the serializer?  Right
             // now, we don't.
@@ -126,11 +133,13 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
             {
                 scoped_ptr_t<serializer_t> ser
                     = make_scoped<standard_serializer_t>(
-                        standard_serializer_t::dynamic_config_t(),
+                        serializer_config,
                         &file_opener,
                         serializers_perfmon_collection);
                 ser = make_scoped<merger_serializer_t>(std::move(ser),
-                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                                       MERGER_SERIALIZER_BLOCK_WRITE_WINDOW_MS,
+                                                       serializers_perfmon_collection);
                 serializer = std::move(ser);
             }
 
@@ -152,11 +161,13 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
             {
                 scoped_ptr_t<serializer_t> ser
                     = make_scoped<standard_serializer_t>(
-                        standard_serializer_t::dynamic_config_t(),
+                        serializer_config,
                         &file_opener,
                         serializers_perfmon_collection);
                 ser = make_scoped<merger_serializer_t>(std::move(ser),
-                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                                                       MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                                       MERGER_SERIALIZER_BLOCK_WRITE_WINDOW_MS,
+                                                       serializers_perfmon_collection);
                 serializer = std::move(ser);
             }
 
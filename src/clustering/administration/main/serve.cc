@@ -5,6 +5,7 @@
 
 #include "arch/arch.hpp"
 #include "arch/os_signal.hpp"
+#include "buffer_cache/alt/cache_balancer.hpp"
 #include "clustering/administration/admin_tracker.hpp"
 #include "clustering/administration/auto_reconnect.hpp"
 #include "clustering/administration/http/server.hpp"
@@ -71,10 +72,12 @@ bool do_serve(
     const peer_address_set_t &joins,
     service_address_ports_t address_ports,
     std::string web_assets,
+    const cache_balancer_bounds_t &cache_bounds,
+    int js_batch_workers,
     os_signal_cond_t *stop_cond,
     const boost::optional<std::string> &config_file) {
     try {
-        extproc_pool_t extproc_pool(get_num_threads());
+        extproc_pool_t extproc_pool(get_num_threads(), js_batch_workers);
 
         local_issue_tracker_t local_issue_tracker;
 
@@ -245,6 +248,8 @@ bool do_serve(
                                           auth_manager_cluster.get_root_view(),
                                           &directory_read_manager,
                                           machine_id,
+                                          io_backender,
+                                          base_path,
                                           &get_global_perfmon_collection());
 
         namespace_repo_t<rdb_protocol_t> rdb_namespace_repo(&mailbox_manager,
@@ -256,6 +261,10 @@ bool do_serve(
         rdb_ctx.ns_repo = &rdb_namespace_repo;
 
         {
+            // All the tables' caches on this server share one memory budget.
+            alt_cache_balancer_t cache_balancer(&get_global_perfmon_collection(),
+                                                cache_bounds);
+
             // Reactor drivers
 
             // Dummy
@@ -266,7 +275,7 @@ bool do_serve(
 
             if (i_am_a_server) {
                 dummy_svs_source.init(new file_based_svs_by_namespace_t<mock::dummy_protocol_t>(
-                    io_backender, base_path));
+                    io_backender, &cache_balancer, base_path));
                 dummy_reactor_driver.init(new reactor_driver_t<mock::dummy_protocol_t>(
                     base_path,
                     io_backender,
@@ -299,7 +308,7 @@ bool do_serve(
 
             if (i_am_a_server) {
                 memcached_svs_source.init(new file_based_svs_by_namespace_t<memcached_protocol_t>(
-                    io_backender, base_path));
+                    io_backender, &cache_balancer, base_path));
                 memcached_reactor_driver.init(new reactor_driver_t<memcached_protocol_t>(
                     base_path,
                     io_backender,
@@ -332,7 +341,7 @@ bool do_serve(
 
             if (i_am_a_server) {
                 rdb_svs_source.init(new file_based_svs_by_namespace_t<rdb_protocol_t>(
-                    io_backender, base_path));
+                    io_backender, &cache_balancer, base_path));
                 rdb_reactor_driver.init(new reactor_driver_t<rdb_protocol_t>(
                         base_path,
                         io_backender,
@@ -377,7 +386,8 @@ bool do_serve(
                     &perfmon_repo);
 
                 query2_server_t rdb_pb2_server(address_ports.local_addresses,
-                                               address_ports.reql_port, &rdb_ctx);
+                                               address_ports.reql_port, &rdb_ctx,
+                                               address_ports.reql_conn_placement);
                 logINF("Listening for client driver connections on port %d\n",
                        rdb_pb2_server.get_port());
 
@@ -484,6 +494,8 @@ bool serve(io_backender_t *io_backender,
            const peer_address_set_t &joins,
            service_address_ports_t address_ports,
            std::string web_assets,
+           const cache_balancer_bounds_t &cache_bounds,
+                  int js_batch_workers,
            os_signal_cond_t *stop_cond,
            const boost::optional<std::string>& config_file) {
     return do_serve(io_backender,
@@ -494,6 +506,8 @@ bool serve(io_backender_t *io_backender,
                     joins,
                     address_ports,
                     web_assets,
+                    cache_bounds,
+                    js_batch_workers,
                     stop_cond,
                     config_file);
 }
@@ -501,6 +515,7 @@ bool serve(io_backender_t *io_backender,
 bool serve_proxy(const peer_address_set_t &joins,
                  service_address_ports_t address_ports,
                  std::string web_assets,
+                 int js_batch_workers,
                  os_signal_cond_t *stop_cond,
                  const boost::optional<std::string>& config_file) {
     // TODO: filepath doesn't _seem_ ignored.
@@ -513,6 +528,9 @@ bool serve_proxy(const peer_address_set_t &joins,
                     joins,
                     address_ports,
                     web_assets,
+                    // Proxies have no tables, so they never balance caches.
+                    cache_balancer_bounds_t(),
+                    js_batch_workers,
                     stop_cond,
                     config_file);
 }
@@ -8,6 +8,8 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/persist.hpp"
 #include "arch/address.hpp"
+#include "arch/types.hpp"
+#include "buffer_cache/alt/cache_balancer.hpp"
 
 class os_signal_cond_t;
 
@@ -43,6 +45,7 @@ struct service_address_ports_t {
         client_port(0),
         http_port(0),
         reql_port(0),
+        reql_conn_placement(conn_placement_t::accepting_thread),
         port_offset(0) { }
 
     service_address_ports_t(const std::set<ip_address_t> &_local_addresses,
@@ -52,6 +55,7 @@ struct service_address_ports_t {
                             bool _http_admin_is_disabled,
                             int _http_port,
                             int _reql_port,
+                            conn_placement_t _reql_conn_placement,
                             int _port_offset) :
         local_addresses(_local_addresses),
         canonical_addresses(_canonical_addresses),
@@ -60,6 +64,7 @@ struct service_address_ports_t {
         http_admin_is_disabled(_http_admin_is_disabled),
         http_port(_http_port),
         reql_port(_reql_port),
+        reql_conn_placement(_reql_conn_placement),
         port_offset(_port_offset)
     {
             sanitize_port(port, "port", port_offset);
@@ -79,6 +84,8 @@ struct service_address_ports_t {
     bool http_admin_is_disabled;
     int http_port;
     int reql_port;
+    // Which thread serves each client driver connection.
+    conn_placement_t reql_conn_placement;
     int port_offset;
 };
 
@@ -92,12 +99,15 @@ bool serve(io_backender_t *io_backender,
            const peer_address_set_t &joins,
            service_address_ports_t ports,
            std::string web_assets,
+           const cache_balancer_bounds_t &cache_bounds,
+           int js_batch_workers,
            os_signal_cond_t *stop_cond,
            const boost::optional<std::string>& config_file);
 
 bool serve_proxy(const peer_address_set_t &joins,
                  service_address_ports_t ports,
                  std::string web_assets,
+                 int js_batch_workers,
                  os_signal_cond_t *stop_cond,
                  const boost::optional<std::string>& config_file);
 
@@ -39,6 +39,87 @@ struct cluster_metadata_superblock_t {
 /* Etymology: (R)ethink(D)B (m)eta(d)ata */
 const block_magic_t expected_magic = { { 'R', 'D', 'm', 'd' } };
 
+/* The cluster metadata superblock gets this magic once its blob holds tables'
+`compress_blocks` settings.  A cluster metadata file from the previous
+serializer version still has `expected_magic`, and its blob lacks them. */
+const block_magic_t cluster_expected_magic = { { 'R', 'D', 'm', 'c' } };
+
+/* Reads a table's metadata as the previous serializer version wrote it, which
+is every field but `compress_blocks`.  Those tables don't compress blocks. */
+template <class protocol_t>
+class previous_namespace_semilattice_metadata_t {
+public:
+    namespace_semilattice_metadata_t<protocol_t> ns;
+
+    friend class archive_deserializer_t;
+    archive_result_t rdb_deserialize(read_stream_t *s) {
+        archive_result_t res = archive_result_t::SUCCESS;
+        res = deserialize(s, &ns.blueprint);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.primary_datacenter);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.replica_affinities);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.ack_expectations);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.shards);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.name);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.port);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.primary_pinnings);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.secondary_pinnings);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.primary_key);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.database);
+        if (bad(res)) { return res; }
+        res = deserialize(s, &ns.cache_size);
+        return res;
+    }
+};
+
+template <class protocol_t>
+static archive_result_t deserialize_previous_namespaces(
+        read_stream_t *s,
+        cow_ptr_t<namespaces_semilattice_metadata_t<protocol_t> > *namespaces_out) {
+    std::map<namespace_id_t, deletable_t<previous_namespace_semilattice_metadata_t<protocol_t> > > previous;
+    archive_result_t res = deserialize(s, &previous);
+    if (bad(res)) { return res; }
+
+    typename cow_ptr_t<namespaces_semilattice_metadata_t<protocol_t> >::change_t change(namespaces_out);
+    for (auto it = previous.begin(); it != previous.end(); ++it) {
+        deletable_t<namespace_semilattice_metadata_t<protocol_t> > *ns
+            = &change.get()->namespaces[it->first];
+        if (it->second.is_deleted()) {
+            ns->mark_deleted();
+        } else {
+            *ns->get_mutable() = it->second.get_ref().ns;
+        }
+    }
+    return res;
+}
+
+/* The layout of `cluster_semilattice_metadata_t` is otherwise unchanged, so
+this reads its fields in the same order `RDB_MAKE_ME_SERIALIZABLE_6` does. */
+static archive_result_t deserialize_previous_cluster_metadata(
+        read_stream_t *s, cluster_semilattice_metadata_t *metadata_out) {
+    archive_result_t res = deserialize_previous_namespaces(s, &metadata_out->dummy_namespaces);
+    if (bad(res)) { return res; }
+    res = deserialize_previous_namespaces(s, &metadata_out->memcached_namespaces);
+    if (bad(res)) { return res; }
+    res = deserialize_previous_namespaces(s, &metadata_out->rdb_namespaces);
+    if (bad(res)) { return res; }
+    res = deserialize(s, &metadata_out->machines);
+    if (bad(res)) { return res; }
+    res = deserialize(s, &metadata_out->datacenters);
+    if (bad(res)) { return res; }
+    res = deserialize(s, &metadata_out->databases);
+    return res;
+}
+
 template <class T>
 static void write_blob(buf_parent_t parent, char *ref, int maxreflen,
                        const T &value) {
@@ -75,6 +156,19 @@ static void read_blob(buf_parent_t parent, const char *ref, int maxreflen,
     guarantee_deserialization(res, "T (template code)");
 }
 
+static void read_previous_cluster_metadata_blob(buf_parent_t parent, const char *ref,
+                                                int maxreflen,
+                                                cluster_semilattice_metadata_t *value_out) {
+    blob_t blob(parent.cache()->get_block_size(),
+                     const_cast<char *>(ref), maxreflen);
+    blob_acq_t acq_group;
+    buffer_group_t group;
+    blob.expose_all(parent, access_t::read, &group, &acq_group);
+    buffer_group_read_stream_t ss(const_view(&group));
+    archive_result_t res = deserialize_previous_cluster_metadata(&ss, value_out);
+    guarantee_deserialization(res, "previous cluster_semilattice_metadata_t");
+}
+
 template <class metadata_t>
 persistent_file_t<metadata_t>::persistent_file_t(io_backender_t *io_backender,
                                                  const serializer_filepath_t &filename,
@@ -123,7 +217,7 @@ void persistent_file_t<metadata_t>::construct_serializer_and_cache(const bool cr
     {
         alt_cache_config_t cache_dynamic_config;
         cache_dynamic_config.page_config.memory_limit = MEGABYTE;
-        cache.init(new cache_t(serializer.get(), cache_dynamic_config, perfmon_parent));
+        cache.init(new cache_t(serializer.get(), cache_dynamic_config, NULL, perfmon_parent));
         cache_conn.init(new cache_conn_t(cache.get()));
     }
 
@@ -237,7 +331,7 @@ cluster_persistent_file_t::cluster_persistent_file_t(io_backender_t *io_backende
         = static_cast<cluster_metadata_superblock_t *>(sb_write.get_data_write());
 
     memset(sb, 0, get_cache_block_size().value());
-    sb->magic = expected_magic;
+    sb->magic = cluster_expected_magic;
     sb->machine_id = machine_id;
     write_blob(buf_parent_t(&superblock),
                sb->metadata_blob,
@@ -273,8 +367,14 @@ cluster_semilattice_metadata_t cluster_persistent_file_t::read_metadata() {
     const cluster_metadata_superblock_t *sb
         = static_cast<const cluster_metadata_superblock_t *>(sb_read.get_data_read());
     cluster_semilattice_metadata_t metadata;
-    read_blob(buf_parent_t(&superblock), sb->metadata_blob,
-              cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, &metadata);
+    if (sb->magic == expected_magic) {
+        read_previous_cluster_metadata_blob(buf_parent_t(&superblock), sb->metadata_blob,
+                                            cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN,
+                                            &metadata);
+    } else {
+        read_blob(buf_parent_t(&superblock), sb->metadata_blob,
+                  cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, &metadata);
+    }
     return metadata;
 }
 
@@ -288,6 +388,7 @@ void cluster_persistent_file_t::update_metadata(const cluster_semilattice_metada
         = static_cast<cluster_metadata_superblock_t *>(sb_write.get_data_write());
     write_blob(buf_parent_t(&superblock), sb->metadata_blob,
                cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, metadata);
+    sb->magic = cluster_expected_magic;
 }
 
 machine_id_t cluster_persistent_file_t::read_machine_id() {
@@ -233,14 +233,15 @@ void backfiller_t<protocol_t>::on_cancel_backfill(backfill_session_id_t session_
 
 template <class protocol_t>
 void backfiller_t<protocol_t>::request_backfill_progress(backfill_session_id_t session_id,
-                                                         mailbox_addr_t<void(std::pair<int, int>)> response_mbox,
+                                                         mailbox_addr_t<void(std::pair<int, int>, backfill_throughput_t)> response_mbox,
                                                          auto_drainer_t::lock_t) {
     if (std_contains(local_backfill_progress, session_id) && local_backfill_progress[session_id]) {
         progress_completion_fraction_t fraction = local_backfill_progress[session_id]->guess_completion();
         std::pair<int, int> pair_fraction = std::make_pair(fraction.estimate_of_released_nodes, fraction.estimate_of_total_nodes);
-        send(mailbox_manager, response_mbox, pair_fraction);
+        backfill_throughput_t throughput = local_backfill_progress[session_id]->guess_throughput();
+        send(mailbox_manager, response_mbox, pair_fraction, throughput);
     } else {
-        send(mailbox_manager, response_mbox, std::make_pair(-1, -1));
+        send(mailbox_manager, response_mbox, std::make_pair(-1, -1), backfill_throughput_t());
     }
 
     //TODO indicate an error has occurred
@@ -5,6 +5,7 @@
 #include <map>
 #include <utility>
 
+#include "backfill_progress.hpp"
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/fifo_checker.hpp"
@@ -116,7 +117,7 @@ struct backfiller_business_card_t {
 
 
     /* Mailboxes used for requesting the progress of a backfill */
-    typedef mailbox_t<void(backfill_session_id_t, mailbox_addr_t<void(std::pair<int, int>)>)> request_progress_mailbox_t;
+    typedef mailbox_t<void(backfill_session_id_t, mailbox_addr_t<void(std::pair<int, int>, backfill_throughput_t)>)> request_progress_mailbox_t;
 
     backfiller_business_card_t() { }
     backfiller_business_card_t(
@@ -16,7 +16,14 @@
  */
 
 #define SOFTWARE_NAME_STRING "RethinkDB"
-#define SERIALIZER_VERSION_STRING "1.12"
+// Bump this whenever older binaries would misread files written by the current
+// one.  1.13 added LBA checkpoints and compressed blocks.
+#define SERIALIZER_VERSION_STRING "1.13"
+// Files of the previous version still read fine: the fields that locate LBA
+// checkpoints and hold the sizes of compressed blocks were zero padding in them,
+// which reads as having neither.  They get restamped with the current version
+// when they are opened.
+#define SERIALIZER_PREVIOUS_VERSION_STRING "1.12"
 
 /**
  * Basic configuration parameters.
@@ -57,6 +64,24 @@
 // 0 = minimal priority
 #define SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY   5
 
+// The keys of the secondary indexes that get bulk loaded during post construction
+// get sorted in memory before they're written out to disk in runs.  Together they
+// may take up 1/SINDEX_BULK_LOAD_SORT_MEMORY_DIVISOR of the table's cache memory
+// limit, but no less than SINDEX_BULK_LOAD_MIN_SORT_MEMORY per index.
+// SINDEX_BULK_LOAD_KEYS_PER_TXN is how many of those keys get loaded per
+// transaction.
+#define SINDEX_BULK_LOAD_SORT_MEMORY_DIVISOR      4
+#define SINDEX_BULK_LOAD_MIN_SORT_MEMORY          (1 * MEGABYTE)
+#define SINDEX_BULK_LOAD_KEYS_PER_TXN             1000
+
+// How much memory orderBy and distinct sort in before they write sorted runs out
+// to disk, unless the query sets `sort_memory`.  Whatever the query sets gets
+// clamped to [MIN_SORT_MEMORY, MAX_SORT_MEMORY], so that it can neither create a
+// run for every few items nor keep an unbounded amount in memory.
+#define DEFAULT_SORT_MEMORY                       (64 * MEGABYTE)
+#define MIN_SORT_MEMORY                           (1 * MEGABYTE)
+#define MAX_SORT_MEMORY                           (512 * MEGABYTE)
+
 // Garbage Collection uses its own two IO accounts.
 // There is one low-priority account that is meant to guarantee
 // (performance-wise) unintrusive garbage collection.
@@ -102,11 +127,22 @@
 // merger serializer.
 #define MERGED_INDEX_WRITE_IO_PRIORITY            128
 
+// How long (in milliseconds) the merger serializer waits for more block writes
+// to come in before it writes out the ones it has got, as a single batch.  With
+// 0, only block writes that come in during the same pass of the event loop get
+// merged.  This is a compile-time setting; there is no startup option for it.
+#define MERGER_SERIALIZER_BLOCK_WRITE_WINDOW_MS   1
+
 
 // Maximum number of threads we support
 // TODO: make this dynamic where possible
 #define MAX_THREADS                               128
 
+// The most JavaScript worker processes `--js-batch-workers` may let a single batch
+// of a map, filter or concatMap use.  Each one beyond the first adds a helper
+// worker per thread to the extproc pool.
+#define MAX_JS_BATCH_WORKERS                      16
+
 // Ticks (in milliseconds) the internal timed tasks are performed at
 #define TIMER_TICKS_IN_MS                         5
 
@@ -168,6 +204,18 @@
 // What's the definition of a "young" extent in microseconds?
 #define GC_YOUNG_EXTENT_TIMELIMIT_MICROS          50000
 
+// The GC picks the extent with the best ratio of benefit (the garbage it reclaims,
+// weighted by the extent's age) to cost (the live blocks it has to copy).  This is
+// how often the ages get brought up to date.
+#define GC_SCORE_REFRESH_INTERVAL_MICROS          1000000
+
+// Between gc_low_ratio and gc_high_ratio, the GC relocates blocks in proportion
+// to the user writes.  Close to gc_high_ratio, it goes up to this many times as
+// fast as it needs to keep up with them.
+#define GC_PACING_MAX_URGENCY                     4.0
+// How many extents worth of relocation credit the GC can save up.
+#define GC_PACING_MAX_CREDIT_EXTENTS              2
+
 // If the size of the LBA on a given disk exceeds LBA_MIN_SIZE_FOR_GC, then the fraction of the
 // entries that are live and not garbage should be at least LBA_MIN_UNGARBAGE_FRACTION.
 #define LBA_MIN_SIZE_FOR_GC                       (MEGABYTE * 1)
@@ -179,6 +227,15 @@
 // How many block ids should the LBA garbage collector rewrite before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
+// A shard's LBA gets checkpointed once this many entries have been written to it since the
+// last checkpoint, or once as many entries have been written as the shard has blocks, whichever
+// is more.
+#define LBA_CHECKPOINT_MIN_ENTRIES                (1024 * 64)
+
+// How many entries an LBA checkpoint is written and read in at a time. Must be a multiple of 1024,
+// so that every chunk is a whole number of device blocks.
+#define LBA_CHECKPOINT_CHUNK_ENTRIES              (1024 * 100)
+
 // How many LBA structures to have for each file
 #define LBA_SHARD_FACTOR                          4
 
@@ -200,6 +257,15 @@
 
 #define COROUTINE_STACK_SIZE                      131072
 
+// Stack sizes for coroutines spawned with `coro_stack_class_t::SMALL` and
+// `coro_stack_class_t::LARGE`.
+#define SMALL_COROUTINE_STACK_SIZE                32768
+#define LARGE_COROUTINE_STACK_SIZE                1048576
+
+// Coroutine stacks are carved out of mappings of this much address space (or of a
+// single stack, if that's bigger).
+#define COROUTINE_STACK_REGION_SIZE               (4 * MEGABYTE)
+
 // How many unused coroutine stacks to keep around (maximally), before they are
 // freed. This value is per thread.
 #define COROUTINE_FREE_LIST_SIZE                  64
@@ -40,4 +40,38 @@ archive_result_t deserialize(read_stream_t *s, std::string *out) {
     return archive_result_t::SUCCESS;
 }
 
+size_t serialized_size(const std::vector<char> &v) {
+    return varint_uint64_serialized_size(v.size()) + v.size();
+}
+
+write_message_t &operator<<(write_message_t &msg, const std::vector<char> &v) {
+    serialize_varint_uint64(&msg, v.size());
+    msg.append(v.data(), v.size());
+    return msg;
+}
+
+archive_result_t deserialize(read_stream_t *s, std::vector<char> *out) {
+    out->clear();
+
+    uint64_t sz;
+    archive_result_t res = deserialize_varint_uint64(s, &sz);
+    if (bad(res)) { return res; }
+
+    if (sz > std::numeric_limits<size_t>::max()) {
+        return archive_result_t::RANGE_ERROR;
+    }
+
+    out->resize(sz);
+
+    int64_t num_read = force_read(s, out->data(), sz);
+    if (num_read == -1) {
+        return archive_result_t::SOCK_ERROR;
+    }
+    if (static_cast<uint64_t>(num_read) < sz) {
+        return archive_result_t::SOCK_EOF;
+    }
+
+    return archive_result_t::SUCCESS;
+}
+
 }  // namespace std
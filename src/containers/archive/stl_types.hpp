@@ -128,6 +128,12 @@ size_t serialized_size(const std::string &s);
 write_message_t &operator<<(write_message_t &msg, const std::string &s);
 MUST_USE archive_result_t deserialize(read_stream_t *s, std::string *out);
 
+// Byte vectors are written in one piece, in the same format the generic
+// `std::vector<T>` functions below would produce.
+size_t serialized_size(const std::vector<char> &v);
+write_message_t &operator<<(write_message_t &msg, const std::vector<char> &v);
+MUST_USE archive_result_t deserialize(read_stream_t *s, std::vector<char> *out);
+
 // Think twice before using this function on vectors containing a primitive type --
 // it'll take O(n) time!
 // Keep in sync with operator<<.
@@ -2,6 +2,8 @@
 #ifndef CONTAINERS_ARCHIVE_TCP_CONN_STREAM_HPP_
 #define CONTAINERS_ARCHIVE_TCP_CONN_STREAM_HPP_
 
+#include <sys/uio.h>
+
 #include "arch/address.hpp"
 #include "arch/types.hpp"
 #include "containers/archive/archive.hpp"
@@ -20,6 +22,10 @@ public:
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
 
+    // Writes all `iovcnt` buffers with a single gathered write.  Returns the
+    // total number of bytes written, or -1 upon error.
+    virtual MUST_USE int64_t writev(const iovec *iov, size_t iovcnt);
+
     void rethread(threadnum_t new_thread);
 
     threadnum_t home_thread() const;
@@ -58,6 +64,7 @@ public:
 
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
+    virtual MUST_USE int64_t writev(const iovec *iov, size_t iovcnt);
 
 private:
     keepalive_callback_t *keepalive_callback;
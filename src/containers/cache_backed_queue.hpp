@@ -0,0 +1,67 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_CACHE_BACKED_QUEUE_HPP_
+#define CONTAINERS_CACHE_BACKED_QUEUE_HPP_
+
+#include "concurrency/fifo_checker.hpp"
+#include "concurrency/mutex.hpp"
+#include "containers/disk_backed_queue.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/core.hpp"
+#include "serializer/types.hpp"
+
+class cache_conn_t;
+class cache_t;
+class txn_t;
+class io_backender_t;
+class perfmon_collection_t;
+
+struct queue_block_t {
+    block_id_t next;
+    int32_t data_size, live_data_offset;
+    char data[0];
+} __attribute__((__packed__));
+
+/* The queue `internal_disk_backed_queue_t` used to be: a linked list of blocks
+in a serializer file of its own, accessed through a cache. It has the same
+interface, and is kept around to compare the two against each other (see the
+benchmark in unittest/disk_backed_queue.cc). */
+class internal_cache_backed_queue_t {
+public:
+    internal_cache_backed_queue_t(io_backender_t *io_backender, const serializer_filepath_t& filename, perfmon_collection_t *stats_parent);
+    ~internal_cache_backed_queue_t();
+
+    // TODO: order_token_t::ignore.  This should take an order token and store it.
+    void push(const write_message_t &value);
+
+    // TODO: order_token_t::ignore.  This should output an order token (that was passed in to push).
+    void pop(buffer_group_viewer_t *viewer);
+
+    bool empty();
+
+    int64_t size();
+
+private:
+    void add_block_to_head(txn_t *txn);
+    void remove_block_from_tail(txn_t *txn);
+
+    mutex_t mutex;
+
+    // Serves more as sanity-checking for the cache than this type's ordering.
+    order_source_t cache_order_source;
+    perfmon_collection_t perfmon_collection;
+    perfmon_membership_t perfmon_membership;
+
+    int64_t queue_size;
+
+    // The end we push onto.
+    block_id_t head_block_id;
+    // The end we pop from.
+    block_id_t tail_block_id;
+    scoped_ptr_t<standard_serializer_t> serializer;
+    scoped_ptr_t<cache_t> cache;
+    scoped_ptr_t<cache_conn_t> cache_conn;
+
+    DISABLE_COPYING(internal_cache_backed_queue_t);
+};
+
+#endif  // CONTAINERS_CACHE_BACKED_QUEUE_HPP_
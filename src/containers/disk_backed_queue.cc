@@ -1,92 +1,77 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "containers/disk_backed_queue.hpp"
 
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "arch/arch.hpp"
 #include "arch/io/disk.hpp"
-#include "buffer_cache/alt/alt.hpp"
-#include "buffer_cache/alt/blob.hpp"
-#include "buffer_cache/alt/alt_serialize_onto_blob.hpp"
-#include "serializer/config.hpp"
+#include "config/args.hpp"
+#include "math.hpp"
+#include "utils.hpp"
+
+// The size of each segment file. Segment files are allocated in full when they
+// are created, and deleted in full once everything in them has been popped.
+#define DBQ_SEGMENT_SIZE (32 * MEGABYTE)
+
+// How much we write to or read from a segment file at once. Must divide
+// DBQ_SEGMENT_SIZE and be a multiple of DEVICE_BLOCK_SIZE.
+#define DBQ_CHUNK_SIZE (256 * KILOBYTE)
+
+class internal_disk_backed_queue_t::append_stream_t : public write_stream_t {
+public:
+    explicit append_stream_t(internal_disk_backed_queue_t *_parent) : parent(_parent) { }
+
+    int64_t write(const void *p, int64_t n) {
+        parent->append(p, n);
+        return n;
+    }
 
+private:
+    internal_disk_backed_queue_t *parent;
 
-#define DBQ_MAX_REF_SIZE 251
+    DISABLE_COPYING(append_stream_t);
+};
 
-internal_disk_backed_queue_t::internal_disk_backed_queue_t(io_backender_t *io_backender,
+internal_disk_backed_queue_t::internal_disk_backed_queue_t(io_backender_t *_io_backender,
                                                            const serializer_filepath_t &filename,
                                                            perfmon_collection_t *stats_parent)
-    : perfmon_membership(stats_parent, &perfmon_collection,
+    : io_backender(_io_backender),
+      filename_base(filename.permanent_path()),
+      pm_members(&perfmon_collection,
+                 &pm_segments, "segments",
+                 &pm_bytes, "bytes"),
+      perfmon_membership(stats_parent, &perfmon_collection,
                          filename.permanent_path().c_str()),
       queue_size(0),
-      head_block_id(NULL_BLOCK_ID),
-      tail_block_id(NULL_BLOCK_ID) {
-    filepath_file_opener_t file_opener(filename, io_backender);
-    standard_serializer_t::create(&file_opener,
-                                  standard_serializer_t::static_config_t());
-
-    serializer.init(new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
-                                              &file_opener,
-                                              &perfmon_collection));
-
-    /* Remove the file we just created from the filesystem, so that it will
-       get deleted as soon as the serializer is destroyed or if the process
-       crashes. */
-    file_opener.unlink_serializer_file();
-
-    alt_cache_config_t cache_dynamic_config;
-    cache_dynamic_config.page_config.memory_limit = MEGABYTE;
-    cache.init(new cache_t(serializer.get(), cache_dynamic_config,
-                           &perfmon_collection));
-    cache_conn.init(new cache_conn_t(cache.get()));
-    // Emulate cache_t::create behavior by zeroing the block with id SUPERBLOCK_ID.
-    txn_t txn(cache_conn.get(), write_durability_t::HARD,
-              repli_timestamp_t::distant_past, 1);
-    buf_lock_t block(&txn, SUPERBLOCK_ID, alt_create_t::create);
-    buf_write_t write(&block);
-    const block_size_t block_size = cache->max_block_size();
-    void *buf = write.get_data_write(block_size.value());
-    memset(buf, 0, block_size.value());
+      write_offset(0),
+      read_offset(0),
+      first_segment(0),
+      next_file_number(0),
+      write_buffer_offset(0),
+      read_buffer_offset(-1) {
+    CT_ASSERT(DBQ_SEGMENT_SIZE % DBQ_CHUNK_SIZE == 0);
+    CT_ASSERT(DBQ_CHUNK_SIZE % DEVICE_BLOCK_SIZE == 0);
 }
 
-internal_disk_backed_queue_t::~internal_disk_backed_queue_t() { }
+internal_disk_backed_queue_t::~internal_disk_backed_queue_t() {
+    pm_segments -= segments.size();
+    pm_bytes -= write_offset - read_offset;
+}
 
 void internal_disk_backed_queue_t::push(const write_message_t &wm) {
     mutex_t::acq_t mutex_acq(&mutex);
 
-    // There's no need for hard durability with an unlinked dbq file.
-    txn_t txn(cache_conn.get(), write_durability_t::SOFT,
-              repli_timestamp_t::distant_past, 2);
-
-    if (head_block_id == NULL_BLOCK_ID) {
-        add_block_to_head(&txn);
-    }
-
-    auto _head = make_scoped<buf_lock_t>(buf_parent_t(&txn), head_block_id,
-                                         access_t::write);
-    auto write = make_scoped<buf_write_t>(_head.get());
-    queue_block_t *head = static_cast<queue_block_t *>(write->get_data_write());
-
-    char buffer[DBQ_MAX_REF_SIZE];
-    memset(buffer, 0, DBQ_MAX_REF_SIZE);
-
-    blob_t blob(cache->max_block_size(), buffer, DBQ_MAX_REF_SIZE);
+    // Every value is preceded by its size.
+    const uint64_t value_size = wm.size();
+    append(&value_size, sizeof(value_size));
 
-    write_onto_blob(buf_parent_t(_head.get()), &blob, wm);
-
-    if (static_cast<size_t>((head->data + head->data_size) - reinterpret_cast<char *>(head)) + blob.refsize(cache->max_block_size()) > cache->max_block_size().value()) {
-        // The data won't fit in our current head block, so it's time to make a new one.
-        head = NULL;
-        write.reset();
-        _head.reset();
-        add_block_to_head(&txn);
-        _head.init(new buf_lock_t(buf_parent_t(&txn), head_block_id,
-                                  access_t::write));
-        write.init(new buf_write_t(_head.get()));
-        head = static_cast<queue_block_t *>(write->get_data_write());
-    }
-
-    memcpy(head->data + head->data_size, buffer,
-           blob.refsize(cache->max_block_size()));
-    head->data_size += blob.refsize(cache->max_block_size());
+    append_stream_t stream(this);
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
 
+    pm_bytes += sizeof(value_size) + value_size;
     queue_size++;
 }
 
@@ -94,60 +79,34 @@ void internal_disk_backed_queue_t::pop(buffer_group_viewer_t *viewer) {
     guarantee(size() != 0);
     mutex_t::acq_t mutex_acq(&mutex);
 
-    char buffer[DBQ_MAX_REF_SIZE];
-    // No need for hard durability with an unlinked dbq file.
-    txn_t txn(cache_conn.get(), write_durability_t::SOFT,
-              repli_timestamp_t::distant_past, 2);
-
-    buf_lock_t _tail(buf_parent_t(&txn), tail_block_id, access_t::write);
-
-    /* Grab the data from the blob and delete it. */
-    {
-        buf_read_t read(&_tail);
-        const queue_block_t *tail
-            = static_cast<const queue_block_t *>(read.get_data_read());
-        rassert(tail->data_size != tail->live_data_offset);
-        memcpy(buffer, tail->data + tail->live_data_offset,
-               blob::ref_size(cache->max_block_size(),
-                              tail->data + tail->live_data_offset,
-                              DBQ_MAX_REF_SIZE));
-    }
-
-    /* Grab the data from the blob and delete it. */
-
-    std::vector<char> data_vec;
+    uint64_t value_size;
+    read(read_offset, sizeof(value_size), reinterpret_cast<char *>(&value_size));
+    const int64_t value_offset = read_offset + sizeof(value_size);
+    rassert(value_offset + static_cast<int64_t>(value_size) <= write_offset);
 
-    blob_t blob(cache->max_block_size(), buffer, DBQ_MAX_REF_SIZE);
-    {
-        blob_acq_t acq_group;
-        buffer_group_t blob_group;
-        blob.expose_all(buf_parent_t(&_tail), access_t::read,
-                        &blob_group, &acq_group);
-
-        viewer->view_buffer_group(const_view(&blob_group));
+    const char *value = try_read_in_place(value_offset, value_size);
+    if (value == NULL) {
+        pop_buffer.resize(value_size);
+        read(value_offset, value_size, pop_buffer.data());
+        value = pop_buffer.data();
     }
 
-    int32_t data_size;
-    int32_t live_data_offset;
     {
-        buf_write_t write(&_tail);
-        queue_block_t *tail = static_cast<queue_block_t *>(write.get_data_write());
-        /* Record how far along in the blob we are. */
-        tail->live_data_offset += blob.refsize(cache->max_block_size());
-        data_size = tail->data_size;
-        live_data_offset = tail->live_data_offset;
+        const_buffer_group_t group;
+        group.add_buffer(value_size, value);
+        viewer->view_buffer_group(&group);
     }
 
-    blob.clear(buf_parent_t(&_tail));
-
+    read_offset = value_offset + value_size;
+    pm_bytes -= sizeof(value_size) + value_size;
     queue_size--;
 
-    _tail.reset_buf_lock();
-
-    /* If that was the last blob in this block move on to the next one. */
-    if (live_data_offset == data_size) {
-        remove_block_from_tail(&txn);
+    if (pop_buffer.size() > DBQ_CHUNK_SIZE) {
+        // Don't hold on to the memory of an unusually big value forever.
+        std::vector<char>().swap(pop_buffer);
     }
+
+    drop_consumed_segments();
 }
 
 bool internal_disk_backed_queue_t::empty() {
@@ -158,46 +117,113 @@ int64_t internal_disk_backed_queue_t::size() {
     return queue_size;
 }
 
-void internal_disk_backed_queue_t::add_block_to_head(txn_t *txn) {
-    buf_lock_t _new_head(buf_parent_t(txn), alt_create_t::create);
-    buf_write_t write(&_new_head);
-    queue_block_t *new_head = static_cast<queue_block_t *>(write.get_data_write());
-    if (head_block_id == NULL_BLOCK_ID) {
-        rassert(tail_block_id == NULL_BLOCK_ID);
-        head_block_id = tail_block_id = _new_head.block_id();
-    } else {
-        buf_lock_t _old_head(buf_parent_t(txn), head_block_id,
-                             access_t::write);
-        buf_write_t old_write(&_old_head);
-        queue_block_t *old_head
-            = static_cast<queue_block_t *>(old_write.get_data_write());
-        rassert(old_head->next == NULL_BLOCK_ID);
-        old_head->next = _new_head.block_id();
-        head_block_id = _new_head.block_id();
+void internal_disk_backed_queue_t::append(const void *data, size_t size) {
+    if (!write_buffer.has()) {
+        // Queues that never get pushed to don't need this.
+        write_buffer.init(malloc_aligned(DBQ_CHUNK_SIZE, DEVICE_BLOCK_SIZE));
+    }
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const int64_t buffer_used = write_offset - write_buffer_offset;
+        const size_t n = std::min<size_t>(size, DBQ_CHUNK_SIZE - buffer_used);
+        memcpy(write_buffer.get() + buffer_used, p, n);
+        write_offset += n;
+        p += n;
+        size -= n;
+
+        if (write_offset - write_buffer_offset == DBQ_CHUNK_SIZE) {
+            flush_write_buffer();
+        }
     }
-
-    new_head->next = NULL_BLOCK_ID;
-    new_head->data_size = 0;
-    new_head->live_data_offset = 0;
 }
 
-void internal_disk_backed_queue_t::remove_block_from_tail(txn_t *txn) {
-    rassert(tail_block_id != NULL_BLOCK_ID);
-    buf_lock_t _old_tail(buf_parent_t(txn), tail_block_id,
-                         access_t::write);
+void internal_disk_backed_queue_t::flush_write_buffer() {
+    rassert(write_offset - write_buffer_offset == DBQ_CHUNK_SIZE);
 
-    {
-        buf_write_t old_write(&_old_tail);
-        queue_block_t *old_tail = static_cast<queue_block_t *>(old_write.get_data_write());
-
-        if (old_tail->next == NULL_BLOCK_ID) {
-            rassert(head_block_id == _old_tail.block_id());
-            tail_block_id = head_block_id = NULL_BLOCK_ID;
-        } else {
-            tail_block_id = old_tail->next;
+    const int64_t segment_number = write_buffer_offset / DBQ_SEGMENT_SIZE;
+    if (segments.empty()) {
+        first_segment = segment_number;
+    }
+    while (first_segment + static_cast<int64_t>(segments.size()) <= segment_number) {
+        const std::string path = strprintf("%s.%" PRIi64, filename_base.c_str(),
+                                           next_file_number++);
+        scoped_ptr_t<file_t> file;
+        const file_open_result_t res
+            = open_file(path.c_str(),
+                        linux_file_t::mode_read | linux_file_t::mode_write
+                        | linux_file_t::mode_create | linux_file_t::mode_truncate,
+                        io_backender, &file);
+        if (res.outcome == file_open_result_t::ERROR) {
+            crash_due_to_inaccessible_database_file(path.c_str(), res);
         }
+
+        /* Remove the file we just created from the filesystem, so that it will
+           get deleted as soon as we drop it or if the process crashes. */
+        const int unlink_res = ::unlink(path.c_str());
+        guarantee_err(unlink_res == 0, "unlink() failed");
+
+        file->preallocate(DBQ_SEGMENT_SIZE);
+        segments.push_back(std::move(file));
+        ++pm_segments;
+    }
+
+    // There's no need to sync anything, since the files are gone after a crash
+    // anyway.
+    co_write(segments[segment_number - first_segment].get(),
+             write_buffer_offset % DBQ_SEGMENT_SIZE, DBQ_CHUNK_SIZE,
+             write_buffer.get(), DEFAULT_DISK_ACCOUNT, file_t::NO_DATASYNCS);
+    write_buffer_offset += DBQ_CHUNK_SIZE;
+}
+
+void internal_disk_backed_queue_t::read(int64_t offset, size_t size, char *out) {
+    while (size > 0) {
+        const int64_t chunk_offset = floor_aligned(offset, DBQ_CHUNK_SIZE);
+        const size_t n = std::min<size_t>(size, chunk_offset + DBQ_CHUNK_SIZE - offset);
+        const char *data = try_read_in_place(offset, n);
+        rassert(data != NULL);
+        memcpy(out, data, n);
+        offset += n;
+        out += n;
+        size -= n;
+    }
+}
+
+const char *internal_disk_backed_queue_t::try_read_in_place(int64_t offset, size_t size) {
+    rassert(offset + static_cast<int64_t>(size) <= write_offset);
+    const int64_t chunk_offset = floor_aligned(offset, DBQ_CHUNK_SIZE);
+    if (offset + static_cast<int64_t>(size) > chunk_offset + DBQ_CHUNK_SIZE) {
+        return NULL;
+    }
+
+    if (chunk_offset == write_buffer_offset) {
+        return write_buffer.get() + (offset - chunk_offset);
     }
+    if (chunk_offset != read_buffer_offset) {
+        load_read_buffer(chunk_offset);
+    }
+    return read_buffer.get() + (offset - chunk_offset);
+}
+
+void internal_disk_backed_queue_t::load_read_buffer(int64_t chunk_offset) {
+    rassert(chunk_offset < write_buffer_offset);
+    const int64_t segment_number = chunk_offset / DBQ_SEGMENT_SIZE;
+    rassert(segment_number >= first_segment);
+    rassert(segment_number < first_segment + static_cast<int64_t>(segments.size()));
 
-    _old_tail.mark_deleted();
+    if (!read_buffer.has()) {
+        // Queues that never grow beyond the write buffer don't need this.
+        read_buffer.init(malloc_aligned(DBQ_CHUNK_SIZE, DEVICE_BLOCK_SIZE));
+    }
+    co_read(segments[segment_number - first_segment].get(),
+            chunk_offset % DBQ_SEGMENT_SIZE, DBQ_CHUNK_SIZE,
+            read_buffer.get(), DEFAULT_DISK_ACCOUNT);
+    read_buffer_offset = chunk_offset;
 }
 
+void internal_disk_backed_queue_t::drop_consumed_segments() {
+    while (!segments.empty() && (first_segment + 1) * DBQ_SEGMENT_SIZE <= read_offset) {
+        segments.pop_front();
+        ++first_segment;
+        --pm_segments;
+    }
+}
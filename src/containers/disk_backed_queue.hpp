@@ -2,32 +2,21 @@
 #ifndef CONTAINERS_DISK_BACKED_QUEUE_HPP_
 #define CONTAINERS_DISK_BACKED_QUEUE_HPP_
 
+#include <deque>
 #include <string>
 #include <vector>
 
-#include "concurrency/fifo_checker.hpp"
 #include "concurrency/mutex.hpp"
 #include "containers/buffer_group.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "containers/scoped.hpp"
-#include "perfmon/core.hpp"
-#include "serializer/types.hpp"
+#include "perfmon/perfmon.hpp"
 
-class cache_conn_t;
-class cache_t;
-class txn_t;
+class file_t;
 class io_backender_t;
 class perfmon_collection_t;
 
-struct queue_block_t {
-    block_id_t next;
-    int32_t data_size, live_data_offset;
-    char data[0];
-} __attribute__((__packed__));
-
-class value_acquisition_object_t;
-
 class buffer_group_viewer_t {
 public:
     virtual void view_buffer_group(const const_buffer_group_t *group) = 0;
@@ -39,6 +28,11 @@ protected:
     DISABLE_COPYING(buffer_group_viewer_t);
 };
 
+/* A FIFO of byte strings that spills to disk. It is an append-only log split into
+fixed-size segment files: pushes are collected in memory and written out a big
+chunk at a time, pops read ahead a chunk at a time, and a segment file is deleted
+as soon as everything in it has been popped. The segment files are unlinked right
+after they are created, so nothing is left behind if we crash. */
 class internal_disk_backed_queue_t {
 public:
     internal_disk_backed_queue_t(io_backender_t *io_backender, const serializer_filepath_t& filename, perfmon_collection_t *stats_parent);
@@ -55,25 +49,62 @@ public:
     int64_t size();
 
 private:
-    void add_block_to_head(txn_t *txn);
-    void remove_block_from_tail(txn_t *txn);
+    class append_stream_t;
+
+    // Appends to the log at `write_offset`, flushing the write buffer whenever it
+    // fills up.
+    void append(const void *data, size_t size);
+    void flush_write_buffer();
+
+    // Copies `size` bytes starting at the log offset `offset` (which must not be
+    // past `write_offset`) into `out`.
+    void read(int64_t offset, size_t size, char *out);
+    // Returns a pointer to the given range of the log if it lies entirely within
+    // one of our buffers, loading it from disk if necessary. Returns NULL if the
+    // range straddles two chunks.
+    const char *try_read_in_place(int64_t offset, size_t size);
+    void load_read_buffer(int64_t chunk_offset);
+
+    void drop_consumed_segments();
+
+    io_backender_t *const io_backender;
+    const std::string filename_base;
 
     mutex_t mutex;
 
-    // Serves more as sanity-checking for the cache than this type's ordering.
-    order_source_t cache_order_source;
     perfmon_collection_t perfmon_collection;
+    perfmon_counter_t pm_segments, pm_bytes;
+    perfmon_multi_membership_t pm_members;
     perfmon_membership_t perfmon_membership;
 
     int64_t queue_size;
 
+    // Offsets into the log of every byte ever pushed. Segment `n` holds the bytes
+    // at offsets [n * segment size, (n + 1) * segment size).
     // The end we push onto.
-    block_id_t head_block_id;
+    int64_t write_offset;
     // The end we pop from.
-    block_id_t tail_block_id;
-    scoped_ptr_t<standard_serializer_t> serializer;
-    scoped_ptr_t<cache_t> cache;
-    scoped_ptr_t<cache_conn_t> cache_conn;
+    int64_t read_offset;
+
+    // The segment files that still hold unpopped data; the first one is segment
+    // number `first_segment`.
+    std::deque<scoped_ptr_t<file_t> > segments;
+    int64_t first_segment;
+    int64_t next_file_number;
+
+    // Holds the chunk of the log starting at `write_buffer_offset`, which has not
+    // been written to disk yet. Everything before it is on disk. Allocated on the
+    // first push.
+    scoped_malloc_t<char> write_buffer;
+    int64_t write_buffer_offset;
+
+    // A copy of the chunk of the log starting at `read_buffer_offset` (or -1 if we
+    // haven't read anything from disk yet). Allocated on first use.
+    scoped_malloc_t<char> read_buffer;
+    int64_t read_buffer_offset;
+
+    // Where we put values that straddle two chunks.
+    std::vector<char> pop_buffer;
 
     DISABLE_COPYING(internal_disk_backed_queue_t);
 };
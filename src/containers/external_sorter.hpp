@@ -0,0 +1,269 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_EXTERNAL_SORTER_HPP_
+#define CONTAINERS_EXTERNAL_SORTER_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "concurrency/mutex.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/disk_backed_queue.hpp"
+#include "containers/scoped.hpp"
+#include "utils.hpp"
+
+/* How many items of a sorted run get written to disk (and read back) at a time. */
+#define EXTERNAL_SORTER_CHUNK_SIZE 256
+
+/* How many runs get merged at once.  Every run being merged has a file open and a
+chunk of items in memory. */
+#define EXTERNAL_SORTER_MAX_MERGE_FAN_IN 32
+
+/* `external_sorter_t` sorts more items than we want to keep in memory at once.
+Items get buffered until they take up `memory_limit` bytes (as the caller reports
+their sizes), then the buffer gets sorted and written out to a disk backed queue as a
+run, in `base_path`'s temporary directory.  Whenever
+`EXTERNAL_SORTER_MAX_MERGE_FAN_IN` runs of the same size class pile up, they get
+merged into one bigger run, so only a logarithmic number of runs is ever around.
+Once everything has been pushed, `finish()` merges runs until there are at most
+`EXTERNAL_SORTER_MAX_MERGE_FAN_IN` of them left, and `next()` merges those with
+whatever is still in memory and hands out the items in order.  If everything fits
+into memory, nothing ever touches the disk.
+
+`T` has to be serializable.  `push()` may be called from several coroutines at once;
+everything else must not be. */
+template <class T, class Less = std::less<T> >
+class external_sorter_t {
+public:
+    external_sorter_t(io_backender_t *io_backender,
+                      const base_path_t &base_path,
+                      const std::string &name,
+                      perfmon_collection_t *stats_parent,
+                      size_t memory_limit,
+                      const Less &less = Less())
+        : io_backender_(io_backender), base_path_(base_path), name_(name),
+          stats_parent_(stats_parent), memory_limit_(memory_limit),
+          memory_used_(0), less_(less), runs_created_(0), finished_(false),
+          next_in_buffer_(0) { }
+
+    // Adds an item.  `item_size` is roughly how much memory the item takes up.  May
+    // block while a run gets written out.
+    void push(T &&item, size_t item_size) {
+        guarantee(!finished_);
+        mutex_t::acq_t acq(&mutex_);
+        buffer_.push_back(std::move(item));
+        memory_used_ += item_size;
+        if (memory_used_ >= memory_limit_) {
+            spill_buffer();
+        }
+    }
+
+    // Call once after the last `push()`.  May block.
+    void finish() {
+        guarantee(!finished_);
+        mutex_t::acq_t acq(&mutex_);
+        finished_ = true;
+        std::sort(buffer_.begin(), buffer_.end(), less_);
+
+        // The smallest runs are at the back, merge those first.  Merging `k` runs
+        // leaves `k - 1` fewer, so don't merge more than it takes.
+        while (runs_.size() > EXTERNAL_SORTER_MAX_MERGE_FAN_IN) {
+            const size_t k = std::min<size_t>(
+                EXTERNAL_SORTER_MAX_MERGE_FAN_IN,
+                runs_.size() - EXTERNAL_SORTER_MAX_MERGE_FAN_IN + 1);
+            merge_runs(runs_.size() - k);
+        }
+
+        start_merge(0, &heap_);
+    }
+
+    // Gets the next item in order.  Returns false once there are none left.  May
+    // block while reading a run back in.
+    bool next(T *out) {
+        guarantee(finished_);
+        // The in-memory buffer takes part in the merge like any other run.
+        const bool buffer_left = next_in_buffer_ < buffer_.size();
+        if (heap_.empty()) {
+            if (!buffer_left) {
+                return false;
+            }
+            *out = std::move(buffer_[next_in_buffer_++]);
+            return true;
+        }
+
+        run_t *run = heap_.front();
+        if (buffer_left && less_(buffer_[next_in_buffer_], run->chunk[run->next])) {
+            *out = std::move(buffer_[next_in_buffer_++]);
+            return true;
+        }
+
+        next_from_heap(&heap_, out);
+        return true;
+    }
+
+    // How many runs have been written to disk, including the ones that got merged
+    // into others.
+    size_t num_runs() const { return runs_created_; }
+
+    // How many runs there are right now.
+    size_t num_open_runs() const { return runs_.size(); }
+
+private:
+    struct run_t {
+        run_t(io_backender_t *io_backender, const serializer_filepath_t &filename,
+              perfmon_collection_t *stats_parent, int _level)
+            : queue(io_backender, filename, stats_parent), next(0), level(_level) { }
+        disk_backed_queue_t<std::vector<T> > queue;
+        // The part of the run that has been read back in.
+        std::vector<T> chunk;
+        size_t next;
+        // How many times the items in this run have been merged.
+        int level;
+    };
+
+    // Orders a heap of runs so that the one with the smallest next item ends up at
+    // the front.
+    class heap_less_t {
+    public:
+        explicit heap_less_t(const Less *less) : less_(less) { }
+        bool operator()(const run_t *a, const run_t *b) const {
+            return (*less_)(b->chunk[b->next], a->chunk[a->next]);
+        }
+    private:
+        const Less *less_;
+    };
+
+    scoped_ptr_t<run_t> new_run(int level) {
+        return scoped_ptr_t<run_t>(new run_t(
+            io_backender_,
+            serializer_filepath_t(base_path_,
+                                  strprintf("%s/%s_run_%zu", TEMPORARY_DIRECTORY_NAME,
+                                            name_.c_str(), runs_created_++)),
+            stats_parent_,
+            level));
+    }
+
+    void spill_buffer() {
+        std::vector<T> items;
+        items.swap(buffer_);
+        memory_used_ = 0;
+        std::sort(items.begin(), items.end(), less_);
+
+        scoped_ptr_t<run_t> run = new_run(0);
+        std::vector<T> chunk;
+        for (auto it = items.begin(); it != items.end(); ++it) {
+            chunk.push_back(std::move(*it));
+            if (chunk.size() == EXTERNAL_SORTER_CHUNK_SIZE) {
+                run->queue.push(chunk);
+                chunk.clear();
+            }
+        }
+        if (!chunk.empty()) {
+            run->queue.push(chunk);
+        }
+        runs_.push_back(std::move(run));
+
+        // Runs only ever get merged with runs of the same level, so every item
+        // gets rewritten once per level.
+        for (;;) {
+            const size_t n = EXTERNAL_SORTER_MAX_MERGE_FAN_IN;
+            if (runs_.size() < n
+                || runs_[runs_.size() - n]->level != runs_.back()->level) {
+                break;
+            }
+            merge_runs(runs_.size() - n);
+        }
+    }
+
+    // Replaces the runs from `begin` to the end of `runs_` with a single run.
+    void merge_runs(size_t begin) {
+        rassert(begin < runs_.size());
+        int level = 0;
+        for (size_t i = begin; i < runs_.size(); ++i) {
+            level = std::max(level, runs_[i]->level + 1);
+        }
+        scoped_ptr_t<run_t> merged = new_run(level);
+
+        std::vector<run_t *> heap;
+        start_merge(begin, &heap);
+        std::vector<T> chunk;
+        while (!heap.empty()) {
+            T item;
+            next_from_heap(&heap, &item);
+            chunk.push_back(std::move(item));
+            if (chunk.size() == EXTERNAL_SORTER_CHUNK_SIZE) {
+                merged->queue.push(chunk);
+                chunk.clear();
+            }
+        }
+        if (!chunk.empty()) {
+            merged->queue.push(chunk);
+        }
+
+        runs_.resize(begin);
+        runs_.push_back(std::move(merged));
+    }
+
+    // Reads in the first chunk of every run from `begin` on and puts the runs that
+    // aren't empty into `heap_out`.
+    void start_merge(size_t begin, std::vector<run_t *> *heap_out) {
+        heap_out->clear();
+        for (size_t i = begin; i < runs_.size(); ++i) {
+            load_chunk(runs_[i].get());
+            if (!runs_[i]->chunk.empty()) {
+                heap_out->push_back(runs_[i].get());
+            }
+        }
+        std::make_heap(heap_out->begin(), heap_out->end(), heap_less_t(&less_));
+    }
+
+    // Takes the smallest item out of the runs in `heap`, which must not be empty.
+    void next_from_heap(std::vector<run_t *> *heap, T *out) {
+        rassert(!heap->empty());
+        run_t *run = heap->front();
+        std::pop_heap(heap->begin(), heap->end(), heap_less_t(&less_));
+        *out = std::move(run->chunk[run->next++]);
+        if (run->next == run->chunk.size()) {
+            load_chunk(run);
+        }
+        if (run->chunk.empty()) {
+            heap->pop_back();
+        } else {
+            std::push_heap(heap->begin(), heap->end(), heap_less_t(&less_));
+        }
+    }
+
+    static void load_chunk(run_t *run) {
+        run->chunk.clear();
+        run->next = 0;
+        if (!run->queue.empty()) {
+            run->queue.pop(&run->chunk);
+        }
+    }
+
+    io_backender_t *const io_backender_;
+    const base_path_t base_path_;
+    const std::string name_;
+    perfmon_collection_t *const stats_parent_;
+    const size_t memory_limit_;
+
+    mutex_t mutex_;
+    std::vector<T> buffer_;
+    size_t memory_used_;
+    Less less_;
+
+    // The runs, from the highest level to the lowest.
+    std::vector<scoped_ptr_t<run_t> > runs_;
+    size_t runs_created_;
+
+    bool finished_;
+    size_t next_in_buffer_;
+    // The runs that still have items, as a heap.
+    std::vector<run_t *> heap_;
+
+    DISABLE_COPYING(external_sorter_t);
+};
+
+#endif  // CONTAINERS_EXTERNAL_SORTER_HPP_
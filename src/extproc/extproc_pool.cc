@@ -2,10 +2,16 @@
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 
-extproc_pool_t::extproc_pool_t(size_t worker_count) :
+extproc_pool_t::extproc_pool_t(size_t worker_count, size_t _workers_per_job) :
     ct_interruptors(&interruptor),
     worker_semaphore(worker_count,
-                     extproc_spawner_t::get_instance()) { }
+                     extproc_spawner_t::get_instance()),
+    workers_per_job(_workers_per_job) {
+    guarantee(workers_per_job >= 1);
+    if (workers_per_job > 1) {
+        helper_pool.init(new extproc_pool_t(worker_count * (workers_per_job - 1)));
+    }
+}
 
 extproc_pool_t::~extproc_pool_t() {
     // Can only be destructed on the same thread we were created on
@@ -13,9 +13,21 @@
 //  must be created from within the thread pool
 class extproc_pool_t : public home_thread_mixin_t {
 public:
-    explicit extproc_pool_t(size_t worker_count);
+    // `workers_per_job` is how many workers a single job may use at once: the one
+    //  it holds from this pool, plus up to `workers_per_job - 1` from a separate
+    //  pool of helpers.
+    explicit extproc_pool_t(size_t worker_count, size_t workers_per_job = 1);
     ~extproc_pool_t();
 
+    size_t get_workers_per_job() const { return workers_per_job; }
+
+    // The pool of helper workers, or NULL if `workers_per_job` is 1.  A job may
+    //  only hold helpers while it holds a main worker from this pool, and never
+    //  more than `workers_per_job - 1` of them.  The helper pool is sized for
+    //  every main worker's job to hold that many at once, so a job waiting for a
+    //  helper can't deadlock against other jobs holding on to theirs.
+    extproc_pool_t *get_helper_pool() { return helper_pool.get_or_null(); }
+
     // Get the signal for the current thread that will indicate when this object is being
     //  destroyed, make sure to combine with any other interruptors or shutdown may hang
     signal_t *get_shutdown_signal();
@@ -39,6 +51,9 @@ private:
 
     // Cross-threaded semaphore allowing workers to be acquired from any thread
     cross_thread_semaphore_t<extproc_worker_t> worker_semaphore;
+
+    size_t workers_per_job;
+    scoped_ptr_t<extproc_pool_t> helper_pool;
 };
 
 #endif /* EXTPROC_EXTPROC_POOL_HPP_ */
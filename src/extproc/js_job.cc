@@ -87,6 +87,7 @@ public:
 enum js_task_t {
     TASK_EVAL,
     TASK_CALL,
+    TASK_CALL_BATCH,
     TASK_RELEASE,
     TASK_EXIT
 };
@@ -134,6 +135,28 @@ js_result_t js_job_t::call(js_id_t id, const std::vector<counted_t<const ql::dat
     return result;
 }
 
+void js_job_t::send_call_batch(
+        js_id_t id,
+        const std::vector<std::vector<counted_t<const ql::datum_t> > > &args_batch) {
+    js_task_t task = js_task_t::TASK_CALL_BATCH;
+    write_message_t msg;
+    msg.append(&task, sizeof(task));
+    msg << id;
+    msg << args_batch;
+    int res = send_write_message(extproc_job.write_stream(), &msg);
+    if (res != 0) { throw js_worker_exc_t("failed to send data to the worker"); }
+}
+
+js_result_t js_job_t::read_batch_result() {
+    js_result_t result;
+    archive_result_t res = deserialize(extproc_job.read_stream(), &result);
+    if (bad(res)) {
+        throw js_worker_exc_t(strprintf("failed to deserialize result from worker (%s)",
+                                        archive_result_as_str(res)));
+    }
+    return result;
+}
+
 void js_job_t::release(js_id_t id) {
     js_task_t task = js_task_t::TASK_RELEASE;
     write_message_t msg;
@@ -201,6 +224,28 @@ bool js_job_t::worker_fn(read_stream_t *stream_in, write_stream_t *stream_out) {
                 if (res != 0) { return false; }
             }
             break;
+        case TASK_CALL_BATCH:
+            {
+                js_id_t id;
+                std::vector<std::vector<counted_t<const ql::datum_t> > > args_batch;
+                {
+                    archive_result_t res = deserialize(stream_in, &id);
+                    if (bad(res)) { return false; }
+                    res = deserialize(stream_in, &args_batch);
+                    if (bad(res)) { return false; }
+                }
+
+                // Each result goes out as soon as it's computed, so the parent
+                //  can time every call on its own.
+                for (auto it = args_batch.begin(); it != args_batch.end(); ++it) {
+                    js_result_t js_result = js_env.call(id, *it);
+                    write_message_t msg;
+                    msg << js_result;
+                    int res = send_write_message(stream_out, &msg);
+                    if (res != 0) { return false; }
+                }
+            }
+            break;
         case TASK_RELEASE:
             {
                 js_id_t id;
@@ -537,7 +582,7 @@ v8::Handle<v8::Value> js_from_datum(const counted_t<const ql::datum_t> &datum) {
             return date;
         } else {
             v8::Handle<v8::Object> obj = v8::Object::New();
-            const std::map<std::string, counted_t<const ql::datum_t> > &source_map = datum->as_object();
+            const ql::datum_object_t &source_map = datum->as_object();
 
             for (auto it = source_map.begin(); it != source_map.end(); ++it) {
                 DECLARE_HANDLE_SCOPE(scope);
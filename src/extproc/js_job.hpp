@@ -23,6 +23,14 @@ public:
 
     js_result_t eval(const std::string &source);
     js_result_t call(js_id_t id, const std::vector<counted_t<const ql::datum_t> > &args);
+    // Sends the worker a single message asking it to call the function once for
+    // each argument list in `args_batch`.  The worker replies with one message per
+    // call, in order, which the caller must read with `read_batch_result` exactly
+    // `args_batch.size()` times before sending the next task.
+    void send_call_batch(
+        js_id_t id,
+        const std::vector<std::vector<counted_t<const ql::datum_t> > > &args_batch);
+    js_result_t read_batch_result();
     void release(js_id_t id);
     void exit();
 
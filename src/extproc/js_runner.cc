@@ -171,6 +171,60 @@ js_result_t js_runner_t::call(const std::string &source,
     return result;
 }
 
+std::vector<js_result_t> js_runner_t::call_batch(
+        const std::string &source,
+        const std::vector<std::vector<counted_t<const ql::datum_t> > > &args_batch,
+        const req_config_t &config) {
+    assert_thread();
+    guarantee(job_data.has());
+
+    std::vector<js_result_t> results;
+    if (args_batch.empty()) {
+        return results;
+    }
+
+    // This will retrieve the function from the cache if it's there, or re-eval it
+    js_result_t fn_result = eval(source, config);
+    js_id_t *fn_id = boost::get<js_id_t>(&fn_result);
+    guarantee(fn_id != NULL);
+
+    object_buffer_t<js_timeout_t::sentry_t> sentry;
+
+    try {
+        results.reserve(args_batch.size());
+        job_data->js_job.send_call_batch(*fn_id, args_batch);
+
+        // Each call gets its own `timeout_ms`, starting once the previous
+        //  result has come back
+        for (size_t i = 0; i < args_batch.size(); ++i) {
+            sentry.create(&job_data->js_timeout, config.timeout_ms);
+            results.push_back(job_data->js_job.read_batch_result());
+            sentry.reset();
+        }
+
+        // Functions returned by the calls can't be cached under `source` (one
+        //  source may have produced many of them), so release them right away
+        for (auto it = results.begin(); it != results.end(); ++it) {
+            js_id_t *any_id = boost::get<js_id_t>(&*it);
+            if (any_id != NULL) {
+                release_id(*any_id);
+            }
+        }
+    } catch (...) {
+        // Sentry must be destroyed before the js_timeout
+        if (sentry.has()) {
+            sentry.reset();
+        }
+        // This will mark the worker as errored so we don't try to re-sync with it
+        //  on the next line (since we're in a catch statement, we aren't allowed)
+        job_data->js_job.worker_error();
+        job_data.reset();
+        throw;
+    }
+
+    return results;
+}
+
 void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     guarantee(job_data.has());
     guarantee(id != INVALID_ID);
@@ -64,6 +64,15 @@ public:
                      const std::vector<counted_t<const ql::datum_t> > &args,
                      const req_config_t &config);
 
+    // Calls a previously compiled function once for each argument list in
+    // `args_batch`, sending the whole batch to the worker process in one message.
+    // The timeout in `config` applies to each call separately, exactly as it
+    // does for `call`.
+    std::vector<js_result_t> call_batch(
+        const std::string &source,
+        const std::vector<std::vector<counted_t<const ql::datum_t> > > &args_batch,
+        const req_config_t &config);
+
 private:
     static const size_t CACHE_SIZE;
 
@@ -414,13 +414,14 @@ region_t memcached_protocol_t::cpu_sharding_subspace(int subregion_number, int n
 store_t::store_t(serializer_t *serializer,
                  const std::string &perfmon_name,
                  int64_t cache_size,
+                 alt_cache_balancer_t *balancer,
                  bool create,
                  perfmon_collection_t *parent_perfmon_collection,
                  context_t *ctx,
                  io_backender_t *io,
                  const base_path_t &base_path)
     : btree_store_t<memcached_protocol_t>(
-            serializer, perfmon_name, cache_size,
+            serializer, perfmon_name, cache_size, balancer,
             create, parent_perfmon_collection, ctx, io,
             base_path)
 { }
@@ -179,6 +179,7 @@ public:
         store_t(serializer_t *serializer,
                 const std::string &perfmon_name,
                 int64_t cache_quota,
+                alt_cache_balancer_t *balancer,
                 bool create,
                 perfmon_collection_t *collection,
                 context_t *,
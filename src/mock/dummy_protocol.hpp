@@ -17,6 +17,7 @@
 #include "perfmon/types.hpp"
 #include "utils.hpp"
 
+class alt_cache_balancer_t;
 class signal_t;
 class io_backender_t;
 class serializer_t;
@@ -107,7 +108,8 @@ public:
 
         store_t();
         store_t(serializer_t *serializer, const std::string &perfmon_name,
-                UNUSED int64_t cache_size, bool create,
+                UNUSED int64_t cache_size,
+                UNUSED alt_cache_balancer_t *balancer, bool create,
                 perfmon_collection_t *collection, context_t *ctx,
                 io_backender_t *io, const base_path_t &);
         ~store_t();
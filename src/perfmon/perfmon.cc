@@ -3,6 +3,7 @@
 
 #include <stdarg.h>
 #include <math.h>
+#include <string.h>
 #include <map>
 
 #include "utils.hpp"
@@ -61,6 +62,40 @@ scoped_ptr_t<perfmon_result_t> perfmon_counter_t::output_stat(const int64_t &sta
     return make_scoped<perfmon_result_t>(strprintf("%" PRIi64, stat));
 }
 
+/* perfmon_high_water_t */
+
+perfmon_high_water_t::perfmon_high_water_t()
+    : perfmon_perthread_t<cache_line_padded_t<int64_t>, int64_t>(),
+      thread_data(new padded_int64_t[MAX_THREADS])
+{
+    for (int i = 0; i < MAX_THREADS; i++) thread_data[i].value = 0;
+}
+
+perfmon_high_water_t::~perfmon_high_water_t() {
+    delete[] thread_data;
+}
+
+int64_t &perfmon_high_water_t::get() {
+    rassert(get_thread_id().threadnum >= 0);
+    return thread_data[get_thread_id().threadnum].value;
+}
+
+void perfmon_high_water_t::get_thread_stat(padded_int64_t *stat) {
+    stat->value = get();
+}
+
+int64_t perfmon_high_water_t::combine_stats(const padded_int64_t *data) {
+    int64_t value = 0;
+    for (int i = 0; i < get_num_threads(); i++) {
+        value = std::max(value, data[i].value);
+    }
+    return value;
+}
+
+scoped_ptr_t<perfmon_result_t> perfmon_high_water_t::output_stat(const int64_t &stat) {
+    return make_scoped<perfmon_result_t>(strprintf("%" PRIi64, stat));
+}
+
 /* perfmon_sampler_t */
 
 perfmon_sampler_t::perfmon_sampler_t(ticks_t _length, bool _include_rate)
@@ -138,6 +173,160 @@ scoped_ptr_t<perfmon_result_t> perfmon_sampler_t::output_stat(const stats_t &agg
     return stat;
 }
 
+/* perfmon_histogram_t */
+
+namespace perfmon_histogram {
+
+int bucket_for_value(uint64_t value) {
+    if (value < static_cast<uint64_t>(SUB_BUCKET_COUNT)) {
+        return static_cast<int>(value);
+    }
+    if (value >> MAX_VALUE_BITS != 0) {
+        return NUM_BUCKETS - 1;
+    }
+    // `magnitude` is the index of the highest set bit, at least SUB_BUCKET_BITS.
+    int magnitude = 63 - __builtin_clzll(value);
+    int shift = magnitude - SUB_BUCKET_BITS;
+    int sub_bucket = static_cast<int>(value >> shift) - SUB_BUCKET_COUNT;
+    return (shift + 1) * SUB_BUCKET_COUNT + sub_bucket;
+}
+
+uint64_t bucket_upper_bound(int bucket) {
+    rassert(bucket >= 0 && bucket < NUM_BUCKETS);
+    if (bucket < SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    int shift = bucket / SUB_BUCKET_COUNT - 1;
+    uint64_t sub_bucket = bucket % SUB_BUCKET_COUNT;
+    return ((SUB_BUCKET_COUNT + sub_bucket + 1) << shift) - 1;
+}
+
+stats_t::stats_t() : count(0), max(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void stats_t::record(uint64_t value) {
+    ++count;
+    max = std::max(max, value);
+    ++buckets[bucket_for_value(value)];
+}
+
+void stats_t::aggregate(const stats_t &s) {
+    if (s.count == 0) {
+        return;
+    }
+    count += s.count;
+    max = std::max(max, s.max);
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] += s.buckets[i];
+    }
+}
+
+uint64_t stats_t::quantile(double q) const {
+    rassert(count > 0);
+    uint64_t rank = static_cast<uint64_t>(ceil(q * count));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // The bucket's upper bound can overshoot the largest value recorded.
+            return std::min(bucket_upper_bound(i), max);
+        }
+    }
+    return max;
+}
+
+std::vector<double> default_quantiles() {
+    std::vector<double> res;
+    res.push_back(0.5);
+    res.push_back(0.9);
+    res.push_back(0.99);
+    res.push_back(0.999);
+    return res;
+}
+
+}   /* namespace perfmon_histogram */
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length, const std::vector<double> &_quantiles)
+    : perfmon_perthread_t<stats_t>(), thread_data(MAX_THREADS), length(_length), quantiles(_quantiles)
+{
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread_data[i].current_interval = get_ticks() / length;
+    }
+}
+
+perfmon_histogram_t::thread_info_t *perfmon_histogram_t::update(ticks_t now) {
+    int64_t interval = now / length;
+    rassert(get_thread_id().threadnum >= 0);
+    thread_info_t *thread = &thread_data[get_thread_id().threadnum];
+
+    if (thread->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread->current_interval + 1 == interval) {
+        /* We're one step behind; recycle the old buffer for the new interval */
+        thread->last_stats.swap(thread->current_stats);
+        if (thread->current_stats.has()) {
+            *thread->current_stats = stats_t();
+        }
+        thread->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        if (thread->current_stats.has()) {
+            *thread->current_stats = stats_t();
+        }
+        thread->last_stats.reset();
+        thread->current_interval = interval;
+    }
+    return thread;
+}
+
+void perfmon_histogram_t::record(double secs) {
+    thread_info_t *thread = update(get_ticks());
+    if (!thread->current_stats.has()) {
+        thread->current_stats.init(new stats_t());
+    }
+    thread->current_stats->record(secs > 0 ? static_cast<uint64_t>(secs * 1e9) : 0);
+}
+
+void perfmon_histogram_t::get_thread_stat(stats_t *stat) {
+    /* As with perfmon_sampler_t, report the last complete interval. */
+    thread_info_t *thread = update(get_ticks());
+    if (thread->last_stats.has()) {
+        *stat = *thread->last_stats;
+    }
+}
+
+perfmon_histogram_t::stats_t perfmon_histogram_t::combine_stats(const stats_t *stats) {
+    stats_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+scoped_ptr_t<perfmon_result_t> perfmon_histogram_t::output_stat(const stats_t &aggregated) {
+    scoped_ptr_t<perfmon_result_t> stat = perfmon_result_t::alloc_map_result();
+
+    stat->insert(stat_count, new perfmon_result_t(strprintf("%" PRIu64, aggregated.count)));
+    stat->insert(stat_per_sec, new perfmon_result_t(strprintf("%.8f", aggregated.count / ticks_to_secs(length))));
+    for (size_t i = 0; i < quantiles.size(); ++i) {
+        std::string name = strprintf("p%g", quantiles[i] * 100);
+        if (aggregated.count > 0) {
+            stat->insert(name, new perfmon_result_t(strprintf("%.8f", aggregated.quantile(quantiles[i]) / 1e9)));
+        } else {
+            stat->insert(name, new perfmon_result_t(no_value));
+        }
+    }
+    if (aggregated.count > 0) {
+        stat->insert(stat_max, new perfmon_result_t(strprintf("%.8f", aggregated.max / 1e9)));
+    } else {
+        stat->insert(stat_max, new perfmon_result_t(no_value));
+    }
+
+    return stat;
+}
+
 /* perfmon_stddev_t */
 
 stddev_t::stddev_t()
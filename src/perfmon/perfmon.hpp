@@ -13,6 +13,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "concurrency/cache_line_padded.hpp"
 #include "config/args.hpp"
@@ -78,6 +79,29 @@ public:
     void operator-=(int64_t num) { get() -= num; }
 };
 
+/* perfmon_high_water_t is a perfmon_t that keeps track of the highest value
+ * something has reached since startup, across all threads.
+ */
+class perfmon_high_water_t : public perfmon_perthread_t<cache_line_padded_t<int64_t>, int64_t> {
+    typedef cache_line_padded_t<int64_t> padded_int64_t;
+    padded_int64_t *thread_data;
+
+    int64_t &get();
+
+    void get_thread_stat(padded_int64_t *);
+    int64_t combine_stats(const padded_int64_t *);
+    scoped_ptr_t<perfmon_result_t> output_stat(const int64_t&);
+public:
+    perfmon_high_water_t();
+    virtual ~perfmon_high_water_t();
+    void record(int64_t value) {
+        int64_t &high = get();
+        if (value > high) {
+            high = value;
+        }
+    }
+};
+
 /* perfmon_sampler_t is a perfmon_t that keeps a log of events that happen.
  * When something happens, call the perfmon_sampler_t's record() method. The
  * perfmon_sampler_t will retain that record until 'length' ticks have passed.
@@ -137,6 +161,79 @@ public:
     void record(double value);
 };
 
+/* perfmon_histogram_t records durations (in seconds) into a log-linear
+ * histogram, in the style of HdrHistogram, and reports the count, the max and
+ * a configurable list of quantiles over the last complete interval of
+ * 'length' ticks. Every power of two is split into 2^SUB_BUCKET_BITS linear
+ * sub-buckets, so reported quantiles are within ~3% of the true value.
+ * Each thread records into its own buckets, which are only allocated once the
+ * thread records something; the per-thread histograms are merged when stats
+ * are collected. */
+
+namespace perfmon_histogram {
+
+// Values are stored as integer nanoseconds.
+static const int SUB_BUCKET_BITS = 5;
+static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+// Anything at or above 2^MAX_VALUE_BITS ns (about 4.9 hours) lands in the last bucket.
+static const int MAX_VALUE_BITS = 44;
+static const int NUM_BUCKETS = SUB_BUCKET_COUNT * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+int bucket_for_value(uint64_t value);
+// The largest value that maps to `bucket`.
+uint64_t bucket_upper_bound(int bucket);
+
+struct stats_t {
+    uint64_t count;
+    uint64_t max;
+    uint64_t buckets[NUM_BUCKETS];
+
+    stats_t();
+    void record(uint64_t value);
+    void aggregate(const stats_t &s);
+    // Returns the (upper bound of the) value below which `q` of the records fall.
+    uint64_t quantile(double q) const;
+};
+
+std::vector<double> default_quantiles();
+
+}   /* namespace perfmon_histogram */
+
+class perfmon_histogram_t : public perfmon_perthread_t<perfmon_histogram::stats_t> {
+    typedef perfmon_histogram::stats_t stats_t;
+    struct thread_info_t {
+        scoped_ptr_t<stats_t> current_stats, last_stats;
+        int64_t current_interval;
+    };
+
+    scoped_array_t<thread_info_t> thread_data;
+
+    void get_thread_stat(stats_t *);
+    stats_t combine_stats(const stats_t *);
+    scoped_ptr_t<perfmon_result_t> output_stat(const stats_t&);
+
+    thread_info_t *update(ticks_t now);
+
+    ticks_t length;
+    std::vector<double> quantiles;
+public:
+    explicit perfmon_histogram_t(ticks_t _length,
+                                 const std::vector<double> &_quantiles
+                                     = perfmon_histogram::default_quantiles());
+    void record(double secs);
+};
+
+/* Records the lifetime of the block into a perfmon_histogram_t. */
+struct block_pm_histogram {
+    ticks_t start;
+    perfmon_histogram_t *pm;
+    explicit block_pm_histogram(perfmon_histogram_t *_pm)
+        : start(get_ticks()), pm(_pm) { }
+    ~block_pm_histogram() {
+        pm->record(ticks_to_secs(get_ticks() - start));
+    }
+};
+
 // One-pass variance calculation algorithm/datastructure taken from
 // http://www.cs.berkeley.edu/~mhoemmen/cs194/Tutorials/variance.pdf
 struct stddev_t {
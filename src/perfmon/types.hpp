@@ -5,10 +5,12 @@
 class perfmon_collection_t;
 class perfmon_result_t;
 class perfmon_counter_t;
+class perfmon_high_water_t;
 class perfmon_sampler_t;
 struct perfmon_stddev_t;
 struct perfmon_duration_sampler_t;
 class perfmon_rate_monitor_t;
+class perfmon_histogram_t;
 struct perfmon_function_t;
 
 #endif  // PERFMON_TYPES_HPP_
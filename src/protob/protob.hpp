@@ -15,7 +15,12 @@
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/cache_line_padded.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/mutex.hpp"
+#include "concurrency/new_semaphore.hpp"
+#include "concurrency/one_per_thread.hpp"
+#include "concurrency/rwlock.hpp"
 #include "containers/archive/archive.hpp"
 #include "http/http.hpp"
 
@@ -122,8 +127,29 @@ private:
 // // Retrieves the protocol buffers object from an initialized request_t.
 // request_t::protob_type *underlying_protob_value(request_t *request);
 //
+// // In CORO_UNORDERED mode, returns true if the request must not start until
+// // every request received before it on the connection has completed (and no
+// // later request may start until it has completed).
+// bool is_barrier_request(request_t *request);
+//
 // "request_t::protob_type" does not actually have to be defined.
 
+// Returns the thread in [0, num_threads) with the fewest connections according to
+// `conns_per_thread`, preferring `preferred_thread` on ties.  The counts may get
+// changed by other threads meanwhile.
+inline int least_loaded_thread(const cache_line_padded_t<int64_t> *conns_per_thread,
+                               int num_threads, int preferred_thread) {
+    int best = preferred_thread < num_threads ? preferred_thread : 0;
+    int64_t best_conns = __atomic_load_n(&conns_per_thread[best].value, __ATOMIC_RELAXED);
+    for (int i = 0; i < num_threads; ++i) {
+        int64_t conns = __atomic_load_n(&conns_per_thread[i].value, __ATOMIC_RELAXED);
+        if (conns < best_conns) {
+            best = i;
+            best_conns = conns;
+        }
+    }
+    return best;
+}
 
 template <class request_t, class response_t, class context_t>
 class protob_server_t : public http_app_t {
@@ -133,13 +159,41 @@ public:
                     boost::function<bool(request_t, response_t *, context_t *)> _f,  // NOLINT(readability/casting)
                     response_t (*_on_unparsable_query)(request_t, std::string),
                     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > _auth_metadata,
-                    protob_server_callback_mode_t _cb_mode = CORO_ORDERED);
+                    protob_server_callback_mode_t _cb_mode = CORO_ORDERED,
+                    conn_placement_t _conn_placement = conn_placement_t::accepting_thread);
     ~protob_server_t();
 
     int get_port() const;
 private:
+    // The most queries a single connection may have running at once in
+    // CORO_UNORDERED mode.  Once it's reached we stop reading from the connection
+    // until one of them completes.
+    static const int64_t MAX_IN_FLIGHT_QUERIES_PER_CONN = 1024;
 
-    void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, auto_drainer_t::lock_t);
+    // Per-connection state shared by the query coroutines in CORO_UNORDERED mode.
+    struct unordered_conn_t {
+        unordered_conn_t(tcp_conn_t *_conn, context_t *_ctx, signal_t *_closer)
+            : conn(_conn), ctx(_ctx), closer(_closer),
+              in_flight(MAX_IN_FLIGHT_QUERIES_PER_CONN) { }
+        tcp_conn_t *conn;
+        context_t *ctx;
+        signal_t *closer;
+        // Responses are written whole, one at a time, in completion order.
+        mutex_t send_mutex;
+        new_semaphore_t in_flight;
+        // Ordinary requests hold this for reading, barrier requests for writing.
+        rwlock_t barrier_lock;
+        // Must be last: waits for the query coroutines before the rest goes away.
+        auto_drainer_t drainer;
+    };
+
+    // Called on the thread that accepted the connection.
+    void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn);
+    threadnum_t choose_conn_thread();
+    void handle_unordered_query(unordered_conn_t *uconn,
+                                request_t request,
+                                new_semaphore_acq_t *in_flight_acq,
+                                auto_drainer_t::lock_t keepalive);
     void send(const response_t &, tcp_conn_t *conn, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
     static auth_key_t read_auth_key(tcp_conn_t *conn, signal_t *interruptor);
 
@@ -152,12 +206,24 @@ private:
     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > auth_metadata;
 
     protob_server_callback_mode_t cb_mode;
+    conn_placement_t conn_placement;
+    // Whether `tcp_listener` accepts connections on every db thread.  Decided
+    // before it starts listening, since connections can come in before
+    // `tcp_listener` is set.
+    const bool accepting_per_thread;
+
+    // The number of open connections on each thread, for
+    // `conn_placement_t::least_loaded_thread`.  Updated atomically from any thread.
+    scoped_array_t<cache_line_padded_t<int64_t> > conns_per_thread;
 
     /* WARNING: The order here is fragile. */
     cond_t main_shutting_down_cond;
     signal_t *shutdown_signal() { return &shutting_down_conds[get_thread_id().threadnum]; }
     boost::ptr_vector<cross_thread_signal_t> shutting_down_conds;
     auto_drainer_t auto_drainer;
+    // Connections are handled starting on the accepting thread, so they keep the
+    // server alive with a lock on that thread's drainer.
+    one_per_thread_t<auto_drainer_t> conn_drainers;
     struct pulse_on_destruct_t {
         explicit pulse_on_destruct_t(cond_t *_cond) : cond(_cond) { }
         ~pulse_on_destruct_t() { cond->pulse(); }
@@ -165,8 +231,9 @@ private:
     } pulse_sdc_on_shutdown;
     http_conn_cache_t<context_t> http_conn_cache;
 
-    scoped_ptr_t<tcp_listener_t> tcp_listener;
+    scoped_ptr_t<per_thread_tcp_listener_t> tcp_listener;
 
+    // Only used to round-robin when there's a single listening thread.
     unsigned next_thread;
 };
 
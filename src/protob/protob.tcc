@@ -17,6 +17,7 @@
 #include "arch/io/network.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/interruptor.hpp"
 #include "containers/auth_key.hpp"
 #include "rpc/semilattice/joins/vclock.hpp"
 #include "rpc/semilattice/view.hpp"
@@ -30,16 +31,22 @@ protob_server_t<request_t, response_t, context_t>::protob_server_t(
     boost::function<bool(request_t, response_t *, context_t *)> _f,  // NOLINT(readability/casting)
     response_t (*_on_unparsable_query)(request_t, std::string),
     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > _auth_metadata,
-    protob_server_callback_mode_t _cb_mode)
+    protob_server_callback_mode_t _cb_mode,
+    conn_placement_t _conn_placement)
     : f(_f),
       on_unparsable_query(_on_unparsable_query),
       auth_metadata(_auth_metadata),
       cb_mode(_cb_mode),
+      conn_placement(_conn_placement),
+      accepting_per_thread(
+          per_thread_tcp_listener_t::listens_per_thread(get_num_db_threads())),
+      conns_per_thread(get_num_threads()),
       shutting_down_conds(get_num_threads()),
       pulse_sdc_on_shutdown(&main_shutting_down_cond),
       next_thread(0) {
 
     for (int i = 0; i < get_num_threads(); ++i) {
+        conns_per_thread[i].value = 0;
         cross_thread_signal_t *s =
             new cross_thread_signal_t(&main_shutting_down_cond, threadnum_t(i));
         shutting_down_conds.push_back(s);
@@ -47,11 +54,12 @@ protob_server_t<request_t, response_t, context_t>::protob_server_t(
     }
 
     try {
-        tcp_listener.init(new tcp_listener_t(
+        tcp_listener.init(new per_thread_tcp_listener_t(
             local_addresses,
             port,
+            get_num_db_threads(),
             boost::bind(&protob_server_t<request_t, response_t, context_t>::handle_conn,
-                        this, _1, auto_drainer_t::lock_t(&auto_drainer))));
+                        this, _1)));
     } catch (const address_in_use_exc_t &ex) {
         throw address_in_use_exc_t(strprintf("Could not bind to RDB protocol port: %s", ex.what()));
     }
@@ -95,15 +103,49 @@ auth_key_t protob_server_t<request_t, response_t, context_t>::read_auth_key(tcp_
     return ret;
 }
 
+template <class request_t, class response_t, class context_t>
+threadnum_t protob_server_t<request_t, response_t, context_t>::choose_conn_thread() {
+    const int num_db_threads = get_num_db_threads();
+    const int accepting_thread = get_thread_id().threadnum;
+    if (conn_placement == conn_placement_t::least_loaded_thread) {
+        // Ties go to the accepting thread, which saves a thread switch.
+        return threadnum_t(least_loaded_thread(conns_per_thread.data(),
+                                               num_db_threads, accepting_thread));
+    } else if (accepting_per_thread) {
+        // The kernel already picked a thread for us.
+        return threadnum_t(accepting_thread);
+    } else {
+        // All connections come in on one thread.
+        return threadnum_t((next_thread++) % num_db_threads);
+    }
+}
+
 template <class request_t, class response_t, class context_t>
 void protob_server_t<request_t, response_t, context_t>::handle_conn(
-    const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
-    auto_drainer_t::lock_t keepalive) {
+    const scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+    auto_drainer_t::lock_t keepalive(conn_drainers.get());
+
+    // Connections get accepted on every db thread, but the auth metadata view
+    // only works on its home thread.
+    vclock_t<auth_key_t> auth_vclock;
+    {
+        on_thread_t thread_switcher(auth_metadata->home_thread());
+        auth_vclock = auth_metadata->get().auth_key;
+    }
 
-    // This must be read here because of home threads and stuff
-    const vclock_t<auth_key_t> auth_vclock = auth_metadata->get().auth_key;
+    threadnum_t chosen_thread = choose_conn_thread();
+    // Counted before switching threads, so that connections accepted meanwhile on
+    // other threads see it.
+    struct conn_count_t {
+        explicit conn_count_t(int64_t *_count) : count(_count) {
+            __sync_add_and_fetch(count, 1);
+        }
+        ~conn_count_t() {
+            __sync_sub_and_fetch(count, 1);
+        }
+        int64_t *count;
+    } conn_count(&conns_per_thread[chosen_thread.threadnum].value);
 
-    threadnum_t chosen_thread = threadnum_t((next_thread++) % get_num_db_threads());
     cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
     on_thread_t rethreader(chosen_thread);
 
@@ -165,8 +207,24 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
         return;
     }
 
+    // Declared after `conn` and `ctx`, so that its drainer waits for any query
+    // coroutines still running before those are destroyed.
+    unordered_conn_t uconn(conn.get(), &ctx, &ct_keepalive);
+
     //TODO figure out how to do this with less copying
     for (;;) {
+        // In CORO_UNORDERED mode we stop reading once the connection has too many
+        // queries in flight, so that one client can't queue up unbounded work.
+        new_semaphore_acq_t in_flight_acq;
+        if (cb_mode == CORO_UNORDERED) {
+            in_flight_acq.init(&uconn.in_flight, 1);
+            try {
+                wait_interruptible(in_flight_acq.acquisition_signal(), &ct_keepalive);
+            } catch (const interrupted_exc_t &) {
+                return;
+            }
+        }
+
         request_t request;
         make_empty_protob_bearer(&request);
         bool force_response = false;
@@ -192,8 +250,7 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
                 }
             }
         } catch (const tcp_conn_read_closed_exc_t &) {
-            //TODO need to figure out what blocks us up here in non inline cb
-            //mode
+            // `uconn`'s drainer waits for any queries that are still running.
             return;
         }
 
@@ -214,7 +271,19 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
                 crash("unimplemented");
                 break;
             case CORO_UNORDERED:
-                crash("unimplemented");
+                if (force_response) {
+                    mutex_t::acq_t send_acq(&uconn.send_mutex);
+                    send(forced_response, conn.get(), &ct_keepalive);
+                } else {
+                    // `spawn_now_dangerously` runs the coroutine up to its first
+                    // block, so it takes over `in_flight_acq` and gets in line for
+                    // `barrier_lock` before we read the next query.
+                    coro_t::spawn_now_dangerously(
+                        std::bind(&protob_server_t<request_t, response_t,
+                                                   context_t>::handle_unordered_query,
+                                  this, &uconn, request, &in_flight_acq,
+                                  uconn.drainer.lock()));
+                }
                 break;
             default:
                 crash("unreachable");
@@ -228,6 +297,38 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
     }
 }
 
+template <class request_t, class response_t, class context_t>
+void protob_server_t<request_t, response_t, context_t>::handle_unordered_query(
+    unordered_conn_t *uconn,
+    request_t request,
+    new_semaphore_acq_t *in_flight_acq,
+    auto_drainer_t::lock_t keepalive) {
+    new_semaphore_acq_t in_flight(std::move(*in_flight_acq));
+    rwlock_in_line_t barrier_in_line(&uconn->barrier_lock,
+                                     is_barrier_request(&request)
+                                         ? access_t::write
+                                         : access_t::read);
+    try {
+        wait_interruptible(is_barrier_request(&request)
+                               ? barrier_in_line.write_signal()
+                               : barrier_in_line.read_signal(),
+                           keepalive.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        return;
+    }
+
+    response_t response;
+    bool response_needed = f(request, &response, uconn->ctx);
+    if (response_needed) {
+        try {
+            mutex_t::acq_t send_acq(&uconn->send_mutex);
+            send(response, uconn->conn, uconn->closer);
+        } catch (const tcp_conn_write_closed_exc_t &) {
+            // The main loop will notice the closed connection on its next read.
+        }
+    }
+}
+
 template <class request_t, class response_t, class context_t>
 void protob_server_t<request_t, response_t, context_t>::send(
     const response_t &res,
@@ -327,7 +428,10 @@ void protob_server_t<request_t, response_t, context_t>::handle(const http_req_t
 
             response_t response;
             switch (cb_mode) {
+            // The HTTP server already handles each request in its own coroutine, so
+            // CORO_UNORDERED needs nothing special here.
             case INLINE:
+            case CORO_UNORDERED:
                 {
                     boost::shared_ptr<typename http_conn_cache_t<context_t>::http_conn_t> conn =
                         http_conn_cache.find(conn_id);
@@ -368,7 +472,6 @@ void protob_server_t<request_t, response_t, context_t>::handle(const http_req_t
                 }
                 break;
             case CORO_ORDERED:
-            case CORO_UNORDERED:
                 crash("unimplemented");
             default:
                 crash("unreachable");
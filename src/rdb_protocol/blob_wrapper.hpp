@@ -30,6 +30,12 @@ public:
                     buffer_group_t *buffer_group_out,
                     blob_acq_t *acq_group_out);
 
+    /* This function only works in read mode. */
+    void expose_region(buf_parent_t parent, access_t mode,
+                       int64_t offset, int64_t size,
+                       buffer_group_t *buffer_group_out,
+                       blob_acq_t *acq_group_out);
+
 private:
     blob_t internal;
 };
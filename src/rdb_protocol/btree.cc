@@ -1,24 +1,32 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/btree.hpp"
 
+#include <algorithm>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "btree/backfill.hpp"
+#include "btree/bulk_load.hpp"
 #include "btree/concurrent_traversal.hpp"
 #include "btree/erase_range.hpp"
 #include "btree/get_distribution.hpp"
 #include "btree/operations.hpp"
 #include "btree/parallel_traversal.hpp"
+#include "btree/superblock.hpp"
 #include "buffer_cache/alt/alt_serialize_onto_blob.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/vector_stream.hpp"
+#include "containers/external_sorter.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/lazy_json.hpp"
 #include "rdb_protocol/shards.hpp"
+#include "stl_utils.hpp"
 
 value_sizer_t<rdb_value_t>::value_sizer_t(block_size_t bs) : block_size_(bs) { }
 
@@ -112,18 +120,20 @@ void kv_location_delete(keyvalue_location_t<rdb_value_t> *kv_location,
             expired_t::NO, &null_cb);
 }
 
-void kv_location_set(keyvalue_location_t<rdb_value_t> *kv_location,
-                     const store_key_t &key,
-                     counted_t<const ql::datum_t> data,
-                     repli_timestamp_t timestamp,
-                     rdb_modification_info_t *mod_info_out) {
+// Stores `serialized_value`, which must be a row in the format written by
+// `ql::serialize_for_storage`.
+void kv_location_set_serialized(keyvalue_location_t<rdb_value_t> *kv_location,
+                                const store_key_t &key,
+                                const write_message_t &serialized_value,
+                                repli_timestamp_t timestamp,
+                                rdb_modification_info_t *mod_info_out) {
     scoped_malloc_t<rdb_value_t> new_value(blob::btree_maxreflen);
     memset(new_value.get(), 0, blob::btree_maxreflen);
 
     const block_size_t block_size = kv_location->buf.cache()->get_block_size();
     {
         blob_t blob(block_size, new_value->value_ref(), blob::btree_maxreflen);
-        serialize_onto_blob(buf_parent_t(&kv_location->buf), &blob, data);
+        write_onto_blob(buf_parent_t(&kv_location->buf), &blob, serialized_value);
     }
 
     if (mod_info_out) {
@@ -150,6 +160,16 @@ void kv_location_set(keyvalue_location_t<rdb_value_t> *kv_location,
                           expired_t::NO, &null_cb);
 }
 
+void kv_location_set(keyvalue_location_t<rdb_value_t> *kv_location,
+                     const store_key_t &key,
+                     counted_t<const ql::datum_t> data,
+                     repli_timestamp_t timestamp,
+                     rdb_modification_info_t *mod_info_out) {
+    write_message_t wm;
+    ql::serialize_for_storage(&wm, data);
+    kv_location_set_serialized(kv_location, key, wm, timestamp, mod_info_out);
+}
+
 void kv_location_set(keyvalue_location_t<rdb_value_t> *kv_location,
                      const store_key_t &key,
                      const std::vector<char> &value_ref,
@@ -414,12 +434,50 @@ void rdb_set(const store_key_t &key,
         (had_value ? point_write_result_t::DUPLICATE : point_write_result_t::STORED);
 }
 
+void rdb_set_serialized(const store_key_t &key,
+                        const std::vector<char> &serialized_value,
+                        bool decode_rows,
+                        btree_slice_t *slice, repli_timestamp_t timestamp,
+                        superblock_t *superblock,
+                        rdb_modification_info_t *mod_info,
+                        promise_t<superblock_t *> *pass_back_superblock) {
+    keyvalue_location_t<rdb_value_t> kv_location;
+    find_keyvalue_location_for_write(superblock, key.btree_key(), &kv_location,
+                                     &slice->stats, static_cast<profile::trace_t *>(NULL),
+                                     pass_back_superblock);
+
+    write_message_t wm;
+    wm.append(serialized_value.data(), serialized_value.size());
+
+    if (decode_rows) {
+        if (kv_location.value.has()) {
+            mod_info->deleted.first = get_data(kv_location.value.get(),
+                                               buf_parent_t(&kv_location.buf));
+        }
+        inplace_vector_read_stream_t read_stream(&serialized_value);
+        archive_result_t res = deserialize(&read_stream, &mod_info->added.first);
+        guarantee_deserialization(res, "backfilled rdb value");
+
+        kv_location_set_serialized(&kv_location, key, wm, timestamp, mod_info);
+    } else {
+        // Nobody is going to look at the old row, so instead of detaching it for
+        // `rdb_update_sindexes` to clean up later we can free it right away.
+        if (kv_location.value.has()) {
+            actually_delete_rdb_value(buf_parent_t(&kv_location.buf),
+                                      kv_location.value.get());
+        }
+        kv_location_set_serialized(&kv_location, key, wm, timestamp, NULL);
+    }
+}
+
 class agnostic_rdb_backfill_callback_t : public agnostic_backfill_callback_t {
 public:
     agnostic_rdb_backfill_callback_t(rdb_backfill_callback_t *cb,
                                      const key_range_t &kr,
-                                     btree_slice_t *slice) :
-        cb_(cb), kr_(kr), slice_(slice) { }
+                                     btree_slice_t *slice,
+                                     traversal_progress_t *progress) :
+        cb_(cb), kr_(kr), slice_(slice), progress_(progress),
+        pending_atoms_size_(0) { }
 
     void on_delete_range(const key_range_t &range, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
         rassert(kr_.is_superset(range));
@@ -435,40 +493,47 @@ public:
                   const std::vector<const btree_key_t *> &keys,
                   const std::vector<const void *> &vals,
                   signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
-
-        std::vector<rdb_protocol_details::backfill_atom_t> chunk_atoms;
-        chunk_atoms.reserve(keys.size());
-        size_t current_chunk_size = 0;
-
+        // A single leaf rarely holds more than a few kilobytes of changes, so we
+        // collect the pairs of several leaves into one chunk of up to
+        // `BACKFILL_MAX_KVPAIRS_SIZE` bytes. That's fine even though deletions
+        // are passed on right away: the deletions and delete ranges reported for
+        // a leaf never reach beyond that leaf's keys, and different leaves don't
+        // overlap, so no two operations on the same key get reordered.
         for (size_t i = 0; i < keys.size(); ++i) {
             rassert(kr_.contains_key(keys[i]->contents, keys[i]->size));
             const rdb_value_t *value = static_cast<const rdb_value_t *>(vals[i]);
 
-            rdb_protocol_details::backfill_atom_t atom;
-            atom.key.assign(keys[i]->size, keys[i]->contents);
-            atom.value = get_data(value, leaf_node);
-            atom.recency = recencies[i];
-            chunk_atoms.push_back(atom);
-            current_chunk_size += static_cast<size_t>(atom.key.size())
-                                  + serialized_size(atom.value);
+            std::vector<char> serialized_value;
+            get_serialized_data(value, leaf_node, &serialized_value);
+            pending_atoms_size_ += static_cast<size_t>(keys[i]->size)
+                                   + serialized_value.size();
+            pending_atoms_.push_back(rdb_protocol_details::backfill_atom_t(
+                store_key_t(keys[i]->size, keys[i]->contents),
+                std::move(serialized_value),
+                recencies[i]));
 
-            if (current_chunk_size >= BACKFILL_MAX_KVPAIRS_SIZE) {
+            if (pending_atoms_size_ >= BACKFILL_MAX_KVPAIRS_SIZE) {
                 // To avoid flooding the receiving node with overly large chunks
                 // (which could easily make it run out of memory in extreme
                 // cases), pass on what we have got so far. Then continue
                 // with the remaining values.
-                slice_->stats.pm_keys_read.record(chunk_atoms.size());
-                cb_->on_keyvalues(std::move(chunk_atoms), interruptor);
-                chunk_atoms = std::vector<rdb_protocol_details::backfill_atom_t>();
-                chunk_atoms.reserve(keys.size() - (i+1));
-                current_chunk_size = 0;
+                flush_pairs(interruptor);
             }
         }
-        if (!chunk_atoms.empty()) {
-            // Pass on the final chunk
-            slice_->stats.pm_keys_read.record(chunk_atoms.size());
-            cb_->on_keyvalues(std::move(chunk_atoms), interruptor);
+    }
+
+    // Passes on the pairs that haven't filled up a whole chunk yet. Must be called
+    // once the traversal is done.
+    void flush_pairs(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        if (pending_atoms_.empty()) {
+            return;
         }
+        std::vector<rdb_protocol_details::backfill_atom_t> chunk_atoms;
+        chunk_atoms.swap(pending_atoms_);
+        slice_->stats.pm_keys_read.record(chunk_atoms.size());
+        progress_->record_transferred(chunk_atoms.size(), pending_atoms_size_);
+        pending_atoms_size_ = 0;
+        cb_->on_keyvalues(std::move(chunk_atoms), interruptor);
     }
 
     void on_sindexes(const std::map<std::string, secondary_index_t> &sindexes, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
@@ -478,6 +543,10 @@ public:
     rdb_backfill_callback_t *cb_;
     key_range_t kr_;
     btree_slice_t *slice_;
+    traversal_progress_t *progress_;
+
+    std::vector<rdb_protocol_details::backfill_atom_t> pending_atoms_;
+    size_t pending_atoms_size_;
 };
 
 void rdb_backfill(btree_slice_t *slice, const key_range_t& key_range,
@@ -486,10 +555,11 @@ void rdb_backfill(btree_slice_t *slice, const key_range_t& key_range,
                   buf_lock_t *sindex_block,
                   parallel_traversal_progress_t *p, signal_t *interruptor)
     THROWS_ONLY(interrupted_exc_t) {
-    agnostic_rdb_backfill_callback_t agnostic_cb(callback, key_range, slice);
+    agnostic_rdb_backfill_callback_t agnostic_cb(callback, key_range, slice, p);
     value_sizer_t<rdb_value_t> sizer(superblock->cache()->get_block_size());
     do_agnostic_btree_backfill(&sizer, key_range, since_when, &agnostic_cb,
                                superblock, sindex_block, p, interruptor);
+    agnostic_cb.flush_pairs(interruptor);
 }
 
 void rdb_delete(const store_key_t &key, btree_slice_t *slice,
@@ -659,16 +729,104 @@ typedef rdb_protocol_details::terminal_variant_t terminal_variant_t;
 
 class sindex_data_t {
 public:
-    sindex_data_t(const key_range_t &_pkey_range, const datum_range_t &_range,
+    sindex_data_t(const key_range_t &_pkey_range,
+                  const std::vector<datum_range_t> &_ranges,
                   ql::map_wire_func_t wire_func, sindex_multi_bool_t _multi)
-        : pkey_range(_pkey_range), range(_range),
-          func(wire_func.compile_wire_func()), multi(_multi) { }
+        : pkey_range(_pkey_range), ranges(sorted_by_left_bound(_ranges)),
+          func(wire_func.compile_wire_func()), multi(_multi) {
+        func_reads_only_fields = ql::get_accessed_fields(func.get(), &func_fields);
+        max_right_bounds.reserve(ranges.size());
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            counted_t<const ql::datum_t> bound = it->right_bound;
+            if (!max_right_bounds.empty()) {
+                const counted_t<const ql::datum_t> &prev = max_right_bounds.back();
+                if (bound.has() && (!prev.has() || *bound < *prev)) {
+                    bound = prev;
+                }
+            }
+            max_right_bounds.push_back(bound);
+        }
+    }
+
+    // The parts of `region` that can hold rows in one of the ranges, sorted and
+    // with no two of them overlapping.  (Truncated keys can make the keyranges
+    // of different datum ranges overlap, and we mustn't visit a row twice.)
+    std::vector<key_range_t> keyranges(const key_range_t &region) const {
+        std::vector<key_range_t> rngs;
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            key_range_t rng = it->to_sindex_keyrange().intersection(region);
+            if (!rng.is_empty()) {
+                rngs.push_back(rng);
+            }
+        }
+        std::sort(rngs.begin(), rngs.end(),
+                  [](const key_range_t &a, const key_range_t &b) {
+                      return a.left < b.left;
+                  });
+        std::vector<key_range_t> merged;
+        for (auto it = rngs.begin(); it != rngs.end(); ++it) {
+            if (!merged.empty()
+                && key_range_t::right_bound_t(it->left) <= merged.back().right) {
+                if (merged.back().right < it->right) {
+                    merged.back().right = it->right;
+                }
+            } else {
+                merged.push_back(*it);
+            }
+        }
+        return merged;
+    }
+
+    // How many of the ranges contain `val`.  Two binary searches narrow it down
+    // to the ranges that start at or before `val` and that don't come before the
+    // first point where `max_right_bounds` reaches `val`.  For a `get_all` those
+    // are just the ranges for `val` itself.
+    size_t count_containing(const counted_t<const ql::datum_t> &val) const {
+        const size_t end = std::upper_bound(
+            ranges.begin(), ranges.end(), val,
+            [](const counted_t<const ql::datum_t> &v, const datum_range_t &r) {
+                return r.left_bound.has() && *v < *r.left_bound;
+            }) - ranges.begin();
+        const size_t begin = std::lower_bound(
+            max_right_bounds.begin(), max_right_bounds.begin() + end, val,
+            [](const counted_t<const ql::datum_t> &bound,
+               const counted_t<const ql::datum_t> &v) {
+                return bound.has() && *bound < *v;
+            }) - max_right_bounds.begin();
+
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if (ranges[i].contains(val)) {
+                ++count;
+            }
+        }
+        return count;
+    }
 private:
+    static std::vector<datum_range_t> sorted_by_left_bound(
+            std::vector<datum_range_t> rngs) {
+        // A missing left bound means the range is unbounded on the left.
+        std::stable_sort(rngs.begin(), rngs.end(),
+                         [](const datum_range_t &a, const datum_range_t &b) {
+                             return b.left_bound.has()
+                                 && (!a.left_bound.has()
+                                     || *a.left_bound < *b.left_bound);
+                         });
+        return rngs;
+    }
+
     friend class rget_cb_t;
     const key_range_t pkey_range;
-    const datum_range_t range;
+    // Sorted by their left bounds.
+    const std::vector<datum_range_t> ranges;
+    // `max_right_bounds[i]` is the largest right bound of `ranges[0]` through
+    // `ranges[i]`; an empty one means there is no bound.
+    std::vector<counted_t<const ql::datum_t> > max_right_bounds;
     const counted_t<ql::func_t> func;
     const sindex_multi_bool_t multi;
+    // If `func_reads_only_fields`, `func` only looks at `func_fields` of a row.
+    bool func_reads_only_fields;
+    std::set<std::string> func_fields;
 };
 
 class job_data_t {
@@ -779,9 +937,20 @@ THROWS_ONLY(interrupted_exc_t) {
                     keyvalue.expose_buf());
     counted_t<const ql::datum_t> val;
     // We only load the value if we actually use it (`count` does not).
-    if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
+    if (job.accumulator->uses_val() || job.transformers.size() != 0) {
         val = row.get();
         io.slice->stats.pm_keys_read.record();
+    } else if (sindex) {
+        // We only need the value to check it's in the sindex range, which often
+        // means only a field or two of it.
+        if (sindex->func_reads_only_fields) {
+            val = get_data_fields(static_cast<const rdb_value_t *>(keyvalue.value()),
+                                  keyvalue.expose_buf(), sindex->func_fields);
+            row.reset();
+        } else {
+            val = row.get();
+        }
+        io.slice->stats.pm_keys_read.record();
     } else {
         row.reset();
     }
@@ -798,6 +967,8 @@ THROWS_ONLY(interrupted_exc_t) {
 
         // Check whether we're out of sindex range.
         counted_t<const ql::datum_t> sindex_val; // NULL if no sindex.
+        // A row shows up once for every range that contains it.
+        size_t copies = 1;
         if (sindex) {
             sindex_val = sindex->func->call(job.env, val)->as_datum();
             if (sindex->multi == sindex_multi_bool_t::MULTI
@@ -807,7 +978,8 @@ THROWS_ONLY(interrupted_exc_t) {
                 sindex_val = sindex_val->get(*tag, ql::NOTHROW);
                 guarantee(sindex_val);
             }
-            if (!sindex->range.contains(sindex_val)) {
+            copies = sindex->count_containing(sindex_val);
+            if (copies == 0) {
                 return done_traversing_t::NO;
             }
         }
@@ -818,6 +990,13 @@ THROWS_ONLY(interrupted_exc_t) {
             (**it)(&data, sindex_val);
             //            ^^^^^^^^^^ NULL if no sindex
         }
+        // All the copies have to go into the same batch, since the next batch
+        // starts after `key`.
+        for (size_t i = 1; i < copies; ++i) {
+            ql::groups_t data_copy = data;
+            (*job.accumulator)(&data_copy, store_key_t(key),
+                               counted_t<const ql::datum_t>(sindex_val));
+        }
         // We need lots of extra data for the accumulation because we might be
         // accumulating `rget_item_t`s for a batch.
         return (*job.accumulator)(&data, std::move(key), std::move(sindex_val));
@@ -860,7 +1039,7 @@ void rdb_rget_slice(
 
 void rdb_rget_secondary_slice(
     btree_slice_t *slice,
-    const datum_range_t &sindex_range,
+    const std::vector<datum_range_t> &sindex_ranges,
     const rdb_protocol_t::region_t &sindex_region,
     superblock_t *superblock,
     ql::env_t *ql_env,
@@ -874,14 +1053,35 @@ void rdb_rget_secondary_slice(
     rget_read_response_t *response) {
     r_sanity_check(boost::get<ql::exc_t>(&response->result) == NULL);
     profile::starter_t starter("Do range scan on secondary index.", ql_env->trace);
+    sindex_data_t sindex_data(pk_range, sindex_ranges, sindex_func, sindex_multi);
+    std::vector<key_range_t> keyranges = sindex_data.keyranges(sindex_region.inner);
+    if (reversed(sorting)) {
+        std::reverse(keyranges.begin(), keyranges.end());
+    }
     rget_cb_t callback(
         io_data_t(response, slice),
         job_data_t(ql_env, batchspec, transforms, terminal, sorting),
-        sindex_data_t(pk_range, sindex_range, sindex_func, sindex_multi),
+        std::move(sindex_data),
         sindex_region.inner);
-    btree_concurrent_traversal(
-        superblock, sindex_region.inner, &callback,
-        (!reversed(sorting) ? FORWARD : BACKWARD));
+    // Every traversal releases the superblock once it has the root.  The ones we
+    // don't get to (or the lack of any) have to give up their references too, or
+    // the superblock stays held until the read is over.
+    const size_t num_references = std::max<size_t>(keyranges.size(), 1);
+    refcount_superblock_t refcount_superblock(superblock, num_references);
+    size_t num_traversals = 0;
+    for (auto it = keyranges.begin(); it != keyranges.end(); ++it) {
+        ++num_traversals;
+        const bool finished = btree_concurrent_traversal(
+            &refcount_superblock, *it, &callback,
+            (!reversed(sorting) ? FORWARD : BACKWARD));
+        if (!finished) {
+            // The batch is full (or there was an error).
+            break;
+        }
+    }
+    for (; num_traversals < num_references; ++num_traversals) {
+        refcount_superblock.release();
+    }
     callback.finish();
 }
 
@@ -999,6 +1199,16 @@ void compute_keys(const store_key_t &primary_key, counted_t<const ql::datum_t> d
     }
 }
 
+void deserialize_sindex_definition(const secondary_index_t &sindex,
+                                   ql::map_wire_func_t *mapping_out,
+                                   sindex_multi_bool_t *multi_out) {
+    inplace_vector_read_stream_t read_stream(&sindex.opaque_definition);
+    archive_result_t success = deserialize(&read_stream, mapping_out);
+    guarantee_deserialization(success, "sindex deserialize");
+    success = deserialize(&read_stream, multi_out);
+    guarantee_deserialization(success, "sindex deserialize");
+}
+
 /* Used below by rdb_update_sindexes. */
 void rdb_update_single_sindex(
         const btree_store_t<rdb_protocol_t>::sindex_access_t *sindex,
@@ -1012,11 +1222,7 @@ void rdb_update_single_sindex(
 
     ql::map_wire_func_t mapping;
     sindex_multi_bool_t multi = sindex_multi_bool_t::MULTI;
-    inplace_vector_read_stream_t read_stream(&sindex->sindex.opaque_definition);
-    archive_result_t success = deserialize(&read_stream, &mapping);
-    guarantee_deserialization(success, "sindex deserialize");
-    success = deserialize(&read_stream, &multi);
-    guarantee_deserialization(success, "sindex deserialize");
+    deserialize_sindex_definition(sindex->sindex, &mapping, &multi);
 
     // TODO we just use a NULL environment here. People should not be able
     // to do anything that requires an environment like gets from other
@@ -1134,16 +1340,35 @@ void rdb_erase_range_sindexes(const sindex_access_vector_t &sindexes,
                               false /* don't release the superblock */, interruptor);
 }
 
+/* A secondary index that gets built by sorting its keys and loading them into its
+btree bottom-up (see `btree_bulk_loader_t`), instead of inserting them one by one.
+That only works if the sindex btree is still empty, which it is unless an earlier
+post construction got interrupted. */
+struct sindex_bulk_load_t {
+    typedef std::pair<store_key_t, std::vector<char> > entry_t;
+
+    uuid_u id;
+    ql::map_wire_func_t mapping;
+    sindex_multi_bool_t multi;
+    scoped_ptr_t<external_sorter_t<entry_t> > sorter;
+};
+
 class post_construct_traversal_helper_t : public btree_traversal_helper_t {
 public:
     post_construct_traversal_helper_t(
             btree_store_t<rdb_protocol_t> *store,
             const std::set<uuid_u> &sindexes_to_post_construct,
+            const std::vector<scoped_ptr_t<sindex_bulk_load_t> > *bulk_loads,
+            const std::set<std::string> *accessed_fields,
+            bool only_accessed_fields,
             cond_t *interrupt_myself,
             signal_t *interruptor
             )
         : store_(store),
           sindexes_to_post_construct_(sindexes_to_post_construct),
+          bulk_loads_(bulk_loads),
+          accessed_fields_(accessed_fields),
+          only_accessed_fields_(only_accessed_fields),
           interrupt_myself_(interrupt_myself), interruptor_(interruptor)
     { }
 
@@ -1151,49 +1376,58 @@ public:
                         const btree_key_t *, const btree_key_t *,
                         signal_t *, int *) THROWS_ONLY(interrupted_exc_t) {
         write_token_pair_t token_pair;
-        store_->new_write_token_pair(&token_pair);
 
         // KSI: FML
         scoped_ptr_t<txn_t> wtxn;
         btree_store_t<rdb_protocol_t>::sindex_access_vector_t sindexes;
 
-        try {
-            scoped_ptr_t<real_superblock_t> superblock;
-
-            // We want soft durability because having a partially constructed
-            // secondary index is okay -- we wipe it and rebuild it, if it has not
-            // been marked completely constructed.
-            store_->acquire_superblock_for_write(
-                    repli_timestamp_t::distant_past,
-                    2,  // KSI: This is not the right value.
-                    write_durability_t::SOFT,
-                    &token_pair,
-                    &wtxn,
-                    &superblock,
-                    interruptor_);
-
-            // Acquire the sindex block.
-            const block_id_t sindex_block_id = superblock->get_sindex_block_id();
-
-            buf_lock_t sindex_block
-                = store_->acquire_sindex_block_for_write(superblock->expose_buf(),
-                                                         sindex_block_id);
-
-            superblock.reset();
-
-            store_->acquire_sindex_superblocks_for_write(
-                    sindexes_to_post_construct_,
-                    &sindex_block,
-                    &sindexes);
-
-            if (sindexes.empty()) {
-                interrupt_myself_->pulse_if_not_already_pulsed();
+        // The sindexes that can't be bulk loaded get updated right away, one row
+        // at a time.
+        if (!sindexes_to_post_construct_.empty()) {
+            store_->new_write_token_pair(&token_pair);
+
+            try {
+                scoped_ptr_t<real_superblock_t> superblock;
+
+                // We want soft durability because having a partially constructed
+                // secondary index is okay -- we wipe it and rebuild it, if it has not
+                // been marked completely constructed.
+                store_->acquire_superblock_for_write(
+                        repli_timestamp_t::distant_past,
+                        2,  // KSI: This is not the right value.
+                        write_durability_t::SOFT,
+                        &token_pair,
+                        &wtxn,
+                        &superblock,
+                        interruptor_);
+
+                // Acquire the sindex block.
+                const block_id_t sindex_block_id = superblock->get_sindex_block_id();
+
+                buf_lock_t sindex_block
+                    = store_->acquire_sindex_block_for_write(superblock->expose_buf(),
+                                                             sindex_block_id);
+
+                superblock.reset();
+
+                store_->acquire_sindex_superblocks_for_write(
+                        sindexes_to_post_construct_,
+                        &sindex_block,
+                        &sindexes);
+
+                if (sindexes.empty() && bulk_loads_->empty()) {
+                    interrupt_myself_->pulse_if_not_already_pulsed();
+                    return;
+                }
+            } catch (const interrupted_exc_t &e) {
                 return;
             }
-        } catch (const interrupted_exc_t &e) {
-            return;
         }
 
+        // See `rdb_update_single_sindex` about the NULL environment.
+        cond_t non_interruptor;
+        ql::env_t env(NULL, &non_interruptor);
+
         buf_read_t leaf_read(leaf_node_buf);
         const leaf_node_t *leaf_node
             = static_cast<const leaf_node_t *>(leaf_read.get_data_read());
@@ -1212,12 +1446,18 @@ public:
             const block_size_t block_size = leaf_node_buf->cache()->get_block_size();
             mod_report.info.added
                 = std::make_pair(
-                    get_data(rdb_value, buf_parent_t(leaf_node_buf)),
+                    only_accessed_fields_
+                    ? get_data_fields(rdb_value, buf_parent_t(leaf_node_buf),
+                                      *accessed_fields_)
+                    : get_data(rdb_value, buf_parent_t(leaf_node_buf)),
                     std::vector<char>(rdb_value->value_ref(),
                         rdb_value->value_ref() + rdb_value->inline_size(block_size)));
 
-            rdb_update_sindexes(sindexes, &mod_report, wtxn.get());
-            store_->btree->stats.pm_keys_set.record();
+            if (!sindexes.empty()) {
+                rdb_update_sindexes(sindexes, &mod_report, wtxn.get());
+                store_->btree->stats.pm_keys_set.record();
+            }
+            add_to_bulk_loads(pk, mod_report.info.added, &env);
             coro_t::yield();
         }
     }
@@ -1236,12 +1476,125 @@ public:
     access_t btree_superblock_mode() { return access_t::read; }
     access_t btree_node_mode() { return access_t::read; }
 
+private:
+    void add_to_bulk_loads(
+            const store_key_t &pk,
+            const std::pair<counted_t<const ql::datum_t>, std::vector<char> > &row,
+            ql::env_t *env) {
+        for (auto it = bulk_loads_->begin(); it != bulk_loads_->end(); ++it) {
+            sindex_bulk_load_t *bulk_load = it->get();
+            std::vector<store_key_t> keys;
+            try {
+                compute_keys(pk, row.first, &bulk_load->mapping, bulk_load->multi,
+                             env, &keys);
+            } catch (const ql::base_exc_t &) {
+                // The row doesn't go into this index.
+                continue;
+            }
+            for (auto key = keys.begin(); key != keys.end(); ++key) {
+                const size_t entry_size = sizeof(sindex_bulk_load_t::entry_t)
+                    + row.second.size();
+                bulk_load->sorter->push(std::make_pair(*key, row.second), entry_size);
+            }
+        }
+    }
+
     btree_store_t<rdb_protocol_t> *store_;
     const std::set<uuid_u> &sindexes_to_post_construct_;
+    const std::vector<scoped_ptr_t<sindex_bulk_load_t> > *bulk_loads_;
+    // The rows only get passed to the sindex functions, so if those just read
+    // some fields, we don't need to load the rest.
+    const std::set<std::string> *accessed_fields_;
+    const bool only_accessed_fields_;
     cond_t *interrupt_myself_;
     signal_t *interruptor_;
 };
 
+/* Loads the sorted keys of `bulk_load` into its sindex btree, a batch of them per
+transaction.  The transactions only hold on to the sindex block while acquiring the
+sindex superblock, so writes to the table can go on in between. */
+void bulk_load_sindex(btree_store_t<rdb_protocol_t> *store,
+                      sindex_bulk_load_t *bulk_load,
+                      signal_t *interruptor)
+    THROWS_ONLY(interrupted_exc_t) {
+    bulk_load->sorter->finish();
+
+    value_sizer_t<rdb_value_t> sizer(store->cache->get_block_size());
+    btree_bulk_loader_t loader(&sizer);
+    std::set<uuid_u> sindex_to_acquire;
+    sindex_to_acquire.insert(bulk_load->id);
+    store_key_t previous_key;
+
+    bool done = false;
+    while (!done) {
+        // Read the next batch before acquiring anything, so that nobody has to
+        // wait for us while the sorter reads its runs back in.
+        std::vector<sindex_bulk_load_t::entry_t> batch;
+        while (batch.size() < SINDEX_BULK_LOAD_KEYS_PER_TXN) {
+            sindex_bulk_load_t::entry_t entry;
+            if (!bulk_load->sorter->next(&entry)) {
+                done = true;
+                break;
+            }
+            // Every key has the primary key in it, so they should all be distinct,
+            // but the loader can't take the same key twice.
+            if (loader.keys_added() + batch.size() != 0
+                && entry.first == previous_key) {
+                continue;
+            }
+            previous_key = entry.first;
+            batch.push_back(std::move(entry));
+        }
+
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+
+        write_token_pair_t token_pair;
+        store->new_write_token_pair(&token_pair);
+
+        scoped_ptr_t<txn_t> wtxn;
+        btree_store_t<rdb_protocol_t>::sindex_access_vector_t sindexes;
+        {
+            scoped_ptr_t<real_superblock_t> superblock;
+
+            // Soft durability is fine here for the same reason as in
+            // `post_construct_traversal_helper_t`.
+            store->acquire_superblock_for_write(
+                    repli_timestamp_t::distant_past,
+                    2,
+                    write_durability_t::SOFT,
+                    &token_pair,
+                    &wtxn,
+                    &superblock,
+                    interruptor);
+
+            buf_lock_t sindex_block
+                = store->acquire_sindex_block_for_write(
+                    superblock->expose_buf(), superblock->get_sindex_block_id());
+
+            superblock.reset();
+
+            store->acquire_sindex_superblocks_for_write(
+                    sindex_to_acquire,
+                    &sindex_block,
+                    &sindexes);
+        }
+
+        if (sindexes.empty()) {
+            // The sindex got dropped.
+            return;
+        }
+
+        loader.begin(sindexes[0].super_block.get());
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            loader.add(it->first.btree_key(), it->second.data());
+            store->btree->stats.pm_keys_set.record();
+        }
+        loader.end();
+    }
+}
+
 void post_construct_secondary_indexes(
         btree_store_t<rdb_protocol_t> *store,
         const std::set<uuid_u> &sindexes_to_post_construct,
@@ -1251,14 +1604,11 @@ void post_construct_secondary_indexes(
 
     wait_any_t wait_any(&local_interruptor, interruptor);
 
-    post_construct_traversal_helper_t helper(store,
-            sindexes_to_post_construct, &local_interruptor, interruptor);
     /* Notice the ordering of progress_tracker and insertion_sentries matters.
      * insertion_sentries puts pointers in the progress tracker map. Once
      * insertion_sentries is destructed nothing has a reference to
      * progress_tracker so we know it's safe to destruct it. */
     parallel_traversal_progress_t progress_tracker;
-    helper.progress = &progress_tracker;
 
     std::vector<map_insertion_sentry_t<uuid_u, const parallel_traversal_progress_t *> >
         insertion_sentries(sindexes_to_post_construct.size());
@@ -1268,27 +1618,104 @@ void post_construct_secondary_indexes(
         store->add_progress_tracker(&*sentry, *it, &progress_tracker);
     }
 
-    object_buffer_t<fifo_enforcer_sink_t::exit_read_t> read_token;
-    store->new_read_token(&read_token);
-
-    // Mind the destructor ordering.
-    // The superblock must be released before txn (`btree_parallel_traversal`
-    // usually already takes care of that).
-    // The txn must be destructed before the cache_account.
-    cache_account_t cache_account;
-    scoped_ptr_t<txn_t> txn;
-    scoped_ptr_t<real_superblock_t> superblock;
-
-    store->acquire_superblock_for_read(
-        &read_token,
-        &txn,
-        &superblock,
-        interruptor,
-        true /* USE_SNAPSHOT */);
-
-    cache_account
-        = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
-    txn->set_account(&cache_account);
-
-    btree_parallel_traversal(superblock.get(), &helper, &wait_any);
+    std::vector<scoped_ptr_t<sindex_bulk_load_t> > bulk_loads;
+    std::set<uuid_u> sindexes_to_update;
+    std::set<std::string> accessed_fields;
+    bool only_accessed_fields = true;
+
+    {
+        object_buffer_t<fifo_enforcer_sink_t::exit_read_t> read_token;
+        store->new_read_token(&read_token);
+
+        // Mind the destructor ordering.
+        // The superblock must be released before txn (`btree_parallel_traversal`
+        // usually already takes care of that).
+        // The txn must be destructed before the cache_account.
+        cache_account_t cache_account;
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+
+        store->acquire_superblock_for_read(
+            &read_token,
+            &txn,
+            &superblock,
+            interruptor,
+            true /* USE_SNAPSHOT */);
+
+        cache_account
+            = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY,
+                                                 eviction_hint_t::one_pass);
+        txn->set_account(&cache_account);
+
+        // Sort out which sindexes are still empty and can be bulk loaded.
+        {
+            buf_lock_t sindex_block
+                = store->acquire_sindex_block_for_read(
+                    superblock->expose_buf(), superblock->get_sindex_block_id());
+
+            std::map<std::string, secondary_index_t> sindexes;
+            get_secondary_indexes(&sindex_block, &sindexes);
+
+            std::vector<secondary_index_t> to_bulk_load;
+            for (auto it = sindexes.begin(); it != sindexes.end(); ++it) {
+                if (!std_contains(sindexes_to_post_construct, it->second.id)) {
+                    continue;
+                }
+                // Find the fields the sindex functions read once for the whole
+                // traversal, rather than compiling them again for every leaf.
+                if (only_accessed_fields) {
+                    ql::map_wire_func_t mapping;
+                    sindex_multi_bool_t multi = sindex_multi_bool_t::MULTI;
+                    deserialize_sindex_definition(it->second, &mapping, &multi);
+                    only_accessed_fields = ql::get_accessed_fields(
+                        mapping.compile_wire_func().get(), &accessed_fields);
+                }
+                buf_lock_t sindex_superblock_lock(&sindex_block,
+                                                  it->second.superblock,
+                                                  access_t::read);
+                real_superblock_t sindex_superblock(std::move(sindex_superblock_lock));
+                if (sindex_superblock.get_root_block_id() == NULL_BLOCK_ID) {
+                    to_bulk_load.push_back(it->second);
+                } else {
+                    sindexes_to_update.insert(it->second.id);
+                }
+            }
+
+            // The sort memory is carved out of this table's cache budget, so that
+            // it scales with the server's cache size and the number of shards.
+            const size_t sort_memory = std::max<size_t>(
+                SINDEX_BULK_LOAD_MIN_SORT_MEMORY,
+                store->cache->memory_limit() / SINDEX_BULK_LOAD_SORT_MEMORY_DIVISOR
+                    / std::max<size_t>(to_bulk_load.size(), 1));
+            for (auto it = to_bulk_load.begin(); it != to_bulk_load.end(); ++it) {
+                scoped_ptr_t<sindex_bulk_load_t> bulk_load(new sindex_bulk_load_t);
+                bulk_load->id = it->id;
+                deserialize_sindex_definition(*it, &bulk_load->mapping,
+                                              &bulk_load->multi);
+                bulk_load->sorter.init(new external_sorter_t<sindex_bulk_load_t::entry_t>(
+                    store->io_backender_,
+                    store->base_path_,
+                    "sindex_bulk_load_" + uuid_to_str(generate_uuid()),
+                    &store->perfmon_collection,
+                    sort_memory));
+                bulk_loads.push_back(std::move(bulk_load));
+            }
+        }
+
+        if (bulk_loads.empty() && sindexes_to_update.empty()) {
+            // They all got dropped already.
+            return;
+        }
+
+        post_construct_traversal_helper_t helper(store,
+                sindexes_to_update, &bulk_loads, &accessed_fields,
+                only_accessed_fields, &local_interruptor, interruptor);
+        helper.progress = &progress_tracker;
+
+        btree_parallel_traversal(superblock.get(), &helper, &wait_any);
+    }
+
+    for (auto it = bulk_loads.begin(); it != bulk_loads.end(); ++it) {
+        bulk_load_sindex(store, it->get(), interruptor);
+    }
 }
@@ -148,6 +148,18 @@ void rdb_set(const store_key_t &key, counted_t<const ql::datum_t> data,
              profile::trace_t *trace,
              promise_t<superblock_t *> *pass_back_superblock = NULL);
 
+// Like `rdb_set`, but takes a row that has already been serialized for storage
+// (for example, by the backfiller that sent it). The row is only decoded if
+// `decode_rows` is true; that fills in `mod_info` for updating secondary indexes.
+// Otherwise `mod_info` is left empty and the old row is freed immediately.
+void rdb_set_serialized(const store_key_t &key,
+                        const std::vector<char> &serialized_value,
+                        bool decode_rows,
+                        btree_slice_t *slice, repli_timestamp_t timestamp,
+                        superblock_t *superblock,
+                        rdb_modification_info_t *mod_info,
+                        promise_t<superblock_t *> *pass_back_superblock);
+
 class rdb_backfill_callback_t {
 public:
     virtual void on_delete_range(
@@ -209,9 +221,11 @@ void rdb_rget_slice(
     sorting_t sorting,
     rget_read_response_t *response);
 
+// Visits every row whose sindex value lies in one of `datum_ranges`, in a single
+// pass over the keyspace.
 void rdb_rget_secondary_slice(
     btree_slice_t *slice,
-    const datum_range_t &datum_range,
+    const std::vector<datum_range_t> &datum_ranges,
     const rdb_protocol_t::region_t &sindex_region,
     superblock_t *superblock,
     ql::env_t *ql_env,
@@ -27,6 +27,108 @@ const std::set<std::string> datum_t::_allowed_pts = std::set<std::string>();
 
 const char* const datum_t::reql_type_string = "$reql_type$";
 
+datum_object_t::datum_object_t() { }
+
+datum_object_t::datum_object_t(std::map<std::string, counted_t<const datum_t> > &&map) {
+    pairs_.reserve(map.size());
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        pairs_.push_back(value_type(it->first, std::move(it->second)));
+    }
+}
+
+datum_object_t::datum_object_t(const datum_object_t &other) : pairs_(other.pairs_) { }
+
+datum_object_t::datum_object_t(datum_object_t &&other)
+    : pairs_(std::move(other.pairs_)) { }
+
+datum_object_t::~datum_object_t() { }
+
+datum_object_t &datum_object_t::operator=(const datum_object_t &other) {
+    pairs_ = other.pairs_;
+    return *this;
+}
+
+datum_object_t &datum_object_t::operator=(datum_object_t &&other) {
+    pairs_ = std::move(other.pairs_);
+    return *this;
+}
+
+static bool pair_key_less(const datum_object_t::value_type &pair,
+                          const std::string &key) {
+    return pair.first < key;
+}
+
+datum_object_t::const_iterator datum_object_t::find(const std::string &key) const {
+    const_iterator it = std::lower_bound(pairs_.begin(), pairs_.end(), key,
+                                         &pair_key_less);
+    return it != pairs_.end() && it->first == key ? it : pairs_.end();
+}
+
+std::vector<datum_object_t::value_type>::iterator
+datum_object_t::lower_bound(const std::string &key) {
+    return std::lower_bound(pairs_.begin(), pairs_.end(), key, &pair_key_less);
+}
+
+bool datum_object_t::set(const std::string &key, counted_t<const datum_t> val,
+                         clobber_bool_t clobber_bool) {
+    auto it = lower_bound(key);
+    if (it != pairs_.end() && it->first == key) {
+        if (clobber_bool == CLOBBER) {
+            it->second = std::move(val);
+        }
+        return true;
+    }
+    pairs_.insert(it, value_type(key, std::move(val)));
+    return false;
+}
+
+bool datum_object_t::erase(const std::string &key) {
+    auto it = lower_bound(key);
+    if (it != pairs_.end() && it->first == key) {
+        pairs_.erase(it);
+        return true;
+    }
+    return false;
+}
+
+bool datum_object_t::append(std::string &&key, counted_t<const datum_t> &&val) {
+    if (pairs_.empty() || pairs_.back().first < key) {
+        pairs_.push_back(value_type(std::move(key), std::move(val)));
+        return false;
+    }
+    auto it = lower_bound(key);
+    if (it->first == key) {
+        return true;
+    }
+    pairs_.insert(it, value_type(std::move(key), std::move(val)));
+    return false;
+}
+
+void datum_object_t::append_unsorted(std::string &&key,
+                                     counted_t<const datum_t> &&val) {
+    pairs_.push_back(value_type(std::move(key), std::move(val)));
+}
+
+static bool pair_less(const datum_object_t::value_type &a,
+                      const datum_object_t::value_type &b) {
+    return a.first < b.first;
+}
+
+static bool pair_key_equal(const datum_object_t::value_type &a,
+                           const datum_object_t::value_type &b) {
+    return a.first == b.first;
+}
+
+bool datum_object_t::sort_appended(std::string *duplicate_out) {
+    std::sort(pairs_.begin(), pairs_.end(), &pair_less);
+    auto dup = std::adjacent_find(pairs_.begin(), pairs_.end(), &pair_key_equal);
+    if (dup != pairs_.end()) {
+        *duplicate_out = dup->first;
+        return false;
+    }
+    return true;
+}
+
 datum_t::datum_t(type_t _type, bool _bool) : type(_type), r_bool(_bool) {
     r_sanity_check(_type == R_BOOL);
 }
@@ -59,15 +161,21 @@ datum_t::datum_t(std::vector<counted_t<const datum_t> > &&_array)
 
 datum_t::datum_t(std::map<std::string, counted_t<const datum_t> > &&_object)
     : type(R_OBJECT),
-      r_object(new std::map<std::string, counted_t<const datum_t> >(
-                   std::move(_object))) {
+      r_object(new datum_object_t(std::move(_object))) {
+    maybe_sanitize_ptype();
+}
+
+datum_t::datum_t(datum_object_t &&_object)
+    : type(R_OBJECT),
+      r_object(new datum_object_t(std::move(_object))) {
     maybe_sanitize_ptype();
 }
 
 datum_t::datum_t(grouped_data_t &&gd)
     : type(R_OBJECT),
-      r_object(new std::map<std::string, counted_t<const datum_t> >()) {
-    (*r_object)[reql_type_string] = make_counted<const datum_t>("GROUPED_DATA");
+      r_object(new datum_object_t()) {
+    r_object->set(reql_type_string, make_counted<const datum_t>("GROUPED_DATA"),
+                  CLOBBER);
     std::vector<counted_t<const datum_t> > v;
     v.reserve(gd.size());
     for (auto kv = gd.begin(); kv != gd.end(); ++kv) {
@@ -75,7 +183,7 @@ datum_t::datum_t(grouped_data_t &&gd)
                         std::vector<counted_t<const datum_t> >{
                             std::move(kv->first), std::move(kv->second)}));
     }
-    (*r_object)["data"] = make_counted<const datum_t>(std::move(v));
+    r_object->set("data", make_counted<const datum_t>(std::move(v)), CLOBBER);
     // We don't sanitize the ptype because this is a fake ptype that should only
     // be used for serialization.
 }
@@ -93,7 +201,7 @@ datum_t::datum_t(datum_t::type_t _type) : type(_type) {
         r_array = new std::vector<counted_t<const datum_t> >();
     } break;
     case R_OBJECT: {
-        r_object = new std::map<std::string, counted_t<const datum_t> >();
+        r_object = new datum_object_t();
     } break;
     case UNINITIALIZED: // fallthru
     default: unreachable();
@@ -134,7 +242,7 @@ void datum_t::init_array() {
 
 void datum_t::init_object() {
     type = R_OBJECT;
-    r_object = new std::map<std::string, counted_t<const datum_t> >();
+    r_object = new datum_object_t();
 }
 
 void datum_t::init_json(cJSON *json) {
@@ -173,10 +281,13 @@ void datum_t::init_json(cJSON *json) {
         init_object();
         json_object_iterator_t it(json);
         while (cJSON *item = it.next()) {
-            bool conflict = add(item->string, make_counted<datum_t>(item));
-            rcheck(!conflict, base_exc_t::GENERIC,
-                   strprintf("Duplicate key `%s` in JSON.", item->string));
+            std::string key(item->string);
+            check_str_validity(key);
+            r_object->append_unsorted(std::move(key), make_counted<datum_t>(item));
         }
+        std::string duplicate;
+        rcheck(r_object->sort_appended(&duplicate), base_exc_t::GENERIC,
+               strprintf("Duplicate key `%s` in JSON.", duplicate.c_str()));
         maybe_sanitize_ptype();
     } break;
     default: unreachable();
@@ -743,8 +854,7 @@ counted_t<const datum_t> datum_t::get(size_t index, throw_bool_t throw_bool) con
 
 counted_t<const datum_t> datum_t::get(const std::string &key,
                                       throw_bool_t throw_bool) const {
-    std::map<std::string, counted_t<const datum_t> >::const_iterator it
-        = as_object().find(key);
+    datum_object_t::const_iterator it = as_object().find(key);
     if (it != as_object().end()) return it->second;
     if (throw_bool == THROW) {
         rfail(base_exc_t::NON_EXISTENCE,
@@ -753,7 +863,7 @@ counted_t<const datum_t> datum_t::get(const std::string &key,
     return counted_t<const datum_t>();
 }
 
-const std::map<std::string, counted_t<const datum_t> > &datum_t::as_object() const {
+const datum_object_t &datum_t::as_object() const {
     check_type(R_OBJECT);
     return *r_object;
 }
@@ -773,7 +883,7 @@ cJSON *datum_t::as_json_raw() const {
     } break;
     case R_OBJECT: {
         scoped_cJSON_t obj(cJSON_CreateObject());
-        for (std::map<std::string, counted_t<const datum_t> >::const_iterator
+        for (datum_object_t::const_iterator
                  it = r_object->begin(); it != r_object->end(); ++it) {
             obj.AddItemToObject(it->first.c_str(), it->second->as_json_raw());
         }
@@ -821,9 +931,7 @@ MUST_USE bool datum_t::add(const std::string &key, counted_t<const datum_t> val,
     check_type(R_OBJECT);
     check_str_validity(key);
     r_sanity_check(val.has());
-    bool key_in_obj = r_object->count(key) > 0;
-    if (!key_in_obj || (clobber_bool == CLOBBER)) (*r_object)[key] = val;
-    return key_in_obj;
+    return r_object->set(key, val, clobber_bool);
 }
 
 MUST_USE bool datum_t::delete_field(const std::string &key) {
@@ -834,7 +942,7 @@ counted_t<const datum_t> datum_t::merge(counted_t<const datum_t> rhs) const {
     if (get_type() != R_OBJECT || rhs->get_type() != R_OBJECT) { return rhs; }
 
     datum_ptr_t d(as_object());
-    const std::map<std::string, counted_t<const datum_t> > &rhs_obj = rhs->as_object();
+    const datum_object_t &rhs_obj = rhs->as_object();
     for (auto it = rhs_obj.begin(); it != rhs_obj.end(); ++it) {
         counted_t<const datum_t> sub_lhs = d->get(it->first, NOTHROW);
         bool is_literal = it->second->is_ptype(pseudo::literal_string);
@@ -860,7 +968,7 @@ counted_t<const datum_t> datum_t::merge(counted_t<const datum_t> rhs) const {
 counted_t<const datum_t> datum_t::merge(counted_t<const datum_t> rhs,
                                         merge_resoluter_t f) const {
     datum_ptr_t d(as_object());
-    const std::map<std::string, counted_t<const datum_t> > &rhs_obj = rhs->as_object();
+    const datum_object_t &rhs_obj = rhs->as_object();
     for (auto it = rhs_obj.begin(); it != rhs_obj.end(); ++it) {
         if (counted_t<const datum_t> left = get(it->first, NOTHROW)) {
             bool b = d.add(it->first, f(it->first, left, it->second), CLOBBER);
@@ -915,9 +1023,8 @@ int datum_t::cmp(const datum_t &rhs) const {
             }
             return pseudo_cmp(rhs);
         } else {
-            const std::map<std::string, counted_t<const datum_t> > &obj = as_object();
-            const std::map<std::string, counted_t<const datum_t> > &rhs_obj
-                = rhs.as_object();
+            const datum_object_t &obj = as_object();
+            const datum_object_t &rhs_obj = rhs.as_object();
             auto it = obj.begin();
             auto it2 = rhs_obj.begin();
             while (it != obj.end() && it2 != rhs_obj.end()) {
@@ -996,15 +1103,17 @@ void datum_t::init_from_pb(const Datum *d) {
     } break;
     case Datum::R_OBJECT: {
         init_object();
+        r_object->reserve(d->r_object_size());
         for (int i = 0; i < d->r_object_size(); ++i) {
             const Datum_AssocPair *ap = &d->r_object(i);
-            const std::string &key = ap->key();
+            std::string key = ap->key();
             check_str_validity(key);
-            rcheck(r_object->count(key) == 0,
-                   base_exc_t::GENERIC,
-                   strprintf("Duplicate key %s in object.", key.c_str()));
-            (*r_object)[key] = make_counted<datum_t>(&ap->val());
+            r_object->append_unsorted(std::move(key), make_counted<datum_t>(&ap->val()));
         }
+        std::string duplicate;
+        rcheck(r_object->sort_appended(&duplicate),
+               base_exc_t::GENERIC,
+               strprintf("Duplicate key %s in object.", duplicate.c_str()));
         std::set<std::string> allowed_ptypes = { pseudo::literal_string };
         maybe_sanitize_ptype(allowed_ptypes);
     } break;
@@ -1090,11 +1199,152 @@ enum class datum_serialized_type_t {
     R_STR = 6,
     INT_NEGATIVE = 7,
     INT_POSITIVE = 8,
+    // Only written by `serialize_for_storage`.
+    R_OBJECT_INDEXED = 9,
 };
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(datum_serialized_type_t, int8_t,
                                       datum_serialized_type_t::R_ARRAY,
-                                      datum_serialized_type_t::INT_POSITIVE);
+                                      datum_serialized_type_t::R_OBJECT_INDEXED);
+
+size_t serialized_size(const datum_object_t &obj) {
+    size_t ret = varint_uint64_serialized_size(obj.size());
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        ret += serialized_size(it->first);
+        ret += serialized_size(it->second);
+    }
+    return ret;
+}
+
+write_message_t &operator<<(write_message_t &wm, const datum_object_t &obj) {
+    serialize_varint_uint64(&wm, obj.size());
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        wm << it->first;
+        wm << it->second;
+    }
+    return wm;
+}
+
+// We don't trust a deserialized size enough to reserve more than this up front.
+const uint64_t max_reserved_object_size = 1024;
+
+archive_result_t deserialize(read_stream_t *s, datum_object_t *obj) {
+    *obj = datum_object_t();
+
+    uint64_t sz;
+    archive_result_t res = deserialize_varint_uint64(s, &sz);
+    if (bad(res)) { return res; }
+
+    if (sz > std::numeric_limits<size_t>::max()) {
+        return archive_result_t::RANGE_ERROR;
+    }
+
+    obj->reserve(std::min(sz, max_reserved_object_size));
+    for (uint64_t i = 0; i < sz; ++i) {
+        std::string key;
+        res = deserialize(s, &key);
+        if (bad(res)) { return res; }
+        counted_t<const datum_t> val;
+        res = deserialize(s, &val);
+        if (bad(res)) { return res; }
+        // Like `std::map`'s deserialization, keep the first of duplicate keys.
+        UNUSED bool dup = obj->append(std::move(key), std::move(val));
+    }
+
+    return archive_result_t::SUCCESS;
+}
+
+archive_result_t deserialize_indexed_object_table(
+        read_stream_t *s, std::vector<indexed_object_entry_t> *entries_out) {
+    entries_out->clear();
+
+    uint64_t sz;
+    archive_result_t res = deserialize_varint_uint64(s, &sz);
+    if (bad(res)) { return res; }
+
+    if (sz > std::numeric_limits<size_t>::max()) {
+        return archive_result_t::RANGE_ERROR;
+    }
+
+    entries_out->reserve(std::min(sz, max_reserved_object_size));
+    uint64_t offset = 0;
+    for (uint64_t i = 0; i < sz; ++i) {
+        indexed_object_entry_t entry;
+        res = deserialize(s, &entry.key);
+        if (bad(res)) { return res; }
+        res = deserialize_varint_uint64(s, &entry.size);
+        if (bad(res)) { return res; }
+        if (entry.size > std::numeric_limits<uint64_t>::max() - offset) {
+            return archive_result_t::RANGE_ERROR;
+        }
+        entry.offset = offset;
+        offset += entry.size;
+        entries_out->push_back(std::move(entry));
+    }
+
+    return archive_result_t::SUCCESS;
+}
+
+archive_result_t deserialize_indexed_object_header(read_stream_t *s,
+                                                   uint32_t *table_size_out) {
+    datum_serialized_type_t type;
+    archive_result_t res = deserialize(s, &type);
+    if (bad(res)) { return res; }
+
+    if (type != datum_serialized_type_t::R_OBJECT_INDEXED) {
+        *table_size_out = 0;
+        return archive_result_t::SUCCESS;
+    }
+    res = deserialize(s, table_size_out);
+    if (bad(res)) { return res; }
+    // The table always holds at least the number of fields.
+    if (*table_size_out == 0) {
+        return archive_result_t::RANGE_ERROR;
+    }
+    return archive_result_t::SUCCESS;
+}
+
+// Smaller objects are cheap enough to decode in full that the table isn't worth the
+// space it takes.
+const size_t min_indexed_object_size = 256;
+
+void serialize_for_storage(write_message_t *wm, const counted_t<const datum_t> &datum) {
+    r_sanity_check(datum.has());
+    if (datum->get_type() != datum_t::R_OBJECT) {
+        *wm << datum;
+        return;
+    }
+
+    const datum_object_t &obj = datum->as_object();
+    std::vector<uint64_t> value_sizes;
+    value_sizes.reserve(obj.size());
+    uint64_t table_size = varint_uint64_serialized_size(obj.size());
+    uint64_t values_size = 0;
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        const uint64_t value_size = serialized_size(it->second);
+        value_sizes.push_back(value_size);
+        values_size += value_size;
+        table_size += serialized_size(it->first)
+            + varint_uint64_serialized_size(value_size);
+    }
+    if (values_size < min_indexed_object_size
+        || table_size > std::numeric_limits<uint32_t>::max()) {
+        *wm << datum;
+        return;
+    }
+
+    *wm << datum_serialized_type_t::R_OBJECT_INDEXED;
+    *wm << static_cast<uint32_t>(table_size);
+    serialize_varint_uint64(wm, obj.size());
+    size_t i = 0;
+    for (auto it = obj.begin(); it != obj.end(); ++it, ++i) {
+        *wm << it->first;
+        serialize_varint_uint64(wm, value_sizes[i]);
+    }
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        *wm << it->second;
+    }
+}
 
 // This must be kept in sync with operator<<(write_message_t &, const counted_t<const
 // datum_T> &).
@@ -1256,7 +1506,7 @@ archive_result_t deserialize(read_stream_t *s, counted_t<const datum_t> *datum)
         }
     } break;
     case datum_serialized_type_t::R_OBJECT: {
-        std::map<std::string, counted_t<const datum_t> > value;
+        datum_object_t value;
         res = deserialize(s, &value);
         if (bad(res)) {
             return res;
@@ -1267,6 +1517,34 @@ archive_result_t deserialize(read_stream_t *s, counted_t<const datum_t> *datum)
             return archive_result_t::RANGE_ERROR;
         }
     } break;
+    case datum_serialized_type_t::R_OBJECT_INDEXED: {
+        uint32_t table_size;
+        res = deserialize(s, &table_size);
+        if (bad(res)) {
+            return res;
+        }
+        std::vector<indexed_object_entry_t> entries;
+        res = deserialize_indexed_object_table(s, &entries);
+        if (bad(res)) {
+            return res;
+        }
+        // The values follow the table, in the same order.
+        datum_object_t value;
+        value.reserve(entries.size());
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            counted_t<const datum_t> val;
+            res = deserialize(s, &val);
+            if (bad(res)) {
+                return res;
+            }
+            UNUSED bool dup = value.append(std::move(it->key), std::move(val));
+        }
+        try {
+            datum->reset(new datum_t(std::move(value)));
+        } catch (const base_exc_t &) {
+            return archive_result_t::RANGE_ERROR;
+        }
+    } break;
     case datum_serialized_type_t::R_STR: {
         wire_string_t *value;
         res = deserialize(s, &value);
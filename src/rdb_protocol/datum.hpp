@@ -50,6 +50,67 @@ enum clobber_bool_t { NOCLOBBER = 0, CLOBBER = 1};
 enum class use_json_t { NO = 0, YES = 1 };
 
 class grouped_data_t;
+class datum_t;
+
+/* The fields of an object `datum_t`.  It's used like a read-only
+`std::map<std::string, counted_t<const datum_t> >`, but it keeps the pairs in one
+vector sorted by key, so building, copying, and destroying an object costs one
+allocation for all of its fields instead of one per field, and lookups are a
+binary search over contiguous memory. */
+class datum_object_t {
+public:
+    typedef std::string key_type;
+    typedef std::pair<std::string, counted_t<const datum_t> > value_type;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    typedef std::vector<value_type>::const_reverse_iterator const_reverse_iterator;
+
+    datum_object_t();
+    explicit datum_object_t(std::map<std::string, counted_t<const datum_t> > &&map);
+    datum_object_t(const datum_object_t &other);
+    datum_object_t(datum_object_t &&other);
+    ~datum_object_t();
+    datum_object_t &operator=(const datum_object_t &other);
+    datum_object_t &operator=(datum_object_t &&other);
+
+    size_t size() const { return pairs_.size(); }
+    bool empty() const { return pairs_.empty(); }
+    const_iterator begin() const { return pairs_.begin(); }
+    const_iterator end() const { return pairs_.end(); }
+    const_reverse_iterator rbegin() const { return pairs_.rbegin(); }
+    const_reverse_iterator rend() const { return pairs_.rend(); }
+    const_iterator find(const std::string &key) const;
+    size_t count(const std::string &key) const { return find(key) != end() ? 1 : 0; }
+
+    void reserve(size_t n) { pairs_.reserve(n); }
+    // Sets `key` to `val`, unless `key` is already there and `clobber_bool` is
+    // NOCLOBBER.  Returns true if `key` was already there.
+    bool set(const std::string &key, counted_t<const datum_t> val,
+             clobber_bool_t clobber_bool);
+    // Returns true if `key` was there.
+    bool erase(const std::string &key);
+    // Adds a pair when the pairs are likely to come in key order, as they do when
+    // they're deserialized.  That's a plain append; a pair out of order costs an
+    // insertion.  If `key` is already there, does nothing and returns true.
+    MUST_USE bool append(std::string &&key, counted_t<const datum_t> &&val);
+    // Adds a pair without keeping the pairs sorted, for building an object whose
+    // keys come in no particular order.  `sort_appended()` must be called before
+    // the object is used for anything else.
+    void append_unsorted(std::string &&key, counted_t<const datum_t> &&val);
+    // Sorts the pairs after calls to `append_unsorted()`.  If two pairs have the
+    // same key, sets `*duplicate_out` to that key and returns false.
+    MUST_USE bool sort_appended(std::string *duplicate_out);
+
+private:
+    std::vector<value_type>::iterator lower_bound(const std::string &key);
+
+    std::vector<value_type> pairs_;
+};
+
+// These use the same format as `std::map<std::string, counted_t<const datum_t> >`.
+size_t serialized_size(const datum_object_t &obj);
+write_message_t &operator<<(write_message_t &wm, const datum_object_t &obj);
+archive_result_t deserialize(read_stream_t *s, datum_object_t *obj);
 
 // A `datum_t` is basically a JSON value, although we may extend it later.
 class datum_t : public slow_atomic_countable_t<datum_t> {
@@ -76,6 +137,7 @@ public:
     explicit datum_t(const char *cstr);
     explicit datum_t(std::vector<counted_t<const datum_t> > &&_array);
     explicit datum_t(std::map<std::string, counted_t<const datum_t> > &&object);
+    explicit datum_t(datum_object_t &&object);
 
     // This should only be used to send responses to the client.
     explicit datum_t(grouped_data_t &&gd);
@@ -126,7 +188,7 @@ public:
     // Access an element of an array.
     counted_t<const datum_t> get(size_t index, throw_bool_t throw_bool = THROW) const;
     // Use of `get` is preferred to `as_object` when possible.
-    const std::map<std::string, counted_t<const datum_t> > &as_object() const;
+    const datum_object_t &as_object() const;
 
     // Access an element of an object.
     counted_t<const datum_t> get(const std::string &key,
@@ -216,7 +278,7 @@ private:
         double r_num;
         wire_string_t *r_str;
         std::vector<counted_t<const datum_t> > *r_array;
-        std::map<std::string, counted_t<const datum_t> > *r_object;
+        datum_object_t *r_object;
     };
 
 public:
@@ -234,6 +296,34 @@ archive_result_t deserialize(read_stream_t *s, counted_t<const datum_t> *datum);
 write_message_t &operator<<(write_message_t &wm, const empty_ok_t<const counted_t<const datum_t> > &datum);
 archive_result_t deserialize(read_stream_t *s, empty_ok_ref_t<counted_t<const datum_t> > datum);
 
+/* Rows in the btree are written with `serialize_for_storage`.  Large objects get
+an indexed format: after the type byte comes a fixed-width table size, then a table
+of the object's keys and the serialized sizes of their values, then the values in
+key order.  That lets a reader seek straight to the fields it wants without decoding
+the rest of the row (see `get_data_fields` in lazy_json.hpp).  The `deserialize`
+above reads both formats, so rows written before the indexed format existed stay
+readable, and get rewritten in it the next time they're written. */
+void serialize_for_storage(write_message_t *wm, const counted_t<const datum_t> &datum);
+
+// The type byte and table size at the start of an indexed object.
+const int64_t indexed_object_header_size = 5;
+
+// Reads the start of a datum written by `serialize_for_storage`.  Sets
+// `*table_size_out` to the size of the table that follows, or to 0 if the datum
+// isn't an indexed object (in which case this may have read just the type byte).
+archive_result_t deserialize_indexed_object_header(read_stream_t *s,
+                                                   uint32_t *table_size_out);
+
+struct indexed_object_entry_t {
+    std::string key;
+    // Where the value starts, relative to the end of the table.
+    uint64_t offset;
+    uint64_t size;
+};
+
+archive_result_t deserialize_indexed_object_table(
+        read_stream_t *s, std::vector<indexed_object_entry_t> *entries_out);
+
 // Converts a double to int, but returns false if it's not an integer or out of range.
 bool number_as_integer(double d, int64_t *i_out);
 
@@ -1,7 +1,9 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "rdb_protocol/datum_stream.hpp"
 
+#include <algorithm>
 #include <map>
+#include <vector>
 
 #include "clustering/administration/metadata.hpp"
 #include "rdb_protocol/batching.hpp"
@@ -302,11 +304,9 @@ bool reader_t::is_finished() const {
 
 readgen_t::readgen_t(
     const std::map<std::string, wire_func_t> &_global_optargs,
-    const datum_range_t &_original_datum_range,
     profile_bool_t _profile,
     sorting_t _sorting)
     : global_optargs(_global_optargs),
-      original_datum_range(_original_datum_range),
       profile(_profile),
       sorting(_sorting) { }
 
@@ -358,7 +358,7 @@ primary_readgen_t::primary_readgen_t(
     datum_range_t range,
     profile_bool_t profile,
     sorting_t sorting)
-    : readgen_t(global_optargs, range, profile, sorting) { }
+    : readgen_t(global_optargs, profile, sorting), original_datum_range(range) { }
 scoped_ptr_t<readgen_t> primary_readgen_t::make(
     env_t *env, datum_range_t range, sorting_t sorting) {
     return scoped_ptr_t<readgen_t>(
@@ -404,17 +404,39 @@ std::string primary_readgen_t::sindex_name() const {
 sindex_readgen_t::sindex_readgen_t(
     const std::map<std::string, wire_func_t> &global_optargs,
     const std::string &_sindex,
-    datum_range_t range,
+    std::vector<datum_range_t> &&ranges,
     profile_bool_t profile,
     sorting_t sorting)
-    : readgen_t(global_optargs, range, profile, sorting), sindex(_sindex) { }
+    : readgen_t(global_optargs, profile, sorting),
+      sindex(_sindex),
+      original_datum_ranges(sort_sindex_ranges(std::move(ranges))) {
+    r_sanity_check(!original_datum_ranges.empty());
+}
 
 scoped_ptr_t<readgen_t> sindex_readgen_t::make(
     env_t *env, const std::string &sindex, datum_range_t range, sorting_t sorting) {
     return scoped_ptr_t<readgen_t>(
         new sindex_readgen_t(
             env->global_optargs.get_all_optargs(),
-            sindex, range, env->profile(), sorting));
+            sindex, std::vector<datum_range_t>{range}, env->profile(), sorting));
+}
+
+scoped_ptr_t<readgen_t> sindex_readgen_t::make(
+    env_t *env, const std::string &sindex, std::vector<datum_range_t> &&ranges) {
+    return scoped_ptr_t<readgen_t>(
+        new sindex_readgen_t(
+            env->global_optargs.get_all_optargs(),
+            sindex, std::move(ranges), env->profile(), sorting_t::UNORDERED));
+}
+
+std::vector<datum_range_t> sindex_readgen_t::sort_sindex_ranges(
+    std::vector<datum_range_t> &&ranges) {
+    std::stable_sort(ranges.begin(), ranges.end(),
+                     [](const datum_range_t &a, const datum_range_t &b) {
+                         return a.to_sindex_keyrange().left
+                             < b.to_sindex_keyrange().left;
+                     });
+    return std::move(ranges);
 }
 
 class sindex_compare_t {
@@ -449,7 +471,7 @@ rget_read_t sindex_readgen_t::next_read_impl(
         batchspec,
         transforms,
         boost::optional<terminal_variant_t>(),
-        sindex_rangespec_t(sindex, region_t(active_range), original_datum_range),
+        sindex_rangespec_t(sindex, region_t(active_range), original_datum_ranges),
         sorting);
 }
 
@@ -486,7 +508,7 @@ boost::optional<read_t> sindex_readgen_t::sindex_sort_read(
                         sindex_rangespec_t(
                             sindex,
                             region_t(key_range_t(rng)),
-                            original_datum_range),
+                            original_datum_ranges),
                         sorting),
                     profile);
             }
@@ -496,7 +518,16 @@ boost::optional<read_t> sindex_readgen_t::sindex_sort_read(
 }
 
 key_range_t sindex_readgen_t::original_keyrange() const {
-    return original_datum_range.to_sindex_keyrange();
+    // The smallest range that covers all of the ranges.
+    key_range_t rng = original_datum_ranges[0].to_sindex_keyrange();
+    for (auto it = original_datum_ranges.begin() + 1;
+         it != original_datum_ranges.end(); ++it) {
+        key_range_t it_rng = it->to_sindex_keyrange();
+        if (rng.right < it_rng.right) {
+            rng.right = it_rng.right;
+        }
+    }
+    return rng;
 }
 
 std::string sindex_readgen_t::sindex_name() const {
@@ -764,6 +795,50 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
     return ret;
 }
 
+// EXTERNAL_SORT_DATUM_STREAM_T
+external_sort_datum_stream_t::external_sort_datum_stream_t(
+    scoped_ptr_t<datum_sorter_t> &&_sorter,
+    bool _distinct,
+    const protob_t<const Backtrace> &bt_src)
+    : eager_datum_stream_t(bt_src), sorter(std::move(_sorter)), distinct(_distinct) {
+    advance();
+}
+
+bool external_sort_datum_stream_t::is_exhausted() const {
+    return !next_item.has() && batch_cache_exhausted();
+}
+
+void external_sort_datum_stream_t::advance() {
+    counted_t<const datum_t> last = std::move(next_item);
+    next_item.reset();
+    counted_t<const datum_t> d;
+    while (sorter->next(&d)) {
+        if (!distinct || !last.has() || *d != *last) {
+            next_item = std::move(d);
+            return;
+        }
+    }
+}
+
+std::vector<counted_t<const datum_t> >
+external_sort_datum_stream_t::next_raw_batch(env_t *env,
+                                             const batchspec_t &batchspec) {
+    std::vector<counted_t<const datum_t> > ret;
+    batcher_t batcher = batchspec.to_batcher();
+
+    profile::sampler_t sampler("Merging sorted runs.", env->trace);
+    while (next_item.has()) {
+        batcher.note_el(next_item);
+        ret.push_back(next_item);
+        advance();
+        if (batcher.should_send_batch()) {
+            break;
+        }
+        sampler.new_sample();
+    }
+    return ret;
+}
+
 // INDEXES_OF_DATUM_STREAM_T
 indexes_of_datum_stream_t::indexes_of_datum_stream_t(counted_t<func_t> _f,
                                                      counted_t<datum_stream_t> _source)
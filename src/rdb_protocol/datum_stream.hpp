@@ -15,6 +15,7 @@
 #include <boost/optional.hpp>
 
 #include "clustering/administration/namespace_interface_repository.hpp"
+#include "containers/external_sorter.hpp"
 #include "rdb_protocol/protocol.hpp"
 
 namespace ql {
@@ -248,6 +249,33 @@ size_t index;
 std::vector<counted_t<const datum_t> > data;
 };
 
+typedef std::function<bool(const counted_t<const datum_t> &,  // NOLINT(readability/casting)
+                           const counted_t<const datum_t> &)> datum_less_t;
+typedef external_sorter_t<counted_t<const datum_t>, datum_less_t> datum_sorter_t;
+
+// Hands out what a finished `datum_sorter_t` has sorted.  The sorter's runs get
+// merged lazily as the stream is read, so only a chunk of each run needs to be in
+// memory at a time.  If `distinct` is set, items equal to the one before get
+// skipped.
+class external_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    external_sort_datum_stream_t(scoped_ptr_t<datum_sorter_t> &&_sorter,
+                                 bool _distinct,
+                                 const protob_t<const Backtrace> &bt_src);
+    virtual bool is_exhausted() const;
+
+private:
+    virtual bool is_array() { return false; }
+    virtual std::vector<counted_t<const datum_t> >
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+    void advance();
+
+    scoped_ptr_t<datum_sorter_t> sorter;
+    const bool distinct;
+    // The item we hand out next, or empty once the sorter has run dry.
+    counted_t<const datum_t> next_item;
+};
+
 class union_datum_stream_t : public datum_stream_t {
 public:
     union_datum_stream_t(std::vector<counted_t<datum_stream_t> > &&_streams,
@@ -278,7 +306,6 @@ class readgen_t {
 public:
     explicit readgen_t(
         const std::map<std::string, wire_func_t> &global_optargs,
-        const datum_range_t &original_datum_range,
         profile_bool_t profile,
         sorting_t sorting);
     virtual ~readgen_t() { }
@@ -312,7 +339,6 @@ public:
                       const store_key_t &last_key) const;
 protected:
     const std::map<std::string, wire_func_t> global_optargs;
-    const datum_range_t original_datum_range;
     const profile_bool_t profile;
     const sorting_t sorting;
 
@@ -344,6 +370,8 @@ private:
     virtual void sindex_sort(std::vector<rget_item_t> *vec) const;
     virtual key_range_t original_keyrange() const;
     virtual std::string sindex_name() const; // Used for error checking.
+
+    const datum_range_t original_datum_range;
 };
 
 class sindex_readgen_t : public readgen_t {
@@ -353,10 +381,15 @@ public:
         const std::string &sindex,
         datum_range_t range = datum_range_t::universe(),
         sorting_t sorting = sorting_t::UNORDERED);
+    // Reads all of `ranges` at once, e.g. for `get_all` with several values.
+    static scoped_ptr_t<readgen_t> make(
+        env_t *env,
+        const std::string &sindex,
+        std::vector<datum_range_t> &&ranges);
 private:
     sindex_readgen_t(
         const std::map<std::string, wire_func_t> &global_optargs,
-        const std::string &sindex, datum_range_t sindex_range,
+        const std::string &sindex, std::vector<datum_range_t> &&sindex_ranges,
         profile_bool_t profile, sorting_t sorting);
     virtual rget_read_t next_read_impl(
         const key_range_t &active_range,
@@ -371,7 +404,12 @@ private:
     virtual key_range_t original_keyrange() const;
     virtual std::string sindex_name() const; // Used for error checking.
 
+    static std::vector<datum_range_t> sort_sindex_ranges(
+        std::vector<datum_range_t> &&ranges);
+
     const std::string sindex;
+    // Sorted by where they start in the sindex keyspace.
+    const std::vector<datum_range_t> original_datum_ranges;
 };
 
 class reader_t {
@@ -4,6 +4,7 @@
 #include "clustering/administration/database_metadata.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
+#include "extproc/extproc_pool.hpp"
 #include "extproc/js_runner.hpp"
 #include "rdb_protocol/counted_term.hpp"
 #include "rdb_protocol/func.hpp"
@@ -160,6 +161,24 @@ js_runner_t *env_t::get_js_runner() {
     return &js_runner;
 }
 
+js_runner_t *env_t::get_js_helper_runner(size_t i) {
+    assert_thread();
+    r_sanity_check(extproc_pool != NULL);
+    // Only a job that holds a main worker may hold helpers; see
+    // extproc_pool_t::get_helper_pool().
+    r_sanity_check(js_runner.connected());
+    extproc_pool_t *helper_pool = extproc_pool->get_helper_pool();
+    r_sanity_check(helper_pool != NULL);
+    if (js_helper_runners.size() == 0) {
+        js_helper_runners.init(extproc_pool->get_workers_per_job() - 1);
+    }
+    r_sanity_check(i < js_helper_runners.size());
+    if (!js_helper_runners[i].connected()) {
+        js_helper_runners[i].begin(helper_pool, interruptor);
+    }
+    return &js_helper_runners[i];
+}
+
 env_t::env_t(rdb_protocol_t::context_t *ctx, signal_t *_interruptor)
     : global_optargs(protob_t<Query>()),
       extproc_pool(ctx ? ctx->extproc_pool : NULL),
@@ -176,6 +195,10 @@ env_t::env_t(rdb_protocol_t::context_t *ctx, signal_t *_interruptor)
                     semilattice_readwrite_view_t<cluster_semilattice_metadata_t> >(),
           NULL,
           ctx ? ctx->machine_id : uuid_u()),
+      spill_location(ctx != NULL
+                     ? spill_location_t(ctx->io_backender, ctx->base_path,
+                                        &ctx->ql_stats_collection)
+                     : spill_location_t()),
       interruptor(_interruptor),
       eval_callback(NULL) { }
 
@@ -191,6 +214,7 @@ env_t::env_t(
     directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
     signal_t *_interruptor,
     uuid_u _this_machine,
+    const spill_location_t &_spill_location,
     protob_t<Query> query)
   : evals_since_yield(0),
     global_optargs(query),
@@ -201,6 +225,7 @@ env_t::env_t(
                    _semilattice_metadata,
                    _directory_read_manager,
                    _this_machine),
+    spill_location(_spill_location),
     interruptor(_interruptor),
     eval_callback(NULL)
 {
@@ -41,6 +41,24 @@ private:
     std::map<std::string, wire_func_t> optargs;
 };
 
+// Where orderBy and distinct write out sorted runs once they go over their memory
+// budget.  There's nowhere to spill to if `io_backender` is NULL (as on a proxy),
+// and then everything has to fit into memory.
+class spill_location_t {
+public:
+    spill_location_t()
+        : io_backender(NULL), base_path(""), stats_parent(NULL) { }
+    spill_location_t(io_backender_t *_io_backender,
+                     const base_path_t &_base_path,
+                     perfmon_collection_t *_stats_parent)
+        : io_backender(_io_backender), base_path(_base_path),
+          stats_parent(_stats_parent) { }
+
+    io_backender_t *io_backender;
+    base_path_t base_path;
+    perfmon_collection_t *stats_parent;
+};
+
 class cluster_access_t {
 public:
     typedef namespaces_semilattice_metadata_t<rdb_protocol_t> ns_metadata_t;
@@ -98,6 +116,7 @@ public:
         directory_read_manager_t<cluster_directory_metadata_t> *_directory_read_manager,
         signal_t *_interruptor,
         uuid_u _this_machine,
+        const spill_location_t &_spill_location,
         protob_t<Query> query);
 
     env_t(
@@ -133,6 +152,12 @@ public:
     // already been called.
     js_runner_t *get_js_runner();
 
+    // Returns the `i`th runner on a helper worker from `extproc_pool`'s helper
+    // pool, first calling begin() on it if it hasn't already been called.  Like
+    // js_runner, helpers are kept for as long as the env lives.  get_js_runner()
+    // must have been called first.
+    js_runner_t *get_js_helper_runner(size_t i);
+
     // This is a callback used in unittests to control things during a query
     class eval_callback_t {
     public:
@@ -154,6 +179,9 @@ public:
     // Access to the cluster, for talking over the cluster or about the cluster.
     cluster_access_t cluster_access;
 
+    // Where to put sorted runs that don't fit into memory.
+    spill_location_t spill_location;
+
     // The interruptor signal while a query evaluates.  This can get overwritten!
     signal_t *interruptor;
 
@@ -163,6 +191,8 @@ public:
 
 private:
     js_runner_t js_runner;
+    // There are `extproc_pool->get_workers_per_job() - 1` of these, once any is used.
+    scoped_array_t<js_runner_t> js_helper_runners;
 
     eval_callback_t *eval_callback;
 
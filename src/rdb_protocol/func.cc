@@ -1,5 +1,10 @@
 #include "rdb_protocol/func.hpp"
 
+#include <algorithm>
+#include <functional>
+
+#include "concurrency/pmap.hpp"
+#include "extproc/extproc_pool.hpp"
 #include "rdb_protocol/counted_term.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/minidriver.hpp"
@@ -10,6 +15,12 @@
 
 namespace ql {
 
+// Runs `filter_fn` and applies `filter`'s `default` semantics to any error it
+// throws.  Shared by `filter_call` and the batched filter paths.
+static bool apply_filter_default(env_t *env,
+                                 const std::function<bool()> &filter_fn,
+                                 counted_t<func_t> default_filter_val);
+
 func_t::func_t(const protob_t<const Backtrace> &bt_source)
   : pb_rcheckable_t(bt_source) { }
 func_t::~func_t() { }
@@ -32,6 +43,29 @@ counted_t<val_t> func_t::call(env_t *env,
     return call(env, make_vector(arg1, arg2), eval_flags);
 }
 
+std::vector<counted_t<val_t> > func_t::call_batch(
+    env_t *env,
+    const std::vector<std::vector<counted_t<const datum_t> > > &args_batch) const {
+    std::vector<counted_t<val_t> > results;
+    results.reserve(args_batch.size());
+    for (auto it = args_batch.begin(); it != args_batch.end(); ++it) {
+        results.push_back(call(env, *it));
+    }
+    return results;
+}
+
+std::vector<bool> func_t::filter_call_batch(
+    env_t *env,
+    const std::vector<counted_t<const datum_t> > &args,
+    counted_t<func_t> default_filter_val) const {
+    std::vector<bool> results;
+    results.reserve(args.size());
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        results.push_back(filter_call(env, *it, default_filter_val));
+    }
+    return results;
+}
+
 void func_t::assert_deterministic(const char *extra_msg) const {
     rcheck(is_deterministic(),
            base_exc_t::GENERIC,
@@ -118,6 +152,138 @@ counted_t<val_t> js_func_t::call(
     }
 }
 
+// A helper worker has to compile the function before it can call it, so slices
+// smaller than this stay on the env's own worker.
+static const size_t JS_BATCH_MIN_SLICE_SIZE = 16;
+
+std::vector<js_result_t> js_func_t::run_batch(
+    env_t *env,
+    const std::vector<std::vector<counted_t<const datum_t> > > &args_batch,
+    std::exception_ptr *error_out) const {
+    js_runner_t::req_config_t config;
+    config.timeout_ms = js_timeout_ms;
+
+    r_sanity_check(!js_source.empty());
+    r_sanity_check(env->extproc_pool != NULL);
+
+    // Contiguous slices of the batch are evaluated in parallel: the first on the
+    //  env's own runner, the rest on the env's helper runners.
+    size_t num_slices = 1;
+    if (env->extproc_pool->get_helper_pool() != NULL) {
+        num_slices = std::min(env->extproc_pool->get_workers_per_job(),
+                              std::max<size_t>(1, args_batch.size()
+                                                  / JS_BATCH_MIN_SLICE_SIZE));
+    }
+
+    // The helpers may only be acquired while the env holds its main worker.
+    js_runner_t *main_runner = env->get_js_runner();
+
+    std::vector<std::vector<js_result_t> > slice_results(num_slices);
+    // Exceptions can't get out of `pmap`, so they wait here to be rethrown.
+    std::vector<std::exception_ptr> slice_errors(num_slices);
+    pmap(num_slices, [&](int i) {
+        std::vector<std::vector<counted_t<const datum_t> > > slice_copy;
+        const std::vector<std::vector<counted_t<const datum_t> > > *slice = &args_batch;
+        if (num_slices > 1) {
+            slice_copy.assign(args_batch.begin() + args_batch.size() * i / num_slices,
+                              args_batch.begin()
+                                  + args_batch.size() * (i + 1) / num_slices);
+            slice = &slice_copy;
+        }
+
+        try {
+            try {
+                // `get_js_helper_runner` fails the query if it can't get a helper.
+                js_runner_t *runner
+                    = i == 0 ? main_runner : env->get_js_helper_runner(i - 1);
+                slice_results[i] = runner->call_batch(js_source, *slice, config);
+            } catch (const js_worker_exc_t &e) {
+                rfail(base_exc_t::GENERIC,
+                      "Javascript query `%s` caused a crash in a worker process.",
+                      js_source.c_str());
+            } catch (const interrupted_exc_t &e) {
+                rfail(base_exc_t::GENERIC,
+                      "JavaScript query `%s` timed out after "
+                      "%" PRIu64 ".%03" PRIu64 " seconds.",
+                      js_source.c_str(), js_timeout_ms / 1000, js_timeout_ms % 1000);
+            }
+        } catch (const base_exc_t &e) {
+            slice_errors[i] = std::current_exception();
+        }
+    });
+
+    if (num_slices == 1 && slice_errors[0] == std::exception_ptr()) {
+        return std::move(slice_results[0]);
+    }
+    // The batch stops at the first failed slice.
+    std::vector<js_result_t> results;
+    results.reserve(args_batch.size());
+    for (size_t i = 0; i < num_slices; ++i) {
+        if (slice_errors[i] != std::exception_ptr()) {
+            *error_out = slice_errors[i];
+            break;
+        }
+        results.insert(results.end(), slice_results[i].begin(), slice_results[i].end());
+    }
+    return results;
+}
+
+counted_t<val_t> js_func_t::result_to_val(const js_result_t &result) const {
+    try {
+        return boost::apply_visitor(
+            js_result_visitor_t(js_source, js_timeout_ms, this), result);
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
+std::vector<counted_t<val_t> > js_func_t::call_batch(
+    env_t *env,
+    const std::vector<std::vector<counted_t<const datum_t> > > &args_batch) const {
+    std::exception_ptr batch_error;
+    std::vector<js_result_t> js_results = run_batch(env, args_batch, &batch_error);
+
+    std::vector<counted_t<val_t> > results;
+    results.reserve(js_results.size());
+    for (auto it = js_results.begin(); it != js_results.end(); ++it) {
+        results.push_back(result_to_val(*it));
+    }
+    if (batch_error != std::exception_ptr()) {
+        std::rethrow_exception(batch_error);
+    }
+    return results;
+}
+
+std::vector<bool> js_func_t::filter_call_batch(
+    env_t *env,
+    const std::vector<counted_t<const datum_t> > &args,
+    counted_t<func_t> default_filter_val) const {
+    std::vector<std::vector<counted_t<const datum_t> > > args_batch;
+    args_batch.reserve(args.size());
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        args_batch.push_back(make_vector(*it));
+    }
+
+    // A worker crash or timeout fails the rest of the batch, but only after the
+    //  rows before it, which may fail with their own errors first.
+    std::exception_ptr batch_error;
+    std::vector<js_result_t> js_results = run_batch(env, args_batch, &batch_error);
+
+    std::vector<bool> results;
+    results.reserve(js_results.size());
+    for (auto it = js_results.begin(); it != js_results.end(); ++it) {
+        results.push_back(apply_filter_default(
+            env,
+            [&]() { return result_to_val(*it)->as_datum()->as_bool(); },
+            default_filter_val));
+    }
+    if (batch_error != std::exception_ptr()) {
+        std::rethrow_exception(batch_error);
+    }
+    return results;
+}
+
 bool js_func_t::is_deterministic() const {
     return false;
 }
@@ -223,8 +389,7 @@ bool filter_match(counted_t<const datum_t> predicate, counted_t<const datum_t> v
     if (predicate->is_ptype(pseudo::literal_string)) {
         return *predicate->get(pseudo::value_key) == *value;
     } else {
-        const std::map<std::string, counted_t<const datum_t> > &obj
-            = predicate->as_object();
+        const datum_object_t &obj = predicate->as_object();
         for (auto it = obj.begin(); it != obj.end(); ++it) {
             r_sanity_check(it->second.has());
             counted_t<const datum_t> elt = value->get(it->first, NOTHROW);
@@ -278,13 +443,21 @@ bool js_func_t::filter_helper(env_t *env, counted_t<const datum_t> arg) const {
 }
 
 bool func_t::filter_call(env_t *env, counted_t<const datum_t> arg, counted_t<func_t> default_filter_val) const {
+    return apply_filter_default(env,
+                                [&]() { return filter_helper(env, arg); },
+                                default_filter_val);
+}
+
+static bool apply_filter_default(env_t *env,
+                                 const std::function<bool()> &filter_fn,
+                                 counted_t<func_t> default_filter_val) {
     // We have to catch every exception type and save it so we can rethrow it later
     // So we don't trigger a coroutine wait in a catch statement
     std::exception_ptr saved_exception;
     base_exc_t::type_t exception_type;
 
     try {
-        return filter_helper(env, arg);
+        return filter_fn();
     } catch (const base_exc_t &e) {
         saved_exception = std::current_exception();
         exception_type = e.get_type();
@@ -369,6 +542,83 @@ counted_t<func_t> new_eq_comparison_func(counted_t<const datum_t> obj,
     return func_term->eval_to_func(var_scope_t());
 }
 
+// True if `term` is a reference to the variable `var`.
+bool is_var_term(const Term &term, int64_t var, bool implicit_is_var) {
+    if (term.type() == Term::IMPLICIT_VAR) {
+        return implicit_is_var;
+    }
+    return term.type() == Term::VAR
+        && term.args_size() == 1
+        && term.args(0).type() == Term::DATUM
+        && term.args(0).datum().type() == Datum::R_NUM
+        && term.args(0).datum().r_num() == var;
+}
+
+// Adds the fields `term` gets from `var` to `fields_out`.  Returns false if `term`
+// uses `var` (or the implicit variable, which might be `var`) any other way.
+bool collect_accessed_fields(const Term &term, int64_t var, bool implicit_is_var,
+                             std::set<std::string> *fields_out) {
+    if (term.type() == Term::GET_FIELD
+        && term.args_size() == 2
+        && term.optargs_size() == 0
+        && is_var_term(term.args(0), var, implicit_is_var)
+        && term.args(1).type() == Term::DATUM
+        && term.args(1).datum().type() == Datum::R_STR) {
+        fields_out->insert(term.args(1).datum().r_str());
+        return true;
+    }
+    if (term.type() == Term::IMPLICIT_VAR || is_var_term(term, var, false)) {
+        return false;
+    }
+    for (int i = 0; i < term.args_size(); ++i) {
+        if (!collect_accessed_fields(term.args(i), var, implicit_is_var, fields_out)) {
+            return false;
+        }
+    }
+    for (int i = 0; i < term.optargs_size(); ++i) {
+        if (!collect_accessed_fields(term.optargs(i).val(), var, implicit_is_var,
+                                     fields_out)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class accessed_fields_visitor_t : public func_visitor_t {
+public:
+    explicit accessed_fields_visitor_t(std::set<std::string> *_fields_out)
+        : fields_out(_fields_out), result(false) { }
+
+    void on_reql_func(const reql_func_t *reql_func) {
+        const std::vector<sym_t> &arg_names = reql_func->arg_names;
+        if (arg_names.size() != 1) {
+            return;
+        }
+        result = collect_accessed_fields(*reql_func->body->get_src(),
+                                         arg_names[0].value,
+                                         function_emits_implicit_variable(arg_names),
+                                         fields_out);
+    }
+
+    void on_js_func(const js_func_t *) {
+        // We can't see what the JavaScript does with its argument.
+        result = false;
+    }
+
+    std::set<std::string> *const fields_out;
+    bool result;
+};
+
+bool get_accessed_fields(const func_t *func, std::set<std::string> *fields_out) {
+    std::set<std::string> fields;
+    accessed_fields_visitor_t v(&fields);
+    func->visit(&v);
+    if (v.result) {
+        fields_out->insert(fields.begin(), fields.end());
+    }
+    return v.result;
+}
+
 counted_t<val_t> js_result_visitor_t::operator()(const std::string &err_val) const {
     rfail_target(parent, base_exc_t::GENERIC, "%s", err_val.c_str());
     unreachable();
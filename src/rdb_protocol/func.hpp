@@ -2,7 +2,9 @@
 #ifndef RDB_PROTOCOL_FUNC_HPP_
 #define RDB_PROTOCOL_FUNC_HPP_
 
+#include <exception>
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -46,6 +48,23 @@ public:
                      counted_t<const datum_t> arg,
                      counted_t<func_t> default_filter_val) const;
 
+    // Batched versions of `call` and `filter_call`, used by transformations that
+    // apply the function to a whole batch of rows.  They behave exactly like
+    // calling the single-row versions on each element in order; the default
+    // implementations do just that, but `js_func_t` evaluates the whole batch
+    // in one round trip to its worker process.
+    virtual std::vector<counted_t<val_t> > call_batch(
+        env_t *env,
+        const std::vector<std::vector<counted_t<const datum_t> > > &args_batch) const;
+    virtual std::vector<bool> filter_call_batch(
+        env_t *env,
+        const std::vector<counted_t<const datum_t> > &args,
+        counted_t<func_t> default_filter_val) const;
+    // Whether `call_batch` does anything more than loop over `call`.  Callers
+    // that would otherwise have to hold on to every result of a batch at once
+    // only batch when this is true.
+    virtual bool batches_calls() const { return false; }
+
     // These are simple, they call the vector version of call.
     counted_t<val_t> call(env_t *env, eval_flags_t eval_flags = NO_FLAGS) const;
     counted_t<val_t> call(env_t *env,
@@ -85,6 +104,7 @@ public:
 
 private:
     friend class wire_func_serialization_visitor_t;
+    friend class accessed_fields_visitor_t;
     bool filter_helper(env_t *env, counted_t<const datum_t> arg) const;
 
     // Only contains the parts of the scope that `body` uses.
@@ -118,10 +138,31 @@ public:
 
     void visit(func_visitor_t *visitor) const;
 
+    std::vector<counted_t<val_t> > call_batch(
+        env_t *env,
+        const std::vector<std::vector<counted_t<const datum_t> > > &args_batch) const;
+    std::vector<bool> filter_call_batch(
+        env_t *env,
+        const std::vector<counted_t<const datum_t> > &args,
+        counted_t<func_t> default_filter_val) const;
+    bool batches_calls() const { return true; }
+
 private:
     friend class wire_func_serialization_visitor_t;
     bool filter_helper(env_t *env, counted_t<const datum_t> arg) const;
 
+    // Runs the batch through the env's js_runner_t, splitting it across helper
+    // workers when the extproc pool has them.  Each call gets the full
+    // `js_timeout_ms`.  If a slice fails (a worker crash, a timeout, or a query
+    // error), only the results of the rows before it are returned, and its error
+    // goes in `*error_out` for the caller to rethrow once it has dealt with those
+    // rows, so that their errors come first as if the rows had run one by one.
+    std::vector<js_result_t> run_batch(
+        env_t *env,
+        const std::vector<std::vector<counted_t<const datum_t> > > &args_batch,
+        std::exception_ptr *error_out) const;
+    counted_t<val_t> result_to_val(const js_result_t &result) const;
+
     std::string js_source;
     uint64_t js_timeout_ms;
 
@@ -138,6 +179,13 @@ protected:
     DISABLE_COPYING(func_visitor_t);
 };
 
+// If `func` is a one-argument ReQL function that only uses its argument to get
+// top-level fields by constant name (like `r.row('a').add(r.row('b'))`), puts the
+// names of those fields in `fields_out` and returns true.  Calling it on an object
+// with just those fields then gives the same result as calling it on the whole
+// object.
+bool get_accessed_fields(const func_t *func, std::set<std::string> *fields_out);
+
 // Some queries, like filter, can take a shortcut object instead of a
 // function as their argument.
 
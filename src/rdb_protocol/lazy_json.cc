@@ -21,6 +21,83 @@ counted_t<const ql::datum_t> get_data(const rdb_value_t *value, buf_parent_t par
     return data;
 }
 
+void get_serialized_data(const rdb_value_t *value,
+                         buf_parent_t parent,
+                         std::vector<char> *data_out) {
+    rdb_blob_wrapper_t blob(parent.cache()->get_block_size(),
+                            const_cast<rdb_value_t *>(value)->value_ref(),
+                            blob::btree_maxreflen);
+
+    blob_acq_t acq_group;
+    buffer_group_t buffer_group;
+    blob.expose_all(parent, access_t::read, &buffer_group, &acq_group);
+
+    data_out->clear();
+    data_out->reserve(buffer_group.get_size());
+    for (size_t i = 0; i < buffer_group.num_buffers(); ++i) {
+        buffer_group_t::buffer_t buf = buffer_group.get_buffer(i);
+        const char *start = static_cast<const char *>(buf.data);
+        data_out->insert(data_out->end(), start, start + buf.size);
+    }
+}
+
+counted_t<const ql::datum_t> get_data_fields(const rdb_value_t *value,
+                                             buf_parent_t parent,
+                                             const std::set<std::string> &fields) {
+    rdb_blob_wrapper_t blob(parent.cache()->get_block_size(),
+                            const_cast<rdb_value_t *>(value)->value_ref(),
+                            blob::btree_maxreflen);
+
+    uint32_t table_size;
+    {
+        blob_acq_t acq_group;
+        buffer_group_t buffer_group;
+        blob.expose_region(parent, access_t::read, 0,
+                           std::min(blob.valuesize(), ql::indexed_object_header_size),
+                           &buffer_group, &acq_group);
+        buffer_group_read_stream_t read_stream(const_view(&buffer_group));
+        archive_result_t res
+            = ql::deserialize_indexed_object_header(&read_stream, &table_size);
+        guarantee_deserialization(res, "rdb value");
+    }
+    if (table_size == 0) {
+        return get_data(value, parent);
+    }
+
+    std::vector<ql::indexed_object_entry_t> entries;
+    {
+        blob_acq_t acq_group;
+        buffer_group_t buffer_group;
+        blob.expose_region(parent, access_t::read, ql::indexed_object_header_size,
+                           table_size, &buffer_group, &acq_group);
+        buffer_group_read_stream_t read_stream(const_view(&buffer_group));
+        archive_result_t res
+            = ql::deserialize_indexed_object_table(&read_stream, &entries);
+        guarantee_deserialization(res, "rdb value");
+    }
+
+    const int64_t values_offset = ql::indexed_object_header_size + table_size;
+    ql::datum_object_t obj;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (fields.count(it->key) == 0) {
+            continue;
+        }
+        guarantee(values_offset + it->offset + it->size
+                  <= static_cast<uint64_t>(blob.valuesize()));
+
+        counted_t<const ql::datum_t> val;
+        blob_acq_t acq_group;
+        buffer_group_t buffer_group;
+        blob.expose_region(parent, access_t::read, values_offset + it->offset,
+                           it->size, &buffer_group, &acq_group);
+        buffer_group_read_stream_t read_stream(const_view(&buffer_group));
+        archive_result_t res = deserialize(&read_stream, &val);
+        guarantee_deserialization(res, "rdb value");
+        UNUSED bool dup = obj.append(std::move(it->key), std::move(val));
+    }
+    return make_counted<const ql::datum_t>(std::move(obj));
+}
+
 const counted_t<const ql::datum_t> &lazy_json_t::get() const {
     guarantee(pointee.has());
     if (!pointee->ptr.has()) {
@@ -2,6 +2,10 @@
 #ifndef RDB_PROTOCOL_LAZY_JSON_HPP_
 #define RDB_PROTOCOL_LAZY_JSON_HPP_
 
+#include <set>
+#include <string>
+#include <vector>
+
 #include "buffer_cache/alt/alt.hpp"
 #include "buffer_cache/alt/blob.hpp"
 #include "rdb_protocol/datum.hpp"
@@ -30,6 +34,21 @@ public:
 counted_t<const ql::datum_t> get_data(const rdb_value_t *value,
                                       buf_parent_t parent);
 
+// Copies out the row's bytes exactly as they are stored, without decoding them.
+// Backfilling ships these as they are and writes them straight into the receiving
+// btree.
+void get_serialized_data(const rdb_value_t *value,
+                         buf_parent_t parent,
+                         std::vector<char> *data_out);
+
+// Loads only the given top-level fields of a row, for callers that know they won't
+// look at any others.  Rows stored in the indexed format (see
+// `ql::serialize_for_storage`) only have those fields read and decoded; other rows
+// are loaded in full, so the result may have more fields than were asked for.
+counted_t<const ql::datum_t> get_data_fields(const rdb_value_t *value,
+                                             buf_parent_t parent,
+                                             const std::set<std::string> &fields);
+
 class lazy_json_pointee_t : public single_threaded_countable_t<lazy_json_pointee_t> {
     lazy_json_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent)
         : rdb_value(_rdb_value), parent(_parent) {
@@ -18,13 +18,15 @@ Response on_unparsable_query2(ql::protob_t<Query> q, std::string msg) {
 
 query2_server_t::query2_server_t(const std::set<ip_address_t> &local_addresses,
                                  int port,
-                                 rdb_protocol_t::context_t *_ctx) :
+                                 rdb_protocol_t::context_t *_ctx,
+                                 conn_placement_t conn_placement) :
     server(local_addresses,
            port,
            boost::bind(&query2_server_t::handle, this, _1, _2, _3),
            &on_unparsable_query2,
            _ctx->auth_metadata,
-           INLINE),
+           CORO_UNORDERED,
+           conn_placement),
     ctx(_ctx), parser_id(generate_uuid()), thread_counters(0)
 { }
 
@@ -73,6 +75,7 @@ bool query2_server_t::handle(ql::protob_t<Query> q,
          noreply->as_bool());
     try {
         scoped_ops_running_stat_t stat(&ctx->ql_ops_running);
+        block_pm_histogram latency(&ctx->ql_query_latency);
         guarantee(ctx->directory_read_manager);
         // `ql::run` will set the status code
         ql::run(q, ctx, interruptor, response_out, stream_cache2);
@@ -98,3 +101,7 @@ void make_empty_protob_bearer(ql::protob_t<Query> *request) {
 Query *underlying_protob_value(ql::protob_t<Query> *request) {
     return request->get();
 }
+
+bool is_barrier_request(ql::protob_t<Query> *request) {
+    return (*request)->type() == Query::NOREPLY_WAIT;
+}
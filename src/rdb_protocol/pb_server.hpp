@@ -16,11 +16,13 @@ namespace ql { template <class> class protob_t; }
 // Overloads used by protob_server_t.
 void make_empty_protob_bearer(ql::protob_t<Query> *request);
 Query *underlying_protob_value(ql::protob_t<Query> *request);
+bool is_barrier_request(ql::protob_t<Query> *request);
 
 class query2_server_t {
 public:
     query2_server_t(const std::set<ip_address_t> &local_addresses, int port,
-                    rdb_protocol_t::context_t *_ctx);
+                    rdb_protocol_t::context_t *_ctx,
+                    conn_placement_t conn_placement = conn_placement_t::accepting_thread);
 
     http_app_t *get_http_app();
 
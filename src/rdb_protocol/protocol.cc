@@ -7,6 +7,7 @@
 #include "arch/io/disk.hpp"
 #include "btree/erase_range.hpp"
 #include "btree/parallel_traversal.hpp"
+#include "btree/secondary_operations.hpp"
 #include "btree/slice.hpp"
 #include "btree/superblock.hpp"
 #include "clustering/administration/metadata.hpp"
@@ -44,6 +45,9 @@ typedef rdb_protocol_t::read_response_t read_response_t;
 typedef rdb_protocol_t::point_read_t point_read_t;
 typedef rdb_protocol_t::point_read_response_t point_read_response_t;
 
+typedef rdb_protocol_t::multi_point_read_t multi_point_read_t;
+typedef rdb_protocol_t::multi_point_read_response_t multi_point_read_response_t;
+
 typedef rdb_protocol_t::rget_read_t rget_read_t;
 typedef rdb_protocol_t::rget_read_response_t rget_read_response_t;
 
@@ -383,8 +387,12 @@ rdb_protocol_t::context_t::context_t()
     cross_thread_database_watchables(get_num_threads()),
     directory_read_manager(NULL),
     signals(get_num_threads()),
+    io_backender(NULL),
+    base_path(""),
     ql_stats_membership(&get_global_perfmon_collection(), &ql_stats_collection, "query_language"),
-    ql_ops_running_membership(&ql_stats_collection, &ql_ops_running, "ops_running")
+    ql_ops_running_membership(&ql_stats_collection, &ql_ops_running, "ops_running"),
+    ql_query_latency(secs_to_ticks(10)),
+    ql_query_latency_membership(&ql_stats_collection, &ql_query_latency, "query_latency")
 { }
 
 rdb_protocol_t::context_t::context_t(
@@ -397,6 +405,8 @@ rdb_protocol_t::context_t::context_t(
     directory_read_manager_t<cluster_directory_metadata_t>
         *_directory_read_manager,
     machine_id_t _machine_id,
+    io_backender_t *_io_backender,
+    const base_path_t &_base_path,
     perfmon_collection_t *global_stats)
     : extproc_pool(_extproc_pool), ns_repo(_ns_repo),
       cross_thread_namespace_watchables(get_num_threads()),
@@ -406,8 +416,12 @@ rdb_protocol_t::context_t::context_t(
       directory_read_manager(_directory_read_manager),
       signals(get_num_threads()),
       machine_id(_machine_id),
+      io_backender(_io_backender),
+      base_path(_base_path),
       ql_stats_membership(global_stats, &ql_stats_collection, "query_language"),
-      ql_ops_running_membership(&ql_stats_collection, &ql_ops_running, "ops_running")
+      ql_ops_running_membership(&ql_stats_collection, &ql_ops_running, "ops_running"),
+      ql_query_latency(secs_to_ticks(10)),
+      ql_query_latency_membership(&ql_stats_collection, &ql_query_latency, "query_latency")
 {
     for (int thread = 0; thread < get_num_threads(); ++thread) {
         cross_thread_namespace_watchables[thread].init(new cross_thread_watchable_variable_t<cow_ptr_t<namespaces_semilattice_metadata_t<rdb_protocol_t> > >(
@@ -458,12 +472,18 @@ store_key_t sindex_list_region_key() {
     return store_key_t();
 }
 
+region_t region_from_keys(const std::vector<store_key_t> &keys);
+
 /* read_t::get_region implementation */
 struct rdb_r_get_region_visitor : public boost::static_visitor<region_t> {
     region_t operator()(const point_read_t &pr) const {
         return rdb_protocol_t::monokey_region(pr.key);
     }
 
+    region_t operator()(const multi_point_read_t &mpr) const {
+        return region_from_keys(mpr.keys);
+    }
+
     region_t operator()(const rget_read_t &rg) const {
         return rg.region;
     }
@@ -505,6 +525,21 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
         return keyed_read(pr, pr.key);
     }
 
+    bool operator()(const multi_point_read_t &mpr) const {
+        std::vector<store_key_t> shard_keys;
+        for (auto it = mpr.keys.begin(); it != mpr.keys.end(); ++it) {
+            if (region_contains_key(*region, *it)) {
+                shard_keys.push_back(*it);
+            }
+        }
+        if (!shard_keys.empty()) {
+            *read_out = read_t(multi_point_read_t(std::move(shard_keys)), profile);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
     template <class T>
     bool rangey_read(const T &arg) const {
         const hash_region_t<key_range_t> intersection
@@ -592,6 +627,7 @@ public:
           env(ctx, interruptor) { }
 
     void operator()(const point_read_t &);
+    void operator()(const multi_point_read_t &);
 
     void operator()(const rget_read_t &rg);
     void operator()(const distribution_read_t &rg);
@@ -611,6 +647,17 @@ void rdb_r_unshard_visitor_t::operator()(const point_read_t &) {
     *response_out = responses[0];
 }
 
+void rdb_r_unshard_visitor_t::operator()(const multi_point_read_t &) {
+    response_out->response = multi_point_read_response_t();
+    auto out = boost::get<multi_point_read_response_t>(&response_out->response);
+    for (size_t i = 0; i < count; ++i) {
+        auto resp = boost::get<multi_point_read_response_t>(&responses[i].response);
+        guarantee(resp != NULL);
+        // The shards have disjoint keys.
+        out->rows.insert(resp->rows.begin(), resp->rows.end());
+    }
+}
+
 void rdb_r_unshard_visitor_t::operator()(const rget_read_t &rg) {
     // Initialize response.
     response_out->response = rget_read_response_t();
@@ -1035,13 +1082,14 @@ void write_t::unshard(write_response_t *responses, size_t count,
 store_t::store_t(serializer_t *serializer,
                  const std::string &perfmon_name,
                  int64_t cache_target,
+                 alt_cache_balancer_t *balancer,
                  bool create,
                  perfmon_collection_t *parent_perfmon_collection,
                  context_t *_ctx,
                  io_backender_t *io,
                  const base_path_t &base_path) :
     btree_store_t<rdb_protocol_t>(serializer, perfmon_name, cache_target,
-            create, parent_perfmon_collection, _ctx, io, base_path),
+            balancer, create, parent_perfmon_collection, _ctx, io, base_path),
     ctx(_ctx)
 {
     // Make sure to continue bringing sindexes up-to-date if it was interrupted earlier
@@ -1093,6 +1141,30 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         rdb_get(get.key, btree, superblock, res, ql_env.trace.get_or_null());
     }
 
+    void operator()(const multi_point_read_t &mget) {
+        response->response = multi_point_read_response_t();
+        multi_point_read_response_t *res =
+            boost::get<multi_point_read_response_t>(&response->response);
+
+        // All the keys get read in parallel, and the superblock gets released
+        // once they've all gotten past it.
+        std::vector<point_read_response_t> rows(mget.keys.size());
+        {
+            profile::starter_t starter("Perform multi-point read.", ql_env.trace);
+            profile::disabler_t disabler(ql_env.trace);
+            refcount_superblock_t refcount_wrapper(superblock, mget.keys.size());
+            pmap(mget.keys.size(), std::bind(&rdb_read_visitor_t::get_one_of_many,
+                                             this, &mget, &refcount_wrapper, &rows,
+                                             ph::_1));
+        }
+
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (rows[i].data->get_type() != ql::datum_t::R_NULL) {
+                res->rows[mget.keys[i]] = std::move(rows[i].data);
+            }
+        }
+    }
+
     void operator()(const rget_read_t &rget) {
         if (rget.transforms.size() != 0 || rget.terminal) {
             rassert(rget.optargs.size() != 0);
@@ -1145,7 +1217,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
 
             rdb_rget_secondary_slice(
                 store->get_sindex_slice(rget.sindex->id),
-                rget.sindex->original_range, rget.sindex->region,
+                rget.sindex->original_ranges, rget.sindex->region,
                 sindex_sb.get(), &ql_env, rget.batchspec, rget.transforms,
                 rget.terminal, rget.region.inner, rget.sorting,
                 sindex_mapping, multi_bool, res);
@@ -1266,6 +1338,11 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
     }
 
 private:
+    void get_one_of_many(const multi_point_read_t *mget, superblock_t *superblock_wrapper,
+                         std::vector<point_read_response_t> *rows_out, int i) {
+        rdb_get(mget->keys[i], btree, superblock_wrapper, &(*rows_out)[i], NULL);
+    }
+
     read_response_t *response;
     btree_slice_t *btree;
     btree_store_t<rdb_protocol_t> *store;
@@ -1471,6 +1548,8 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
                NULL,
                &interruptor,
                ctx->machine_id,
+               ql::spill_location_t(ctx->io_backender, ctx->base_path,
+                                    &ctx->ql_stats_collection),
                ql::protob_t<Query>()) {
         sindex_block =
             store->acquire_sindex_block_for_write((*superblock)->expose_buf(),
@@ -1654,18 +1733,21 @@ void store_t::protocol_send_backfill(const region_map_t<rdb_protocol_t, state_ti
     }
 }
 
-void backfill_chunk_single_rdb_set(const rdb_backfill_atom_t &bf_atom,
+void backfill_chunk_single_rdb_set(const rdb_backfill_atom_t *bf_atom,
+                                   bool decode_rows,
                                    btree_slice_t *btree, superblock_t *superblock,
                                    UNUSED auto_drainer_t::lock_t drainer_acq,
                                    rdb_modification_report_t *mod_report_out,
                                    promise_t<superblock_t *> *superblock_promise_out) {
-    mod_report_out->primary_key = bf_atom.key;
-    point_write_response_t response;
-    rdb_set(bf_atom.key, bf_atom.value, true,
-            btree, bf_atom.recency,
-            superblock, &response,
-            &mod_report_out->info, static_cast<profile::trace_t *>(NULL),
-            superblock_promise_out);
+    mod_report_out->primary_key = bf_atom->key;
+    // KSI: Every atom walks down from the root on its own, even though the atoms
+    // of a chunk come in key order and consecutive ones mostly land in the same
+    // leaf.  Setting them under a single leaf acquisition would need a bulk
+    // variant of `find_keyvalue_location_for_write` that handles splits.
+    rdb_set_serialized(bf_atom->key, bf_atom->value, decode_rows,
+                       btree, bf_atom->recency,
+                       superblock, &mod_report_out->info,
+                       superblock_promise_out);
 }
 
 struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
@@ -1701,6 +1783,13 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
     }
 
     void operator()(const backfill_chunk_t::key_value_pairs_t &kv) {
+        // The rows only have to be decoded if there are secondary indexes that
+        // need the old and new values. Otherwise we copy the bytes we got from
+        // the backfiller straight into the btree.
+        std::map<std::string, secondary_index_t> sindex_map;
+        get_secondary_indexes(&sindex_block, &sindex_map);
+        const bool decode_rows = !sindex_map.empty();
+
         std::vector<rdb_modification_report_t> mod_reports(kv.backfill_atoms.size());
         {
             auto_drainer_t drainer;
@@ -1709,7 +1798,8 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
                 // `spawn_now_dangerously` so that we don't have to wait for the
                 // superblock if it's immediately available.
                 coro_t::spawn_now_dangerously(std::bind(&backfill_chunk_single_rdb_set,
-                                                        kv.backfill_atoms[i], btree,
+                                                        &kv.backfill_atoms[i],
+                                                        decode_rows, btree,
                                                         superblock.release(),
                                                         auto_drainer_t::lock_t(&drainer),
                                                         &mod_reports[i],
@@ -1718,7 +1808,9 @@ struct rdb_receive_backfill_visitor_t : public boost::static_visitor<void> {
             }
             superblock->release();
         }
-        update_sindexes(mod_reports);
+        if (decode_rows) {
+            update_sindexes(mod_reports);
+        }
     }
 
     void operator()(const backfill_chunk_t::sindexes_t &s) {
@@ -1816,6 +1908,7 @@ RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_details::single_sindex_status_t,
                            blocks_total, blocks_processed, ready);
 
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_read_response_t, data);
+RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::multi_point_read_response_t, rows);
 RDB_IMPL_ME_SERIALIZABLE_4(rdb_protocol_t::rget_read_response_t,
                            result, key_range, truncated, last_key);
 RDB_IMPL_ME_SERIALIZABLE_2(rdb_protocol_t::distribution_read_response_t,
@@ -1826,8 +1919,9 @@ RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::read_response_t,
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::sindex_status_response_t, statuses);
 
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_read_t, key);
+RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::multi_point_read_t, keys);
 RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::sindex_rangespec_t,
-                           id, region, original_range);
+                           id, region, original_ranges);
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(key_range_t::bound_t, int8_t,
                                       key_range_t::open, key_range_t::none);
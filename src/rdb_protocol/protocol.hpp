@@ -36,6 +36,7 @@ template <class> class directory_read_manager_t;
 template <class> class namespace_repo_t;
 template <class> class namespaces_semilattice_metadata_t;
 template <class> class semilattice_readwrite_view_t;
+class sindex_data_t;
 class traversal_progress_combiner_t;
 
 namespace unittest { struct make_sindex_read_t; }
@@ -114,11 +115,13 @@ public:
 
 private:
     // Only `readgen_t` and its subclasses should do anything fancy with a range.
-    // (Modulo unit tests.)
+    // (Modulo unit tests, and `sindex_data_t`, which needs to know which parts
+    // of the sindex keyspace to traverse.)
     friend class ql::readgen_t;
     friend class ql::primary_readgen_t;
     friend class ql::sindex_readgen_t;
     friend struct unittest::make_sindex_read_t;
+    friend class ::sindex_data_t;
 
     key_range_t to_primary_keyrange() const;
     key_range_t to_sindex_keyrange() const;
@@ -134,15 +137,18 @@ typedef ql::terminal_variant_t terminal_variant_t;
 
 struct backfill_atom_t {
     store_key_t key;
-    counted_t<const ql::datum_t> value;
+    // The row exactly as it is stored in the btree (see `ql::serialize_for_storage`).
+    // Neither end of a backfill needs to decode it unless the receiver has secondary
+    // indexes to update.
+    std::vector<char> value;
     repli_timestamp_t recency;
 
     backfill_atom_t() { }
     backfill_atom_t(const store_key_t &_key,
-                    const counted_t<const ql::datum_t> &_value,
+                    std::vector<char> &&_value,
                     const repli_timestamp_t &_recency) :
         key(_key),
-        value(_value),
+        value(std::move(_value)),
         recency(_recency)
     { }
 };
@@ -204,6 +210,8 @@ struct rdb_protocol_t {
                   directory_read_manager_t<
                       cluster_directory_metadata_t> *_directory_read_manager,
                   uuid_u _machine_id,
+                  io_backender_t *_io_backender,
+                  const base_path_t &_base_path,
                   perfmon_collection_t *global_stats);
         ~context_t();
 
@@ -228,10 +236,17 @@ struct rdb_protocol_t {
         scoped_array_t<scoped_ptr_t<cross_thread_signal_t> > signals;
         uuid_u machine_id;
 
+        // Queries that sort more than fits into memory write sorted runs to
+        // temporary files under `base_path`.  NULL on a proxy, which has no disk.
+        io_backender_t *io_backender;
+        base_path_t base_path;
+
         perfmon_collection_t ql_stats_collection;
         perfmon_membership_t ql_stats_membership;
         perfmon_counter_t ql_ops_running;
         perfmon_membership_t ql_ops_running_membership;
+        perfmon_histogram_t ql_query_latency;
+        perfmon_membership_t ql_query_latency_membership;
     };
 
     struct point_read_response_t {
@@ -242,6 +257,12 @@ struct rdb_protocol_t {
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
+    struct multi_point_read_response_t {
+        // Only the keys that were found are in here.
+        std::map<store_key_t, counted_t<const ql::datum_t> > rows;
+        RDB_DECLARE_ME_SERIALIZABLE;
+    };
+
     struct rget_read_response_t {
 
         class empty_t { RDB_MAKE_ME_SERIALIZABLE_0() };
@@ -291,6 +312,7 @@ struct rdb_protocol_t {
 
     struct read_response_t {
         typedef boost::variant<point_read_response_t,
+                               multi_point_read_response_t,
                                rget_read_response_t,
                                distribution_read_response_t,
                                sindex_list_response_t,
@@ -316,18 +338,40 @@ struct rdb_protocol_t {
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
+    /* Reads the rows with several primary keys at once.  It gets split up by
+    shard, and every shard reads all of its keys in one transaction. */
+    class multi_point_read_t {
+    public:
+        multi_point_read_t() { }
+        explicit multi_point_read_t(std::vector<store_key_t> &&_keys)
+            : keys(std::move(_keys)) {
+            r_sanity_check(!keys.empty());
+        }
+
+        std::vector<store_key_t> keys;
+
+        RDB_DECLARE_ME_SERIALIZABLE;
+    };
+
     struct sindex_rangespec_t {
         sindex_rangespec_t() { }
         sindex_rangespec_t(const std::string &_id,
                            // This is the region in the sindex keyspace.  It's
-                           // sometimes smaller than the datum range below when
+                           // sometimes smaller than the datum ranges below when
                            // dealing with truncated keys.
                            const region_t &_region,
-                           const datum_range_t _original_range)
-            : id(_id), region(_region), original_range(_original_range) { }
+                           const std::vector<datum_range_t> &_original_ranges)
+            : id(_id), region(_region), original_ranges(_original_ranges) {
+            r_sanity_check(!original_ranges.empty());
+        }
         std::string id; // What sindex we're using.
         region_t region; // What keyspace we're currently operating on.
-        datum_range_t original_range; // For dealing with truncation.
+        // For dealing with truncation.  There's more than one of these when
+        // we're reading several values at once (for `get_all`); every shard
+        // then visits all of them in a single traversal.  They're sorted by
+        // where they start in the sindex keyspace, and a row gets returned
+        // once for every range that contains it.
+        std::vector<datum_range_t> original_ranges;
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
@@ -406,6 +450,7 @@ struct rdb_protocol_t {
 
     struct read_t {
         typedef boost::variant<point_read_t,
+                               multi_point_read_t,
                                rget_read_t,
                                distribution_read_t,
                                sindex_list_t,
@@ -758,6 +803,7 @@ struct rdb_protocol_t {
         store_t(serializer_t *serializer,
                 const std::string &perfmon_name,
                 int64_t cache_target,
+                alt_cache_balancer_t *balancer,
                 bool create,
                 perfmon_collection_t *parent_perfmon_collection,
                 context_t *ctx,
@@ -8,6 +8,7 @@
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "stl_utils.hpp"
 
 namespace ql {
 
@@ -557,6 +558,18 @@ eager_acc_t *make_eager_terminal(env_t *env, const terminal_variant_t &t) {
 
 class ungrouped_op_t : public op_t {
 protected:
+    // Wraps each row as a single-argument list for `func_t::call_batch`, so
+    // that functions which can evaluate a whole batch at once (i.e. `r.js`)
+    // only cost one round trip per batch.
+    static std::vector<std::vector<counted_t<const datum_t> > > batch_args(
+        const datums_t &lst) {
+        std::vector<std::vector<counted_t<const datum_t> > > args_batch;
+        args_batch.reserve(lst.size());
+        for (auto it = lst.begin(); it != lst.end(); ++it) {
+            args_batch.push_back(make_vector(*it));
+        }
+        return args_batch;
+    }
 private:
     virtual void operator()(groups_t *groups, const counted_t<const datum_t> &) {
         for (auto it = groups->begin(); it != groups->end(); ++it) {
@@ -688,8 +701,19 @@ public:
 private:
     virtual void lst_transform(datums_t *lst) {
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                *it = f->call(env, *it)->as_datum();
+            // Rows must fail in order, before later rows get evaluated, so only
+            //  functions that really batch their calls get the whole batch.
+            if (f->batches_calls()) {
+                std::vector<counted_t<val_t> > vals
+                    = f->call_batch(env, batch_args(*lst));
+                r_sanity_check(vals.size() == lst->size());
+                for (size_t i = 0; i < vals.size(); ++i) {
+                    (*lst)[i] = vals[i]->as_datum();
+                }
+            } else {
+                for (auto it = lst->begin(); it != lst->end(); ++it) {
+                    *it = f->call(env, *it)->as_datum();
+                }
             }
         } catch (const datum_exc_t &e) {
             throw exc_t(e, f->backtrace().get(), 1);
@@ -712,8 +736,10 @@ private:
         auto it = lst->begin();
         auto loc = it;
         try {
-            for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
+            std::vector<bool> keep = f->filter_call_batch(env, *lst, default_val);
+            r_sanity_check(keep.size() == lst->size());
+            for (size_t i = 0; it != lst->end(); ++it, ++i) {
+                if (keep[i]) {
                     loc->swap(*it);
                     ++loc;
                 }
@@ -737,14 +763,18 @@ private:
         batchspec_t bs = batchspec_t::user(batch_type_t::TERMINAL, env);
         profile::sampler_t sampler("Evaluating CONCAT_MAP elements.", env->trace);
         try {
-            for (auto it = lst->begin(); it != lst->end(); ++it) {
-                auto ds = f->call(env, *it)->as_seq(env);
-                for (;;) {
-                    auto v = ds->next_batch(env, bs);
-                    if (v.size() == 0) break;
-                    new_lst.reserve(new_lst.size() + v.size());
-                    new_lst.insert(new_lst.end(), v.begin(), v.end());
-                    sampler.new_sample();
+            // A ReQL function may return a lazy stream for every row (e.g. a
+            //  table read), so only functions that really batch their calls get
+            //  evaluated for the whole batch up front.
+            if (f->batches_calls()) {
+                std::vector<counted_t<val_t> > vals
+                    = f->call_batch(env, batch_args(*lst));
+                for (auto it = vals.begin(); it != vals.end(); ++it) {
+                    append_seq(*it, bs, &sampler, &new_lst);
+                }
+            } else {
+                for (auto it = lst->begin(); it != lst->end(); ++it) {
+                    append_seq(f->call(env, *it), bs, &sampler, &new_lst);
                 }
             }
         } catch (const datum_exc_t &e) {
@@ -752,6 +782,17 @@ private:
         }
         lst->swap(new_lst);
     }
+    void append_seq(counted_t<val_t> val, const batchspec_t &bs,
+                    profile::sampler_t *sampler, datums_t *new_lst) {
+        auto ds = val->as_seq(env);
+        for (;;) {
+            auto v = ds->next_batch(env, bs);
+            if (v.size() == 0) break;
+            new_lst->reserve(new_lst->size() + v.size());
+            new_lst->insert(new_lst->end(), v.begin(), v.end());
+            sampler->new_sample();
+        }
+    }
     env_t *env;
     counted_t<func_t> f;
 };
@@ -9,10 +9,31 @@ bool stream_cache2_t::contains(int64_t key) {
     return streams.find(key) != streams.end();
 }
 
-void stream_cache2_t::insert(int64_t key,
+stream_cache2_t::reservation_t::reservation_t(stream_cache2_t *_parent, int64_t _key)
+    : parent(NULL), key(_key) {
+    if (!_parent->contains(key)
+        && _parent->reserved_tokens.insert(key).second) {
+        parent = _parent;
+    }
+}
+
+stream_cache2_t::reservation_t::~reservation_t() {
+    if (parent != NULL) {
+        size_t erased = parent->reserved_tokens.erase(key);
+        guarantee(erased == 1);
+    }
+}
+
+void stream_cache2_t::insert(reservation_t *reservation,
                              use_json_t use_json,
                              scoped_ptr_t<env_t> &&val_env,
                              counted_t<datum_stream_t> val_stream) {
+    guarantee(reservation->parent == this);
+    int64_t key = reservation->key;
+    size_t erased = reserved_tokens.erase(key);
+    guarantee(erased == 1);
+    reservation->parent = NULL;
+
     maybe_evict();
     std::pair<boost::ptr_map<int64_t, entry_t>::iterator, bool> res = streams.insert(
         key, new entry_t(time(0), use_json, std::move(val_env), val_stream));
@@ -20,15 +41,24 @@ void stream_cache2_t::insert(int64_t key,
 }
 
 void stream_cache2_t::erase(int64_t key) {
-    size_t num_erased = streams.erase(key);
-    guarantee(num_erased == 1);
+    boost::ptr_map<int64_t, entry_t>::iterator it = streams.find(key);
+    guarantee(it != streams.end());
+    if (it->second->in_use) {
+        it->second->erase_when_done = true;
+    } else {
+        streams.erase(it);
+    }
 }
 
 bool stream_cache2_t::serve(int64_t key, Response *res, signal_t *interruptor) {
     boost::ptr_map<int64_t, entry_t>::iterator it = streams.find(key);
     if (it == streams.end()) return false;
     entry_t *entry = it->second;
+    rcheck_toplevel(!entry->in_use, base_exc_t::GENERIC,
+                    strprintf("Token %" PRIi64 " is already being served by "
+                              "another CONTINUE.", key));
     entry->last_activity = time(0);
+    entry->in_use = true;
     try {
         // Reset the env_t's interruptor to a good one before we use it.  This may be a
         // hack.  (I'd rather not have env_t be mutable this way -- could we construct
@@ -51,10 +81,14 @@ bool stream_cache2_t::serve(int64_t key, Response *res, signal_t *interruptor) {
                 res->mutable_profile(), entry->use_json);
         }
     } catch (const std::exception &e) {
+        entry->in_use = false;
         erase(key);
         throw;
     }
-    if (entry->stream->is_exhausted() || res->response_size() == 0) {
+    entry->in_use = false;
+    if (entry->erase_when_done
+        || entry->stream->is_exhausted()
+        || res->response_size() == 0) {
         erase(key);
         res->set_type(Response::SUCCESS_SEQUENCE);
     } else {
@@ -77,7 +111,9 @@ stream_cache2_t::entry_t::entry_t(time_t _last_activity,
       env(std::move(env_ptr)),
       stream(_stream),
       max_age(DEFAULT_MAX_AGE),
-      has_sent_batch(false) { }
+      has_sent_batch(false),
+      in_use(false),
+      erase_when_done(false) { }
 
 stream_cache2_t::entry_t::~entry_t() { }
 
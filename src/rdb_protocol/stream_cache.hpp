@@ -5,6 +5,7 @@
 #include <time.h>
 
 #include <map>
+#include <set>
 
 #include "errors.hpp"
 #include <boost/ptr_container/ptr_map.hpp>
@@ -22,9 +23,26 @@ namespace ql {
 
 class stream_cache2_t {
 public:
+    // Claims a START query's token while the query is being evaluated, so that
+    // a concurrent START with the same token on the connection is rejected
+    // instead of colliding with it in `insert`.
+    class reservation_t {
+    public:
+        reservation_t(stream_cache2_t *parent, int64_t key);
+        ~reservation_t();
+        // False if the token was already in use.
+        bool is_reserved() const { return parent != NULL; }
+    private:
+        friend class stream_cache2_t;
+        stream_cache2_t *parent;
+        int64_t key;
+        DISABLE_COPYING(reservation_t);
+    };
+
     stream_cache2_t() { }
     MUST_USE bool contains(int64_t key);
-    void insert(int64_t key,
+    // Consumes `reservation`, which must be held.
+    void insert(reservation_t *reservation,
                 use_json_t use_json,
                 scoped_ptr_t<env_t> &&val_env,
                 counted_t<datum_stream_t> val_stream);
@@ -46,11 +64,17 @@ private:
         counted_t<datum_stream_t> stream;
         time_t max_age;
         bool has_sent_batch;
+        // Set while `serve` is using the entry.  Queries on a connection may run
+        // concurrently, so a STOP for the token can arrive in the meantime; it sets
+        // `erase_when_done` and leaves the entry for `serve` to remove.
+        bool in_use;
+        bool erase_when_done;
     private:
         DISABLE_COPYING(entry_t);
     };
 
     boost::ptr_map<int64_t, entry_t> streams;
+    std::set<int64_t> reserved_tokens;
     DISABLE_COPYING(stream_cache2_t);
 };
 
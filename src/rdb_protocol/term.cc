@@ -195,7 +195,10 @@ void run(protob_t<Query> q,
                 ctx->cross_thread_namespace_watchables[th.threadnum]->get_watchable(),
                 ctx->cross_thread_database_watchables[th.threadnum]->get_watchable(),
                 ctx->cluster_metadata, ctx->directory_read_manager,
-                interruptor, ctx->machine_id, q));
+                interruptor, ctx->machine_id,
+                ql::spill_location_t(ctx->io_backender, ctx->base_path,
+                                     &ctx->ql_stats_collection),
+                q));
 
         counted_t<term_t> root_term;
         try {
@@ -211,8 +214,11 @@ void run(protob_t<Query> q,
             return;
         }
 
+        // Queries on a connection run concurrently, so the token has to be
+        // claimed up front rather than checked here and inserted later.
+        stream_cache2_t::reservation_t reservation(stream_cache2, token);
         try {
-            rcheck_toplevel(!stream_cache2->contains(token),
+            rcheck_toplevel(reservation.is_reserved(),
                             base_exc_t::GENERIC,
                             strprintf("ERROR: duplicate token %" PRIi64, token));
         } catch (const exc_t &e) {
@@ -253,7 +259,7 @@ void run(protob_t<Query> q,
                             res->mutable_profile(), use_json);
                     }
                 } else {
-                    stream_cache2->insert(token, use_json, std::move(env), seq);
+                    stream_cache2->insert(&reservation, use_json, std::move(env), seq);
                     bool b = stream_cache2->serve(token, res, interruptor);
                     r_sanity_check(b);
                 }
@@ -307,9 +313,9 @@ void run(protob_t<Query> q,
         }
 
         // NOREPLY_WAIT is just a no-op.
-        // This works because we only evaluate one Query at a time
-        // on the connection level. Once we get to the NOREPLY_WAIT Query
-        // we know that all previous Queries have completed processing.
+        // This works because the connection treats NOREPLY_WAIT as a barrier
+        // (see `is_barrier_request`): it doesn't get evaluated until all
+        // previous Queries on the connection have completed processing.
 
         // Send back a WAIT_COMPLETE response.
         res->set_type(Response_ResponseType_WAIT_COMPLETE);
@@ -3,6 +3,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "clustering/administration/main/ports.hpp"
 #include "clustering/administration/suggester.hpp"
@@ -176,7 +177,8 @@ public:
     table_create_term_t(compile_env_t *env, const protob_t<const Term> &term) :
         meta_write_op_t(env, term, argspec_t(1, 2),
                         optargspec_t({"datacenter", "primary_key",
-                                    "cache_size", "durability"})) { }
+                                    "cache_size", "durability",
+                                    "compress_blocks"})) { }
 private:
     virtual std::string write_eval_impl(scope_env_t *env, UNUSED eval_flags_t flags) {
         uuid_u dc_id = nil_uuid();
@@ -204,6 +206,11 @@ private:
             cache_size = v->as_int<int64_t>();
         }
 
+        bool compress_blocks = false;
+        if (counted_t<val_t> v = optarg(env, "compress_blocks")) {
+            compress_blocks = v->as_bool();
+        }
+
         uuid_u db_id;
         name_string_t tbl_name;
         if (num_args() == 1) {
@@ -236,7 +243,7 @@ private:
                 new_namespace<rdb_protocol_t>(
                     env->env->cluster_access.this_machine, db_id, dc_id, tbl_name,
                     primary_key, port_defaults::reql_port,
-                    cache_size);
+                    cache_size, compress_blocks);
 
             // Set Durability
             std::map<datacenter_id_t, ack_expectation_t> *ack_map =
@@ -501,23 +508,29 @@ private:
         counted_t<val_t> index = optarg(env, "index");
         std::string index_str = index ? index->as_str().to_std() : "";
         if (index && index_str != table->get_pkey()) {
-            std::vector<counted_t<datum_stream_t> > streams;
+            std::vector<counted_t<const datum_t> > keys;
+            keys.reserve(num_args() - 1);
             for (size_t i = 1; i < num_args(); ++i) {
-                counted_t<const datum_t> key = arg(env, i)->as_datum();
-                counted_t<datum_stream_t> seq =
-                    table->get_all(env->env, key, index_str, backtrace());
-                streams.push_back(seq);
+                keys.push_back(arg(env, i)->as_datum());
             }
+            // One stream that reads all the keys, instead of one per key.
             counted_t<datum_stream_t> stream
-                = make_counted<union_datum_stream_t>(std::move(streams), backtrace());
+                = table->get_all(env->env, keys, index_str, backtrace());
             return new_val(stream, table);
         } else {
-            datum_ptr_t arr(datum_t::R_ARRAY);
+            std::vector<counted_t<const datum_t> > keys;
+            keys.reserve(num_args() - 1);
             for (size_t i = 1; i < num_args(); ++i) {
-                counted_t<const datum_t> key = arg(env, i)->as_datum();
-                counted_t<const datum_t> row = table->get_row(env->env, key);
-                if (row->get_type() != datum_t::R_NULL) {
-                    arr.add(row);
+                keys.push_back(arg(env, i)->as_datum());
+            }
+            // One read for all the keys, instead of one per key.
+            std::map<store_key_t, counted_t<const datum_t> > rows
+                = table->get_rows(env->env, keys);
+            datum_ptr_t arr(datum_t::R_ARRAY);
+            for (auto it = keys.begin(); it != keys.end(); ++it) {
+                auto row = rows.find(store_key_t((*it)->print_primary()));
+                if (row != rows.end()) {
+                    arr.add(row->second);
                 }
             }
             counted_t<datum_stream_t> stream
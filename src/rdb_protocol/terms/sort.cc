@@ -1,12 +1,13 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
+#include <vector>
 
-#include "errors.hpp"
-#include <boost/bind.hpp>
-
+#include "containers/uuid.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
@@ -45,11 +46,84 @@ private:
     virtual const char *name() const { return "desc"; }
 };
 
-class orderby_term_t : public op_term_t {
+// Base for the terms that have to sort a whole sequence.
+class sorting_term_t : public op_term_t {
+protected:
+    sorting_term_t(compile_env_t *env, const protob_t<const Term> &term,
+                   const argspec_t &argspec, optargspec_t optargspec)
+        : op_term_t(env, term, argspec, std::move(optargspec)) { }
+
+    // Reads all of `seq` into an external sorter ordered by `less`, and returns
+    // the finished sorter and how many items went into it.  Once the buffered
+    // items take up more than `sort_memory` bytes (within the server's bounds),
+    // they get written out to disk as a sorted run.  If there's no disk to spill
+    // to, they have to fit into an array instead.
+    scoped_ptr_t<datum_sorter_t> sort_seq(scope_env_t *env,
+                                          counted_t<datum_stream_t> seq,
+                                          const datum_less_t &less,
+                                          const std::string &sample_description,
+                                          size_t *num_items_out) {
+        const spill_location_t &spill = env->env->spill_location;
+        size_t memory_limit = DEFAULT_SORT_MEMORY;
+        if (counted_t<val_t> v = optarg(env, "sort_memory")) {
+            const int64_t sort_memory = v->as_int();
+            rcheck(sort_memory > 0, base_exc_t::GENERIC,
+                   "`sort_memory` must be positive.");
+            memory_limit = std::min<int64_t>(
+                std::max<int64_t>(sort_memory, MIN_SORT_MEMORY), MAX_SORT_MEMORY);
+        }
+        if (spill.io_backender == NULL) {
+            memory_limit = std::numeric_limits<size_t>::max();
+        }
+
+        scoped_ptr_t<datum_sorter_t> sorter(new datum_sorter_t(
+            spill.io_backender,
+            spill.base_path,
+            "sort_" + uuid_to_str(generate_uuid()),
+            spill.stats_parent,
+            memory_limit,
+            less));
+
+        size_t num_items = 0;
+        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
+        {
+            profile::sampler_t sampler(sample_description, env->env->trace);
+            for (;;) {
+                std::vector<counted_t<const datum_t> > data
+                    = seq->next_batch(env->env, batchspec);
+                if (data.size() == 0) {
+                    break;
+                }
+                for (auto it = data.begin(); it != data.end(); ++it) {
+                    ++num_items;
+                    rcheck(spill.io_backender != NULL
+                           || num_items <= array_size_limit(),
+                           base_exc_t::GENERIC,
+                           strprintf("Array over size limit %zu.", num_items).c_str());
+                    const size_t item_size = serialized_size(*it);
+                    sorter->push(std::move(*it), item_size);
+                    sampler.new_sample();
+                }
+            }
+            sorter->finish();
+        }
+        *num_items_out = num_items;
+        return sorter;
+    }
+
+    // Whether the output of `sort_seq` is small enough to be handed out as an
+    // array, the way it was before sorts could spill.  It doesn't matter whether
+    // the sorter spilled; its merged runs get read back into the array.
+    static bool fits_in_array(size_t num_items) {
+        return num_items <= array_size_limit();
+    }
+};
+
+class orderby_term_t : public sorting_term_t {
 public:
     orderby_term_t(compile_env_t *env, const protob_t<const Term> &term)
-        : op_term_t(env, term, argspec_t(1, -1),
-          optargspec_t({"index"})), src_term(term) { }
+        : sorting_term_t(env, term, argspec_t(1, -1),
+          optargspec_t({"index", "sort_memory"})), src_term(term) { }
 private:
     enum order_direction_t { ASC, DESC };
     class lt_cmp_t {
@@ -63,7 +137,9 @@ private:
                         profile::sampler_t *sampler,
                         counted_t<const datum_t> l,
                         counted_t<const datum_t> r) const {
-            sampler->new_sample();
+            if (sampler != NULL) {
+                sampler->new_sample();
+            }
             for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
                 counted_t<const datum_t> lval;
                 counted_t<const datum_t> rval;
@@ -167,23 +243,29 @@ private:
             }
             rcheck(!comparisons.empty(), base_exc_t::GENERIC,
                    "Must specify something to order by.");
-            std::vector<counted_t<const datum_t> > to_sort;
-            batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
-            for (;;) {
-                std::vector<counted_t<const datum_t> > data
-                    = seq->next_batch(env->env, batchspec);
-                if (data.size() == 0) {
-                    break;
+            env_t *query_env = env->env;
+            size_t num_items;
+            scoped_ptr_t<datum_sorter_t> sorter = sort_seq(
+                env, seq,
+                [query_env, lt_cmp](const counted_t<const datum_t> &l,
+                                    const counted_t<const datum_t> &r) {
+                    return lt_cmp(query_env, NULL, l, r);
+                },
+                "Sorting in-memory.",
+                &num_items);
+            if (fits_in_array(num_items)) {
+                std::vector<counted_t<const datum_t> > sorted;
+                sorted.reserve(num_items);
+                counted_t<const datum_t> d;
+                while (sorter->next(&d)) {
+                    sorted.push_back(std::move(d));
                 }
-                std::move(data.begin(), data.end(), std::back_inserter(to_sort));
-                rcheck(to_sort.size() <= array_size_limit(), base_exc_t::GENERIC,
-                       strprintf("Array over size limit %zu.", to_sort.size()).c_str());
+                seq = make_counted<array_datum_stream_t>(
+                    make_counted<const datum_t>(std::move(sorted)), backtrace());
+            } else {
+                seq = make_counted<external_sort_datum_stream_t>(
+                    std::move(sorter), false, backtrace());
             }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = boost::bind(lt_cmp, env->env, &sampler, _1, _2);
-            std::sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                make_counted<const datum_t>(std::move(to_sort)), backtrace());
         }
         return tbl.has() ? new_val(seq, tbl) : new_val(env->env, seq);
     }
@@ -194,37 +276,29 @@ private:
     protob_t<const Term> src_term;
 };
 
-class distinct_term_t : public op_term_t {
+class distinct_term_t : public sorting_term_t {
 public:
     distinct_term_t(compile_env_t *env, const protob_t<const Term> &term)
-        : op_term_t(env, term, argspec_t(1)) { }
+        : sorting_term_t(env, term, argspec_t(1), optargspec_t({"sort_memory"})) { }
 private:
-    static bool lt_cmp(env_t *,
-                       counted_t<const datum_t> l,
-                       counted_t<const datum_t> r) {
+    static bool lt_cmp(const counted_t<const datum_t> &l,
+                       const counted_t<const datum_t> &r) {
         return *l < *r;
     }
     virtual counted_t<val_t> eval_impl(scope_env_t *env, UNUSED eval_flags_t flags) {
         counted_t<datum_stream_t> s = arg(env, 0)->as_seq(env->env);
-        std::vector<counted_t<const datum_t> > arr;
-        counted_t<const datum_t> last;
-        batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
-        {
-            profile::sampler_t sampler("Evaluating elements in distinct.",
-                                       env->env->trace);
-            while (counted_t<const datum_t> d = s->next(env->env, batchspec)) {
-                arr.push_back(std::move(d));
-                rcheck_array_size(arr, base_exc_t::GENERIC);
-                sampler.new_sample();
-            }
+        size_t num_items;
+        scoped_ptr_t<datum_sorter_t> sorter
+            = sort_seq(env, s, &lt_cmp, "Evaluating elements in distinct.", &num_items);
+        if (!fits_in_array(num_items)) {
+            return new_val(env->env, make_counted<external_sort_datum_stream_t>(
+                               std::move(sorter), true, backtrace()));
         }
-        std::sort(arr.begin(), arr.end(),
-                  std::bind(lt_cmp, env->env,
-                            ph::_1, ph::_2));
         std::vector<counted_t<const datum_t> > toret;
-        for (auto it = arr.begin(); it != arr.end(); ++it) {
-            if (toret.size() == 0 || **it != *toret[toret.size()-1]) {
-                toret.push_back(std::move(*it));
+        counted_t<const datum_t> d;
+        while (sorter->next(&d)) {
+            if (toret.size() == 0 || *d != *toret[toret.size()-1]) {
+                toret.push_back(std::move(d));
             }
         }
         return new_val(make_counted<const datum_t>(std::move(toret)));
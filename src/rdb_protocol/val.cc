@@ -306,29 +306,50 @@ counted_t<const datum_t> table_t::get_row(env_t *env, counted_t<const datum_t> p
     return p_res->data;
 }
 
+std::map<store_key_t, counted_t<const datum_t> > table_t::get_rows(
+        env_t *env, const std::vector<counted_t<const datum_t> > &pvals) {
+    std::vector<store_key_t> keys;
+    keys.reserve(pvals.size());
+    for (auto it = pvals.begin(); it != pvals.end(); ++it) {
+        keys.push_back(store_key_t((*it)->print_primary()));
+    }
+    rdb_protocol_t::read_t read(
+            rdb_protocol_t::multi_point_read_t(std::move(keys)), env->profile());
+    rdb_protocol_t::read_response_t res;
+    if (use_outdated) {
+        access->get_namespace_if().read_outdated(read, &res, env->interruptor);
+    } else {
+        access->get_namespace_if().read(
+            read, &res, order_token_t::ignore, env->interruptor);
+    }
+    rdb_protocol_t::multi_point_read_response_t *p_res =
+        boost::get<rdb_protocol_t::multi_point_read_response_t>(&res.response);
+    r_sanity_check(p_res);
+    return std::move(p_res->rows);
+}
+
 counted_t<datum_stream_t> table_t::get_all(
         env_t *env,
-        counted_t<const datum_t> value,
+        const std::vector<counted_t<const datum_t> > &values,
         const std::string &get_all_sindex_id,
         const protob_t<const Backtrace> &bt) {
     rcheck_src(bt.get(), base_exc_t::GENERIC, !sindex_id,
             "Cannot chain get_all and other indexed operations.");
     r_sanity_check(sorting == sorting_t::UNORDERED);
     r_sanity_check(bounds.is_universe());
+    // Primary key lookups go through `get_rows`.
+    r_sanity_check(get_all_sindex_id != get_pkey());
 
-    if (get_all_sindex_id == get_pkey()) {
-        return make_counted<lazy_datum_stream_t>(
-            access.get(),
-            use_outdated,
-            primary_readgen_t::make(env, datum_range_t(value)),
-            bt);
-    } else {
-        return make_counted<lazy_datum_stream_t>(
-            access.get(),
-            use_outdated,
-            sindex_readgen_t::make(env, get_all_sindex_id, datum_range_t(value)),
-            bt);
+    std::vector<datum_range_t> ranges;
+    ranges.reserve(values.size());
+    for (auto it = values.begin(); it != values.end(); ++it) {
+        ranges.push_back(datum_range_t(*it));
     }
+    return make_counted<lazy_datum_stream_t>(
+        access.get(),
+        use_outdated,
+        sindex_readgen_t::make(env, get_all_sindex_id, std::move(ranges)),
+        bt);
 }
 
 void table_t::add_sorting(const std::string &new_sindex_id, sorting_t _sorting,
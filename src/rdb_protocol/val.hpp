@@ -2,6 +2,7 @@
 #ifndef RDB_PROTOCOL_VAL_HPP_
 #define RDB_PROTOCOL_VAL_HPP_
 
+#include <map>
 #include <set>
 #include <string>
 #include <utility>
@@ -38,9 +39,14 @@ public:
                                               const protob_t<const Backtrace> &bt);
     const std::string &get_pkey();
     counted_t<const datum_t> get_row(env_t *env, counted_t<const datum_t> pval);
+    // Reads the rows with all of the given primary keys in one go.  Rows that
+    // don't exist are left out.
+    std::map<store_key_t, counted_t<const datum_t> > get_rows(
+            env_t *env, const std::vector<counted_t<const datum_t> > &pvals);
+    // Reads the rows with any of `values` in secondary index `sindex_id`.
     counted_t<datum_stream_t> get_all(
             env_t *env,
-            counted_t<const datum_t> value,
+            const std::vector<counted_t<const datum_t> > &values,
             const std::string &sindex_id,
             const protob_t<const Backtrace> &bt);
     void add_sorting(
@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rpc/connectivity/cluster.hpp"
 
+#include <limits.h>
 #include <netinet/in.h>
 
 #include <functional>
@@ -12,6 +13,7 @@
 #include "arch/timing.hpp"
 
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/interruptor.hpp"
 #include "concurrency/pmap.hpp"
 #include "concurrency/semaphore.hpp"
 #include "containers/archive/vector_stream.hpp"
@@ -152,10 +154,23 @@ connectivity_cluster_t::run_t::connection_entry_t::connection_entry_t(run_t *p,
     conn(c), address(a), session_id(generate_uuid()),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
+    pm_messages_per_write(secs_to_ticks(1), false),
+    pm_send_queue_delay(secs_to_ticks(1), false),
     pm_collection_membership(&p->parent->connectivity_collection, &pm_collection, uuid_to_str(id.get_uuid())),
     pm_bytes_sent_membership(&pm_collection, &pm_bytes_sent, "bytes_sent"),
+    pm_messages_per_write_membership(&pm_collection, &pm_messages_per_write, "messages_per_write"),
+    pm_send_queue_delay_membership(&pm_collection, &pm_send_queue_delay, "send_queue_delay"),
     parent(p), peer(id),
-    entries(new one_per_thread_t<entry_installation_t>(this)) {
+    send_queue_waiter(NULL) {
+    if (conn != NULL) {
+        coro_t::spawn_sometime(std::bind(
+            &connectivity_cluster_t::run_t::connection_entry_t::send_queue_writer,
+            this, auto_drainer_t::lock_t(&send_queue_drainer)));
+    }
+
+    /* Only now that the writer exists can anybody find us to send messages. */
+    entries.init(new one_per_thread_t<entry_installation_t>(this));
+
     if (peer != parent->parent->me && parent->heartbeat_manager != NULL) {
         parent->heartbeat_manager->begin_peer_heartbeat(peer);
     }
@@ -170,8 +185,84 @@ connectivity_cluster_t::run_t::connection_entry_t::~connection_entry_t() THROWS_
     entries.reset();
 
     /* `~entry_installation_t` destroys the `auto_drainer_t`'s in entries,
-    so nothing can be holding the `send_mutex`. */
-    guarantee(!send_mutex.is_locked());
+    so nobody can still be waiting for a message to be sent. */
+    guarantee(send_queue.empty());
+}
+
+void connectivity_cluster_t::run_t::connection_entry_t::send(outbound_message_t *message) {
+    assert_thread();
+    rassert(conn != NULL);
+
+    message->enqueue_time = get_ticks();
+    send_queue.push_back(message);
+    if (send_queue_waiter != NULL) {
+        send_queue_waiter->pulse();
+        send_queue_waiter = NULL;
+    }
+
+    message->sent.wait_lazily_unordered();
+}
+
+void connectivity_cluster_t::run_t::connection_entry_t::send_queue_writer(
+        auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+
+    std::vector<outbound_message_t *> batch;
+    std::vector<iovec> iov;
+    while (true) {
+        if (send_queue.empty()) {
+            cond_t wakeup;
+            send_queue_waiter = &wakeup;
+            try {
+                wait_interruptible(&wakeup, keepalive.get_drain_signal());
+            } catch (const interrupted_exc_t &) {
+                /* The drainer is only destroyed after `entries`, so there
+                cannot be anybody left who wants to send something. */
+                send_queue_waiter = NULL;
+                guarantee(send_queue.empty());
+                return;
+            }
+            continue;
+        }
+
+        /* Take everything that has piled up while the previous write was in
+        progress. The buffers are written straight out of the messages; the
+        senders keep them alive until we pulse `sent`. */
+        ticks_t now = get_ticks();
+        size_t batch_bytes = 0;
+        while (!send_queue.empty() && iov.size() < static_cast<size_t>(IOV_MAX)) {
+            outbound_message_t *message = send_queue.head();
+            send_queue.pop_front();
+            batch.push_back(message);
+
+            iovec vec;
+            vec.iov_base = message->data.data();
+            vec.iov_len = message->data.size();
+            iov.push_back(vec);
+            batch_bytes += message->data.size();
+
+            pm_send_queue_delay.record(ticks_to_secs(now - message->enqueue_time));
+        }
+        pm_messages_per_write.record(batch.size());
+
+        int64_t res = conn->writev(iov.data(), iov.size());
+        if (res == -1) {
+            /* Close the other half of the connection to make sure that
+               `connectivity_cluster_t::run_t::handle()` notices that something is
+               up */
+            if (conn->is_read_open()) {
+                conn->shutdown_read();
+            }
+        } else {
+            guarantee(res == static_cast<int64_t>(batch_bytes));
+        }
+
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            (*it)->sent.pulse();
+        }
+        batch.clear();
+        iov.clear();
+    }
 }
 
 static void ping_connection_watcher(peer_id_t peer, peers_list_callback_t *connect_disconnect_cb) THROWS_NOTHING {
@@ -890,10 +981,9 @@ void connectivity_cluster_t::send_message(peer_id_t dest, send_message_write_cal
 
     guarantee(!dest.is_nil());
 
-    /* We currently write the message to a vector_stream_t, then
-       serialize that as a string. It's horribly inefficient, of course. */
-    // TODO: If we don't do it this way, we (or the caller) will need
-    // to worry about having the writer run on the connection thread.
+    /* We serialize the message into a vector_stream_t on the caller's thread.
+    The buffer is then handed over (not copied) to the connection's send
+    queue, whose writer coroutine batches it with whatever else is pending. */
     vector_stream_t buffer;
     // Reserve some space to reduce overhead (especially for small messages)
     buffer.reserve(1024);
@@ -954,24 +1044,9 @@ void connectivity_cluster_t::send_message(peer_id_t dest, send_message_write_cal
         guarantee(dest != me);
         on_thread_t threader(conn_structure->conn->home_thread());
 
-        /* Acquire the send-mutex so we don't collide with other things trying
-        to send on the same connection. */
-        mutex_t::acq_t acq(&conn_structure->send_mutex);
-
-        {
-            int64_t res = conn_structure->conn->write(buffer.vector().data(),
-                                                      buffer.vector().size());
-            if (res == -1) {
-                /* Close the other half of the connection to make sure that
-                   `connectivity_cluster_t::run_t::handle()` notices that something is
-                   up */
-                if (conn_structure->conn->is_read_open()) {
-                    conn_structure->conn->shutdown_read();
-                }
-            } else {
-                guarantee(res == static_cast<int64_t>(buffer.vector().size()));
-            }
-        }
+        run_t::connection_entry_t::outbound_message_t message;
+        buffer.swap(&message.data);
+        conn_structure->send(&message);
     }
 
     conn_structure->pm_bytes_sent.record(bytes_sent);
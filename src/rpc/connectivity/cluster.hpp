@@ -10,14 +10,17 @@
 
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "concurrency/semaphore.hpp"
 #include "containers/archive/tcp_conn_stream.hpp"
+#include "containers/intrusive_list.hpp"
 #include "containers/map_sentries.hpp"
 #include "containers/uuid.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rpc/connectivity/connectivity.hpp"
 #include "rpc/connectivity/messages.hpp"
+#include "time.hpp"
 #include "utils.hpp"
 
 namespace boost {
@@ -106,20 +109,47 @@ public:
             cross-thread to access the routing table. */
             peer_address_t address;
 
+            /* A message that has been serialized by `send_message()` and is
+            waiting for `send_queue_writer()` to put it on the wire. It lives on
+            the sender's stack; the sender waits on `sent` before returning. */
+            class outbound_message_t :
+                public intrusive_list_node_t<outbound_message_t> {
+            public:
+                std::vector<char> data;
+                ticks_t enqueue_time;
+                cond_t sent;
+            };
+
+            /* Hands `message` to the writer coroutine and blocks until it has
+            been written (or the write failed). Must be called on `conn`'s home
+            thread. */
+            void send(outbound_message_t *message);
+
             /* Unused for our connection to ourself */
-            mutex_t send_mutex;
+            intrusive_list_t<outbound_message_t> send_queue;
 
             uuid_u session_id;
 
             perfmon_collection_t pm_collection;
             perfmon_sampler_t pm_bytes_sent;
-            perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
+            perfmon_sampler_t pm_messages_per_write;
+            perfmon_sampler_t pm_send_queue_delay;
+            perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership,
+                pm_messages_per_write_membership, pm_send_queue_delay_membership;
 
         private:
+            /* Runs on `conn`'s home thread for as long as the connection
+            entry exists. Whenever `send_queue` is non-empty it takes every
+            queued message and writes them all with one `writev()`. */
+            void send_queue_writer(auto_drainer_t::lock_t keepalive);
+
             /* We only hold this information so we can deregister ourself */
             run_t *parent;
             peer_id_t peer;
 
+            /* Non-NULL while `send_queue_writer()` is waiting for messages */
+            cond_t *send_queue_waiter;
+
             struct entry_installation_t {
                 auto_drainer_t drainer_;
                 connection_entry_t *that_;
@@ -133,6 +163,10 @@ public:
             this `connection_entry_t` acquire the drainer for their thread when
             they look us up in `thread_info_t::connection_map`. */
             scoped_ptr_t<one_per_thread_t<entry_installation_t> > entries;
+
+            /* Keeps `send_queue_writer()` alive. Declared last so that the
+            writer stops before anything it uses is destroyed. */
+            auto_drainer_t send_queue_drainer;
         };
 
         /* Sets a variable to a value in its constructor; sets it to NULL in its
@@ -9,6 +9,17 @@
 #include "containers/archive/vector_stream.hpp"
 #include "concurrency/pmap.hpp"
 #include "logger.hpp"
+#include "perfmon/perfmon.hpp"
+
+// How long a received message waits before its mailbox's callback starts running
+// on the destination thread.
+static perfmon_histogram_t *get_pm_mailbox_delivery_latency() {
+    static perfmon_histogram_t pm_mailbox_delivery_latency(secs_to_ticks(10));
+    static perfmon_membership_t pm_mailbox_delivery_latency_membership(
+        &get_global_perfmon_collection(), &pm_mailbox_delivery_latency,
+        "mailbox_delivery_latency");
+    return &pm_mailbox_delivery_latency;
+}
 
 /* raw_mailbox_t */
 
@@ -174,6 +185,7 @@ void mailbox_manager_t::mailbox_read_coroutine(peer_id_t source_peer,
                                                raw_mailbox_t::id_t dest_mailbox_id,
                                                std::vector<char> *stream_data,
                                                int64_t stream_data_offset) {
+    const ticks_t receive_ticks = get_ticks();
 
     // Construct a new stream to use
     vector_read_stream_t stream(std::move(*stream_data), stream_data_offset);
@@ -183,6 +195,8 @@ void mailbox_manager_t::mailbox_read_coroutine(peer_id_t source_peer,
     bool archive_exception = false;
     {
         on_thread_t rethreader(dest_thread);
+        get_pm_mailbox_delivery_latency()->record(
+            ticks_to_secs(get_ticks() - receive_ticks));
 
         try {
             raw_mailbox_t *mbox = mailbox_tables.get()->find_mailbox(dest_mailbox_id);
@@ -0,0 +1,51 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/block_compression.hpp"
+
+#include <inttypes.h>
+#include <zlib.h>
+
+#include "config/args.hpp"
+#include "math.hpp"
+
+uint32_t compress_block(const ser_buffer_t *buf, block_size_t block_size,
+                        ser_buffer_t *out) {
+    // Unless the compressed block ends at least one device block earlier, it
+    // doesn't save anything on disk and only costs a decompression on every read.
+    const uint32_t aligned_size = ceil_aligned(block_size.ser_value(), DEVICE_BLOCK_SIZE);
+    if (aligned_size <= DEVICE_BLOCK_SIZE) {
+        return 0;
+    }
+    const uint32_t max_size = aligned_size - DEVICE_BLOCK_SIZE;
+    rassert(max_size <= block_size.ser_value());
+
+    uLongf compressed_size = max_size - sizeof(ls_buf_data_t);
+    const int res = compress2(reinterpret_cast<Bytef *>(out->cache_data),
+                              &compressed_size,
+                              reinterpret_cast<const Bytef *>(buf->cache_data),
+                              block_size.value(),
+                              Z_BEST_SPEED);
+    if (res == Z_BUF_ERROR) {
+        // It didn't fit into `max_size`.
+        return 0;
+    }
+    guarantee(res == Z_OK, "compress2 failed with error %d", res);
+
+    out->ser_header = buf->ser_header;
+    return sizeof(ls_buf_data_t) + compressed_size;
+}
+
+void decompress_block(const ser_buffer_t *buf, block_size_t disk_block_size,
+                      ser_buffer_t *out, block_size_t block_size) {
+    guarantee(disk_block_size.ser_value() > sizeof(ls_buf_data_t));
+
+    uLongf uncompressed_size = block_size.value();
+    const int res = uncompress(reinterpret_cast<Bytef *>(out->cache_data),
+                               &uncompressed_size,
+                               reinterpret_cast<const Bytef *>(buf->cache_data),
+                               disk_block_size.value());
+    guarantee(res == Z_OK && uncompressed_size == block_size.value(),
+              "Failed to decompress block %" PRIu64 " (zlib error %d).  The data "
+              "file might be corrupted.", buf->ser_header.block_id, res);
+
+    out->ser_header = buf->ser_header;
+}
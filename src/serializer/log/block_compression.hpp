@@ -0,0 +1,29 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+#define SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+
+#include "serializer/types.hpp"
+
+/* When block compression is turned on (see `log_serializer_dynamic_config_t`),
+blocks get written with their `ls_buf_data_t` header as it is, followed by the
+deflated contents of the rest of the block.  The header is left alone so that the
+GC and read-ahead can still find out which block they're looking at.  The LBA
+entry of a compressed block has the compressed size as its `ser_block_size` and the
+original size as its `uncompressed_ser_block_size`.
+
+These do the actual work, and don't touch anything but their arguments, so they
+can be run in the blocker pool. */
+
+/* Compresses `buf`, which is `block_size` bytes long, into `out`, which must have
+room for `block_size` bytes.  Returns the compressed size, or 0 if compressing the
+block wouldn't make it take up fewer device blocks on disk, in which case it
+should be written uncompressed. */
+uint32_t compress_block(const ser_buffer_t *buf, block_size_t block_size,
+                        ser_buffer_t *out);
+
+/* Decompresses `buf`, which is a `disk_block_size` bytes long compressed block,
+into `out`, which gets the original `block_size` bytes. */
+void decompress_block(const ser_buffer_t *buf, block_size_t disk_block_size,
+                      ser_buffer_t *out, block_size_t block_size);
+
+#endif  // SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
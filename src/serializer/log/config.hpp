@@ -17,6 +17,7 @@ struct log_serializer_dynamic_config_t {
         gc_high_ratio = DEFAULT_GC_HIGH_RATIO;
         read_ahead = true;
         io_batch_factor = DEFAULT_IO_BATCH_FACTOR;
+        compress_blocks = false;
     }
 
     /* When the proportion of garbage blocks hits gc_high_ratio, then the serializer will collect
@@ -31,7 +32,13 @@ struct log_serializer_dynamic_config_t {
     /* Enable reading more data than requested to let the cache warmup more quickly esp. on rotational drives */
     bool read_ahead;
 
-    RDB_MAKE_ME_SERIALIZABLE_4(gc_low_ratio, gc_high_ratio, io_batch_factor, read_ahead);
+    /* Compress blocks when writing them (see serializer/log/block_compression.hpp).
+    Tables' serializers take it from the table's `compress_blocks` setting.  Blocks
+    that were written compressed can be read whether or not this is set. */
+    bool compress_blocks;
+
+    RDB_MAKE_ME_SERIALIZABLE_5(gc_low_ratio, gc_high_ratio, io_batch_factor, read_ahead,
+                               compress_blocks);
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
@@ -4,13 +4,17 @@
 #include <inttypes.h>
 #include <sys/uio.h>
 
+#include <algorithm>
+
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
 #include "arch/arch.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
 #include "concurrency/mutex.hpp"
 #include "perfmon/perfmon.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -31,11 +35,12 @@ private:
 
 public:
     /* This constructor is for starting a new active extent. */
-    explicit gc_entry_t(data_block_manager_t *_parent)
+    gc_entry_t(data_block_manager_t *_parent, block_temperature_t _temperature)
         : parent(_parent),
           extent_ref(parent->extent_manager->gen_extent()),
           timestamp(current_microtime()),
           was_written(false),
+          temperature(_temperature),
           state(state_active),
           garbage_bytes_stat(_parent->static_config->extent_size()),
           num_live_blocks_stat(0),
@@ -44,12 +49,14 @@ public:
     }
 
     /* This constructor is for reconstructing extents that the LBA tells us contained
-       data blocks. */
+       data blocks.  We don't know what the blocks' temperature was, so they count
+       as warm. */
     gc_entry_t(data_block_manager_t *_parent, int64_t _offset)
         : parent(_parent),
           extent_ref(parent->extent_manager->reserve_extent(_offset)),
           timestamp(current_microtime()),
           was_written(false),
+          temperature(block_temperature_t::WARM),
           state(state_reconstructing),
           garbage_bytes_stat(_parent->static_config->extent_size()),
           num_live_blocks_stat(0),
@@ -162,6 +169,23 @@ public:
         return garbage_bytes_stat;
     }
 
+    // How worthwhile it is to GC the extent: the garbage we'd reclaim, weighted by
+    // how long the extent has been around (old extents are unlikely to become
+    // garbage on their own), divided by the cost of reading the extent's live
+    // blocks and writing them elsewhere.  The age is measured at
+    // parent->gc_score_reference_time, so that the score only changes when the
+    // extent's blocks do.
+    double cost_benefit() const {
+        const uint32_t extent_size = parent->static_config->extent_size();
+        const microtime_t reference_time = parent->gc_score_reference_time;
+        // Old extents are at least GC_YOUNG_EXTENT_TIMELIMIT_MICROS old, even if
+        // they got started after the reference time.
+        const double age = (reference_time > timestamp ? reference_time - timestamp : 0)
+            + GC_YOUNG_EXTENT_TIMELIMIT_MICROS;
+        const double live_bytes = extent_size - garbage_bytes();
+        return garbage_bytes() * age / (extent_size + live_bytes);
+    }
+
     bool block_is_garbage(unsigned int block_index) const {
         guarantee(state != state_reconstructing);
         guarantee(block_index < block_infos.size());
@@ -247,9 +271,10 @@ public:
         return b;
     }
 
-    void make_active() {
+    void make_active(block_temperature_t _temperature) {
         guarantee(state == state_reconstructing);
         state = state_active;
+        temperature = _temperature;
     }
 
     std::string format_block_infos(const char *separator) const {
@@ -336,11 +361,14 @@ public:
     // True iff the extent has been written to after starting up the serializer.
     bool was_written;
 
+    // The temperature class of the blocks we put on the extent.
+    block_temperature_t temperature;
+
     enum state_t {
         // It has been, or is being, reconstructed from data on disk.
         state_reconstructing,
         // We are currently putting things on this extent. It is equal to
-        // last_data_extent.
+        // parent->active_extents[temperature].
         state_active,
         // Not active, but not a GC candidate yet. It is in young_extent_queue.
         state_young,
@@ -382,7 +410,18 @@ private:
 data_block_manager_t::data_block_manager_t(const log_serializer_dynamic_config_t *_dynamic_config, extent_manager_t *em, log_serializer_t *_serializer, const log_serializer_on_disk_static_config_t *_static_config, log_serializer_stats_t *_stats)
     : stats(_stats), shutdown_callback(NULL), state(state_unstarted), dynamic_config(_dynamic_config),
       static_config(_static_config), extent_manager(em), serializer(_serializer),
-      gc_state(), gc_stats(stats)
+      gc_score_reference_time(current_microtime()), gc_relocation_credit(0),
+      gc_state(),
+      gc_stats(&stats->pm_serializer_old_total_block_bytes,
+               &stats->pm_serializer_old_garbage_block_bytes),
+      temperature_gc_stats{
+          gc_stats_t(&stats->pm_serializer_hot_old_total_block_bytes,
+                     &stats->pm_serializer_hot_old_garbage_block_bytes),
+          gc_stats_t(&stats->pm_serializer_warm_old_total_block_bytes,
+                     &stats->pm_serializer_warm_old_garbage_block_bytes),
+          gc_stats_t(&stats->pm_serializer_cold_old_total_block_bytes,
+                     &stats->pm_serializer_cold_old_garbage_block_bytes) },
+      gc_debt_bytes(&stats->pm_serializer_gc_debt_bytes)
 {
     rassert(dynamic_config != NULL);
     rassert(static_config != NULL);
@@ -434,7 +473,13 @@ void data_block_manager_t::start_existing(file_t *file,
     gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
     gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
 
-    /* Reconstruct the active data block extents from the metablock. */
+    for (int i = 0; i < NUM_BLOCK_TEMPERATURES; ++i) {
+        active_extents[i] = NULL;
+    }
+
+    /* Reconstruct the active data block extent from the metablock.  Only the hot
+       extent is recorded there; the other active extents we had before get
+       reconstructed as old extents below, like every other extent. */
     const int64_t offset = last_metablock->active_extent;
 
     if (offset != NULL_OFFSET) {
@@ -446,16 +491,15 @@ void data_block_manager_t::start_existing(file_t *file,
             reconstructed_extents.push_back(e);
         }
 
-        active_extent = entries.get(offset / extent_manager->extent_size);
+        gc_entry_t *active_extent = entries.get(offset / extent_manager->extent_size);
         guarantee(active_extent != NULL);
 
         /* Turn the extent from a reconstructing extent into an active extent */
         guarantee(active_extent->state == gc_entry_t::state_reconstructing);
         reconstructed_extents.remove(active_extent);
 
-        active_extent->make_active();
-    } else {
-        active_extent = NULL;
+        active_extent->make_active(block_temperature_t::HOT);
+        active_extents[static_cast<int>(block_temperature_t::HOT)] = active_extent;
     }
 
     /* Convert any extents that we found live blocks in, but that are not active
@@ -468,8 +512,7 @@ void data_block_manager_t::start_existing(file_t *file,
 
         entry->our_pq_entry = gc_pq.push(entry);
 
-        gc_stats.old_total_block_bytes += static_config->extent_size();
-        gc_stats.old_garbage_block_bytes += entry->garbage_bytes();
+        add_old_block_bytes(entry, static_config->extent_size(), entry->garbage_bytes());
     }
 
     state = state_ready;
@@ -614,6 +657,9 @@ public:
 
         bool handled_required_block = false;
 
+        // Compressed blocks are put aside, to be decompressed all at once.
+        std::vector<compressed_block_t> compressed_blocks;
+
         for (; lower_it < upper_it; ++lower_it) {
             const char *current_buf
                 = read_ahead_buf.get() + (*lower_it - relative_offset);
@@ -639,9 +685,21 @@ public:
                     continue;
                 }
 
+                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
+
+                if (info.uncompressed_ser_block_size != 0) {
+                    compressed_blocks.push_back(compressed_block_t{
+                        block_id,
+                        current_offset,
+                        reinterpret_cast<const ser_buffer_t *>(current_buf),
+                        info.uncompressed_ser_block_size,
+                        info.ser_block_size,
+                        parent->serializer->allocate_buffer()});
+                    continue;
+                }
+
                 scoped_malloc_t<ser_buffer_t> data = parent->serializer->allocate_buffer();
                 memcpy(data.get(), current_buf, info.ser_block_size);
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
 
                 counted_t<ls_block_token_pointee_t> ls_token
                     = parent->serializer->generate_block_token(current_offset,
@@ -658,6 +716,58 @@ public:
         }
 
         guarantee(handled_required_block);
+
+        if (!compressed_blocks.empty()) {
+            offer_compressed_blocks(parent, &compressed_blocks);
+        }
+    }
+
+private:
+    struct compressed_block_t {
+        block_id_t block_id;
+        int64_t offset;
+        // Points into the read-ahead buffer.
+        const ser_buffer_t *buf;
+        uint32_t uncompressed_ser_block_size;
+        uint32_t ser_block_size;
+        scoped_malloc_t<ser_buffer_t> data;
+    };
+
+    static void offer_compressed_blocks(data_block_manager_t *const parent,
+                                        std::vector<compressed_block_t> *blocks) {
+        thread_pool_t::run_in_blocker_pool([&]() {
+            for (auto it = blocks->begin(); it != blocks->end(); ++it) {
+                decompress_block(it->buf,
+                                 block_size_t::unsafe_make(it->ser_block_size),
+                                 it->data.get(),
+                                 block_size_t::unsafe_make(it->uncompressed_ser_block_size));
+            }
+        });
+
+        for (auto it = blocks->begin(); it != blocks->end(); ++it) {
+            // The block might have been rewritten while we were decompressing it.
+            const index_block_info_t info
+                = parent->serializer->lba_index->get_block_info(it->block_id);
+            if (!info.offset.has_value() || info.offset.get_value() != it->offset) {
+                continue;
+            }
+            rassert(info.ser_block_size == it->ser_block_size
+                    && info.uncompressed_ser_block_size == it->uncompressed_ser_block_size);
+
+            counted_t<ls_block_token_pointee_t> ls_token
+                = parent->serializer->generate_block_token(
+                        it->offset,
+                        block_size_t::unsafe_make(it->uncompressed_ser_block_size),
+                        block_size_t::unsafe_make(it->ser_block_size));
+
+            counted_t<standard_block_token_t> token
+                = to_standard_block_token(it->block_id, ls_token);
+
+            parent->serializer->offer_buf_to_read_ahead_callbacks(
+                    it->block_id,
+                    std::move(it->data),
+                    token);
+        }
     }
 };
 
@@ -700,6 +810,7 @@ void data_block_manager_t::read(int64_t off_in, uint32_t ser_block_size_in,
 
 std::vector<counted_t<ls_block_token_pointee_t> >
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
+                                  bool gc_relocations,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
     // Either we're ready to write, or we're shutting down and just finished reading
@@ -708,14 +819,29 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
               (state == state_shutting_down && gc_state.step() == gc_write));
 
     // These tokens are grouped by extent.  You can do a contiguous write in each
-    // extent.
+    // group.
+    std::vector<size_t> write_order;
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > token_groups
-        = gimme_some_new_offsets(writes);
+        = gimme_some_new_offsets(writes, gc_relocations, &write_order);
 
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         it->buf->ser_header.block_id = it->block_id;
     }
 
+    if (!gc_relocations) {
+        // User writes let the GC relocate more blocks.
+        int64_t write_bytes = 0;
+        for (auto it = writes.begin(); it != writes.end(); ++it) {
+            write_bytes += gc_entry_t::aligned_value(it->block_size);
+        }
+        const double pacing_rate = gc_pacing_rate();
+        gc_relocation_credit
+            = std::min<double>(gc_relocation_credit + write_bytes * pacing_rate,
+                               GC_PACING_MAX_CREDIT_EXTENTS * static_config->extent_size());
+        stats->pm_serializer_gc_pacing_rate.record(pacing_rate);
+        update_gc_debt();
+    }
+
     struct intermediate_cb_t : public iocallback_t {
         virtual void on_io_complete() {
             --ops_remaining;
@@ -741,7 +867,7 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         const int64_t front_offset = token_groups[i].front()->offset();
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(token_groups[i].back()->disk_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -753,15 +879,16 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         for (size_t j = 0; j < token_groups[i].size(); ++j) {
             const int64_t j_offset = token_groups[i][j]->offset();
-            const block_size_t j_block_size = token_groups[i][j]->block_size();
+            const block_size_t j_block_size = token_groups[i][j]->disk_block_size();
             guarantee(j_offset == last_written_offset);
             const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
 
-            // The behavior of gimme_some_new_offsets is supposed to retain order, so
-            // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            // The tokens are in the order of write_order, so
+            // writes[write_order[write_number]] is the currently-relevant write.
+            const buf_write_info_t &write = writes[write_order[write_number]];
+            guarantee(write.block_size == j_block_size);
 
-            iovecs[j].iov_base = writes[write_number].buf;
+            iovecs[j].iov_base = write.buf;
             iovecs[j].iov_len = j_aligned_size;
             last_written_offset = j_offset + j_aligned_size;
 
@@ -770,6 +897,11 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         guarantee(last_written_offset == back_offset);
 
+        if (gc_relocations) {
+            stats->pm_serializer_gc_block_bytes_written += write_size;
+        }
+        ++stats->pm_serializer_data_writes;
+
         dbfile->writev_async(front_offset, write_size,
                              std::move(iovecs), io_account, intermediate_cb);
     }
@@ -778,11 +910,13 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
     // earlier).
     intermediate_cb->on_io_complete();
 
-    std::vector<counted_t<ls_block_token_pointee_t> > ret;
-    ret.reserve(writes.size());
+    // Hand the tokens back in the order of `writes`.
+    std::vector<counted_t<ls_block_token_pointee_t> > ret(writes.size());
+    size_t token_number = 0;
     for (auto it = token_groups.begin(); it != token_groups.end(); ++it) {
         for (auto jt = it->begin(); jt != it->end(); ++jt) {
-            ret.push_back(std::move(*jt));
+            ret[write_order[token_number]] = std::move(*jt);
+            ++token_number;
         }
     }
 
@@ -817,8 +951,8 @@ void data_block_manager_t::check_and_handle_empty_extent(uint64_t extent_id) {
             /* Remove from the priority queue */
             case gc_entry_t::state_old:
                 gc_pq.remove(entry->our_pq_entry);
-                gc_stats.old_total_block_bytes -= static_config->extent_size();
-                gc_stats.old_garbage_block_bytes -= static_config->extent_size();
+                add_old_block_bytes(entry, -static_config->extent_size(),
+                                    -static_config->extent_size());
                 break;
 
             /* Notify the GC that the extent got released during GC */
@@ -869,7 +1003,8 @@ void data_block_manager_t::mark_garbage(int64_t offset, extent_transaction_t *tx
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        add_old_block_bytes(entry, 0,
+                            gc_entry_t::aligned_value(entry->block_size(block_index)));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -899,7 +1034,8 @@ void data_block_manager_t::mark_garbage_tokenwise_with_offset(int64_t offset) {
     // Add to old garbage count if necessary (works because of the
     // !entry->block_is_garbage(block_index) assertion above).
     if (entry->state == gc_entry_t::state_old && entry->block_is_garbage(block_index)) {
-        gc_stats.old_garbage_block_bytes += gc_entry_t::aligned_value(entry->block_size(block_index));
+        add_old_block_bytes(entry, 0,
+                            gc_entry_t::aligned_value(entry->block_size(block_index)));
     }
 
     check_and_handle_empty_extent(extent_id);
@@ -955,7 +1091,7 @@ void data_block_manager_t::gc_writer_t::write_gcs(gc_write_t *writes, size_t num
             }
 
             new_block_tokens
-                = parent->many_writes(the_writes, parent->choose_gc_io_account(),
+                = parent->many_writes(the_writes, true, parent->choose_gc_io_account(),
                                       &block_write_cond);
 
             guarantee(new_block_tokens.size() == num_writes);
@@ -983,11 +1119,26 @@ void data_block_manager_t::gc_writer_t::write_gcs(gc_write_t *writes, size_t num
                 if (parent->gc_state.current_entry->block_referenced_by_index(block_index)) {
                     block_id_t block_id = writes[i].buf->ser_header.block_id;
 
+                    // We copied the block as it is on disk, so if it's compressed,
+                    // the index needs its uncompressed size from the LBA, which
+                    // still describes the old copy.
+                    const index_block_info_t info
+                        = parent->serializer->lba_index->get_block_info(block_id);
+                    rassert(info.offset.has_value()
+                            && info.offset.get_value() == writes[i].old_offset);
+                    counted_t<ls_block_token_pointee_t> token = new_block_tokens[i];
+                    if (info.uncompressed_ser_block_size != 0) {
+                        token = parent->serializer->generate_block_token(
+                                token->offset(),
+                                block_size_t::unsafe_make(info.uncompressed_ser_block_size),
+                                token->disk_block_size());
+                    }
+
                     index_write_ops.push_back(
                             index_write_op_t(block_id,
                                              to_standard_block_token(
                                                      block_id,
-                                                     new_block_tokens[i])));
+                                                     token)));
                 }
 
                 // (If we don't have an i_array entry, the block is referenced
@@ -1048,22 +1199,35 @@ void data_block_manager_t::run_gc() {
         run_again = false;
         switch (gc_state.step()) {
             case gc_ready: {
+                update_gc_debt();
                 if (gc_pq.empty() || !should_we_keep_gcing()) {
                     return;
                 }
 
                 ASSERT_NO_CORO_WAITING;
 
+                maybe_refresh_gc_scores();
+                if (!gc_pacer_allows(gc_pq.peak())) {
+                    // We get started again once the user writes have given us
+                    // enough credit.
+                    return;
+                }
+
                 ++stats->pm_serializer_data_extents_gced;
 
                 /* grab the entry */
                 gc_state.current_entry = gc_pq.pop();
                 gc_state.current_entry->our_pq_entry = NULL;
+                gc_relocation_credit
+                    = std::max<double>(0, gc_relocation_credit
+                                       - (static_config->extent_size()
+                                          - gc_state.current_entry->garbage_bytes()));
 
                 guarantee(gc_state.current_entry->state == gc_entry_t::state_old);
                 gc_state.current_entry->state = gc_entry_t::state_in_gc;
-                gc_stats.old_garbage_block_bytes -= gc_state.current_entry->garbage_bytes();
-                gc_stats.old_total_block_bytes -= static_config->extent_size();
+                add_old_block_bytes(gc_state.current_entry,
+                                    -static_config->extent_size(),
+                                    -gc_state.current_entry->garbage_bytes());
 
                 /* read all the live data into buffers */
 
@@ -1234,6 +1398,7 @@ void data_block_manager_t::run_gc() {
 void data_block_manager_t::prepare_metablock(data_block_manager::metablock_mixin_t *metablock) {
     guarantee(state == state_ready || state == state_shutting_down);
 
+    gc_entry_t *active_extent = active_extents[static_cast<int>(block_temperature_t::HOT)];
     if (active_extent != NULL) {
         metablock->active_extent = active_extent->extent_ref.offset();
     } else {
@@ -1262,10 +1427,12 @@ void data_block_manager_t::actually_shutdown() {
 
     guarantee(reconstructed_extents.head() == NULL);
 
-    if (active_extent != NULL) {
-        UNUSED int64_t extent = active_extent->extent_ref.release();
-        delete active_extent;
-        active_extent = NULL;
+    for (int i = 0; i < NUM_BLOCK_TEMPERATURES; ++i) {
+        if (active_extents[i] != NULL) {
+            UNUSED int64_t extent = active_extents[i]->extent_ref.release();
+            delete active_extents[i];
+            active_extents[i] = NULL;
+        }
     }
 
     while (gc_entry_t *entry = young_extent_queue.head()) {
@@ -1285,58 +1452,122 @@ void data_block_manager_t::actually_shutdown() {
     }
 }
 
-std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+block_temperature_t data_block_manager_t::choose_temperature(block_id_t block_id,
+                                                             bool gc_relocation) const {
+    if (gc_relocation) {
+        return block_temperature_t::COLD;
+    }
+
+    // A block whose previous version was written by a user write that is still
+    // recent gets rewritten often.
+    const flagged_off64_t old_offset = serializer->lba_index->get_block_offset(block_id);
+    if (old_offset.has_value()) {
+        const gc_entry_t *old_entry
+            = entries.get(static_config->extent_index(old_offset.get_value()));
+        if (old_entry != NULL
+            && old_entry->temperature != block_temperature_t::COLD
+            && (old_entry->state == gc_entry_t::state_active
+                || old_entry->state == gc_entry_t::state_young)) {
+            return block_temperature_t::HOT;
+        }
+    }
+    return block_temperature_t::WARM;
+}
+
+void data_block_manager_t::start_new_active_extent(block_temperature_t temperature) {
     ASSERT_NO_CORO_WAITING;
+    gc_entry_t **active_extent = &active_extents[static_cast<int>(temperature)];
+
+    // Move the active extent's gc_entry_t to the young extent queue (if it's not
+    // already empty), and make a new gc_entry_t.
+    gc_entry_t *old_active_extent = *active_extent;
+    *active_extent = new gc_entry_t(this, temperature);
+    ++stats->pm_serializer_data_extents_allocated;
 
-    // Start a new extent if necessary.
-    if (active_extent == NULL) {
-        active_extent = new gc_entry_t(this);
-        ++stats->pm_serializer_data_extents_allocated;
+    if (old_active_extent != NULL) {
+        if (old_active_extent->num_live_blocks() == 0) {
+            destroy_entry(old_active_extent);
+        } else {
+            old_active_extent->state = gc_entry_t::state_young;
+            young_extent_queue.push_back(old_active_extent);
+            mark_unyoung_entries();
+        }
     }
+}
 
+std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
+data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes,
+                                             bool gc_relocations,
+                                             std::vector<size_t> *write_order_out) {
+    ASSERT_NO_CORO_WAITING;
 
-    guarantee(active_extent->state == gc_entry_t::state_active);
+    // The temperatures are chosen up front, because starting a new extent below
+    // can change what `choose_temperature` says about the remaining blocks.
+    std::vector<block_temperature_t> temperatures;
+    temperatures.reserve(writes.size());
+    for (auto it = writes.begin(); it != writes.end(); ++it) {
+        temperatures.push_back(choose_temperature(it->block_id, gc_relocations));
+    }
+
+    // Each temperature has its own active extent, and every switch between
+    // extents ends a group, which is a separate write.  So the writes of each
+    // temperature get their offsets together instead of in the order of `writes`.
+    write_order_out->resize(writes.size());
+    for (size_t i = 0; i < writes.size(); ++i) {
+        (*write_order_out)[i] = i;
+    }
+    std::stable_sort(write_order_out->begin(), write_order_out->end(),
+                     [&temperatures](size_t x, size_t y) {
+                         return static_cast<int>(temperatures[x])
+                             < static_cast<int>(temperatures[y]);
+                     });
 
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > > ret;
 
+    // The extent that the blocks in `tokens` are on.
+    gc_entry_t *tokens_extent = NULL;
     std::vector<counted_t<ls_block_token_pointee_t> > tokens;
-    for (auto it = writes.begin(); it != writes.end(); ++it) {
+    for (auto jt = write_order_out->begin(); jt != write_order_out->end(); ++jt) {
+        const buf_write_info_t &write = writes[*jt];
+        const block_temperature_t temperature = temperatures[*jt];
+        const int temperature_index = static_cast<int>(temperature);
+
+        // Start a new extent if necessary.
+        if (active_extents[temperature_index] == NULL) {
+            start_new_active_extent(temperature);
+        }
+        guarantee(active_extents[temperature_index]->state == gc_entry_t::state_active);
+
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(it->block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
-            // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
-                destroy_entry(old_active_extent);
-            } else {
-                active_extent->state = gc_entry_t::state_young;
-                young_extent_queue.push_back(active_extent);
-                mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
-            }
-
-            ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(it->block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+        if (!active_extents[temperature_index]->new_offset(write.block_size,
+                                                           &relative_offset,
+                                                           &block_index)) {
+            start_new_active_extent(temperature);
+            const bool succeeded
+                = active_extents[temperature_index]->new_offset(write.block_size,
+                                                                &relative_offset,
+                                                                &block_index);
             guarantee(succeeded);
+        }
+
+        gc_entry_t *const active_extent = active_extents[temperature_index];
 
-            // Push the current group of tokens, if it's nonempty, onto the return vector.
+        // Push the current group of tokens, if it's nonempty and on a different
+        // extent, onto the return vector.
+        if (active_extent != tokens_extent) {
             if (!tokens.empty()) {
                 ret.push_back(std::move(tokens));
                 tokens.clear();
             }
+            tokens_extent = active_extent;
         }
 
         const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
         active_extent->was_written = true;
         active_extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, it->block_size));
+        tokens.push_back(serializer->generate_block_token(offset, write.block_size));
     }
 
     if (!tokens.empty()) {
@@ -1374,29 +1605,88 @@ void data_block_manager_t::remove_last_unyoung_entry() {
 
     entry->our_pq_entry = gc_pq.push(entry);
 
-    gc_stats.old_total_block_bytes += static_config->extent_size();
-    gc_stats.old_garbage_block_bytes += entry->garbage_bytes();
+    add_old_block_bytes(entry, static_config->extent_size(), entry->garbage_bytes());
 }
 
 /* functions for gc structures */
 
 // Answers the following question: We're in the middle of gc'ing, and
-// look, it's the next largest entry.  Should we keep gc'ing?  Returns
-// false when the entry is active or young, or when its garbage ratio
-// is lower than GC_THRESHOLD_RATIO_*.
+// look, it's the next best entry.  Should we keep gc'ing?  Returns
+// false when the garbage ratio is lower than gc_low_ratio.
 bool data_block_manager_t::should_we_keep_gcing() const {
     return garbage_ratio() > dynamic_config->gc_low_ratio;
 }
 
 // Answers the following question: Do we want to bother gc'ing?
-// Returns true when our garbage_ratio is greater than
-// GC_THRESHOLD_RATIO_*.
+// Returns true when our garbage_ratio is greater than gc_low_ratio.  How
+// fast we go from there is up to the pacer.
 bool data_block_manager_t::do_we_want_to_start_gcing() const {
-    return garbage_ratio() > dynamic_config->gc_high_ratio;
+    return should_we_keep_gcing();
+}
+
+bool data_block_manager_t::gc_pacer_allows(const gc_entry_t *entry) const {
+    if (garbage_ratio() > dynamic_config->gc_high_ratio) {
+        // We're falling behind, so we GC as fast as we can.
+        return true;
+    }
+    const int64_t live_bytes = static_config->extent_size() - entry->garbage_bytes();
+    return gc_relocation_credit >= live_bytes;
+}
+
+double data_block_manager_t::gc_pacing_rate() const {
+    return compute_gc_pacing_rate(garbage_ratio(),
+                                  dynamic_config->gc_low_ratio,
+                                  dynamic_config->gc_high_ratio);
+}
+
+double compute_gc_pacing_rate(double ratio, double low_ratio, double high_ratio) {
+    if (ratio <= low_ratio) {
+        return 0.0;
+    }
+
+    // Copying the live blocks of extents with a garbage ratio of `ratio` reclaims
+    // `ratio` of the space we copy them from, so to keep up with the garbage that
+    // user writes create, we have to copy (1 - ratio) / ratio bytes for every
+    // byte that gets written.  The closer we get to gc_high_ratio, the more we
+    // try to make up for the garbage that's already there.
+    const double keep_up_rate = (1.0 - ratio) / ratio;
+    const double urgency = high_ratio > low_ratio
+        ? std::min(1.0, (ratio - low_ratio) / (high_ratio - low_ratio))
+        : 1.0;
+    return keep_up_rate * (1.0 + (GC_PACING_MAX_URGENCY - 1.0) * urgency);
+}
+
+void data_block_manager_t::update_gc_debt() {
+    const double total_bytes = gc_stats.old_total_block_bytes.get()
+        + extent_manager->held_extents() * static_config->extent_size();
+    const int64_t debt = std::max<int64_t>(
+        0,
+        gc_stats.old_garbage_block_bytes.get() - dynamic_config->gc_low_ratio * total_bytes);
+    gc_debt_bytes += debt - gc_debt_bytes.get();
+}
+
+void data_block_manager_t::maybe_refresh_gc_scores() {
+    ASSERT_NO_CORO_WAITING;
+    const microtime_t now = current_microtime();
+    if (now - gc_score_reference_time < GC_SCORE_REFRESH_INTERVAL_MICROS) {
+        return;
+    }
+
+    // The scores of all the extents change when the reference time does, so
+    // gc_pq has to be rebuilt.
+    std::vector<gc_entry_t *> old_entries;
+    old_entries.reserve(gc_pq.size());
+    while (!gc_pq.empty()) {
+        old_entries.push_back(gc_pq.pop());
+    }
+    gc_score_reference_time = now;
+    for (auto it = old_entries.begin(); it != old_entries.end(); ++it) {
+        (*it)->our_pq_entry = gc_pq.push(*it);
+    }
 }
 
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
-    return x->garbage_bytes() < y->garbage_bytes();
+    return x->cost_benefit() < y->cost_benefit();
 }
 
 /****************
@@ -1423,6 +1713,17 @@ void data_block_manager_t::gc_stat_t::operator-=(int64_t num) {
     *perfmon -= num;
 }
 
-data_block_manager_t::gc_stats_t::gc_stats_t(log_serializer_stats_t *_stats)
-    : old_total_block_bytes(&_stats->pm_serializer_old_total_block_bytes),
-      old_garbage_block_bytes(&_stats->pm_serializer_old_garbage_block_bytes) { }
+void data_block_manager_t::add_old_block_bytes(const gc_entry_t *entry,
+                                               int64_t total_bytes,
+                                               int64_t garbage_bytes) {
+    gc_stats_t *class_stats = &temperature_gc_stats[static_cast<int>(entry->temperature)];
+    gc_stats.old_total_block_bytes += total_bytes;
+    gc_stats.old_garbage_block_bytes += garbage_bytes;
+    class_stats->old_total_block_bytes += total_bytes;
+    class_stats->old_garbage_block_bytes += garbage_bytes;
+}
+
+data_block_manager_t::gc_stats_t::gc_stats_t(perfmon_counter_t *total_perfmon,
+                                             perfmon_counter_t *garbage_perfmon)
+    : old_total_block_bytes(total_perfmon),
+      old_garbage_block_bytes(garbage_perfmon) { }
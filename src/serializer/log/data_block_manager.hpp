@@ -13,6 +13,7 @@
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 class log_serializer_t;
 
@@ -20,6 +21,25 @@ class data_block_manager_t;
 
 class gc_entry_t;
 
+/* The data block manager keeps one active extent per temperature class, so that
+blocks that get rewritten soon don't share extents with blocks that stay put for a
+long time.  The extents that hold hot blocks then turn into garbage almost
+entirely on their own, and the cold blocks don't get copied by the GC over and
+over again. */
+enum class block_temperature_t {
+    // User writes of blocks whose previous version is on a young or active extent,
+    // i.e. blocks that got rewritten shortly after they were last written.
+    HOT,
+    // All other user writes, including writes of new blocks.
+    WARM,
+    // Blocks relocated by the GC, which survived a whole extent's lifetime.
+    COLD
+};
+
+const int NUM_BLOCK_TEMPERATURES = 3;
+
+// Orders extents by how worthwhile it is to GC them; see
+// `gc_entry_t::cost_benefit()`.
 struct gc_entry_less_t {
     bool operator() (const gc_entry_t *x, const gc_entry_t *y);
 };
@@ -97,13 +117,28 @@ public:
     // ratio of garbage to blocks in the system
     double garbage_ratio() const;
 
+    // How many bytes of live blocks the GC may relocate for every byte of user
+    // writes.  It's zero when the garbage ratio is below gc_low_ratio, and it
+    // grows as the garbage ratio approaches gc_high_ratio.  Above that, the GC
+    // isn't paced at all.
+    double gc_pacing_rate() const;
+
+    // `gc_relocations` says whether the writes come from the GC; see
+    // `block_temperature_t`.
     std::vector<counted_t<ls_block_token_pointee_t> >
     many_writes(const std::vector<buf_write_info_t> &writes,
+                bool gc_relocations,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
+    // Returns tokens for `writes` grouped by extent, so that each group can be
+    // written contiguously.  The writes of each temperature get their offsets
+    // together, so the tokens aren't in the order of `writes`:
+    // `(*write_order_out)[i]` is the index in `writes` of the i-th token.
     std::vector<std::vector<counted_t<ls_block_token_pointee_t> > >
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
+    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes,
+                           bool gc_relocations,
+                           std::vector<size_t> *write_order_out);
 
 
 private:
@@ -118,6 +153,17 @@ private:
     // Tells if we should keep gc'ing.
     bool should_we_keep_gcing() const;
 
+    // Tells if the pacer lets us GC the entry now, or if we have to wait for more
+    // user writes first.
+    bool gc_pacer_allows(const gc_entry_t *entry) const;
+
+    // Updates the GC debt stat.
+    void update_gc_debt();
+
+    // Moves gc_score_reference_time to now and reorders gc_pq accordingly, if
+    // the scores are older than GC_SCORE_REFRESH_INTERVAL_MICROS.
+    void maybe_refresh_gc_scores();
+
     // Pops things off young_extent_queue that are no longer young.
     void mark_unyoung_entries();
 
@@ -127,6 +173,17 @@ private:
 
     void destroy_entry(gc_entry_t *entry);
 
+    block_temperature_t choose_temperature(block_id_t block_id, bool gc_relocation) const;
+
+    // Replaces the active extent of the given temperature with a new one, moving
+    // the old one to the young extent queue.
+    void start_new_active_extent(block_temperature_t temperature);
+
+    // Adds to the old block byte stats, both the overall ones and the ones of the
+    // entry's temperature class.
+    void add_old_block_bytes(const gc_entry_t *entry,
+                             int64_t total_bytes, int64_t garbage_bytes);
+
     bool should_perform_read_ahead(int64_t offset);
 
     /* internal garbage collection structures */
@@ -172,8 +229,9 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
-    gc_entry_t *active_extent;
+    /* Contains the extents in the gc_entry_t::state_active state, indexed by
+       block_temperature_t.  Any of them can be NULL. */
+    gc_entry_t *active_extents[NUM_BLOCK_TEMPERATURES];
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
@@ -181,6 +239,15 @@ private:
     /* Contains every extent in the gc_entry_t::state_old state */
     priority_queue_t<gc_entry_t *, gc_entry_less_t> gc_pq;
 
+    /* The time that the ages in the cost-benefit scores of the extents in gc_pq
+       are measured at.  It only changes when gc_pq gets reordered, so that the
+       scores don't change while the extents are in the queue. */
+    microtime_t gc_score_reference_time;
+
+    /* How many bytes of live blocks the GC may relocate before it has to wait for
+       more user writes. */
+    double gc_relocation_credit;
+
 
     /* Buffer used during GC. */
     std::vector<gc_write_t> gc_writes;
@@ -203,7 +270,7 @@ private:
             : val(0), perfmon(_perfmon) { }
         void operator+=(int64_t num);
         void operator-=(int64_t num);
-        int get() const { return val; }
+        int64_t get() const { return val; }
     };
 
     struct gc_state_t {
@@ -245,11 +312,18 @@ private:
     struct gc_stats_t {
         gc_stat_t old_total_block_bytes;
         gc_stat_t old_garbage_block_bytes;
-        explicit gc_stats_t(log_serializer_stats_t *);
+        gc_stats_t(perfmon_counter_t *total_perfmon, perfmon_counter_t *garbage_perfmon);
     };
 
     gc_stats_t gc_stats;
 
+    // The same stats, restricted to the extents of each temperature class.
+    gc_stats_t temperature_gc_stats[NUM_BLOCK_TEMPERATURES];
+
+    // How many bytes of garbage the GC has to reclaim to get down to
+    // gc_low_ratio.
+    gc_stat_t gc_debt_bytes;
+
     DISABLE_COPYING(data_block_manager_t);
 };
 
@@ -264,4 +338,8 @@ void unaligned_read_ahead_interval(const int64_t block_offset,
                                    int64_t *const offset_out,
                                    int64_t *const end_offset_out);
 
+// Exposed for unit tests.  Computes data_block_manager_t::gc_pacing_rate() for the
+// given garbage ratio and GC thresholds.
+double compute_gc_pacing_rate(double garbage_ratio, double low_ratio, double high_ratio);
+
 #endif /* SERIALIZER_LOG_DATA_BLOCK_MANAGER_HPP_ */
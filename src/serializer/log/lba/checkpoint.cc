@@ -0,0 +1,227 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/lba/checkpoint.hpp"
+
+#include <algorithm>
+
+#include "arch/arch.hpp"
+#include "containers/scoped.hpp"
+#include "math.hpp"
+
+lba_checkpoint_t::lba_checkpoint_t(extent_manager_t *em, file_t *file,
+                                   int64_t entries_count,
+                                   int64_t replay_extent_offset,
+                                   int64_t replay_extent_entries_count)
+    : em_(em), file_(file),
+      replay_extent_offset_(replay_extent_offset),
+      replay_extent_entries_count_(replay_extent_entries_count),
+      entries_count_(entries_count),
+      header_written_(false), next_entry_(0), next_extent_(0),
+      next_entry_in_extent_(0) {
+    em_->assert_thread();
+    CT_ASSERT(LBA_CHECKPOINT_CHUNK_ENTRIES % 1024 == 0);
+    rassert(entries_count_ >= 0);
+
+    const int64_t extents_count = extents_needed(em_->extent_size, entries_count_);
+    for (int64_t i = 0; i < extents_count; ++i) {
+        extents_.push_back(em_->gen_extent());
+    }
+}
+
+lba_checkpoint_t::lba_checkpoint_t(extent_manager_t *em, file_t *file,
+                                   int32_t first_extent_index)
+    : em_(em), file_(file),
+      header_written_(true), next_entry_(0), next_extent_(0),
+      next_entry_in_extent_(0) {
+    em_->assert_thread();
+    guarantee(first_extent_index > 0);
+    const int64_t first_extent_offset = first_extent_index * em_->extent_size;
+
+    // Read the first block to find out how long the header is, then the rest of it.
+    scoped_malloc_t<lba_checkpoint_header_t> header(
+        malloc_aligned(DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE));
+    co_read(file_, first_extent_offset, DEVICE_BLOCK_SIZE, header.get(),
+            DEFAULT_DISK_ACCOUNT);
+    guarantee(memcmp(header->magic, lba_checkpoint_magic,
+                     LBA_CHECKPOINT_MAGIC_SIZE) == 0,
+              "Invalid LBA checkpoint magic.");
+    const int64_t extents_count = header->extents_count;
+    guarantee(extents_count > 0 && header_size(extents_count) <= em_->extent_size,
+              "Invalid LBA checkpoint extent count.");
+    if (header_size(extents_count) > DEVICE_BLOCK_SIZE) {
+        header = scoped_malloc_t<lba_checkpoint_header_t>(
+            malloc_aligned(header_size(extents_count), DEVICE_BLOCK_SIZE));
+        co_read(file_, first_extent_offset, header_size(extents_count), header.get(),
+                DEFAULT_DISK_ACCOUNT);
+    }
+
+    replay_extent_offset_ = header->replay_extent_offset;
+    replay_extent_entries_count_ = header->replay_extent_entries_count;
+    entries_count_ = header->entries_count;
+    guarantee(extents_needed(em_->extent_size, entries_count_) == extents_count);
+    guarantee(header->extent_offsets[0] == first_extent_offset);
+    for (int64_t i = 0; i < extents_count; ++i) {
+        extents_.push_back(em_->reserve_extent(header->extent_offsets[i]));
+    }
+}
+
+lba_checkpoint_t::~lba_checkpoint_t() {
+    guarantee(extents_.empty());
+}
+
+bool lba_checkpoint_t::write_some(int lba_shard, in_memory_index_t *index,
+                                  file_account_t *io_account) {
+    em_->assert_thread();
+
+    if (!header_written_) {
+        const size_t size = header_size(extents_.size());
+        scoped_malloc_t<lba_checkpoint_header_t> header(
+            malloc_aligned(size, DEVICE_BLOCK_SIZE));
+        bzero(header.get(), size);
+        memcpy(header->magic, lba_checkpoint_magic, LBA_CHECKPOINT_MAGIC_SIZE);
+        header->replay_extent_offset = replay_extent_offset_;
+        header->replay_extent_entries_count = replay_extent_entries_count_;
+        header->entries_count = entries_count_;
+        header->extents_count = extents_.size();
+        for (size_t i = 0; i < extents_.size(); ++i) {
+            header->extent_offsets[i] = extents_[i].offset();
+        }
+        co_write(file_, extents_[0].offset(), size, header.get(), io_account,
+                 file_t::NO_DATASYNCS);
+        header_written_ = true;
+        return next_entry_ == entries_count_;
+    }
+
+    rassert(next_entry_ < entries_count_);
+    const int64_t in_extent = entries_in_extent(em_->extent_size, extents_.size(),
+                                                next_extent_);
+    const int64_t count = std::min<int64_t>(
+        LBA_CHECKPOINT_CHUNK_ENTRIES,
+        std::min(in_extent - next_entry_in_extent_, entries_count_ - next_entry_));
+    const size_t size = ceil_aligned(count * sizeof(lba_checkpoint_entry_t),
+                                     DEVICE_BLOCK_SIZE);
+    scoped_malloc_t<lba_checkpoint_entry_t> entries(
+        malloc_aligned(size, DEVICE_BLOCK_SIZE));
+    bzero(entries.get(), size);
+    for (int64_t i = 0; i < count; ++i) {
+        const index_block_info_t info = index->get_block_info(
+            lba_shard + (next_entry_ + i) * LBA_SHARD_FACTOR);
+        entries.get()[i].offset = info.offset;
+        entries.get()[i].recency = info.recency;
+        entries.get()[i].ser_block_size = info.ser_block_size;
+        entries.get()[i].uncompressed_ser_block_size = info.uncompressed_ser_block_size;
+    }
+
+    const int64_t pos = extent_entries_offset(next_extent_)
+        + next_entry_in_extent_ * sizeof(lba_checkpoint_entry_t);
+    rassert(divides(DEVICE_BLOCK_SIZE, pos));
+    co_write(file_, extents_[next_extent_].offset() + pos, size, entries.get(),
+             io_account, file_t::NO_DATASYNCS);
+
+    next_entry_ += count;
+    next_entry_in_extent_ += count;
+    if (next_entry_in_extent_ == in_extent) {
+        ++next_extent_;
+        next_entry_in_extent_ = 0;
+    }
+    return next_entry_ == entries_count_;
+}
+
+void lba_checkpoint_t::read(int lba_shard, in_memory_index_t *index,
+                            file_account_t *io_account) {
+    em_->assert_thread();
+
+    const size_t buffer_size = LBA_CHECKPOINT_CHUNK_ENTRIES * sizeof(lba_checkpoint_entry_t);
+    scoped_malloc_t<lba_checkpoint_entry_t> entries(
+        malloc_aligned(buffer_size, DEVICE_BLOCK_SIZE));
+
+    const index_block_info_t unused_info;
+    int64_t entry = 0;
+    for (size_t i = 0; i < extents_.size(); ++i) {
+        const int64_t in_extent = std::min(
+            entries_in_extent(em_->extent_size, extents_.size(), i),
+            entries_count_ - entry);
+        for (int64_t j = 0; j < in_extent; j += LBA_CHECKPOINT_CHUNK_ENTRIES) {
+            const int64_t count = std::min<int64_t>(LBA_CHECKPOINT_CHUNK_ENTRIES,
+                                                    in_extent - j);
+            co_read(file_,
+                    extents_[i].offset() + extent_entries_offset(i)
+                        + j * sizeof(lba_checkpoint_entry_t),
+                    ceil_aligned(count * sizeof(lba_checkpoint_entry_t), DEVICE_BLOCK_SIZE),
+                    entries.get(), io_account);
+
+            for (int64_t k = 0; k < count; ++k) {
+                const lba_checkpoint_entry_t &e = entries.get()[k];
+                // Blocks that were never written don't get set, so that
+                // `end_block_id()` comes out the same as with a full replay.
+                if (index_block_info_t(e.offset, e.recency, e.ser_block_size,
+                                       e.uncompressed_ser_block_size)
+                    == unused_info) {
+                    continue;
+                }
+                index->set_block_info(lba_shard + (entry + j + k) * LBA_SHARD_FACTOR,
+                                      e.recency, e.offset, e.ser_block_size,
+                                      e.uncompressed_ser_block_size);
+            }
+        }
+        entry += in_extent;
+    }
+    guarantee(entry == entries_count_);
+}
+
+int32_t lba_checkpoint_t::first_extent_index() const {
+    return extents_[0].offset() / em_->extent_size;
+}
+
+void lba_checkpoint_t::destroy(extent_transaction_t *txn) {
+    for (auto it = extents_.begin(); it != extents_.end(); ++it) {
+        em_->release_extent_into_transaction(std::move(*it), txn);
+    }
+    extents_.clear();
+}
+
+void lba_checkpoint_t::abort() {
+    for (auto it = extents_.begin(); it != extents_.end(); ++it) {
+        em_->release_extent(std::move(*it));
+    }
+    extents_.clear();
+}
+
+void lba_checkpoint_t::shutdown() {
+    for (auto it = extents_.begin(); it != extents_.end(); ++it) {
+        UNUSED int64_t extent = it->release();
+    }
+    extents_.clear();
+}
+
+int64_t lba_checkpoint_t::extents_needed(uint64_t extent_size, int64_t entries_count) {
+    const int64_t per_extent = extent_size / sizeof(lba_checkpoint_entry_t);
+    int64_t extents_count = std::max<int64_t>(1, ceil_divide(entries_count, per_extent));
+    for (;;) {
+        guarantee(header_size(extents_count) < extent_size,
+                  "The LBA checkpoint header doesn't fit into an extent.");
+        const int64_t capacity = entries_in_extent(extent_size, extents_count, 0)
+            + (extents_count - 1) * per_extent;
+        if (capacity >= entries_count) {
+            return extents_count;
+        }
+        ++extents_count;
+    }
+}
+
+int64_t lba_checkpoint_t::entries_in_extent(uint64_t extent_size, int64_t extents_count,
+                                            int64_t i) {
+    if (i == 0) {
+        return (extent_size - header_size(extents_count)) / sizeof(lba_checkpoint_entry_t);
+    } else {
+        return extent_size / sizeof(lba_checkpoint_entry_t);
+    }
+}
+
+size_t lba_checkpoint_t::header_size(int64_t extents_count) {
+    return ceil_aligned(sizeof(lba_checkpoint_header_t) + sizeof(int64_t) * extents_count,
+                        DEVICE_BLOCK_SIZE);
+}
+
+int64_t lba_checkpoint_t::extent_entries_offset(int64_t i) const {
+    return i == 0 ? header_size(extents_.size()) : 0;
+}
@@ -0,0 +1,81 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_LBA_CHECKPOINT_HPP_
+#define SERIALIZER_LOG_LBA_CHECKPOINT_HPP_
+
+#include <vector>
+
+#include "arch/types.hpp"
+#include "serializer/log/extent_manager.hpp"
+#include "serializer/log/lba/disk_format.hpp"
+#include "serializer/log/lba/in_memory_index.hpp"
+
+/* `lba_checkpoint_t` is one shard's LBA checkpoint (see `lba_checkpoint_header_t`
+for the format).  A new checkpoint is written out with `write_some()` while the
+serializer keeps running, so it's fuzzy: the info for each block is picked up at
+some point after the replay position was taken, which is fine because every change
+after that point gets replayed on top of it at startup.  The LBA extent at the replay
+position has to still exist then; if it doesn't, the file is treated as corrupted,
+since there's no complete LBA left to fall back to. */
+
+class lba_checkpoint_t {
+public:
+    // Sets up a new checkpoint of `entries_count` entries and allocates its extents.
+    // Nothing gets written until `write_some()` is called.
+    lba_checkpoint_t(extent_manager_t *em, file_t *file, int64_t entries_count,
+                     int64_t replay_extent_offset, int64_t replay_extent_entries_count);
+
+    // Reads the header of an existing checkpoint and reserves its extents.  Must be
+    // called in a coroutine, while the extent manager is still reserving extents.
+    lba_checkpoint_t(extent_manager_t *em, file_t *file, int32_t first_extent_index);
+
+    ~lba_checkpoint_t();
+
+    // Writes the next part of the checkpoint of the given shard.  Returns true once
+    // the whole checkpoint has been written.  Must be called in a coroutine.
+    bool write_some(int lba_shard, in_memory_index_t *index,
+                    file_account_t *io_account);
+
+    // Reads the whole checkpoint of the given shard into `index`.  Must be called in
+    // a coroutine.
+    void read(int lba_shard, in_memory_index_t *index, file_account_t *io_account);
+
+    int32_t first_extent_index() const;
+    int64_t replay_extent_offset() const { return replay_extent_offset_; }
+    int64_t replay_extent_entries_count() const { return replay_extent_entries_count_; }
+
+    // Releases the extents into `txn`.
+    void destroy(extent_transaction_t *txn);
+    // Releases the extents right away.  Only for checkpoints that no metablock
+    // refers to yet.
+    void abort();
+    // Only forgets about the extents.
+    void shutdown();
+
+    // How many extents a checkpoint of `entries_count` entries takes up.
+    static int64_t extents_needed(uint64_t extent_size, int64_t entries_count);
+    // How many entries fit into the `i`th extent of a checkpoint that has
+    // `extents_count` extents.
+    static int64_t entries_in_extent(uint64_t extent_size, int64_t extents_count, int64_t i);
+
+private:
+    static size_t header_size(int64_t extents_count);
+    int64_t extent_entries_offset(int64_t i) const;
+
+    extent_manager_t *const em_;
+    file_t *const file_;
+
+    int64_t replay_extent_offset_;
+    int64_t replay_extent_entries_count_;
+    int64_t entries_count_;
+    std::vector<extent_reference_t> extents_;
+
+    // How far `write_some()` has gotten.
+    bool header_written_;
+    int64_t next_entry_;
+    size_t next_extent_;
+    int64_t next_entry_in_extent_;
+
+    DISABLE_COPYING(lba_checkpoint_t);
+};
+
+#endif  // SERIALIZER_LOG_LBA_CHECKPOINT_HPP_
@@ -52,16 +52,17 @@ void lba_disk_extent_t::read_step_1(read_info_t *info_out, extent_t::read_callba
     data->read(0, sizeof(lba_extent_t) + sizeof(lba_entry_t) * count, info_out->buffer, cb);
 }
 
-void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index) {
+void lba_disk_extent_t::read_step_2(read_info_t *info, in_memory_index_t *index,
+                                    int first_entry) {
     em->assert_thread();
     lba_extent_t *extent = reinterpret_cast<lba_extent_t *>(info->buffer);
     guarantee(memcmp(extent->header.magic, lba_magic, LBA_MAGIC_SIZE) == 0);
 
-    for (int i = 0; i < info->count; i++) {
+    for (int i = first_entry; i < info->count; i++) {
         lba_entry_t *e = &extent->entries[i];
         if (!lba_entry_t::is_padding(e)) {
             index->set_block_info(e->block_id, e->recency, e->offset,
-                                  e->ser_block_size);
+                                  e->ser_block_size, e->uncompressed_ser_block_size);
         }
     }
 
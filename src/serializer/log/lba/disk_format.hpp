@@ -62,26 +62,26 @@ static const block_id_t PADDING_BLOCK_ID = NULL_BLOCK_ID;
 struct lba_entry_t {
     block_id_t block_id;
 
+    // The size of the block as it's stored on disk.
     uint32_t ser_block_size;
 
-    // TODO: Remove the need for these fields (or this zero field).  Remove the
-    // requirement that lba_entry_t be a divisor of DEVICE_BLOCK_SIZE.  When doing
-    // so, be sure to make lba entries backwards compatiblizable for now.  (We could
-    // in the future use this value being non-zero to mean the lba entry is a
-    // new-style entry.)
-    uint32_t zero2;
+    // If the block is stored compressed, its size once it's decompressed, and
+    // zero otherwise.  (This used to be a zero field, so old LBA entries read as
+    // uncompressed blocks.)
+    uint32_t uncompressed_ser_block_size;
 
     repli_timestamp_t recency;
     // An offset into the file, with is_delete set appropriately.
     flagged_off64_t offset;
 
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint32_t ser_block_size) {
+                            flagged_off64_t offset, uint32_t ser_block_size,
+                            uint32_t uncompressed_ser_block_size) {
         guarantee(ser_block_size != 0 || !offset.has_value());
         lba_entry_t entry;
         entry.block_id = block_id;
         entry.ser_block_size = ser_block_size;
-        entry.zero2 = 0;
+        entry.uncompressed_ser_block_size = uncompressed_ser_block_size;
         entry.recency = recency;
         entry.offset = offset;
         return entry;
@@ -92,7 +92,7 @@ struct lba_entry_t {
     }
 
     static lba_entry_t make_padding_entry() {
-        return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid, flagged_off64_t::padding(), 0);
+        return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid, flagged_off64_t::padding(), 0, 0);
     }
 } __attribute__((__packed__));
 
@@ -104,7 +104,12 @@ struct lba_shard_metablock_t {
      * reference to the clean extent. */
     int64_t last_lba_extent_offset;
     int32_t last_lba_extent_entries_count;
-    int32_t padding1;
+
+    /* The index (offset divided by the extent size) of the first extent of
+     * the shard's checkpoint, or 0 if there is none.  Extent 0 holds the
+     * static header, so it can never be a checkpoint extent, and databases
+     * from before there were checkpoints have a zero here. */
+    int32_t checkpoint_extent_index;
 
     /* Reference to the LBA superblock and its size */
     int64_t lba_superblock_offset;
@@ -183,6 +188,40 @@ struct lba_superblock_t {
 };
 
 
+/* An LBA checkpoint is a copy of one shard's part of the in-memory index,
+ * written out now and then so that startup can read it sequentially instead
+ * of replaying the shard's whole LBA.  It is spread over one or more extents.
+ * The first extent starts with an `lba_checkpoint_header_t`, padded to
+ * DEVICE_BLOCK_SIZE.  The entries come after it and continue at the start of
+ * every following extent; an entry never straddles two extents.  Entry `i` is
+ * for block `shard + i * LBA_SHARD_FACTOR`. */
+
+struct lba_checkpoint_entry_t {
+    flagged_off64_t offset;
+    repli_timestamp_t recency;
+    uint32_t ser_block_size;
+    // As in `lba_entry_t`.
+    uint32_t uncompressed_ser_block_size;
+} __attribute__((__packed__));
+
+#define LBA_CHECKPOINT_MAGIC_SIZE 8
+static const char lba_checkpoint_magic[LBA_CHECKPOINT_MAGIC_SIZE] = {'l', 'b', 'a', 'c', 'k', 'p', 'n', 't'};
+
+struct lba_checkpoint_header_t {
+    char magic[LBA_CHECKPOINT_MAGIC_SIZE];
+
+    /* The checkpoint reflects all of the LBA entries that came before this
+     * position, but not necessarily any of the ones after it, so those get
+     * replayed on top of it.  The position is given as an LBA extent and the
+     * number of entries that were in it.  If `replay_extent_offset` is
+     * NULL_OFFSET, the whole LBA gets replayed. */
+    int64_t replay_extent_offset;
+    int64_t replay_extent_entries_count;
+
+    int64_t entries_count;
+    int64_t extents_count;
+    int64_t extent_offsets[0];
+};
 
 #endif  // SERIALIZER_LOG_LBA_DISK_FORMAT_HPP_
 
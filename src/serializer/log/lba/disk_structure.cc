@@ -66,6 +66,7 @@ void lba_disk_structure_t::on_extent_read() {
 
 void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t recency,
                                      flagged_off64_t offset, uint32_t ser_block_size,
+                                     uint32_t uncompressed_ser_block_size,
                                      file_account_t *io_account, extent_transaction_t *txn) {
     if (last_extent && last_extent->full()) {
         /* We have filled up an extent. Transfer it to the superblock. */
@@ -84,7 +85,9 @@ void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t rece
 
     rassert(!last_extent->full());
 
-    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size), io_account);
+    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size,
+                                             uncompressed_ser_block_size),
+                           io_account);
 }
 
 std::set<lba_disk_extent_t *> lba_disk_structure_t::get_inactive_extents() const {
@@ -204,6 +207,7 @@ struct reader_t
         reader_t *parent;   // Our reader_t that we were created by
         int index;   // parent->readers[index] = this
         lba_disk_extent_t *extent;   // The extent we are supposed to read
+        int first_entry;   // The entries before this one have already been replayed
         lba_disk_extent_t::read_info_t read_info;   // Opaque data used by extent_t::read()
         bool have_read;   // true if our extent has been loaded from disk
 
@@ -213,8 +217,8 @@ struct reader_t
         and the LBA would be corrupted. */
         bool prev_done;
 
-        extent_reader_t(reader_t *p, lba_disk_extent_t *e)
-            : parent(p), extent(e), have_read(false)
+        extent_reader_t(reader_t *p, lba_disk_extent_t *e, int _first_entry)
+            : parent(p), extent(e), first_entry(_first_entry), have_read(false)
         {
             index = parent->readers.size();
             parent->readers.push_back(this);
@@ -241,7 +245,7 @@ struct reader_t
             if (have_read) done();
         }
         void done() {
-            extent->read_step_2(&read_info, parent->index);
+            extent->read_step_2(&read_info, parent->index, first_entry);
             parent->active_readers--;
             parent->start_more_readers();
             if (index == static_cast<int>(parent->readers.size()) - 1) {
@@ -260,14 +264,21 @@ struct reader_t
     // reading process so that we stay under LBA_READ_BUFFER_SIZE.
     int active_readers;
 
-    reader_t(lba_disk_structure_t *_ds, in_memory_index_t *_index, lba_disk_structure_t::read_callback_t *cb)
+    reader_t(lba_disk_structure_t *_ds, in_memory_index_t *_index,
+             int64_t extent_offset, int64_t entries_count,
+             lba_disk_structure_t::read_callback_t *cb)
         : ds(_ds), index(_index), rcb(cb)
     {
+        // Skip everything up to the given position, if there is one.
+        bool found = extent_offset == NULL_OFFSET;
         for (lba_disk_extent_t *e = ds->extents_in_superblock.head();
              e != NULL; e = ds->extents_in_superblock.next(e)) {
-            new extent_reader_t(this, e);
+            add_reader(e, extent_offset, entries_count, &found);
         }
-        if (ds->last_extent) new extent_reader_t(this, ds->last_extent);
+        if (ds->last_extent) {
+            add_reader(ds->last_extent, extent_offset, entries_count, &found);
+        }
+        guarantee(found, "The LBA position to read from isn't in the LBA.");
 
         /* The constructor for extent_reader_t pushed them onto our 'readers' vector. So now we
         have a vector with an extent_reader_t object for each extent we need to read, but none
@@ -282,6 +293,19 @@ struct reader_t
         }
     }
 
+    void add_reader(lba_disk_extent_t *e, int64_t extent_offset, int64_t entries_count,
+                    bool *found) {
+        if (!*found && e->data->extent_ref.offset() == extent_offset) {
+            *found = true;
+            rassert(entries_count <= e->count);
+            if (entries_count < e->count) {
+                new extent_reader_t(this, e, entries_count);
+            }
+        } else if (*found) {
+            new extent_reader_t(this, e, 0);
+        }
+    }
+
     void start_more_readers() {
         int limit = std::max<int>(LBA_READ_BUFFER_SIZE / ds->em->extent_size / LBA_SHARD_FACTOR, 1);
         while (next_reader != static_cast<int>(readers.size()) && active_readers < limit) {
@@ -296,7 +320,62 @@ struct reader_t
 };
 
 void lba_disk_structure_t::read(in_memory_index_t *index, read_callback_t *cb) {
-    new reader_t(this, index, cb);
+    read(index, NULL_OFFSET, 0, cb);
+}
+
+void lba_disk_structure_t::read(in_memory_index_t *index, int64_t extent_offset,
+                                int64_t entries_count, read_callback_t *cb) {
+    new reader_t(this, index, extent_offset, entries_count, cb);
+}
+
+void lba_disk_structure_t::get_end_position(int64_t *extent_offset_out,
+                                            int64_t *entries_count_out) const {
+    if (last_extent) {
+        *extent_offset_out = last_extent->data->extent_ref.offset();
+        *entries_count_out = last_extent->count;
+    } else {
+        rassert(extents_in_superblock.empty());
+        *extent_offset_out = NULL_OFFSET;
+        *entries_count_out = 0;
+    }
+}
+
+bool lba_disk_structure_t::count_entries_since(int64_t extent_offset,
+                                               int64_t entries_count,
+                                               int64_t *count_out) const {
+    bool found = extent_offset == NULL_OFFSET;
+    int64_t count = 0;
+    for (lba_disk_extent_t *e = extents_in_superblock.head();
+         e != NULL; e = extents_in_superblock.next(e)) {
+        if (found) {
+            count += e->count;
+        } else if (e->data->extent_ref.offset() == extent_offset) {
+            found = true;
+            count += e->count - entries_count;
+        }
+    }
+    if (last_extent) {
+        if (found) {
+            count += last_extent->count;
+        } else if (last_extent->data->extent_ref.offset() == extent_offset) {
+            found = true;
+            count += last_extent->count - entries_count;
+        }
+    }
+    *count_out = count;
+    return found;
+}
+
+std::set<lba_disk_extent_t *>
+lba_disk_structure_t::get_extents_before(int64_t extent_offset) const {
+    guarantee(extent_offset != NULL_OFFSET);
+    std::set<lba_disk_extent_t *> result;
+    for (lba_disk_extent_t *e = extents_in_superblock.head();
+         e != NULL && e->data->extent_ref.offset() != extent_offset;
+         e = extents_in_superblock.next(e)) {
+        result.insert(e);
+    }
+    return result;
 }
 
 void lba_disk_structure_t::prepare_metablock(lba_shard_metablock_t *mb_out) {
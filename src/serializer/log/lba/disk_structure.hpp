@@ -33,6 +33,7 @@ public:
     // Put entries in an LBA and then call sync() to write to disk
     void add_entry(block_id_t block_id, repli_timestamp_t recency,
                    flagged_off64_t offset, uint32_t ser_block_size,
+                   uint32_t uncompressed_ser_block_size,
                    file_account_t *io_account,
                    extent_transaction_t *txn);
     struct sync_callback_t {
@@ -60,6 +61,22 @@ public:
         virtual ~read_callback_t() {}
     };
     void read(in_memory_index_t *index, read_callback_t *cb);
+    // Like read(), but only reads the entries after the given position (see
+    // `get_end_position()`).
+    void read(in_memory_index_t *index, int64_t extent_offset, int64_t entries_count,
+              read_callback_t *cb);
+
+    // A position in the LBA is given as an extent and a number of entries in it.
+    // Returns the position just after the last entry, or NULL_OFFSET if there are
+    // no entries.
+    void get_end_position(int64_t *extent_offset_out, int64_t *entries_count_out) const;
+    // Counts the entries after the given position.  Returns false if the position's
+    // extent isn't part of the LBA anymore.
+    bool count_entries_since(int64_t extent_offset, int64_t entries_count,
+                             int64_t *count_out) const;
+    // Returns the extents that come before the extent at the given position, which
+    // must be part of the LBA.
+    std::set<lba_disk_extent_t *> get_extents_before(int64_t extent_offset) const;
 
     void prepare_metablock(lba_shard_metablock_t *mb_out);
 
@@ -11,25 +11,39 @@ struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          uncompressed_ser_block_size(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint32_t _ser_block_size)
+                       uint32_t _ser_block_size,
+                       uint32_t _uncompressed_ser_block_size)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          uncompressed_ser_block_size(_uncompressed_ser_block_size) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            uncompressed_ser_block_size == other.uncompressed_ser_block_size;
+    }
+
+    // The size of the block once it's been read in, which is different from
+    // `ser_block_size` if the block is stored compressed.
+    uint32_t logical_ser_block_size() const {
+        return uncompressed_ser_block_size != 0
+            ? uncompressed_ser_block_size : ser_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
+    // The size of the block on disk.
     uint32_t ser_block_size;
+    // Zero unless the block is stored compressed (see `lba_entry_t`).
+    uint32_t uncompressed_ser_block_size;
 } __attribute__((__packed__));
 
 
@@ -46,7 +60,8 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint32_t ser_block_size);
+                        flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t uncompressed_ser_block_size);
 
 };
 
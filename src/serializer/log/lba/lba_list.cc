@@ -4,6 +4,7 @@
 #include "errors.hpp"
 #include <boost/ptr_container/ptr_list.hpp>
 
+#include "math.hpp"
 #include "utils.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 #include "arch/arch.hpp"
@@ -20,7 +21,9 @@ lba_list_t::lba_list_t(extent_manager_t *em,
 {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         gc_active[i] = false;
+        checkpoint_active[i] = false;
         disk_structures[i] = NULL;
+        entries_since_checkpoint[i] = 0;
     }
 }
 
@@ -31,6 +34,7 @@ void lba_list_t::prepare_initial_metablock(metablock_mixin_t *mb_out) {
         mb_out->shards[i].lba_superblock_entries_count = 0;
         mb_out->shards[i].last_lba_extent_offset = NULL_OFFSET;
         mb_out->shards[i].last_lba_extent_entries_count = 0;
+        mb_out->shards[i].checkpoint_extent_index = 0;
     }
     mb_out->inline_lba_entries_count = 0;
     memset(mb_out->inline_lba_entries,
@@ -41,6 +45,8 @@ void lba_list_t::prepare_initial_metablock(metablock_mixin_t *mb_out) {
 void lba_list_t::prepare_metablock(metablock_mixin_t *mb_out) {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         disk_structures[i]->prepare_metablock(&mb_out->shards[i]);
+        mb_out->shards[i].checkpoint_extent_index = checkpoints[i].has()
+            ? checkpoints[i]->first_extent_index() : 0;
     }
     rassert(inline_lba_entries_count <= LBA_NUM_INLINE_ENTRIES);
     mb_out->inline_lba_entries_count = inline_lba_entries_count;
@@ -61,6 +67,7 @@ public:
     int cbs_out;
     lba_list_t *owner;
     lba_list_t::ready_callback_t *callback;
+    int32_t checkpoint_extent_indices[LBA_SHARD_FACTOR];
 
     lba_start_fsm_t(lba_list_t *l, lba_list_t::metablock_mixin_t *last_metablock)
         : owner(l), callback(NULL)
@@ -77,6 +84,7 @@ public:
         
         cbs_out = LBA_SHARD_FACTOR;
         for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+            checkpoint_extent_indices[i] = last_metablock->shards[i].checkpoint_extent_index;
             owner->disk_structures[i] = new lba_disk_structure_t(
                 owner->extent_manager, owner->dbfile,
                 &last_metablock->shards[i]);
@@ -88,10 +96,52 @@ public:
         rassert(cbs_out > 0);
         cbs_out--;
         if (cbs_out == 0) {
-            cbs_out = LBA_SHARD_FACTOR;
-            for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
-                owner->disk_structures[i]->read(&owner->in_memory_index, this);
+            // Reading the checkpoints takes a coroutine.
+            coro_t::spawn_sometime(std::bind(&lba_start_fsm_t::read_shards, this));
+        }
+    }
+
+    void read_shards() {
+        int64_t replay_extent_offsets[LBA_SHARD_FACTOR];
+        int64_t replay_entries_counts[LBA_SHARD_FACTOR];
+        for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+            replay_extent_offsets[i] = NULL_OFFSET;
+            replay_entries_counts[i] = 0;
+            if (checkpoint_extent_indices[i] != 0) {
+                owner->checkpoints[i].init(new lba_checkpoint_t(
+                    owner->extent_manager, owner->dbfile, checkpoint_extent_indices[i]));
+                const lba_checkpoint_t *checkpoint = owner->checkpoints[i].get();
+                // The LBA extents before the checkpoint's replay position are
+                // destroyed along with the metablock write that makes the
+                // checkpoint count, and the GC gets rid of the checkpoint in the
+                // same transaction in which it destroys the extent at the replay
+                // position.  So that extent has to still be there.  Without it, neither the checkpoint nor the
+                // truncated LBA has every block's info.
+                int64_t unused;
+                guarantee(owner->disk_structures[i]->count_entries_since(
+                              checkpoint->replay_extent_offset(),
+                              checkpoint->replay_extent_entries_count(),
+                              &unused),
+                          "The LBA checkpoint of shard %d starts replaying at an LBA "
+                          "extent that doesn't exist.  The database file is "
+                          "corrupted.", i);
+                owner->checkpoints[i]->read(i, &owner->in_memory_index,
+                                            DEFAULT_DISK_ACCOUNT);
+                replay_extent_offsets[i] = checkpoint->replay_extent_offset();
+                replay_entries_counts[i] = checkpoint->replay_extent_entries_count();
             }
+            UNUSED bool found = owner->disk_structures[i]->count_entries_since(
+                replay_extent_offsets[i], replay_entries_counts[i],
+                &owner->entries_since_checkpoint[i]);
+            rassert(found);
+        }
+
+        cbs_out = LBA_SHARD_FACTOR;
+        for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+            owner->disk_structures[i]->read(&owner->in_memory_index,
+                                            replay_extent_offsets[i],
+                                            replay_entries_counts[i],
+                                            this);
         }
     }
 
@@ -108,7 +158,8 @@ public:
                         e->block_id,
                         e->recency,
                         e->offset,
-                        e->ser_block_size);
+                        e->ser_block_size,
+                        e->uncompressed_ser_block_size);
             }
             
             owner->state = lba_list_t::state_ready;
@@ -174,10 +225,12 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t uncompressed_ser_block_size,
                                 file_account_t *io_account, extent_transaction_t *txn) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   uncompressed_ser_block_size);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -186,7 +239,8 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size,
+                     uncompressed_ser_block_size);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -224,19 +278,23 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.uncompressed_ser_block_size,
                 io_account,
                 txn);
+        ++entries_since_checkpoint[e.block_id % LBA_SHARD_FACTOR];
     }
 
     inline_lba_entries_count = 0;
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint32_t ser_block_size) {
+                                flagged_off64_t offset, uint32_t ser_block_size,
+                                uint32_t uncompressed_ser_block_size) {
     
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size,
+                              uncompressed_ser_block_size);
 }
 
 class lba_syncer_t :
@@ -294,8 +352,6 @@ void lba_list_t::consider_gc() {
 }
 
 void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
-    ++extent_manager->stats->pm_serializer_lba_gcs;
-
     // Start a transaction
     boost::ptr_list<extent_transaction_t> txns;
     txns.push_back(new extent_transaction_t());
@@ -312,11 +368,13 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
     for (block_id_t id = lba_shard; id < end_id; id += LBA_SHARD_FACTOR) {
         flagged_off64_t off = get_block_offset(id);
         if (off.has_value()) {
-            uint32_t ser_block_size = get_ser_block_size(id);
+            const index_block_info_t info = get_block_info(id);
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
-                                                  off, ser_block_size,
+                                                  info.recency,
+                                                  off, info.ser_block_size,
+                                                  info.uncompressed_ser_block_size,
                                                   gc_io_account.get(), &txns.back());
+            ++entries_since_checkpoint[lba_shard];
         }
 
         ++num_written_in_batch;
@@ -352,10 +410,21 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
         }
     }
 
-    // Discard the old LBA extents
+    // Discard the old LBA extents.  One of them is the extent that the shard's
+    // checkpoint starts replaying from, so the checkpoint goes in the same
+    // transaction.  Until then, every metablock we or anybody else writes still
+    // refers to the checkpoint and to the extents it needs, and if we abort, we
+    // keep both.  Replaying the rewritten LBA is as quick as reading the checkpoint
+    // would be.
     if (!aborted) {
         disk_structures[lba_shard]->destroy_extents(gced_extents, gc_io_account.get(),
                 &txns.back());
+        if (checkpoints[lba_shard].has()) {
+            checkpoints[lba_shard]->destroy(&txns.back());
+            checkpoints[lba_shard].reset();
+        }
+        UNUSED bool found = disk_structures[lba_shard]->count_entries_since(
+            NULL_OFFSET, 0, &entries_since_checkpoint[lba_shard]);
     }
 
     // Sync the changed LBA for a final time
@@ -377,6 +446,9 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
         extent_manager->commit_transaction(&*txn);
     }
 
+    if (!aborted) {
+        ++extent_manager->stats->pm_serializer_lba_gcs;
+    }
     gc_active[lba_shard] = false;
 }
 
@@ -392,8 +464,8 @@ bool lba_list_t::is_any_gc_active() const {
 // Decides, based on the number of unused entries.
 bool lba_list_t::we_want_to_gc(int i) {
 
-    // Don't garbage collect if we are already garbage collecting
-    if (gc_active[i]) {
+    // Don't garbage collect if we are already garbage collecting, or checkpointing
+    if (gc_active[i] || checkpoint_active[i]) {
         return false;
     }
 
@@ -427,6 +499,98 @@ bool lba_list_t::we_want_to_gc(int i) {
     return true;
 }
 
+void lba_list_t::consider_checkpoint() {
+    for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+        if (we_want_to_checkpoint(i)) {
+            checkpoint_active[i] = true;
+            coro_t *checkpoint_coro = coro_t::spawn_sometime(
+                std::bind(&lba_list_t::checkpoint,
+                          this, i, auto_drainer_t::lock_t(gc_drainer.get())));
+            checkpoint_coro->set_priority(CORO_PRIORITY_LBA_GC);
+        }
+    }
+}
+
+void lba_list_t::checkpoint(int lba_shard, auto_drainer_t::lock_t) {
+    // Everything that gets added to the LBA from here on is replayed on top of the
+    // checkpoint at startup, so it doesn't matter at which point while the
+    // checkpoint is being written each block's info gets picked up.
+    int64_t replay_extent_offset;
+    int64_t replay_entries_count;
+    disk_structures[lba_shard]->get_end_position(&replay_extent_offset,
+                                                 &replay_entries_count);
+    entries_since_checkpoint[lba_shard] = 0;
+    const block_id_t end_id = end_block_id();
+    const int64_t entries_count = end_id > static_cast<block_id_t>(lba_shard)
+        ? ceil_divide(end_id - lba_shard, LBA_SHARD_FACTOR) : 0;
+
+    scoped_ptr_t<lba_checkpoint_t> new_checkpoint(
+        new lba_checkpoint_t(extent_manager, dbfile, entries_count,
+                             replay_extent_offset, replay_entries_count));
+    bool done = false;
+    while (!done) {
+        done = new_checkpoint->write_some(lba_shard, &in_memory_index,
+                                          gc_io_account.get());
+
+        // If we are shutting down, we simply drop the checkpoint. No metablock
+        // refers to it yet.
+        if (state == lba_list_t::state_gc_shutting_down) {
+            new_checkpoint->abort();
+            checkpoint_active[lba_shard] = false;
+            return;
+        }
+    }
+
+    // Swap in the new checkpoint. The LBA extents that come before its replay
+    // position aren't needed to start up anymore, so they get destroyed, too.
+    extent_transaction_t txn;
+    extent_manager->begin_transaction(&txn);
+    if (replay_extent_offset != NULL_OFFSET) {
+        const std::set<lba_disk_extent_t *> replayed_extents =
+            disk_structures[lba_shard]->get_extents_before(replay_extent_offset);
+        if (!replayed_extents.empty()) {
+            disk_structures[lba_shard]->destroy_extents(replayed_extents,
+                                                        gc_io_account.get(), &txn);
+        }
+    }
+    if (checkpoints[lba_shard].has()) {
+        checkpoints[lba_shard]->destroy(&txn);
+    }
+    checkpoints[lba_shard] = std::move(new_checkpoint);
+    extent_manager->end_transaction(&txn);
+
+    // The new superblock has to be on disk before the metablock that refers to it.
+    struct : public cond_t, public lba_disk_structure_t::sync_callback_t {
+        void on_lba_sync() { pulse(); }
+    } on_lba_sync;
+    disk_structures[lba_shard]->sync(gc_io_account.get(), &on_lba_sync);
+
+    // The checkpoint only counts once a metablock refers to it, and the extents we
+    // have released can't be reused before then.
+    write_metablock_fun(on_lba_sync, gc_io_account.get());
+    extent_manager->commit_transaction(&txn);
+
+    ++extent_manager->stats->pm_serializer_lba_checkpoints;
+    checkpoint_active[lba_shard] = false;
+}
+
+// Decides, based on how long replaying the LBA at startup would take.
+bool lba_list_t::we_want_to_checkpoint(int i) {
+    if (checkpoint_active[i] || gc_active[i]) {
+        return false;
+    }
+
+    if (state == lba_list_t::state_gc_shutting_down) {
+        return false;
+    }
+
+    // Once more entries have been added to the LBA than the checkpoint would have,
+    // reading a new checkpoint is quicker than replaying them.
+    const int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR;
+    return entries_since_checkpoint[i]
+        >= std::max<int64_t>(LBA_CHECKPOINT_MIN_ENTRIES, entries_live);
+}
+
 void lba_list_t::shutdown_gc() {
     guarantee(state == state_ready);
     guarantee(coro_t::self() != NULL);
@@ -442,8 +606,13 @@ void lba_list_t::shutdown() {
     guarantee(!is_any_gc_active());
 
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+        guarantee(!checkpoint_active[i]);
         disk_structures[i]->shutdown();   // Also deletes it
         disk_structures[i] = NULL;
+        if (checkpoints[i].has()) {
+            checkpoints[i]->shutdown();
+            checkpoints[i].reset();
+        }
     }
 
     gc_io_account.reset();
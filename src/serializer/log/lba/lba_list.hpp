@@ -9,6 +9,7 @@
 #include "containers/scoped.hpp"
 #include "serializer/serializer.hpp"
 #include "serializer/log/extent_manager.hpp"
+#include "serializer/log/lba/checkpoint.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 #include "serializer/log/lba/in_memory_index.hpp"
 #include "serializer/log/lba/disk_structure.hpp"
@@ -62,6 +63,7 @@ public:
 
     void set_block_info(block_id_t block, repli_timestamp_t recency,
                         flagged_off64_t offset, uint32_t ser_block_size,
+                        uint32_t uncompressed_ser_block_size,
                         file_account_t *io_account,
                         extent_transaction_t *txn);
 
@@ -73,7 +75,12 @@ public:
 
     void consider_gc();
 
-    // The garbage collector must be shut down first through `shutdown_gc()`
+    // Starts writing a checkpoint of every shard whose LBA has grown enough since
+    // its last one.  Once a checkpoint is done, the LBA extents that come before its
+    // replay position are freed, so this keeps the LBA compact, too.
+    void consider_checkpoint();
+
+    // The garbage collector and checkpointing must be shut down first through `shutdown_gc()`
     // (must be run in a coroutine). Once that is done, call `shutdown()` to
     // shut down the whole lba_list.
     // The reason for shutting down in two parts like this is because
@@ -86,6 +93,10 @@ public:
 private:
     // Whether we are currently garbage-collecting a shard.
     bool gc_active[LBA_SHARD_FACTOR];
+    // Whether we are currently writing a checkpoint of a shard.  This and
+    // `gc_active` are never both true for the same shard.
+    bool checkpoint_active[LBA_SHARD_FACTOR];
+    // Both the GC and the checkpoint coroutines hold a lock on this.
     scoped_ptr_t<auto_drainer_t> gc_drainer;
 
     write_metablock_fun_t write_metablock_fun;
@@ -114,10 +125,16 @@ private:
     bool check_inline_lba_full() const;
     void move_inline_entries_to_extents(file_account_t *io_account, extent_transaction_t *txn);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint32_t ser_block_size);
+                          flagged_off64_t offset, uint32_t ser_block_size,
+                          uint32_t uncompressed_ser_block_size);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
+    // The most recent checkpoint of each shard, if there is one, and how many
+    // entries have been added to the shard's LBA since its replay position.
+    scoped_ptr_t<lba_checkpoint_t> checkpoints[LBA_SHARD_FACTOR];
+    int64_t entries_since_checkpoint[LBA_SHARD_FACTOR];
+
     // Garbage-collect the given shard
     void gc(int lba_shard, auto_drainer_t::lock_t gc_drainer_lock);
 
@@ -127,6 +144,11 @@ private:
     // gc. The integer is which shard to GC.
     bool we_want_to_gc(int i);
 
+    // Checkpoint the given shard
+    void checkpoint(int lba_shard, auto_drainer_t::lock_t gc_drainer_lock);
+
+    bool we_want_to_checkpoint(int i);
+
     DISABLE_COPYING(lba_list_t);
 };
 
@@ -10,9 +10,11 @@
 #include "arch/io/disk.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
 #include "buffer_cache/types.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/data_block_manager.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
@@ -124,10 +126,24 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_lba_extents(),
       pm_serializer_data_extents(),
       pm_serializer_data_extents_allocated(),
+      pm_serializer_data_writes(),
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_hot_old_garbage_block_bytes(),
+      pm_serializer_hot_old_total_block_bytes(),
+      pm_serializer_warm_old_garbage_block_bytes(),
+      pm_serializer_warm_old_total_block_bytes(),
+      pm_serializer_cold_old_garbage_block_bytes(),
+      pm_serializer_cold_old_total_block_bytes(),
+      pm_serializer_gc_block_bytes_written(),
+      pm_serializer_gc_debt_bytes(),
+      pm_serializer_gc_pacing_rate(secs_to_ticks(1), false),
       pm_serializer_lba_gcs(),
+      pm_serializer_lba_checkpoints(),
+      pm_serializer_block_bytes_uncompressed(),
+      pm_serializer_block_bytes_compressed(),
+      pm_serializer_block_compression_ratio(secs_to_ticks(1), false),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
@@ -140,10 +156,24 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_lba_extents, "serializer_lba_extents",
           &pm_serializer_data_extents, "serializer_data_extents",
           &pm_serializer_data_extents_allocated, "serializer_data_extents_allocated",
+          &pm_serializer_data_writes, "serializer_data_writes",
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
-          &pm_serializer_lba_gcs, "serializer_lba_gcs")
+          &pm_serializer_hot_old_garbage_block_bytes, "serializer_hot_old_garbage_block_bytes",
+          &pm_serializer_hot_old_total_block_bytes, "serializer_hot_old_total_block_bytes",
+          &pm_serializer_warm_old_garbage_block_bytes, "serializer_warm_old_garbage_block_bytes",
+          &pm_serializer_warm_old_total_block_bytes, "serializer_warm_old_total_block_bytes",
+          &pm_serializer_cold_old_garbage_block_bytes, "serializer_cold_old_garbage_block_bytes",
+          &pm_serializer_cold_old_total_block_bytes, "serializer_cold_old_total_block_bytes",
+          &pm_serializer_gc_block_bytes_written, "serializer_gc_block_bytes_written",
+          &pm_serializer_gc_debt_bytes, "serializer_gc_debt_bytes",
+          &pm_serializer_gc_pacing_rate, "serializer_gc_pacing_rate",
+          &pm_serializer_lba_gcs, "serializer_lba_gcs",
+          &pm_serializer_lba_checkpoints, "serializer_lba_checkpoints",
+          &pm_serializer_block_bytes_uncompressed, "serializer_block_bytes_uncompressed",
+          &pm_serializer_block_bytes_compressed, "serializer_block_bytes_compressed",
+          &pm_serializer_block_compression_ratio, "serializer_block_compression_ratio")
 { }
 
 void log_serializer_t::create(serializer_file_opener_t *file_opener, static_config_t static_config) {
@@ -423,8 +453,22 @@ void log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t> &tok
     ticks_t pm_time;
     stats->pm_serializer_block_reads.begin(&pm_time);
 
-    data_block_manager->read(token->offset_, token->block_size().ser_value(),
-                             buf, io_account);
+    if (token->is_compressed()) {
+        // Decompress the block in the blocker pool, so that it doesn't hold up
+        // everything else that's running on the serializer's thread.
+        const block_size_t disk_block_size = token->disk_block_size();
+        const block_size_t block_size = token->block_size();
+        scoped_malloc_t<ser_buffer_t> compressed(
+            malloc_aligned(disk_block_size.ser_value(), DEVICE_BLOCK_SIZE));
+        data_block_manager->read(token->offset_, disk_block_size.ser_value(),
+                                 compressed.get(), io_account);
+        thread_pool_t::run_in_blocker_pool([&]() {
+            decompress_block(compressed.get(), disk_block_size, buf, block_size);
+        });
+    } else {
+        data_block_manager->read(token->offset_, token->block_size().ser_value(),
+                                 buf, io_account);
+    }
 
     stats->pm_serializer_block_reads.end(&pm_time);
 }
@@ -466,8 +510,10 @@ void log_serializer_t::index_write(const std::vector<index_write_op_t> &write_op
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t& op = *write_op_it;
-            flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint32_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t info = lba_index->get_block_info(op.block_id);
+            flagged_off64_t offset = info.offset;
+            uint32_t ser_block_size = info.ser_block_size;
+            uint32_t uncompressed_ser_block_size = info.uncompressed_ser_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -482,21 +528,26 @@ void log_serializer_t::index_write(const std::vector<index_write_op_t> &write_op
                 // Write new token to index, or remove from index as appropriate.
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
-                    ser_block_size = token->block_size().ser_value();
+                    ser_block_size = token->disk_block_size().ser_value();
+                    uncompressed_ser_block_size = token->is_compressed()
+                        ? token->block_size().ser_value() : 0;
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(), token->block_size());
+                    data_block_manager->mark_live(offset.get_value(),
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    uncompressed_ser_block_size = 0;
                 }
             }
 
             repli_timestamp_t recency = op.recency ? op.recency.get()
-                : lba_index->get_block_recency(op.block_id);
+                : info.recency;
 
             lba_index->set_block_info(op.block_id, recency,
                                       offset, ser_block_size,
+                                      uncompressed_ser_block_size,
                                       io_account, &txn);
         }
     }
@@ -512,6 +563,7 @@ void log_serializer_t::index_write_prepare(extent_transaction_t *txn) {
 
     /* Just to make sure that the LBA GC gets exercised */
     lba_index->consider_gc();
+    lba_index->consider_checkpoint();
 
     /* Start an extent manager transaction so we can allocate and release extents */
     extent_manager->begin_transaction(txn);
@@ -589,20 +641,90 @@ void log_serializer_t::write_metablock(const signal_t &safe_to_write_cond,
 
 counted_t<ls_block_token_pointee_t>
 log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+    return generate_block_token(offset, block_size, block_size);
+}
+
+counted_t<ls_block_token_pointee_t>
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<ls_block_token_pointee_t> ret(new ls_block_token_pointee_t(this, offset, block_size));
+    counted_t<ls_block_token_pointee_t> ret(
+        new ls_block_token_pointee_t(this, offset, block_size, disk_block_size));
     return ret;
 }
 
+// Holds on to the compressed copies of the blocks until they've been written.
+class compressed_block_writes_cb_t : public iocallback_t {
+public:
+    compressed_block_writes_cb_t(size_t n, iocallback_t *cb) : bufs(n), cb_(cb) { }
+
+    void on_io_complete() {
+        iocallback_t *cb = cb_;
+        delete this;
+        cb->on_io_complete();
+    }
+
+    std::vector<scoped_malloc_t<ser_buffer_t> > bufs;
+
+private:
+    iocallback_t *const cb_;
+
+    DISABLE_COPYING(compressed_block_writes_cb_t);
+};
+
 std::vector<counted_t<ls_block_token_pointee_t> >
 log_serializer_t::block_writes(const std::vector<buf_write_info_t> &write_infos,
                                file_account_t *io_account, iocallback_t *cb) {
     assert_thread();
     stats->pm_serializer_block_writes += write_infos.size();
 
+    if (!dynamic_config.compress_blocks || write_infos.empty()) {
+        std::vector<counted_t<ls_block_token_pointee_t> > result
+            = data_block_manager->many_writes(write_infos, false, io_account, cb);
+        guarantee(result.size() == write_infos.size());
+        return result;
+    }
+
+    // Compress the blocks in the blocker pool, so that it doesn't hold up everything
+    // else that's running on the serializer's thread.  Blocks that don't get any
+    // smaller on disk are written as they are.
+    compressed_block_writes_cb_t *compressed_cb
+        = new compressed_block_writes_cb_t(write_infos.size(), cb);
+    std::vector<buf_write_info_t> disk_write_infos = write_infos;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        for (size_t i = 0; i < write_infos.size(); ++i) {
+            scoped_malloc_t<ser_buffer_t> compressed(
+                malloc_aligned(write_infos[i].block_size.ser_value(), DEVICE_BLOCK_SIZE));
+            const uint32_t compressed_size = compress_block(write_infos[i].buf,
+                                                            write_infos[i].block_size,
+                                                            compressed.get());
+            if (compressed_size != 0) {
+                disk_write_infos[i].buf = compressed.get();
+                disk_write_infos[i].block_size
+                    = block_size_t::unsafe_make(compressed_size);
+                compressed_cb->bufs[i] = std::move(compressed);
+            }
+        }
+    });
+
     std::vector<counted_t<ls_block_token_pointee_t> > result
-        = data_block_manager->many_writes(write_infos, io_account, cb);
+        = data_block_manager->many_writes(disk_write_infos, false, io_account,
+                                          compressed_cb);
     guarantee(result.size() == write_infos.size());
+
+    int64_t uncompressed_bytes = 0;
+    int64_t compressed_bytes = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+        // Whoever reads the block through the token gets it back decompressed.
+        result[i]->block_size_ = write_infos[i].block_size;
+        uncompressed_bytes += write_infos[i].block_size.ser_value();
+        compressed_bytes += disk_write_infos[i].block_size.ser_value();
+    }
+    stats->pm_serializer_block_bytes_uncompressed += uncompressed_bytes;
+    stats->pm_serializer_block_bytes_compressed += compressed_bytes;
+    stats->pm_serializer_block_compression_ratio.record(
+        static_cast<double>(uncompressed_bytes) / compressed_bytes);
+
     return result;
 }
 
@@ -723,7 +845,9 @@ counted_t<ls_block_token_pointee_t> log_serializer_t::index_read(block_id_t bloc
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(info.offset.get_value(),
+                                    block_size_t::unsafe_make(info.logical_ser_block_size()),
+                                    block_size_t::unsafe_make(info.ser_block_size));
     } else {
         return counted_t<ls_block_token_pointee_t>();
     }
@@ -903,9 +1027,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 ls_block_token_pointee_t::ls_block_token_pointee_t(log_serializer_t *serializer,
                                                    int64_t initial_offset,
-                                                   block_size_t initial_block_size)
+                                                   block_size_t initial_block_size,
+                                                   block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), disk_block_size_(initial_disk_block_size),
+      offset_(initial_offset) {
     serializer_->assert_thread();
     serializer_->register_block_token(this, initial_offset);
 }
@@ -170,6 +170,9 @@ private:
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<ls_block_token_pointee_t> generate_block_token(int64_t offset,
                                                              block_size_t block_size);
+    counted_t<ls_block_token_pointee_t> generate_block_token(int64_t offset,
+                                                             block_size_t block_size,
+                                                             block_size_t disk_block_size);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
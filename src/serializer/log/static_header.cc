@@ -62,7 +62,11 @@ void co_static_header_read(file_t *file, static_header_read_callback_t *callback
         fail_due_to_user_error("This doesn't appear to be a RethinkDB data file.");
     }
 
-    if (memcmp(buffer->version, SERIALIZER_VERSION_STRING, sizeof(SERIALIZER_VERSION_STRING)) != 0) {
+    const bool previous_version
+        = memcmp(buffer->version, SERIALIZER_PREVIOUS_VERSION_STRING,
+                 sizeof(SERIALIZER_PREVIOUS_VERSION_STRING)) == 0;
+    if (!previous_version
+        && memcmp(buffer->version, SERIALIZER_VERSION_STRING, sizeof(SERIALIZER_VERSION_STRING)) != 0) {
         fail_due_to_user_error("File version is incorrect. This file was created with "
                                "RethinkDB's serializer version %s, but you are trying "
                                "to read it with version %s.  See "
@@ -71,6 +75,11 @@ void co_static_header_read(file_t *file, static_header_read_callback_t *callback
                                buffer->version, SERIALIZER_VERSION_STRING);
     }
     memcpy(data_out, buffer->data, data_size);
+    if (previous_version) {
+        // The file is about to get things the previous version can't read, so it
+        // must not open it anymore.
+        co_static_header_write(file, data_out, data_size);
+    }
     callback->on_static_header_read();
     // TODO: free buffer before you call the callback.
     free(buffer);
@@ -24,12 +24,33 @@ struct log_serializer_stats_t {
     /* used in serializer/log/data_block_manager.cc */
     perfmon_counter_t pm_serializer_data_extents;
     perfmon_counter_t pm_serializer_data_extents_allocated;
+    /* The number of contiguous writes that data blocks went out in */
+    perfmon_counter_t pm_serializer_data_writes;
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
-
-    /* used in serializer/log/lba/lba_list.cc */
+    /* The same, for the extents of each block temperature class */
+    perfmon_counter_t pm_serializer_hot_old_garbage_block_bytes;
+    perfmon_counter_t pm_serializer_hot_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_warm_old_garbage_block_bytes;
+    perfmon_counter_t pm_serializer_warm_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_cold_old_garbage_block_bytes;
+    perfmon_counter_t pm_serializer_cold_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_gc_block_bytes_written;
+    perfmon_counter_t pm_serializer_gc_debt_bytes;
+    perfmon_sampler_t pm_serializer_gc_pacing_rate;
+
+    /* used in serializer/log/lba/lba_list.cc, counting the LBA GCs and checkpoints
+    that have run to completion */
     perfmon_counter_t pm_serializer_lba_gcs;
+    perfmon_counter_t pm_serializer_lba_checkpoints;
+
+    /* Block compression: the bytes of the blocks that went through
+    `block_writes()` before and after compressing them, and the ratio of the two
+    for each call. */
+    perfmon_counter_t pm_serializer_block_bytes_uncompressed;
+    perfmon_counter_t pm_serializer_block_bytes_compressed;
+    perfmon_sampler_t pm_serializer_block_compression_ratio;
 
     perfmon_membership_t parent_collection_membership;
     perfmon_multi_membership_t stats_membership;
@@ -1,28 +1,46 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "serializer/merger.hpp"
 
+#include <functional>
+#include <iterator>
+
 #include "errors.hpp"
 
 #include "serializer/types.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "config/args.hpp"
+#include "time.hpp"
 
 
 
 merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+                                         int _max_active_writes,
+                                         int64_t _block_write_window_ms,
+                                         perfmon_collection_t *perfmon_collection) :
     inner(std::move(_inner)),
     index_writes_io_account(make_io_account(MERGED_INDEX_WRITE_IO_PRIORITY)),
     on_inner_index_write_complete(new counted_cond_t()),
     unhandled_index_write_waiter_exists(false),
     num_active_writes(0),
-    max_active_writes(_max_active_writes) {
+    max_active_writes(_max_active_writes),
+    block_write_batch_scheduled(false),
+    block_write_window_ms(_block_write_window_ms),
+    num_block_write_batches_in_flight(0),
+    pm_block_write_batches(),
+    pm_block_writes_per_batch(secs_to_ticks(1), false),
+    parent_collection_membership(perfmon_collection, &merger_collection, "merger"),
+    stats_membership(&merger_collection,
+        &pm_block_write_batches, "merger_block_write_batches",
+        &pm_block_writes_per_batch, "merger_block_writes_per_batch") {
 }
 
 merger_serializer_t::~merger_serializer_t() {
     assert_thread();
     rassert(num_active_writes == 0);
     rassert(outstanding_index_write_ops.empty());
+    rassert(pending_block_writes.empty());
+    rassert(!block_write_batch_scheduled);
 }
 
 void merger_serializer_t::index_write(const std::vector<index_write_op_t> &write_ops,
@@ -116,3 +134,110 @@ void merger_serializer_t::push_index_write_op(const index_write_op_t &op) {
     }
 }
 
+
+struct merger_serializer_t::block_write_request_t {
+    block_write_request_t(const std::vector<buf_write_info_t> *_write_infos,
+                          file_account_t *_io_account, iocallback_t *_cb)
+        : write_infos(_write_infos), io_account(_io_account), cb(_cb) { }
+
+    const std::vector<buf_write_info_t> *const write_infos;
+    file_account_t *const io_account;
+    iocallback_t *const cb;
+
+    // Filled in by `do_block_writes()` before it pulses `done`.
+    std::vector<counted_t<standard_block_token_t> > tokens;
+    cond_t done;
+};
+
+// Calls the callbacks of all block writes of a batch once the batch is written.
+class merger_serializer_t::block_write_batch_cb_t : public iocallback_t {
+public:
+    block_write_batch_cb_t(merger_serializer_t *_parent,
+                           std::vector<iocallback_t *> &&_cbs)
+        : parent(_parent), cbs(std::move(_cbs)) {
+        ++parent->num_block_write_batches_in_flight;
+    }
+
+    void on_io_complete() {
+        parent->assert_thread();
+        --parent->num_block_write_batches_in_flight;
+        std::vector<iocallback_t *> tmp;
+        tmp.swap(cbs);
+        delete this;
+        for (auto cb = tmp.begin(); cb != tmp.end(); ++cb) {
+            (*cb)->on_io_complete();
+        }
+    }
+
+private:
+    merger_serializer_t *parent;
+    std::vector<iocallback_t *> cbs;
+};
+
+std::vector<counted_t<standard_block_token_t> >
+merger_serializer_t::block_writes(const std::vector<buf_write_info_t> &write_infos,
+                                  file_account_t *io_account,
+                                  iocallback_t *cb) {
+    rassert(coro_t::self() != NULL);
+    assert_thread();
+
+    block_write_request_t request(&write_infos, io_account, cb);
+    pending_block_writes.push_back(&request);
+    if (!block_write_batch_scheduled) {
+        block_write_batch_scheduled = true;
+        coro_t::spawn_sometime(std::bind(&merger_serializer_t::do_block_writes, this));
+    }
+
+    request.done.wait_lazily_unordered();
+    return std::move(request.tokens);
+}
+
+void merger_serializer_t::do_block_writes() {
+    assert_thread();
+
+    // Waiting for more block writes to join the batch only pays off while the
+    // disk is busy with the previous batch anyway.
+    if (block_write_window_ms > 0 && num_block_write_batches_in_flight > 0) {
+        nap(block_write_window_ms);
+    }
+
+    std::vector<block_write_request_t *> requests;
+    std::vector<buf_write_info_t> write_infos;
+    std::vector<iocallback_t *> cbs;
+    {
+        ASSERT_NO_CORO_WAITING;
+        requests.swap(pending_block_writes);
+        block_write_batch_scheduled = false;
+
+        cbs.reserve(requests.size());
+        for (auto it = requests.begin(); it != requests.end(); ++it) {
+            write_infos.insert(write_infos.end(),
+                               (*it)->write_infos->begin(), (*it)->write_infos->end());
+            cbs.push_back((*it)->cb);
+        }
+    }
+    rassert(!requests.empty());
+
+    ++pm_block_write_batches;
+    pm_block_writes_per_batch.record(requests.size());
+
+    // The batch goes out through the first request's I/O account.  The requests
+    // all come from flushes of the same file, so that's as good as any.
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = inner->block_writes(write_infos, requests.front()->io_account,
+                              new block_write_batch_cb_t(this, std::move(cbs)));
+    guarantee(tokens.size() == write_infos.size());
+
+    // Hand every request its tokens.  The requests are gone once we pulse them, so
+    // we must not block after this.
+    ASSERT_NO_CORO_WAITING;
+    auto token = tokens.begin();
+    for (auto it = requests.begin(); it != requests.end(); ++it) {
+        const size_t n = (*it)->write_infos->size();
+        (*it)->tokens.assign(std::make_move_iterator(token),
+                             std::make_move_iterator(token + n));
+        token += n;
+        (*it)->done.pulse();
+    }
+    rassert(token == tokens.end());
+}
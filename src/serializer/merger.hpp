@@ -8,6 +8,7 @@
 
 #include "buffer_cache/types.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/serializer.hpp"
 
 /*
@@ -19,11 +20,19 @@
  * hash shards) can be merged together, improving efficiency and significantly
  * reducing the number of disk seeks on rotational drives.
  *
+ * Block writes are gathered up in the same spirit.  A block write that comes in
+ * while no batch is being written by the inner serializer goes out right away.
+ * Otherwise the block writes that come in within `block_write_window_ms` are
+ * passed on to the inner serializer as one batch, which it then writes out
+ * sequentially.  The index writes that follow them tend to get merged, too.
+ *
  */
 
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes,
+                        int64_t _block_write_window_ms,
+                        perfmon_collection_t *perfmon_collection);
     ~merger_serializer_t();
 
 
@@ -88,14 +97,12 @@ public:
     void index_write(const std::vector<index_write_op_t> &write_ops,
                      file_account_t *io_account);
 
-    // Returns block tokens in the same order as write_infos.
+    /* This is where merger_serializer_t merges block writes.  Returns block
+    tokens in the same order as write_infos. */
     std::vector<counted_t<standard_block_token_t> >
     block_writes(const std::vector<buf_write_info_t> &write_infos,
                  file_account_t *io_account,
-                 iocallback_t *cb) {
-        // Currently, we do not merge block writes, only index writes.
-        return inner->block_writes(write_infos, io_account, cb);
-    }
+                 iocallback_t *cb);
 
     /* The size, in bytes, of each serializer block */
     block_size_t max_block_size() const { return inner->max_block_size(); }
@@ -131,6 +138,26 @@ private:
 
     void do_index_write();
 
+    // A `block_writes()` call that's waiting for its batch to be written.
+    struct block_write_request_t;
+    class block_write_batch_cb_t;
+
+    // The block writes for the next batch, and whether `do_block_writes()` has
+    // been spawned to write them out.
+    std::vector<block_write_request_t *> pending_block_writes;
+    bool block_write_batch_scheduled;
+    const int64_t block_write_window_ms;
+    // Batches the inner serializer hasn't finished writing yet.
+    int num_block_write_batches_in_flight;
+
+    void do_block_writes();
+
+    perfmon_collection_t merger_collection;
+    perfmon_counter_t pm_block_write_batches;
+    perfmon_sampler_t pm_block_writes_per_batch;
+    perfmon_membership_t parent_collection_membership;
+    perfmon_multi_membership_t stats_membership;
+
     DISABLE_COPYING(merger_serializer_t);
 };
 
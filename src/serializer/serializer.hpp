@@ -104,7 +104,8 @@ public:
     /* index_write() applies all given index operations in an atomic way */
     virtual void index_write(const std::vector<index_write_op_t>& write_ops, file_account_t *io_account) = 0;
 
-    // Returns block tokens in the same order as write_infos.
+    // Returns block tokens in the same order as write_infos.  Must be called in a
+    // coroutine; it may block (for example to compress the blocks).
     virtual std::vector<counted_t<standard_block_token_t> >
     block_writes(const std::vector<buf_write_info_t> &write_infos,
                  file_account_t *io_account,
@@ -94,6 +94,12 @@ class ls_block_token_pointee_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // The size of the block on disk, which is smaller than `block_size()` if the
+    // block is stored compressed.
+    block_size_t disk_block_size() const { return disk_block_size_; }
+    bool is_compressed() const {
+        return disk_block_size_.ser_value() != block_size_.ser_value();
+    }
 
 private:
     friend class log_serializer_t;
@@ -103,7 +109,8 @@ private:
 
     ls_block_token_pointee_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_ser_block_size);
+                             block_size_t initial_ser_block_size,
+                             block_size_t initial_disk_block_size);
 
     log_serializer_t *serializer_;
     intptr_t ref_count_;
@@ -111,6 +118,9 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The block's size on disk.
+    block_size_t disk_block_size_;
+
     // The block's offset on disk.
     int64_t offset_;
 
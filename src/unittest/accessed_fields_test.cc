@@ -0,0 +1,157 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <set>
+#include <string>
+
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/pb_utils.hpp"
+#include "rdb_protocol/sym.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "stl_utils.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+// The argument of the functions we analyze, and the argument of functions nested
+// in them.
+const ql::sym_t x(1);
+const ql::sym_t y(2);
+
+ql::r::reql_t row() {
+    return ql::r::reql_t(Term::IMPLICIT_VAR);
+}
+
+ql::r::reql_t nested_fun(const ql::sym_t &arg, ql::r::reql_t &&body) {
+    return ql::r::reql_t(Term::FUNC, ql::r::array(static_cast<double>(arg.value)),
+                         std::move(body));
+}
+
+// Compiles `body` into a function of `x` and analyzes it.
+bool accessed_fields(ql::r::reql_t &&body, std::set<std::string> *fields_out) {
+    ql::protob_t<const Term> term = body.release_counted();
+    ql::wire_func_t wire_func(term, make_vector(x), ql::get_backtrace(term));
+    counted_t<ql::func_t> func = wire_func.compile_wire_func();
+    return ql::get_accessed_fields(func.get(), fields_out);
+}
+
+std::set<std::string> field_set(const std::string &a) {
+    std::set<std::string> ret;
+    ret.insert(a);
+    return ret;
+}
+
+std::set<std::string> field_set(const std::string &a, const std::string &b) {
+    std::set<std::string> ret = field_set(a);
+    ret.insert(b);
+    return ret;
+}
+
+TEST(AccessedFieldsTest, GetField) {
+    std::set<std::string> fields;
+    ASSERT_TRUE(accessed_fields(ql::r::var(x)["a"] + ql::r::var(x)["b"], &fields));
+    ASSERT_EQ(field_set("a", "b"), fields);
+
+    // Only top-level fields get loaded, so a nested field needs its parent.
+    fields.clear();
+    ASSERT_TRUE(accessed_fields(ql::r::var(x)["a"]["b"], &fields));
+    ASSERT_EQ(field_set("a"), fields);
+}
+
+TEST(AccessedFieldsTest, WholeRow) {
+    std::set<std::string> fields;
+    ASSERT_FALSE(accessed_fields(ql::r::var(x), &fields));
+    ASSERT_FALSE(accessed_fields(ql::r::array(ql::r::var(x)["a"], ql::r::var(x)),
+                                 &fields));
+    ASSERT_FALSE(accessed_fields(ql::r::var(x).count(), &fields));
+    // A failed analysis leaves `fields_out` alone.
+    ASSERT_TRUE(fields.empty());
+}
+
+TEST(AccessedFieldsTest, ImplicitVar) {
+    std::set<std::string> fields;
+    ASSERT_TRUE(accessed_fields(row()["a"] + ql::r::var(x)["b"], &fields));
+    ASSERT_EQ(field_set("a", "b"), fields);
+
+    ASSERT_FALSE(accessed_fields(row(), &fields));
+    ASSERT_FALSE(accessed_fields(row().pluck("a"), &fields));
+}
+
+TEST(AccessedFieldsTest, NonLiteralFieldName) {
+    std::set<std::string> fields;
+    ASSERT_FALSE(accessed_fields(
+        ql::r::var(x)[ql::r::expr(std::string("a")) + ql::r::expr(std::string("b"))],
+        &fields));
+    ASSERT_FALSE(accessed_fields(ql::r::var(x)[ql::r::var(x)["a"]], &fields));
+    ASSERT_FALSE(accessed_fields(ql::r::var(x)[row()["a"]], &fields));
+}
+
+TEST(AccessedFieldsTest, PluckAndHasFields) {
+    std::set<std::string> fields;
+    ASSERT_FALSE(accessed_fields(ql::r::var(x).pluck("a"), &fields));
+    ASSERT_FALSE(accessed_fields(ql::r::var(x).has_fields("a"), &fields));
+    ASSERT_FALSE(accessed_fields(ql::r::var(x).merge(ql::r::object()), &fields));
+}
+
+TEST(AccessedFieldsTest, NestedFunctions) {
+    std::set<std::string> fields;
+
+    // A nested function that reads fields of the row it captures.
+    ASSERT_TRUE(accessed_fields(
+        ql::r::array(1.0).map(nested_fun(y, ql::r::var(x)["a"] + ql::r::var(y))),
+        &fields));
+    ASSERT_EQ(field_set("a"), fields);
+
+    // A nested function that captures the whole row.
+    ASSERT_FALSE(accessed_fields(
+        ql::r::array(1.0).map(nested_fun(y, ql::r::var(x))), &fields));
+
+    // A nested function whose argument shadows the row.  We can't tell the two
+    // apart, so using the inner one as a whole counts as using the row...
+    ASSERT_FALSE(accessed_fields(
+        ql::r::array(1.0).map(nested_fun(x, ql::r::var(x))), &fields));
+
+    // ... and fields of the inner one may be loaded for nothing, but that's safe.
+    fields.clear();
+    ASSERT_TRUE(accessed_fields(
+        ql::r::array(ql::r::var(x)["a"]).map(nested_fun(x, ql::r::var(x)["b"])),
+        &fields));
+    ASSERT_EQ(1u, fields.count("a"));
+
+    // `r.row` in a nested function that doesn't bind it is still the row.
+    fields.clear();
+    ASSERT_TRUE(accessed_fields(
+        ql::r::array(1.0).map(ql::r::fun(ql::pb::dummy_var_t::IGNORED, row()["a"])),
+        &fields));
+    ASSERT_EQ(field_set("a"), fields);
+    ASSERT_FALSE(accessed_fields(
+        ql::r::array(1.0).map(ql::r::fun(ql::pb::dummy_var_t::IGNORED, row())),
+        &fields));
+}
+
+TEST(AccessedFieldsTest, Optargs) {
+    std::set<std::string> fields;
+    ASSERT_TRUE(accessed_fields(
+        ql::r::array(1.0).filter(ql::r::fun(ql::pb::dummy_var_t::IGNORED,
+                                            ql::r::boolean(true)),
+                                 ql::r::optarg("default", ql::r::var(x)["a"])),
+        &fields));
+    ASSERT_EQ(field_set("a"), fields);
+
+    ASSERT_FALSE(accessed_fields(
+        ql::r::array(1.0).filter(ql::r::fun(ql::pb::dummy_var_t::IGNORED,
+                                            ql::r::boolean(true)),
+                                 ql::r::optarg("default", ql::r::var(x))),
+        &fields));
+}
+
+TEST(AccessedFieldsTest, JsFunc) {
+    ql::protob_t<const Term> term = ql::r::expr(1.0).release_counted();
+    counted_t<ql::func_t> func = make_counted<ql::js_func_t>(
+        "(function(row) { return row.a; })", 5000, ql::get_backtrace(term));
+    std::set<std::string> fields;
+    ASSERT_FALSE(ql::get_accessed_fields(func.get(), &fields));
+    ASSERT_TRUE(fields.empty());
+}
+
+}  // namespace unittest
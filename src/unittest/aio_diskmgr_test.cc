@@ -0,0 +1,124 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <sys/uio.h>
+
+#include "arch/arch.hpp"
+#include "arch/io/disk.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static const size_t AIO_TEST_BLOCK_SIZE = 4 * KILOBYTE;
+static const size_t AIO_TEST_NUM_BLOCKS = 64;
+
+class cond_iocallback_t : public linux_iocallback_t {
+public:
+    void on_io_complete() {
+        done.pulse();
+    }
+    cond_t done;
+};
+
+char test_byte(size_t block, size_t i) {
+    return static_cast<char>(block * 31 + i * 7);
+}
+
+void fill_block(size_t block, char *buf) {
+    for (size_t i = 0; i < AIO_TEST_BLOCK_SIZE; ++i) {
+        buf[i] = test_byte(block, i);
+    }
+}
+
+void check_block(size_t block, const char *buf) {
+    for (size_t i = 0; i < AIO_TEST_BLOCK_SIZE; ++i) {
+        ASSERT_EQ(test_byte(block, i), buf[i]) << "block " << block << " byte " << i;
+    }
+}
+
+// Writes blocks one at a time and in a single writev, reads them back both
+// one at a time and concurrently, and checks the contents.
+void run_read_write_test(io_backend_t io_backend,
+                         file_direct_io_mode_t direct_io_mode) {
+    io_backender_t io_backender(direct_io_mode, DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                                io_backend);
+    temp_file_t temp_file;
+
+    scoped_ptr_t<file_t> file;
+    file_open_result_t res = open_file(temp_file.name().permanent_path().c_str(),
+                                       linux_file_t::mode_read
+                                       | linux_file_t::mode_write
+                                       | linux_file_t::mode_create
+                                       | linux_file_t::mode_truncate,
+                                       &io_backender, &file);
+    ASSERT_NE(file_open_result_t::ERROR, res.outcome);
+    file->set_size(AIO_TEST_NUM_BLOCKS * AIO_TEST_BLOCK_SIZE);
+
+    scoped_malloc_t<char> data(malloc_aligned(AIO_TEST_NUM_BLOCKS * AIO_TEST_BLOCK_SIZE,
+                                              DEVICE_BLOCK_SIZE));
+
+    // The first half of the file is written block by block, the second half with
+    // one writev.
+    const size_t half = AIO_TEST_NUM_BLOCKS / 2;
+    for (size_t b = 0; b < AIO_TEST_NUM_BLOCKS; ++b) {
+        fill_block(b, data.get() + b * AIO_TEST_BLOCK_SIZE);
+    }
+    for (size_t b = 0; b < half; ++b) {
+        co_write(file.get(), b * AIO_TEST_BLOCK_SIZE, AIO_TEST_BLOCK_SIZE,
+                 data.get() + b * AIO_TEST_BLOCK_SIZE, DEFAULT_DISK_ACCOUNT,
+                 file_t::NO_DATASYNCS);
+    }
+    {
+        scoped_array_t<iovec> bufs(AIO_TEST_NUM_BLOCKS - half);
+        for (size_t b = half; b < AIO_TEST_NUM_BLOCKS; ++b) {
+            bufs[b - half].iov_base = data.get() + b * AIO_TEST_BLOCK_SIZE;
+            bufs[b - half].iov_len = AIO_TEST_BLOCK_SIZE;
+        }
+        cond_iocallback_t cb;
+        file->writev_async(half * AIO_TEST_BLOCK_SIZE,
+                           (AIO_TEST_NUM_BLOCKS - half) * AIO_TEST_BLOCK_SIZE,
+                           std::move(bufs), DEFAULT_DISK_ACCOUNT, &cb);
+        cb.done.wait();
+    }
+
+    // Wrapping a write in datasyncs takes the fallback path of the AIO backend.
+    co_write(file.get(), 0, AIO_TEST_BLOCK_SIZE, data.get(), DEFAULT_DISK_ACCOUNT,
+             file_t::WRAP_IN_DATASYNCS);
+
+    scoped_malloc_t<char> readback(malloc_aligned(AIO_TEST_NUM_BLOCKS * AIO_TEST_BLOCK_SIZE,
+                                                  DEVICE_BLOCK_SIZE));
+    for (size_t b = 0; b < AIO_TEST_NUM_BLOCKS; ++b) {
+        co_read(file.get(), b * AIO_TEST_BLOCK_SIZE, AIO_TEST_BLOCK_SIZE,
+                readback.get() + b * AIO_TEST_BLOCK_SIZE, DEFAULT_DISK_ACCOUNT);
+        check_block(b, readback.get() + b * AIO_TEST_BLOCK_SIZE);
+    }
+
+    // Put every read in flight at once, so that they get submitted in batches.
+    memset(readback.get(), 0, AIO_TEST_NUM_BLOCKS * AIO_TEST_BLOCK_SIZE);
+    scoped_array_t<cond_iocallback_t> cbs(AIO_TEST_NUM_BLOCKS);
+    for (size_t b = 0; b < AIO_TEST_NUM_BLOCKS; ++b) {
+        file->read_async(b * AIO_TEST_BLOCK_SIZE, AIO_TEST_BLOCK_SIZE,
+                         readback.get() + b * AIO_TEST_BLOCK_SIZE,
+                         DEFAULT_DISK_ACCOUNT, &cbs[b]);
+    }
+    for (size_t b = 0; b < AIO_TEST_NUM_BLOCKS; ++b) {
+        cbs[b].done.wait();
+        check_block(b, readback.get() + b * AIO_TEST_BLOCK_SIZE);
+    }
+}
+
+TPTEST(AioDiskmgrTest, PoolBuffered) {
+    run_read_write_test(io_backend_t::pool, file_direct_io_mode_t::buffered_desired);
+}
+
+TPTEST(AioDiskmgrTest, NativeBuffered) {
+    run_read_write_test(io_backend_t::native, file_direct_io_mode_t::buffered_desired);
+}
+
+TPTEST(AioDiskmgrTest, NativeDirect) {
+    // Falls back to buffered IO if the filesystem doesn't support O_DIRECT.
+    run_read_write_test(io_backend_t::native, file_direct_io_mode_t::direct_desired);
+}
+
+}  // namespace unittest
@@ -0,0 +1,294 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "btree/bulk_load.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "btree/operations.hpp"
+#include "btree/slice.hpp"
+#include "serializer/config.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+struct bulk_load_test_value_t;
+
+// A value is a length byte followed by that many bytes.
+template <>
+class value_sizer_t<bulk_load_test_value_t> : public value_sizer_t<void> {
+public:
+    explicit value_sizer_t<bulk_load_test_value_t>(block_size_t bs) : block_size_(bs) { }
+
+    int size(const void *value) const {
+        return 1 + *reinterpret_cast<const uint8_t *>(value);
+    }
+
+    bool fits(const void *value, int length_available) const {
+        return length_available > 0 && size(value) <= length_available;
+    }
+
+    int max_possible_size() const {
+        return 256;
+    }
+
+    block_magic_t btree_leaf_magic() const {
+        block_magic_t magic = { { 'b', 'l', 'L', 'F' } };
+        return magic;
+    }
+
+    block_size_t block_size() const { return block_size_; }
+
+private:
+    block_size_t block_size_;
+
+    DISABLE_COPYING(value_sizer_t<bulk_load_test_value_t>);
+};
+
+namespace unittest {
+
+// Big enough values and enough keys that the tree gets two levels of internal
+// nodes, so that the loader has to seal internal nodes too.
+static const int BULK_LOAD_TEST_NUM_KEYS = 6000;
+static const size_t BULK_LOAD_TEST_VALUE_SIZE = 200;
+static const int BULK_LOAD_TEST_KEYS_PER_TXN = 500;
+
+std::string bulk_load_test_key(int i) {
+    return strprintf("key%08d", i);
+}
+
+std::string bulk_load_test_value(int i) {
+    return std::string(BULK_LOAD_TEST_VALUE_SIZE, static_cast<char>('a' + i % 26));
+}
+
+scoped_malloc_t<bulk_load_test_value_t> make_bulk_load_test_value(int i) {
+    const std::string value = bulk_load_test_value(i);
+    scoped_malloc_t<bulk_load_test_value_t> buf(1 + value.size());
+    uint8_t *data = reinterpret_cast<uint8_t *>(buf.get());
+    data[0] = value.size();
+    memcpy(data + 1, value.data(), value.size());
+    return buf;
+}
+
+// An empty btree in its own file.
+class test_btree_t {
+public:
+    explicit test_btree_t(io_backender_t *io_backender)
+        : file_opener(temp_file.name(), io_backender) {
+        standard_serializer_t::create(&file_opener,
+                                      standard_serializer_t::static_config_t());
+        serializer.init(new standard_serializer_t(
+            standard_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection()));
+        cache.init(new cache_t(serializer.get(), alt_cache_config_t(), NULL,
+                               &get_global_perfmon_collection()));
+        cache_conn.init(new cache_conn_t(cache.get()));
+
+        txn_t txn(cache_conn.get(), write_durability_t::HARD,
+                  repli_timestamp_t::invalid, 1);
+        buf_lock_t superblock(&txn, SUPERBLOCK_ID, alt_create_t::create);
+        btree_slice_t::init_superblock(&superblock,
+                                       std::vector<char>(), std::vector<char>());
+    }
+
+    temp_file_t temp_file;
+    filepath_file_opener_t file_opener;
+    scoped_ptr_t<standard_serializer_t> serializer;
+    scoped_ptr_t<cache_t> cache;
+    scoped_ptr_t<cache_conn_t> cache_conn;
+};
+
+// What a walk over a btree saw.
+struct tree_shape_t {
+    tree_shape_t() : leaf_depth(-1) { }
+
+    std::vector<std::pair<std::string, std::string> > pairs;
+    // Copies of the leaves, from left to right.
+    std::vector<std::vector<char> > leaves;
+    // For every level of internal nodes, whether each of them is full, from left to
+    // right.  Level 0 is the root.
+    std::vector<std::vector<bool> > internal_full;
+    int leaf_depth;
+};
+
+std::string key_to_string(const btree_key_t *key) {
+    return std::string(reinterpret_cast<const char *>(key->contents), key->size);
+}
+
+// Walks the subtree under `node_id`, checking that its keys are in
+// (`left_excl`, `right_incl`], where NULL means unbounded.
+void walk_tree(value_sizer_t<void> *sizer, buf_parent_t parent, block_id_t node_id,
+               int depth, const btree_key_t *left_excl, const btree_key_t *right_incl,
+               tree_shape_t *shape) {
+    buf_lock_t lock(parent, node_id, access_t::read);
+    std::vector<std::pair<block_id_t, store_key_t> > children;
+    {
+        buf_read_t read(&lock);
+        const node_t *node = static_cast<const node_t *>(read.get_data_read());
+        if (node::is_leaf(node)) {
+            if (shape->leaf_depth == -1) {
+                shape->leaf_depth = depth;
+            }
+            EXPECT_EQ(shape->leaf_depth, depth) << "Leaves at different depths.";
+            const leaf_node_t *leaf_node = reinterpret_cast<const leaf_node_t *>(node);
+            for (auto it = leaf::begin(*leaf_node); it != leaf::end(*leaf_node); ++it) {
+                const btree_key_t *key = (*it).first;
+                if (left_excl != NULL) {
+                    EXPECT_LT(btree_key_cmp(left_excl, key), 0);
+                }
+                if (right_incl != NULL) {
+                    EXPECT_LE(btree_key_cmp(key, right_incl), 0);
+                }
+                const uint8_t *value = static_cast<const uint8_t *>((*it).second);
+                shape->pairs.push_back(std::make_pair(
+                    key_to_string(key),
+                    std::string(reinterpret_cast<const char *>(value + 1), value[0])));
+            }
+            const char *bytes = static_cast<const char *>(read.get_data_read());
+            shape->leaves.push_back(
+                std::vector<char>(bytes, bytes + sizer->block_size().value()));
+            return;
+        }
+
+        const internal_node_t *internal = reinterpret_cast<const internal_node_t *>(node);
+        if (shape->internal_full.size() <= static_cast<size_t>(depth)) {
+            shape->internal_full.resize(depth + 1);
+        }
+        shape->internal_full[depth].push_back(internal_node::is_full(internal));
+        for (int i = 0; i < internal->npairs; ++i) {
+            const btree_internal_pair *pair = internal_node::get_pair_by_index(internal, i);
+            children.push_back(std::make_pair(pair->lnode, store_key_t(&pair->key)));
+        }
+    }
+
+    for (size_t i = 0; i < children.size(); ++i) {
+        const btree_key_t *child_left = i == 0
+            ? left_excl : children[i - 1].second.btree_key();
+        // The last child is bounded by whatever bounds this node.
+        const btree_key_t *child_right = i + 1 == children.size()
+            ? right_incl : children[i].second.btree_key();
+        walk_tree(sizer, buf_parent_t(&lock), children[i].first, depth + 1,
+                  child_left, child_right, shape);
+    }
+}
+
+void get_tree_shape(test_btree_t *tree, tree_shape_t *shape_out,
+                    int64_t *population_out) {
+    value_sizer_t<bulk_load_test_value_t> sizer(tree->cache->get_block_size());
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    get_btree_superblock_and_txn_for_reading(tree->cache_conn.get(),
+                                             CACHE_SNAPSHOTTED_NO,
+                                             &superblock, &txn);
+    {
+        buf_lock_t stat_block(buf_parent_t(txn.get()),
+                              superblock->get_stat_block_id(), access_t::read);
+        buf_read_t read(&stat_block);
+        *population_out = static_cast<const btree_statblock_t *>(
+            read.get_data_read())->population;
+    }
+    const block_id_t root_id = superblock->get_root_block_id();
+    ASSERT_NE(NULL_BLOCK_ID, root_id);
+    walk_tree(&sizer, superblock->expose_buf(), root_id, 0, NULL, NULL, shape_out);
+}
+
+void check_same_pairs(const tree_shape_t &shape) {
+    ASSERT_EQ(static_cast<size_t>(BULK_LOAD_TEST_NUM_KEYS), shape.pairs.size());
+    for (int i = 0; i < BULK_LOAD_TEST_NUM_KEYS; ++i) {
+        ASSERT_EQ(bulk_load_test_key(i), shape.pairs[i].first);
+        ASSERT_EQ(bulk_load_test_value(i), shape.pairs[i].second);
+    }
+}
+
+// Builds the same tree once by bulk loading and once by inserting the keys one at a
+// time, and checks that the bulk loaded tree has the same contents, is at most as
+// deep and as wide, and has every node but the right-most ones on each level full.
+TPTEST(BtreeBulkLoad, CompareToInserts) {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    test_btree_t bulk_tree(&io_backender);
+    test_btree_t insert_tree(&io_backender);
+    value_sizer_t<bulk_load_test_value_t> sizer(bulk_tree.cache->get_block_size());
+
+    // The bulk load is spread over several transactions.
+    btree_bulk_loader_t loader(&sizer);
+    for (int i = 0; i < BULK_LOAD_TEST_NUM_KEYS; i += BULK_LOAD_TEST_KEYS_PER_TXN) {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        get_btree_superblock_and_txn(bulk_tree.cache_conn.get(), write_access_t::write,
+                                     1, repli_timestamp_t::distant_past,
+                                     write_durability_t::SOFT, &superblock, &txn);
+        loader.begin(superblock.get());
+        for (int j = i; j < i + BULK_LOAD_TEST_KEYS_PER_TXN
+                 && j < BULK_LOAD_TEST_NUM_KEYS; ++j) {
+            store_key_t key(bulk_load_test_key(j));
+            scoped_malloc_t<bulk_load_test_value_t> value = make_bulk_load_test_value(j);
+            loader.add(key.btree_key(), value.get());
+        }
+        loader.end();
+    }
+    ASSERT_EQ(BULK_LOAD_TEST_NUM_KEYS, loader.keys_added());
+
+    btree_stats_t stats(&get_global_perfmon_collection(), "bulk_load_test");
+    for (int i = 0; i < BULK_LOAD_TEST_NUM_KEYS; ++i) {
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        get_btree_superblock_and_txn(insert_tree.cache_conn.get(),
+                                     write_access_t::write, 1,
+                                     repli_timestamp_t::distant_past,
+                                     write_durability_t::SOFT, &superblock, &txn);
+        store_key_t key(bulk_load_test_key(i));
+        keyvalue_location_t<bulk_load_test_value_t> kv_location;
+        find_keyvalue_location_for_write(superblock.get(), key.btree_key(),
+                                         &kv_location, &stats, NULL);
+        kv_location.value = make_bulk_load_test_value(i);
+        null_key_modification_callback_t<bulk_load_test_value_t> null_cb;
+        apply_keyvalue_change(&kv_location, key.btree_key(),
+                              repli_timestamp_t::distant_past, expired_t::NO,
+                              &null_cb);
+    }
+
+    tree_shape_t bulk_shape;
+    int64_t bulk_population;
+    get_tree_shape(&bulk_tree, &bulk_shape, &bulk_population);
+    tree_shape_t insert_shape;
+    int64_t insert_population;
+    get_tree_shape(&insert_tree, &insert_shape, &insert_population);
+
+    check_same_pairs(bulk_shape);
+    check_same_pairs(insert_shape);
+    EXPECT_EQ(BULK_LOAD_TEST_NUM_KEYS, bulk_population);
+    EXPECT_EQ(insert_population, bulk_population);
+
+    // Two levels of internal nodes make sure sealing got exercised.
+    ASSERT_EQ(2u, bulk_shape.internal_full.size());
+    ASSERT_LE(bulk_shape.leaf_depth, insert_shape.leaf_depth);
+    EXPECT_LT(bulk_shape.leaves.size(), insert_shape.leaves.size());
+    for (size_t level = 0; level < bulk_shape.internal_full.size(); ++level) {
+        const std::vector<bool> &full = bulk_shape.internal_full[level];
+        const size_t insert_level = level + insert_shape.internal_full.size()
+            - bulk_shape.internal_full.size();
+        EXPECT_LE(full.size(), insert_shape.internal_full[insert_level].size());
+        for (size_t i = 0; i + 1 < full.size(); ++i) {
+            EXPECT_TRUE(full[i]) << "level " << level << " node " << i;
+        }
+    }
+
+    // Every leaf but the last one is too full to take the first pair of the next.
+    size_t first_of_next = 0;
+    for (size_t i = 0; i + 1 < bulk_shape.leaves.size(); ++i) {
+        const leaf_node_t *leaf_node
+            = reinterpret_cast<const leaf_node_t *>(bulk_shape.leaves[i].data());
+        first_of_next += leaf_node->num_pairs;
+        ASSERT_LT(first_of_next, bulk_shape.pairs.size());
+        store_key_t key(bulk_shape.pairs[first_of_next].first);
+        scoped_malloc_t<bulk_load_test_value_t> value
+            = make_bulk_load_test_value(first_of_next);
+        EXPECT_TRUE(leaf::is_full(&sizer, leaf_node, key.btree_key(), value.get()))
+            << "leaf " << i;
+    }
+}
+
+}  // namespace unittest
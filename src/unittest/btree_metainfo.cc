@@ -53,7 +53,7 @@ TPTEST(BtreeMetainfo, MetainfoTest) {
         &file_opener,
         &get_global_perfmon_collection());
 
-    cache_t cache(&serializer, alt_cache_config_t(),
+    cache_t cache(&serializer, alt_cache_config_t(), NULL,
                   &get_global_perfmon_collection());
     cache_conn_t cache_conn(&cache);
 
@@ -28,7 +28,7 @@ TPTEST(BTreeSindex, LowLevelOps) {
         &file_opener,
         &get_global_perfmon_collection());
 
-    cache_t cache(&serializer, alt_cache_config_t(),
+    cache_t cache(&serializer, alt_cache_config_t(), NULL,
                   &get_global_perfmon_collection());
     cache_conn_t cache_conn(&cache);
 
@@ -120,6 +120,7 @@ TPTEST(BTreeSindex, BtreeStoreAPI) {
             &serializer,
             "unit_test_store",
             GIGABYTE,
+            NULL,
             true,
             &get_global_perfmon_collection(),
             NULL,
@@ -0,0 +1,101 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "buffer_cache/alt/cache_balancer.hpp"
+
+namespace unittest {
+
+static cache_balancer_demand_t make_demand(uint64_t min, uint64_t max, double weight) {
+    cache_balancer_demand_t d;
+    d.min_memory_limit = min;
+    d.max_memory_limit = max;
+    d.weight = weight;
+    return d;
+}
+
+TEST(CacheBalancerTest, ProportionalToWeight) {
+    std::vector<cache_balancer_demand_t> caches;
+    caches.push_back(make_demand(0, UINT64_MAX, 1));
+    caches.push_back(make_demand(0, UINT64_MAX, 3));
+    allocate_cache_memory(1000, &caches);
+    ASSERT_EQ(250u, caches[0].memory_limit);
+    ASSERT_EQ(750u, caches[1].memory_limit);
+}
+
+TEST(CacheBalancerTest, IdleCachesGetTheirMinimum) {
+    std::vector<cache_balancer_demand_t> caches;
+    caches.push_back(make_demand(100, UINT64_MAX, 0));
+    caches.push_back(make_demand(100, UINT64_MAX, 5));
+    allocate_cache_memory(1000, &caches);
+    ASSERT_EQ(100u, caches[0].memory_limit);
+    ASSERT_EQ(900u, caches[1].memory_limit);
+}
+
+TEST(CacheBalancerTest, AllIdleSplitsEvenly) {
+    std::vector<cache_balancer_demand_t> caches;
+    caches.push_back(make_demand(0, UINT64_MAX, 0));
+    caches.push_back(make_demand(0, UINT64_MAX, 0));
+    allocate_cache_memory(1000, &caches);
+    ASSERT_EQ(500u, caches[0].memory_limit);
+    ASSERT_EQ(500u, caches[1].memory_limit);
+}
+
+TEST(CacheBalancerTest, MaximumIsRespected) {
+    std::vector<cache_balancer_demand_t> caches;
+    caches.push_back(make_demand(0, 200, 10));
+    caches.push_back(make_demand(0, UINT64_MAX, 1));
+    caches.push_back(make_demand(0, UINT64_MAX, 1));
+    allocate_cache_memory(1000, &caches);
+    ASSERT_EQ(200u, caches[0].memory_limit);
+    ASSERT_EQ(400u, caches[1].memory_limit);
+    ASSERT_EQ(400u, caches[2].memory_limit);
+}
+
+TEST(CacheBalancerTest, MinimumsOverBudget) {
+    std::vector<cache_balancer_demand_t> caches;
+    caches.push_back(make_demand(600, UINT64_MAX, 1));
+    caches.push_back(make_demand(600, UINT64_MAX, 1));
+    allocate_cache_memory(1000, &caches);
+    ASSERT_EQ(600u, caches[0].memory_limit);
+    ASSERT_EQ(600u, caches[1].memory_limit);
+}
+
+TEST(CacheBalancerTest, NeverOverBudget) {
+    std::vector<cache_balancer_demand_t> caches;
+    caches.push_back(make_demand(10, 300, 7));
+    caches.push_back(make_demand(20, UINT64_MAX, 3));
+    caches.push_back(make_demand(0, 50, 11));
+    caches.push_back(make_demand(5, UINT64_MAX, 0));
+    allocate_cache_memory(12345, &caches);
+    uint64_t total = 0;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        ASSERT_LE(caches[i].min_memory_limit, caches[i].memory_limit);
+        ASSERT_LE(caches[i].memory_limit, caches[i].max_memory_limit);
+        total += caches[i].memory_limit;
+    }
+    ASSERT_LE(total, 12345u);
+    ASSERT_GE(total, 12345u - caches.size());
+}
+
+TEST(CacheBalancerTest, BoundsFromPercentages) {
+    cache_balancer_bounds_t bounds;
+    uint64_t min, max;
+
+    // By default a cache may shrink to a quarter and grow without limit.
+    bounds.memory_limits_for(1000, &min, &max);
+    ASSERT_EQ(250u, min);
+    ASSERT_EQ(UINT64_MAX, max);
+
+    bounds.min_percent = 50;
+    bounds.max_percent = 200;
+    bounds.memory_limits_for(1001, &min, &max);
+    ASSERT_EQ(500u, min);
+    ASSERT_EQ(2002u, max);
+
+    // Huge limits don't overflow.
+    bounds.memory_limits_for(UINT64_MAX / 2, &min, &max);
+    ASSERT_LE(min, UINT64_MAX / 4 + 1);
+    ASSERT_GE(max, UINT64_MAX - 200);
+}
+
+}  // namespace unittest
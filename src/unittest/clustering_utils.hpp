@@ -50,7 +50,7 @@ class test_store_t {
 public:
     test_store_t(io_backender_t *io_backender, order_source_t *order_source, typename protocol_t::context_t *ctx) :
             serializer(create_and_construct_serializer(&temp_file, io_backender)),
-            store(serializer.get(), temp_file.name().permanent_path(), GIGABYTE,
+            store(serializer.get(), temp_file.name().permanent_path(), GIGABYTE, NULL,
                     true, &get_global_perfmon_collection(), ctx, io_backender, base_path_t(".")) {
         /* Initialize store metadata */
         cond_t non_interruptor;
@@ -1,6 +1,9 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "arch/runtime/context_switching.hpp"
 
+#include <string.h>
+#include <unistd.h>
+
 #include <stdexcept>
 
 #include "containers/scoped.hpp"
@@ -17,7 +20,8 @@ TEST(ContextSwitchingTest, ContextRefSemantics) {
 }
 
 TEST(ContextSwitchingTest, CreateArtificialStack) {
-    coro_stack_t a(&noop, 1024*1024);
+    artificial_stack_allocator_t allocator;
+    coro_stack_t a(&noop, 1024*1024, &allocator);
     EXPECT_FALSE(a.context.is_nil());
 }
 
@@ -46,8 +50,9 @@ TEST(ContextSwitchingTest, SwitchToContextRepeatedly) {
     original_context = orig_context_local.get();
 
     test_int = 5;
+    artificial_stack_allocator_t allocator;
     {
-        coro_stack_t a(&switch_context_test, 1024*1024);
+        coro_stack_t a(&switch_context_test, 1024*1024, &allocator);
         artificial_stack_1_context = &a.context;
 
         /* `context_switch` will cause `switch_context_test` to be run, which
@@ -77,9 +82,10 @@ TEST(ContextSwitchingTest, SwitchBetweenContexts) {
     scoped_ptr_t<coro_context_ref_t> orig_context_local(new coro_context_ref_t);
     original_context = orig_context_local.get();
     test_int = 99;
+    artificial_stack_allocator_t allocator;
     {
-        coro_stack_t a1(&first_switch, 1024*1024);
-        coro_stack_t a2(&second_switch, 1024*1024);
+        coro_stack_t a1(&first_switch, 1024*1024, &allocator);
+        coro_stack_t a2(&second_switch, 1024*1024, &allocator);
         artificial_stack_1_context = &a1.context;
         artificial_stack_2_context = &a2.context;
 
@@ -94,12 +100,47 @@ __attribute__((noreturn)) static void throw_an_exception() {
 }
 
 __attribute__((noreturn)) static void throw_exception_from_coroutine() {
-    coro_stack_t artificial_stack(&throw_an_exception, 1024*1024);
+    artificial_stack_allocator_t allocator;
+    coro_stack_t artificial_stack(&throw_an_exception, 1024*1024, &allocator);
     coro_context_ref_t _original_context;
     context_switch(&_original_context, &artificial_stack.context);
     unreachable();
 }
 
+TEST(ContextSwitchingTest, StackAllocatorReusesStacks) {
+    const size_t page_size = getpagesize();
+    artificial_stack_allocator_t allocator;
+    void *small = allocator.allocate(8 * page_size);
+    void *large = allocator.allocate(64 * page_size);
+    EXPECT_EQ(72 * page_size, allocator.bytes_in_use());
+
+    // Stacks of the same size are carved out of the same region.
+    void *small2 = allocator.allocate(8 * page_size);
+    EXPECT_EQ(static_cast<char *>(small) + 8 * page_size, small2);
+
+    // Everything above the guard page is usable, and a released stack is handed
+    // out again.
+    memset(static_cast<char *>(small) + page_size, 0xab, 7 * page_size);
+    allocator.release(small, 8 * page_size);
+    EXPECT_EQ(small, allocator.allocate(8 * page_size));
+
+    allocator.release(small, 8 * page_size);
+    allocator.release(small2, 8 * page_size);
+    allocator.release(large, 64 * page_size);
+    EXPECT_EQ(0u, allocator.bytes_in_use());
+}
+
+static void overflow_guard_page() {
+    const size_t page_size = getpagesize();
+    artificial_stack_allocator_t allocator;
+    char *stack = static_cast<char *>(allocator.allocate(8 * page_size));
+    stack[page_size - 1] = 1;
+}
+
+TEST(ContextSwitchingTest, StackGuardPage) {
+    EXPECT_DEATH(overflow_guard_page(), "");
+}
+
 TEST(ContextSwitchingTest, UncaughtException) {
     EXPECT_DEATH(throw_exception_from_coroutine(), "This is a test exception");
 }
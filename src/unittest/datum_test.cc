@@ -1,6 +1,8 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
+#include "containers/archive/stl_types.hpp"
 #include "containers/archive/string_stream.hpp"
+#include "http/json.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "unittest/gtest.hpp"
 
@@ -63,5 +65,199 @@ TEST(DatumTest, NumericSerialization) {
 }
 
 
+TEST(DatumTest, ObjectFields) {
+    ql::datum_object_t obj;
+    const char *keys[] = { "m", "b", "z", "a", "q" };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+        ASSERT_FALSE(obj.set(keys[i], make_counted<const ql::datum_t>(static_cast<double>(i)),
+                             ql::NOCLOBBER));
+    }
+    ASSERT_EQ(5u, obj.size());
+
+    // Iteration is in key order, like `std::map`.
+    std::string order;
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        order += it->first;
+    }
+    ASSERT_EQ("abmqz", order);
+
+    ASSERT_EQ(1u, obj.count("q"));
+    ASSERT_EQ(0u, obj.count("c"));
+    ASSERT_TRUE(obj.find("c") == obj.end());
+    ASSERT_EQ(4.0, obj.find("q")->second->as_num());
+
+    ASSERT_TRUE(obj.set("q", make_counted<const ql::datum_t>(10.0), ql::NOCLOBBER));
+    ASSERT_EQ(4.0, obj.find("q")->second->as_num());
+    ASSERT_TRUE(obj.set("q", make_counted<const ql::datum_t>(10.0), ql::CLOBBER));
+    ASSERT_EQ(10.0, obj.find("q")->second->as_num());
+
+    ASSERT_TRUE(obj.erase("b"));
+    ASSERT_FALSE(obj.erase("b"));
+    ASSERT_EQ(4u, obj.size());
+
+    ASSERT_FALSE(obj.append("zz", make_counted<const ql::datum_t>(1.0)));
+    ASSERT_FALSE(obj.append("c", make_counted<const ql::datum_t>(2.0)));
+    ASSERT_TRUE(obj.append("c", make_counted<const ql::datum_t>(3.0)));
+    ASSERT_EQ(2.0, obj.find("c")->second->as_num());
+    order.clear();
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        order += it->first;
+    }
+    ASSERT_EQ("acmqzzz", order);
+}
+
+TEST(DatumTest, ObjectUnsortedAppend) {
+    ql::datum_object_t obj;
+    const char *keys[] = { "m", "b", "z", "a", "q" };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+        obj.append_unsorted(keys[i], make_counted<const ql::datum_t>(static_cast<double>(i)));
+    }
+    std::string duplicate;
+    ASSERT_TRUE(obj.sort_appended(&duplicate));
+    std::string order;
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        order += it->first;
+    }
+    ASSERT_EQ("abmqz", order);
+    ASSERT_EQ(2.0, obj.find("z")->second->as_num());
+
+    obj.append_unsorted("c", make_counted<const ql::datum_t>(5.0));
+    obj.append_unsorted("q", make_counted<const ql::datum_t>(6.0));
+    ASSERT_FALSE(obj.sort_appended(&duplicate));
+    ASSERT_EQ("q", duplicate);
+}
+
+TEST(DatumTest, JsonObjects) {
+    scoped_cJSON_t json(cJSON_Parse("{\"m\": 1, \"b\": 2, \"z\": {\"y\": 3, \"x\": 4}}"));
+    counted_t<const ql::datum_t> datum = make_counted<const ql::datum_t>(json);
+    std::string order;
+    for (auto it = datum->as_object().begin(); it != datum->as_object().end(); ++it) {
+        order += it->first;
+    }
+    ASSERT_EQ("bmz", order);
+    ASSERT_EQ(4.0, datum->get("z")->get("x")->as_num());
+
+    scoped_cJSON_t dup_json(cJSON_Parse("{\"a\": 1, \"b\": 2, \"a\": 3}"));
+    try {
+        make_counted<const ql::datum_t>(dup_json);
+        FAIL() << "Parsing a JSON object with a duplicate key should fail.";
+    } catch (const ql::base_exc_t &e) {
+        ASSERT_NE(std::string::npos, std::string(e.what()).find("Duplicate key `a`"));
+    }
+}
+
+TEST(DatumTest, ObjectSerialization) {
+    std::map<std::string, counted_t<const ql::datum_t> > map;
+    for (int i = 0; i < 50; ++i) {
+        map[strprintf("field%d", i)] = make_counted<const ql::datum_t>(static_cast<double>(i));
+    }
+    map["nested"] = make_counted<const ql::datum_t>(
+        std::map<std::string, counted_t<const ql::datum_t> >(map));
+
+    // Objects are serialized in the same format as the `std::map` they used to be,
+    // so data that's already on disk still reads.
+    string_stream_t map_stream;
+    {
+        write_message_t wm;
+        wm << map;
+        ASSERT_EQ(0, send_write_message(&map_stream, &wm));
+    }
+    counted_t<const ql::datum_t> datum
+        = make_counted<const ql::datum_t>(std::move(map));
+    string_stream_t obj_stream;
+    {
+        write_message_t wm;
+        wm << datum->as_object();
+        ASSERT_EQ(0, send_write_message(&obj_stream, &wm));
+    }
+    ASSERT_EQ(map_stream.str(), obj_stream.str());
+    ASSERT_EQ(obj_stream.str().size(), serialized_size(datum->as_object()));
+
+    test_datum_serialization(datum);
+}
+
+TEST(DatumTest, IndexedObjectSerialization) {
+    std::map<std::string, counted_t<const ql::datum_t> > map;
+    for (int i = 0; i < 50; ++i) {
+        map[strprintf("field%d", i)] = make_counted<const ql::datum_t>(
+            std::string(i, 'x'));
+    }
+    map["nested"] = make_counted<const ql::datum_t>(
+        std::map<std::string, counted_t<const ql::datum_t> >(map));
+    counted_t<const ql::datum_t> datum
+        = make_counted<const ql::datum_t>(std::move(map));
+
+    write_message_t wm;
+    ql::serialize_for_storage(&wm, datum);
+    string_stream_t stream;
+    ASSERT_EQ(0, send_write_message(&stream, &wm));
+    const std::string serialized = stream.str();
+
+    // The general deserialization reads the indexed format.
+    {
+        string_read_stream_t read_stream(std::string(serialized), 0);
+        counted_t<const ql::datum_t> deserialized_datum;
+        ASSERT_EQ(archive_result_t::SUCCESS, deserialize(&read_stream, &deserialized_datum));
+        ASSERT_EQ(*datum, *deserialized_datum);
+    }
+
+    // Read single values by going through the table, like `get_data_fields` does.
+    uint32_t table_size;
+    {
+        string_read_stream_t read_stream(
+            serialized.substr(0, ql::indexed_object_header_size), 0);
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  ql::deserialize_indexed_object_header(&read_stream, &table_size));
+        ASSERT_LT(0u, table_size);
+    }
+    std::vector<ql::indexed_object_entry_t> entries;
+    {
+        string_read_stream_t read_stream(
+            serialized.substr(ql::indexed_object_header_size, table_size), 0);
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  ql::deserialize_indexed_object_table(&read_stream, &entries));
+    }
+    ASSERT_EQ(datum->as_object().size(), entries.size());
+    const size_t values_offset = ql::indexed_object_header_size + table_size;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        string_read_stream_t read_stream(
+            serialized.substr(values_offset + it->offset, it->size), 0);
+        counted_t<const ql::datum_t> val;
+        ASSERT_EQ(archive_result_t::SUCCESS, deserialize(&read_stream, &val));
+        ASSERT_EQ(*datum->get(it->key), *val);
+    }
+    ASSERT_EQ(serialized.size(),
+              values_offset + entries.back().offset + entries.back().size);
+}
+
+TEST(DatumTest, SmallObjectsAreNotIndexed) {
+    std::map<std::string, counted_t<const ql::datum_t> > map;
+    map["id"] = make_counted<const ql::datum_t>(1.0);
+    counted_t<const ql::datum_t> datum
+        = make_counted<const ql::datum_t>(std::move(map));
+    counted_t<const ql::datum_t> datums[] = {
+        datum,
+        make_counted<const ql::datum_t>(std::string(1000, 'x')),
+    };
+
+    for (size_t i = 0; i < sizeof(datums) / sizeof(datums[0]); ++i) {
+        write_message_t storage_wm;
+        ql::serialize_for_storage(&storage_wm, datums[i]);
+        string_stream_t storage_stream;
+        ASSERT_EQ(0, send_write_message(&storage_stream, &storage_wm));
+
+        write_message_t wm;
+        wm << datums[i];
+        string_stream_t stream;
+        ASSERT_EQ(0, send_write_message(&stream, &wm));
+        ASSERT_EQ(stream.str(), storage_stream.str());
+
+        string_read_stream_t read_stream(std::move(stream.str()), 0);
+        uint32_t table_size;
+        ASSERT_EQ(archive_result_t::SUCCESS,
+                  ql::deserialize_indexed_object_header(&read_stream, &table_size));
+        ASSERT_EQ(0u, table_size);
+    }
+}
 
 }  // namespace unittest
@@ -1,3 +1,4 @@
+#include "config/args.hpp"
 #include "serializer/log/data_block_manager.hpp"
 #include "unittest/gtest.hpp"
 
@@ -48,6 +49,25 @@ TEST(DBMTest, ReadAheadInterval) {
     ASSERT_EQ(100, end_offset);
 }
 
+TEST(DBMTest, GCPacingRate) {
+    // No GC below the low ratio.
+    ASSERT_EQ(0.0, compute_gc_pacing_rate(0.0, 0.15, 0.20));
+    ASSERT_EQ(0.0, compute_gc_pacing_rate(0.15, 0.15, 0.20));
 
+    // Just above the low ratio, we copy as much as we need to keep up.
+    const double barely = compute_gc_pacing_rate(0.150001, 0.15, 0.20);
+    ASSERT_NEAR(0.85 / 0.15, barely, 0.01);
+
+    // The rate goes up towards the high ratio...
+    const double halfway = compute_gc_pacing_rate(0.175, 0.15, 0.20);
+    ASSERT_LT(barely, halfway);
+    const double high = compute_gc_pacing_rate(0.20, 0.15, 0.20);
+    ASSERT_LT(halfway, high);
+    ASSERT_NEAR(0.8 / 0.2 * GC_PACING_MAX_URGENCY, high, 0.01);
+
+    // ... and doesn't grow any faster above it.
+    ASSERT_NEAR(0.7 / 0.3 * GC_PACING_MAX_URGENCY,
+                compute_gc_pacing_rate(0.30, 0.15, 0.20), 0.01);
+}
 
 }  // namespace unittest
@@ -1,4 +1,5 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <algorithm>
 #include <queue>
 
 #include "arch/io/disk.hpp"
@@ -6,6 +7,7 @@
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/queue/disk_backed_queue_wrapper.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "containers/cache_backed_queue.hpp"
 #include "containers/disk_backed_queue.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "unittest/gtest.hpp"
@@ -97,4 +99,61 @@ TEST(DiskBackedQueue, Concurrent) {
     unittest::run_in_thread_pool(&run_concurrent_test, 1);
 }
 
+class discarding_viewer_t : public buffer_group_viewer_t {
+public:
+    discarding_viewer_t() : bytes_seen(0) { }
+    void view_buffer_group(const const_buffer_group_t *group) {
+        bytes_seen += group->get_size();
+    }
+    int64_t bytes_seen;
+};
+
+template <class queue_t>
+void benchmark_queue(const char *name, size_t value_size, int num_values, int batch_size) {
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    queue_t queue(&io_backender, dbq_serializer_path(), &get_global_perfmon_collection());
+
+    const std::string value(value_size, 'v');
+    discarding_viewer_t viewer;
+
+    // Push `batch_size` values, then pop them all, the way a listener's write
+    // queue fills up during a backfill and is drained afterwards.
+    ticks_t start = get_ticks();
+    for (int i = 0; i < num_values; i += batch_size) {
+        // The last batch may be a short one.
+        const int this_batch = std::min(batch_size, num_values - i);
+        for (int j = 0; j < this_batch; ++j) {
+            write_message_t wm;
+            wm << value;
+            queue.push(wm);
+        }
+        for (int j = 0; j < this_batch; ++j) {
+            queue.pop(&viewer);
+        }
+    }
+    double secs = ticks_to_secs(get_ticks() - start);
+    ASSERT_TRUE(queue.empty());
+    ASSERT_EQ(static_cast<int64_t>(num_values) * serialized_size(value), viewer.bytes_seen);
+    printf("%s, %zu byte values, batches of %d: %.0f values/sec, %.1f MB/sec\n",
+           name, value_size, batch_size, num_values / secs,
+           viewer.bytes_seen / (secs * MEGABYTE));
+}
+
+void run_queue_benchmarks() {
+    const size_t value_sizes[] = { 100, 4 * KILOBYTE, 64 * KILOBYTE };
+    for (size_t i = 0; i < sizeof(value_sizes) / sizeof(value_sizes[0]); ++i) {
+        const int num_values = 64 * MEGABYTE / value_sizes[i];
+        for (int batch_size = 1; batch_size <= num_values; batch_size *= 64) {
+            benchmark_queue<internal_cache_backed_queue_t>(
+                "cache-backed", value_sizes[i], num_values, batch_size);
+            benchmark_queue<internal_disk_backed_queue_t>(
+                "segment log ", value_sizes[i], num_values, batch_size);
+        }
+    }
+}
+
+TEST(DiskBackedQueue, DISABLED_Benchmark) {
+    unittest::run_in_thread_pool(&run_queue_benchmarks, 1);
+}
+
 } //namespace unittest
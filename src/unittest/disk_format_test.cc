@@ -1,5 +1,6 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "math.hpp"
+#include "serializer/log/lba/checkpoint.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 #include "serializer/log/log_serializer.hpp"
 
@@ -40,6 +41,7 @@ TEST(DiskFormatTest, FlaggedOff64T) {
 TEST(DiskFormatTest, LbaShardMetablockT) {
     EXPECT_EQ(0u, offsetof(lba_shard_metablock_t, last_lba_extent_offset));
     EXPECT_EQ(8u, offsetof(lba_shard_metablock_t, last_lba_extent_entries_count));
+    EXPECT_EQ(12u, offsetof(lba_shard_metablock_t, checkpoint_extent_index));
     EXPECT_EQ(16u, offsetof(lba_shard_metablock_t, lba_superblock_offset));
     EXPECT_EQ(24u, offsetof(lba_shard_metablock_t, lba_superblock_entries_count));
     EXPECT_EQ(32u, sizeof(lba_shard_metablock_t));
@@ -56,6 +58,8 @@ TEST(DiskFormatTest, LbaMetablockMixinT) {
 
 TEST(DiskFormatTest, LbaEntryT) {
     EXPECT_EQ(0u, offsetof(lba_entry_t, block_id));
+    EXPECT_EQ(8u, offsetof(lba_entry_t, ser_block_size));
+    EXPECT_EQ(12u, offsetof(lba_entry_t, uncompressed_ser_block_size));
     EXPECT_EQ(16u, offsetof(lba_entry_t, recency));
     EXPECT_EQ(24u, offsetof(lba_entry_t, offset));
     EXPECT_EQ(32u, sizeof(lba_entry_t));
@@ -66,11 +70,11 @@ TEST(DiskFormatTest, LbaEntryT) {
     ASSERT_TRUE(lba_entry_t::is_padding(&ent));
     flagged_off64_t real = flagged_off64_t::unused();
     real = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 0);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
     flagged_off64_t deleteblock = flagged_off64_t::unused();
     deleteblock = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234, 4096);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
 }
 
@@ -95,6 +99,34 @@ TEST(DiskFormatTest, LbaSuperblockT) {
     EXPECT_EQ(16u, offsetof(lba_superblock_t, entries));
 }
 
+TEST(DiskFormatTest, LbaCheckpointT) {
+    EXPECT_EQ(0u, offsetof(lba_checkpoint_entry_t, offset));
+    EXPECT_EQ(8u, offsetof(lba_checkpoint_entry_t, recency));
+    EXPECT_EQ(16u, offsetof(lba_checkpoint_entry_t, ser_block_size));
+    EXPECT_EQ(20u, offsetof(lba_checkpoint_entry_t, uncompressed_ser_block_size));
+    EXPECT_EQ(24u, sizeof(lba_checkpoint_entry_t));
+
+    EXPECT_EQ(8, LBA_CHECKPOINT_MAGIC_SIZE);
+    EXPECT_EQ(0u, offsetof(lba_checkpoint_header_t, magic));
+    EXPECT_EQ(8u, offsetof(lba_checkpoint_header_t, replay_extent_offset));
+    EXPECT_EQ(16u, offsetof(lba_checkpoint_header_t, replay_extent_entries_count));
+    EXPECT_EQ(24u, offsetof(lba_checkpoint_header_t, entries_count));
+    EXPECT_EQ(32u, offsetof(lba_checkpoint_header_t, extents_count));
+    EXPECT_EQ(40u, offsetof(lba_checkpoint_header_t, extent_offsets));
+
+    // The header takes up the first device block of the first extent.
+    const uint64_t extent_size = DEFAULT_EXTENT_SIZE;
+    const int64_t per_extent = extent_size / sizeof(lba_checkpoint_entry_t);
+    const int64_t in_first_extent = (extent_size - DEVICE_BLOCK_SIZE) / sizeof(lba_checkpoint_entry_t);
+    EXPECT_EQ(in_first_extent, lba_checkpoint_t::entries_in_extent(extent_size, 1, 0));
+    EXPECT_EQ(per_extent, lba_checkpoint_t::entries_in_extent(extent_size, 3, 2));
+    EXPECT_EQ(1, lba_checkpoint_t::extents_needed(extent_size, 0));
+    EXPECT_EQ(1, lba_checkpoint_t::extents_needed(extent_size, in_first_extent));
+    EXPECT_EQ(2, lba_checkpoint_t::extents_needed(extent_size, in_first_extent + 1));
+    EXPECT_EQ(3, lba_checkpoint_t::extents_needed(extent_size,
+                                                  in_first_extent + per_extent + 1));
+}
+
 TEST(DiskFormatTest, DataBlockManagerMetablockMixinT) {
     EXPECT_EQ(0u, offsetof(data_block_manager::metablock_mixin_t, active_extent));
     EXPECT_EQ(8u, sizeof(data_block_manager::metablock_mixin_t));
@@ -0,0 +1,59 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "containers/external_sorter.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+void run_sort_test(int num_items, size_t memory_limit, size_t expected_min_runs) {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    external_sorter_t<int> sorter(&io_backender, base_path_t("."),
+                                  "test_external_sorter",
+                                  &get_global_perfmon_collection(), memory_limit);
+    rng_t rng;
+    std::vector<int> expected;
+    for (int i = 0; i < num_items; ++i) {
+        const int x = rng.randint(num_items / 2);
+        expected.push_back(x);
+        sorter.push(int(x), sizeof(int));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    sorter.finish();
+    EXPECT_LE(expected_min_runs, sorter.num_runs());
+    EXPECT_GE(static_cast<size_t>(EXTERNAL_SORTER_MAX_MERGE_FAN_IN),
+              sorter.num_open_runs());
+
+    std::vector<int> sorted;
+    int x;
+    while (sorter.next(&x)) {
+        sorted.push_back(x);
+    }
+    EXPECT_EQ(expected, sorted);
+}
+
+TPTEST(ExternalSorter, InMemory) {
+    run_sort_test(1000, MEGABYTE, 0);
+}
+
+TPTEST(ExternalSorter, ManyRuns) {
+    // Runs of 500 items, with the last 100 items staying in memory.
+    run_sort_test(10100, 500 * sizeof(int), 20);
+}
+
+TPTEST(ExternalSorter, MultiPassMerge) {
+    // 2000 runs of 10 items, which takes more than one level of merges.
+    run_sort_test(20000, 10 * sizeof(int), 2000);
+}
+
+TPTEST(ExternalSorter, Empty) {
+    run_sort_test(0, MEGABYTE, 0);
+}
+
+}  // namespace unittest
@@ -1,8 +1,12 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/administration/metadata.hpp"
+#include "concurrency/watchable.hpp"
 #include "containers/archive/archive.hpp"
 #include "extproc/extproc_pool.hpp"
 #include "extproc/extproc_spawner.hpp"
 #include "extproc/js_runner.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rpc/serialize_macros.hpp"
 #include "unittest/extproc_test.hpp"
 #include "unittest/gtest.hpp"
@@ -111,6 +115,148 @@ SPAWNER_TEST(JSProc, EvalAndCall) {
     ASSERT_EQ((*res_datum)->as_int(), 10337);
 }
 
+SPAWNER_TEST(JSProc, CallBatch) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+
+    js_runner.begin(&extproc_pool, NULL);
+
+    const std::string source_code = "(function (x) { if (x < 0) { throw 'negative'; } return x * 2; })";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 10000;
+
+    std::vector<std::vector<counted_t<const ql::datum_t> > > args_batch;
+    for (int i = 0; i < 100; ++i) {
+        args_batch.push_back(std::vector<counted_t<const ql::datum_t> >(
+            1, make_counted<const ql::datum_t>(static_cast<double>(i == 50 ? -1 : i))));
+    }
+
+    std::vector<js_result_t> results = js_runner.call_batch(source_code, args_batch, config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(args_batch.size(), results.size());
+
+    // An error in one call is reported for that element only
+    for (int i = 0; i < 100; ++i) {
+        if (i == 50) {
+            std::string *error = boost::get<std::string>(&results[i]);
+            ASSERT_TRUE(error != NULL);
+        } else {
+            counted_t<const ql::datum_t> *res_datum =
+                boost::get<counted_t<const ql::datum_t> >(&results[i]);
+            ASSERT_TRUE(res_datum != NULL);
+            ASSERT_EQ((*res_datum)->as_int(), i * 2);
+        }
+    }
+
+    // The function id stays cached, so single calls still work afterwards
+    js_result_t result = js_runner.call(source_code, args_batch[1], config);
+    counted_t<const ql::datum_t> *res_datum =
+        boost::get<counted_t<const ql::datum_t> >(&result);
+    ASSERT_TRUE(res_datum != NULL);
+    ASSERT_EQ((*res_datum)->as_int(), 2);
+}
+
+SPAWNER_TEST(JSProc, CallBatchOnHelpers) {
+    // Every job may use two helper workers besides its own, so a big enough
+    // batch gets split into three slices that are evaluated in parallel.
+    extproc_pool_t extproc_pool(1, 3);
+    cond_t interruptor;
+    ql::env_t env(&extproc_pool, NULL,
+                  clone_ptr_t<watchable_t<cow_ptr_t<ql::env_t::ns_metadata_t> > >(),
+                  clone_ptr_t<watchable_t<databases_semilattice_metadata_t> >(),
+                  boost::shared_ptr<semilattice_readwrite_view_t<
+                      cluster_semilattice_metadata_t> >(),
+                  NULL, &interruptor, uuid_u(), profile_bool_t::DONT_PROFILE);
+
+    ql::js_func_t func("(function (x) { return x * 2; })", 10000,
+                       ql::make_counted_backtrace());
+
+    // The second batch runs on the helpers that the first one started.
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::vector<counted_t<const ql::datum_t> > > args_batch;
+        for (int i = 0; i < 100; ++i) {
+            args_batch.push_back(std::vector<counted_t<const ql::datum_t> >(
+                1, make_counted<const ql::datum_t>(static_cast<double>(i))));
+        }
+
+        std::vector<counted_t<ql::val_t> > results = func.call_batch(&env, args_batch);
+
+        // The slices' results come back in the order of the batch.
+        ASSERT_EQ(args_batch.size(), results.size());
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_EQ(i * 2, results[i]->as_datum()->as_int());
+        }
+    }
+}
+
+SPAWNER_TEST(JSProc, CallBatchErrorBeforeTimeout) {
+    extproc_pool_t extproc_pool(1, 3);
+    cond_t interruptor;
+    ql::env_t env(&extproc_pool, NULL,
+                  clone_ptr_t<watchable_t<cow_ptr_t<ql::env_t::ns_metadata_t> > >(),
+                  clone_ptr_t<watchable_t<databases_semilattice_metadata_t> >(),
+                  boost::shared_ptr<semilattice_readwrite_view_t<
+                      cluster_semilattice_metadata_t> >(),
+                  NULL, &interruptor, uuid_u(), profile_bool_t::DONT_PROFILE);
+
+    // Row 10 is in the first slice and row 50 in the second one.
+    ql::js_func_t func("(function (x) {"
+                       "  if (x == 10) { throw 'row ten'; }"
+                       "  while (x == 50) { }"
+                       "  return x;"
+                       "})", 500, ql::make_counted_backtrace());
+
+    std::vector<std::vector<counted_t<const ql::datum_t> > > args_batch;
+    for (int i = 0; i < 100; ++i) {
+        args_batch.push_back(std::vector<counted_t<const ql::datum_t> >(
+            1, make_counted<const ql::datum_t>(static_cast<double>(i))));
+    }
+
+    // Had the rows run one at a time, row 10 would have failed before row 50
+    // could time out.
+    try {
+        func.call_batch(&env, args_batch);
+        FAIL() << "The batch should fail.";
+    } catch (const ql::base_exc_t &e) {
+        ASSERT_NE(std::string::npos, std::string(e.what()).find("row ten"));
+    }
+}
+
+SPAWNER_TEST(JSProc, CallBatchTimeout) {
+    extproc_pool_t extproc_pool(1);
+    js_runner_t js_runner;
+
+    js_runner.begin(&extproc_pool, NULL);
+
+    // Spins for `ms` milliseconds, or forever if `ms` is negative
+    const std::string source_code =
+        "(function (ms) {"
+        "  var end = new Date().getTime() + ms;"
+        "  while (ms < 0 || new Date().getTime() < end) { }"
+        "  return ms;"
+        "})";
+
+    js_runner_t::req_config_t config;
+    config.timeout_ms = 500;
+
+    // The batch as a whole takes longer than the timeout, but no single call does
+    std::vector<std::vector<counted_t<const ql::datum_t> > > args_batch;
+    for (int i = 0; i < 4; ++i) {
+        args_batch.push_back(std::vector<counted_t<const ql::datum_t> >(
+            1, make_counted<const ql::datum_t>(200.0)));
+    }
+    std::vector<js_result_t> results = js_runner.call_batch(source_code, args_batch, config);
+    ASSERT_TRUE(js_runner.connected());
+    ASSERT_EQ(args_batch.size(), results.size());
+
+    // One call that never returns times out the batch, however short the others
+    args_batch[2][0] = make_counted<const ql::datum_t>(-1.0);
+    ASSERT_THROW(js_runner.call_batch(source_code, args_batch, config),
+                 interrupted_exc_t);
+    ASSERT_FALSE(js_runner.connected());
+}
+
 SPAWNER_TEST(JSProc, BrokenFunction) {
     extproc_pool_t extproc_pool(1);
     js_runner_t js_runner;
@@ -1,10 +1,12 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include <map>
 
+#include "btree/key_search_index.hpp"
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
 #include "containers/scoped.hpp"
 #include "repli_timestamp.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 #include "utils.hpp"
 
@@ -618,4 +620,141 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+std::string random_uuid_key(rng_t *rng) {
+    const char *hex = "0123456789abcdef";
+    std::string res;
+    for (int i = 0; i < 32; ++i) {
+        if (i == 8 || i == 12 || i == 16 || i == 20) {
+            res.push_back('-');
+        }
+        res.push_back(hex[rng->randint(16)]);
+    }
+    return res;
+}
+
+// Looks like a secondary index key: a shared secondary value, then the primary key.
+std::string random_compound_key(rng_t *rng) {
+    return strprintf("Scustomer_%d", rng->randint(3)) + std::string(1, '\0')
+        + random_uuid_key(rng);
+}
+
+// Fills `tracker` with keys from `make_key` until it's full.
+void fill_leaf(LeafNodeTracker *tracker, rng_t *rng,
+               std::string (*make_key)(rng_t *)) {
+    for (;;) {
+        store_key_t key(make_key(rng));
+        if (!tracker->ShouldHave(key) && !tracker->Insert(key, "v")) {
+            break;
+        }
+    }
+}
+
+void check_key_search_index(LeafNodeTracker *tracker, rng_t *rng,
+                            std::string (*make_key)(rng_t *)) {
+    key_search_index_t index;
+    leaf::build_key_search_index(tracker->node(), &index);
+    ASSERT_EQ(tracker->node()->num_pairs, index.num_keys());
+
+    std::vector<store_key_t> probes;
+    for (auto it = tracker->kv_.begin(); it != tracker->kv_.end(); ++it) {
+        probes.push_back(it->first);
+        // Keys just before and after the node's keys.
+        store_key_t shorter = it->first;
+        shorter.set_size(shorter.size() - 1);
+        probes.push_back(shorter);
+        store_key_t longer = it->first;
+        longer.set_size(longer.size() + 1);
+        longer.contents()[longer.size() - 1] = 0;
+        probes.push_back(longer);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        probes.push_back(store_key_t(make_key(rng)));
+    }
+    probes.push_back(store_key_t());
+    probes.push_back(store_key_t::max());
+
+    for (auto it = probes.begin(); it != probes.end(); ++it) {
+        int expected_index;
+        bool expected_found
+            = leaf::find_key(tracker->node(), it->btree_key(), &expected_index);
+        int index_out;
+        bool found
+            = leaf::find_key(tracker->node(), it->btree_key(), &index, &index_out);
+        ASSERT_EQ(expected_found, found);
+        ASSERT_EQ(expected_index, index_out);
+    }
+}
+
+TEST(LeafNodeTest, KeySearchIndexUuidKeys) {
+    rng_t rng(0);
+    LeafNodeTracker tracker;
+    fill_leaf(&tracker, &rng, random_uuid_key);
+    check_key_search_index(&tracker, &rng, random_uuid_key);
+}
+
+TEST(LeafNodeTest, KeySearchIndexCompoundKeys) {
+    rng_t rng(0);
+    LeafNodeTracker tracker;
+    fill_leaf(&tracker, &rng, random_compound_key);
+    check_key_search_index(&tracker, &rng, random_compound_key);
+}
+
+TEST(LeafNodeTest, KeySearchIndexSharedPrefix) {
+    // Every key shares a long prefix, and some differ only past the index's window.
+    rng_t rng(0);
+    LeafNodeTracker tracker;
+    for (int i = 0; i < 40; ++i) {
+        tracker.Insert(store_key_t(strprintf("prefix/%08d/suffix/%d", i % 8, i)), "v");
+    }
+    check_key_search_index(&tracker, &rng, random_compound_key);
+}
+
+TEST(LeafNodeTest, KeySearchIndexEmpty) {
+    LeafNodeTracker tracker;
+    key_search_index_t index;
+    leaf::build_key_search_index(tracker.node(), &index);
+    int index_out;
+    ASSERT_FALSE(leaf::find_key(tracker.node(), store_key_t("a").btree_key(),
+                                &index, &index_out));
+    ASSERT_EQ(0, index_out);
+}
+
+void benchmark_key_search(const char *name, std::string (*make_key)(rng_t *)) {
+    rng_t rng(0);
+    LeafNodeTracker tracker;
+    fill_leaf(&tracker, &rng, make_key);
+    key_search_index_t index;
+    leaf::build_key_search_index(tracker.node(), &index);
+
+    std::vector<store_key_t> probes;
+    for (auto it = tracker.kv_.begin(); it != tracker.kv_.end(); ++it) {
+        probes.push_back(it->first);
+    }
+
+    const int rounds = 20000;
+    for (int with_index = 0; with_index < 2; ++with_index) {
+        const key_search_index_t *search_index = with_index ? &index : NULL;
+        int found = 0;
+        ticks_t start = get_ticks();
+        for (int r = 0; r < rounds; ++r) {
+            for (auto it = probes.begin(); it != probes.end(); ++it) {
+                int index_out;
+                found += leaf::find_key(tracker.node(), it->btree_key(),
+                                        search_index, &index_out);
+            }
+        }
+        double secs = ticks_to_secs(get_ticks() - start);
+        ASSERT_EQ(rounds * static_cast<int>(probes.size()), found);
+        printf("%s keys (%d per leaf), %s: %.1f ns per search\n",
+               name, static_cast<int>(probes.size()),
+               with_index ? "with index" : "without index",
+               secs * BILLION / (rounds * probes.size()));
+    }
+}
+
+TEST(LeafNodeTest, DISABLED_KeySearchBenchmark) {
+    benchmark_key_search("UUID", random_uuid_key);
+    benchmark_key_search("Compound", random_compound_key);
+}
+
 }  // namespace unittest
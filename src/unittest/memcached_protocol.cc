@@ -32,7 +32,9 @@ void run_with_namespace_interface(boost::function<void(namespace_interface_t<mem
                             new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
                                                       &file_opener,
                                                       &get_global_perfmon_collection())),
-                        MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+                        MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                        MERGER_SERIALIZER_BLOCK_WRITE_WINDOW_MS,
+                        &get_global_perfmon_collection()));
 
 
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
@@ -47,7 +49,7 @@ void run_with_namespace_interface(boost::function<void(namespace_interface_t<mem
         underlying_stores.push_back(
                 new memcached_protocol_t::store_t(multiplexer->proxies[i],
                     temp_file.name().permanent_path() + strprintf("_%zd", i),
-                    GIGABYTE, true, &get_global_perfmon_collection(), NULL,
+                    GIGABYTE, NULL, true, &get_global_perfmon_collection(), NULL,
                     &io_backender, base_path_t(".")));
     }
 
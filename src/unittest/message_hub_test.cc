@@ -0,0 +1,109 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Records its arrival on the receiving thread.
+class recording_message_t : public linux_thread_message_t {
+public:
+    recording_message_t() : sender(-1), seq(-1), log(NULL), expected(0), done(NULL) { }
+    ~recording_message_t() { }
+
+    void on_thread_switch() {
+        log->push_back(std::make_pair(sender, seq));
+        if (log->size() == expected) {
+            done->pulse();
+        }
+    }
+
+    int sender;
+    int seq;
+    std::vector<std::pair<int, int> > *log;
+    size_t expected;
+    cond_t *done;
+};
+
+void run_ordered_messages_test(int num_threads) {
+    const int per_sender = 2000;
+    const int num_senders = num_threads - 1;
+
+    // Only touched on thread 0.
+    std::vector<std::pair<int, int> > log;
+    scoped_ptr_t<cond_t> done;
+    {
+        on_thread_t th((threadnum_t(0)));
+        done.init(new cond_t);
+    }
+
+    scoped_array_t<recording_message_t> messages(num_senders * per_sender);
+    for (int s = 0; s < num_senders; ++s) {
+        for (int i = 0; i < per_sender; ++i) {
+            recording_message_t *m = &messages[s * per_sender + i];
+            m->sender = s;
+            m->seq = i;
+            m->log = &log;
+            m->expected = num_senders * per_sender;
+            m->done = done.get();
+        }
+    }
+
+    // Every sender floods thread 0 at the same time, so their batches race to
+    // get onto its incoming stack.
+    pmap(num_senders, [&](int s) {
+        on_thread_t th((threadnum_t(s + 1)));
+        for (int i = 0; i < per_sender; ++i) {
+            bool same_thread = continue_on_thread(threadnum_t(0),
+                                                 &messages[s * per_sender + i]);
+            ASSERT_FALSE(same_thread);
+        }
+    });
+
+    on_thread_t th((threadnum_t(0)));
+    done->wait();
+
+    ASSERT_EQ(static_cast<size_t>(num_senders * per_sender), log.size());
+    std::vector<int> next_seq(num_senders, 0);
+    for (size_t i = 0; i < log.size(); ++i) {
+        ASSERT_EQ(next_seq[log[i].first], log[i].second);
+        ++next_seq[log[i].first];
+    }
+    done.reset();
+}
+
+TEST(MessageHubTest, OrderedMessagesStayOrdered) {
+    run_in_thread_pool(std::bind(&run_ordered_messages_test, 4), 4);
+}
+
+void run_ping_pong(int num_threads, int round_trips) {
+    ticks_t start = get_ticks();
+    // One coroutine per thread bounces between its thread and the next one, so
+    // every thread is sending to and receiving from another one.
+    pmap(num_threads, [&](int i) {
+        on_thread_t home((threadnum_t(i)));
+        for (int r = 0; r < round_trips; ++r) {
+            on_thread_t away((threadnum_t((i + 1) % num_threads)));
+        }
+    });
+    double secs = ticks_to_secs(get_ticks() - start);
+    double messages = 2.0 * num_threads * round_trips;
+    printf("%2d threads: %.0f messages/sec\n", num_threads, messages / secs);
+}
+
+TEST(MessageHubTest, DISABLED_PingPongBenchmark) {
+    for (int num_threads = 2; num_threads <= 32; num_threads *= 2) {
+        run_in_thread_pool(std::bind(&run_ping_pong, num_threads, 100000),
+                           num_threads);
+    }
+}
+
+}  // namespace unittest
@@ -23,6 +23,7 @@ public:
     int64_t get_size();
     void set_size(int64_t size);
     void set_size_at_least(int64_t size);
+    void preallocate(int64_t size) { set_size_at_least(size); }
 
     void read_async(int64_t offset, size_t length, void *buf,
                     file_account_t *account, linux_iocallback_t *cb);
@@ -4,6 +4,7 @@
 #include "buffer_cache/alt/page_cache.hpp"
 // For alt_memory_tracker_t.  KSI: We'll want a mock memory_tracker_t subclass.
 #include "buffer_cache/alt/alt.hpp"
+#include "buffer_cache/alt/stats.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
@@ -25,6 +26,8 @@ struct mock_ser_t {
     mock_file_opener_t opener;
     scoped_ptr_t<standard_serializer_t> ser;
     scoped_ptr_t<alt_memory_tracker_t> tracker;
+    perfmon_collection_t stats_collection;
+    scoped_ptr_t<alt_cache_stats_t> stats;
 
     mock_ser_t()
         : opener() {
@@ -34,6 +37,7 @@ struct mock_ser_t {
                                                  &opener,
                                                  &get_global_perfmon_collection());
         tracker = make_scoped<alt_memory_tracker_t>();
+        stats = make_scoped<alt_cache_stats_t>(&stats_collection);
     }
 };
 
@@ -45,12 +49,15 @@ class test_txn_t;
 
 class test_cache_t : public page_cache_t {
 public:
-    test_cache_t(serializer_t *serializer, alt_memory_tracker_t *tracker)
-        : page_cache_t(serializer, page_cache_config_t(), tracker),
+    test_cache_t(serializer_t *serializer, alt_memory_tracker_t *tracker,
+                 alt_cache_stats_t *stats)
+        : page_cache_t(serializer, page_cache_config_t(), tracker, NULL, stats),
           tracker_(tracker) { }
     test_cache_t(serializer_t *serializer, alt_memory_tracker_t *tracker,
-                 uint64_t memory_limit)
-        : page_cache_t(serializer, make_config(memory_limit), tracker),
+                 alt_cache_stats_t *stats, uint64_t memory_limit,
+                 eviction_policy_t eviction_policy)
+        : page_cache_t(serializer, make_config(memory_limit, eviction_policy),
+                       tracker, NULL, stats),
           tracker_(tracker) { }
 
     void flush(scoped_ptr_t<test_txn_t> txn) {
@@ -64,9 +71,11 @@ public:
     }
 
 private:
-    static page_cache_config_t make_config(uint64_t memory_limit) {
+    static page_cache_config_t make_config(uint64_t memory_limit,
+                                           eviction_policy_t eviction_policy) {
         page_cache_config_t ret;
         ret.memory_limit = memory_limit;
+        ret.eviction_policy = eviction_policy;
         return ret;
     }
 
@@ -128,19 +137,19 @@ TPTEST(PageTest, Control, 4) {
 
 TPTEST(PageTest, CreateDestroy, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
 }
 
 TPTEST(PageTest, OneTxn, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn = make_scoped<test_txn_t>(&page_cache);
     page_cache.flush(std::move(txn));
 }
 
 TPTEST(PageTest, TwoIndependentTxn, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn1 = make_scoped<test_txn_t>(&page_cache);
     auto txn2 = make_scoped<test_txn_t>(&page_cache);
     page_cache.flush(std::move(txn2));
@@ -149,7 +158,7 @@ TPTEST(PageTest, TwoIndependentTxn, 4) {
 
 TPTEST(PageTest, TwoIndependentTxnSwitch, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn1 = make_scoped<test_txn_t>(&page_cache);
     auto txn2 = make_scoped<test_txn_t>(&page_cache);
     page_cache.flush(std::move(txn1));
@@ -158,7 +167,7 @@ TPTEST(PageTest, TwoIndependentTxnSwitch, 4) {
 
 TPTEST(PageTest, TwoSequentialTxnSwitch, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn1 = make_scoped<test_txn_t>(&page_cache);
     auto txn2 = make_scoped<test_txn_t>(&page_cache);
     page_cache.flush(std::move(txn1));
@@ -167,7 +176,7 @@ TPTEST(PageTest, TwoSequentialTxnSwitch, 4) {
 
 TPTEST(PageTest, OneWriteAcq, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn = make_scoped<test_txn_t>(&page_cache);
     {
         current_test_acq_t acq(txn.get(), 0, access_t::write, page_create_t::yes);
@@ -178,7 +187,7 @@ TPTEST(PageTest, OneWriteAcq, 4) {
 
 TPTEST(PageTest, OneWriteAcqOneReadAcq, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn1 = make_scoped<test_txn_t>(&page_cache);
     {
         current_test_acq_t acq(txn1.get(), 0, access_t::write, page_create_t::yes);
@@ -196,7 +205,7 @@ TPTEST(PageTest, OneWriteAcqOneReadAcq, 4) {
 
 TPTEST(PageTest, OneWriteAcqWait, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     auto txn = make_scoped<test_txn_t>(&page_cache);
     {
         current_test_acq_t acq(txn.get(), alt_create_t::create);
@@ -254,7 +263,7 @@ void ReadAfterWrite_cases(ReadAfterWrite_state_t *s, test_cache_t *cache, int i)
 
 TPTEST(PageTest, ReadAfterWrite, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     ReadAfterWrite_state_t s;
     pmap(2, std::bind(&ReadAfterWrite_cases, &s, &page_cache, ph::_1));
 }
@@ -299,15 +308,16 @@ void WriteWaitForFlush_cases(WriteWaitForFlush_state_t *s, test_cache_t *cache,
 
 TPTEST(PageTest, WriteWaitForFlush, 4) {
     mock_ser_t mock;
-    test_cache_t page_cache(mock.ser.get(), mock.tracker.get());
+    test_cache_t page_cache(mock.ser.get(), mock.tracker.get(), mock.stats.get());
     WriteWaitForFlush_state_t s;
     pmap(2, std::bind(&WriteWaitForFlush_cases, &s, &page_cache, ph::_1));
 }
 
 class bigger_test_t {
 public:
-    explicit bigger_test_t(uint64_t _memory_limit)
-        : memory_limit(_memory_limit), mock(), c(NULL),
+    bigger_test_t(uint64_t _memory_limit, eviction_policy_t _eviction_policy)
+        : memory_limit(_memory_limit), eviction_policy(_eviction_policy),
+          mock(), c(NULL),
           txn1_ptr(NULL), txn2_ptr(NULL) {
         for (size_t i = 0; i < b_len; ++i) {
             b[i] = NULL_BLOCK_ID;
@@ -316,7 +326,8 @@ public:
 
     void run() {
         {
-            test_cache_t cache(mock.ser.get(), mock.tracker.get(), memory_limit);
+            test_cache_t cache(mock.ser.get(), mock.tracker.get(), mock.stats.get(),
+                               memory_limit, eviction_policy);
             auto_drainer_t drain;
             c = &cache;
 
@@ -361,7 +372,8 @@ public:
         c = NULL;
 
         {
-            test_cache_t cache(mock.ser.get(), mock.tracker.get(), memory_limit);
+            test_cache_t cache(mock.ser.get(), mock.tracker.get(), mock.stats.get(),
+                               memory_limit, eviction_policy);
             auto_drainer_t drain;
             c = &cache;
             coro_t::spawn_ordered(std::bind(&bigger_test_t::run_txn14,
@@ -372,7 +384,8 @@ public:
         c = NULL;
 
         {
-            test_cache_t cache(mock.ser.get(), mock.tracker.get(), memory_limit);
+            test_cache_t cache(mock.ser.get(), mock.tracker.get(), mock.stats.get(),
+                               memory_limit, eviction_policy);
             c = &cache;
             auto txn = make_scoped<test_txn_t>(c);
 
@@ -1120,6 +1133,7 @@ private:
     }
 
     const uint64_t memory_limit;
+    const eviction_policy_t eviction_policy;
 
     mock_ser_t mock;
     test_cache_t *c;
@@ -1151,23 +1165,133 @@ private:
 };
 
 TPTEST(PageTest, BiggerTest, 4) {
-    bigger_test_t test(GIGABYTE);
+    bigger_test_t test(GIGABYTE, eviction_policy_t::sampled_lru);
     test.run();
 }
 
 TPTEST(PageTest, BiggerTestTightMemory, 4) {
-    bigger_test_t test(8192);
+    bigger_test_t test(8192, eviction_policy_t::sampled_lru);
     test.run();
 }
 
 TPTEST(PageTest, BiggerTestSuperTightMemory, 4) {
-    bigger_test_t test(4096);
+    bigger_test_t test(4096, eviction_policy_t::sampled_lru);
     test.run();
 }
 
 TPTEST(PageTest, BiggerTestNoMemory, 4) {
-    bigger_test_t test(0);
+    bigger_test_t test(0, eviction_policy_t::sampled_lru);
+    test.run();
+}
+
+TPTEST(PageTest, BiggerTestTwoQueueTightMemory, 4) {
+    bigger_test_t test(8192, eviction_policy_t::two_queue);
     test.run();
 }
 
+TPTEST(PageTest, BiggerTestTwoQueueSuperTightMemory, 4) {
+    bigger_test_t test(4096, eviction_policy_t::two_queue);
+    test.run();
+}
+
+int64_t get_counter_value(perfmon_counter_t *counter) {
+    void *ctx = counter->begin_stats();
+    pmap(get_num_threads(), [&](int i) {
+        on_thread_t th((threadnum_t(i)));
+        counter->visit_stats(ctx);
+    });
+    scoped_ptr_t<perfmon_result_t> result = counter->end_stats(ctx);
+    return strtoll(result->get_string()->c_str(), NULL, 10);
+}
+
+std::vector<block_id_t> create_blocks(mock_ser_t *mock, size_t count) {
+    std::vector<block_id_t> block_ids;
+    test_cache_t cache(mock->ser.get(), mock->tracker.get(), mock->stats.get());
+    auto txn = make_scoped<test_txn_t>(&cache);
+    for (size_t i = 0; i < count; ++i) {
+        current_test_acq_t acq(txn.get(), alt_create_t::create);
+        block_ids.push_back(acq.block_id());
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_write(), &cache);
+        memset(page_acq.get_buf_write(), 0, page_acq.get_buf_size());
+    }
+    cache.flush(std::move(txn));
+    return block_ids;
+}
+
+void read_block(test_cache_t *cache, block_id_t block_id) {
+    auto txn = make_scoped<test_txn_t>(cache);
+    {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_read(), cache);
+        page_acq.buf_ready_signal()->wait();
+    }
+    cache->flush(std::move(txn));
+}
+
+TPTEST(PageTest, TwoQueueScanResistance, 4) {
+    mock_ser_t mock;
+    const uint64_t page_size = mock.ser->max_block_size().ser_value();
+    const size_t num_hot = 4;
+    const size_t num_scan = 200;
+    std::vector<block_id_t> block_ids = create_blocks(&mock, num_hot + num_scan);
+
+    test_cache_t cache(mock.ser.get(), mock.tracker.get(), mock.stats.get(),
+                       16 * page_size, eviction_policy_t::two_queue);
+
+    // Reading the hot set twice gets it protected.
+    const int64_t misses_before = get_counter_value(&mock.stats->pm_cache_misses);
+    const int64_t hits_before = get_counter_value(&mock.stats->pm_cache_hits);
+    for (size_t i = 0; i < num_hot; ++i) {
+        read_block(&cache, block_ids[i]);
+    }
+    for (size_t i = 0; i < num_hot; ++i) {
+        read_block(&cache, block_ids[i]);
+    }
+    ASSERT_EQ(misses_before + static_cast<int64_t>(num_hot),
+              get_counter_value(&mock.stats->pm_cache_misses));
+    ASSERT_EQ(hits_before + static_cast<int64_t>(num_hot),
+              get_counter_value(&mock.stats->pm_cache_hits));
+
+    // A one-off scan much bigger than the cache...
+    for (size_t i = num_hot; i < num_hot + num_scan; ++i) {
+        read_block(&cache, block_ids[i]);
+    }
+    const int64_t misses_after_scan = get_counter_value(&mock.stats->pm_cache_misses);
+    ASSERT_EQ(misses_before + static_cast<int64_t>(num_hot + num_scan),
+              misses_after_scan);
+
+    // ... leaves the hot set in memory.
+    for (size_t i = 0; i < num_hot; ++i) {
+        read_block(&cache, block_ids[i]);
+    }
+    ASSERT_EQ(misses_after_scan, get_counter_value(&mock.stats->pm_cache_misses));
+}
+
+TPTEST(PageTest, TwoQueueGhostHits, 4) {
+    mock_ser_t mock;
+    const uint64_t page_size = mock.ser->max_block_size().ser_value();
+    std::vector<block_id_t> block_ids = create_blocks(&mock, 3);
+
+    // With room for one page, reading a block evicts the one read before it.
+    test_cache_t cache(mock.ser.get(), mock.tracker.get(), mock.stats.get(),
+                       page_size, eviction_policy_t::two_queue);
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        read_block(&cache, block_ids[i]);
+    }
+
+    // Block 1 was the last one evicted, so it is still on the ghost list.
+    const int64_t ghost_hits_before = get_counter_value(&mock.stats->pm_cache_ghost_hits);
+    read_block(&cache, block_ids[1]);
+    ASSERT_EQ(ghost_hits_before + 1,
+              get_counter_value(&mock.stats->pm_cache_ghost_hits));
+
+    // Block 0 was evicted two pages' worth of evictions ago, which is more than
+    // the ghost list holds.
+    read_block(&cache, block_ids[0]);
+    ASSERT_EQ(ghost_hits_before + 1,
+              get_counter_value(&mock.stats->pm_cache_ghost_hits));
+}
+
 }  // namespace unittest
@@ -57,4 +57,49 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, HistogramBuckets) {
+    using namespace perfmon_histogram;
+
+    // Small values get exact buckets, and every value lies in its bucket.
+    for (uint64_t v = 0; v < 100000; ++v) {
+        int bucket = bucket_for_value(v);
+        ASSERT_LE(v, bucket_upper_bound(bucket));
+        if (bucket > 0) {
+            ASSERT_GT(v, bucket_upper_bound(bucket - 1));
+        }
+        if (v < static_cast<uint64_t>(SUB_BUCKET_COUNT)) {
+            ASSERT_EQ(v, bucket_upper_bound(bucket));
+        }
+    }
+    EXPECT_EQ(NUM_BUCKETS - 1, bucket_for_value((1ull << MAX_VALUE_BITS) - 1));
+    EXPECT_EQ(NUM_BUCKETS - 1, bucket_for_value(std::numeric_limits<uint64_t>::max()));
+
+    // Quantiles over 1..N are within the bucket resolution of the exact answer.
+    stats_t stats;
+    const uint64_t N = 1000000;
+    for (uint64_t v = 1; v <= N; ++v) {
+        stats.record(v);
+    }
+    EXPECT_EQ(N, stats.count);
+    EXPECT_EQ(N, stats.max);
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); ++i) {
+        double exact = quantiles[i] * N;
+        double reported = stats.quantile(quantiles[i]);
+        EXPECT_LE(exact, reported);
+        EXPECT_NEAR(exact, reported, exact / SUB_BUCKET_COUNT);
+    }
+    EXPECT_EQ(N, stats.quantile(1.0));
+
+    // Merging per-thread histograms is the same as recording everything in one.
+    stats_t a, b;
+    for (uint64_t v = 1; v <= N; ++v) {
+        (v % 2 == 0 ? a : b).record(v);
+    }
+    a.aggregate(b);
+    EXPECT_EQ(stats.count, a.count);
+    EXPECT_EQ(stats.max, a.max);
+    EXPECT_EQ(stats.quantile(0.99), a.quantile(0.99));
+}
+
 }  // namespace unittest
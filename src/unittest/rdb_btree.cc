@@ -9,6 +9,7 @@
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/lazy_json.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/pb_utils.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -193,8 +194,10 @@ void spawn_writes_and_bring_sindexes_up_to_date(btree_store_t<rdb_protocol_t> *s
                                                     &sindex_block);
 }
 
+// Checks that every row {"id" : i, "sid" : i * i + sid_offset} can be found
+// through the sindex.
 void _check_keys_are_present(btree_store_t<rdb_protocol_t> *store,
-        std::string sindex_id) {
+        std::string sindex_id, int sid_offset = 0) {
     cond_t dummy_interruptor;
     for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
         read_token_pair_t token_pair;
@@ -217,7 +220,7 @@ void _check_keys_are_present(btree_store_t<rdb_protocol_t> *store,
         ASSERT_TRUE(sindex_exists);
 
         rdb_protocol_t::rget_read_response_t res;
-        double ii = i * i;
+        double ii = i * i + sid_offset;
         /* The only thing this does is have a NULL scoped_ptr_t<trace_t> in it
          * which prevents to profiling code from crashing. */
         ql::env_t dummy_env(NULL, NULL);
@@ -242,17 +245,18 @@ void _check_keys_are_present(btree_store_t<rdb_protocol_t> *store,
         ASSERT_TRUE(stream != NULL);
         ASSERT_EQ(1ul, stream->size());
 
-        std::string expected_data = strprintf("{\"id\" : %d, \"sid\" : %d}", i, i * i);
+        std::string expected_data = strprintf("{\"id\" : %d, \"sid\" : %d}",
+                                              i, i * i + sid_offset);
         scoped_cJSON_t expected_value(cJSON_Parse(expected_data.c_str()));
         ASSERT_EQ(ql::datum_t(expected_value.get()), *stream->front().data);
     }
 }
 
 void check_keys_are_present(btree_store_t<rdb_protocol_t> *store,
-        std::string sindex_id) {
+        std::string sindex_id, int sid_offset = 0) {
     for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
         try {
-            _check_keys_are_present(store, sindex_id);
+            _check_keys_are_present(store, sindex_id, sid_offset);
         } catch (const sindex_not_post_constructed_exc_t&) { }
         /* Unfortunately we don't have an easy way right now to tell if the
          * sindex has actually been postconstructed so we just need to
@@ -262,7 +266,7 @@ void check_keys_are_present(btree_store_t<rdb_protocol_t> *store,
 }
 
 void _check_keys_are_NOT_present(btree_store_t<rdb_protocol_t> *store,
-        std::string sindex_id) {
+        std::string sindex_id, int sid_offset = 0) {
     /* Check that we don't have any of the keys (we just deleted them all) */
     cond_t dummy_interruptor;
     for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
@@ -286,7 +290,7 @@ void _check_keys_are_NOT_present(btree_store_t<rdb_protocol_t> *store,
         ASSERT_TRUE(sindex_exists);
 
         rdb_protocol_t::rget_read_response_t res;
-        double ii = i * i;
+        double ii = i * i + sid_offset;
         /* The only thing this does is have a NULL scoped_ptr_t<trace_t> in it
          * which prevents the profiling code from crashing. */
         ql::env_t dummy_env(NULL, NULL);
@@ -311,10 +315,10 @@ void _check_keys_are_NOT_present(btree_store_t<rdb_protocol_t> *store,
 }
 
 void check_keys_are_NOT_present(btree_store_t<rdb_protocol_t> *store,
-        std::string sindex_id) {
+        std::string sindex_id, int sid_offset = 0) {
     for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT; ++i) {
         try {
-            _check_keys_are_NOT_present(store, sindex_id);
+            _check_keys_are_NOT_present(store, sindex_id, sid_offset);
         } catch (const sindex_not_post_constructed_exc_t&) { }
         /* Unfortunately we don't have an easy way right now to tell if the
          * sindex has actually been postconstructed so we just need to
@@ -343,6 +347,7 @@ TPTEST(RDBBtree, SindexPostConstruct) {
             &serializer,
             "unit_test_store",
             GIGABYTE,
+            NULL,
             true,
             &get_global_perfmon_collection(),
             NULL,
@@ -383,6 +388,7 @@ TPTEST(RDBBtree, SindexEraseRange) {
             &serializer,
             "unit_test_store",
             GIGABYTE,
+            NULL,
             true,
             &get_global_perfmon_collection(),
             NULL,
@@ -452,6 +458,7 @@ TPTEST(RDBBtree, SindexInterruptionViaDrop) {
             &serializer,
             "unit_test_store",
             GIGABYTE,
+            NULL,
             true,
             &get_global_perfmon_collection(),
             NULL,
@@ -493,6 +500,7 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
             &serializer,
             "unit_test_store",
             GIGABYTE,
+            NULL,
             true,
             &get_global_perfmon_collection(),
             NULL,
@@ -510,4 +518,226 @@ TPTEST(RDBBtree, SindexInterruptionViaStoreDelete) {
     store.reset();
 }
 
+// The backfilled rows' "sid" values are shifted past every value `insert_rows`
+// uses, so that an overwritten row's stale sindex entry can't be mistaken for the
+// new one.
+#define BACKFILL_SID_OFFSET (TOTAL_KEYS_TO_INSERT * TOTAL_KEYS_TO_INSERT)
+
+// Backfills rows {"id" : i, "sid" : i * i + BACKFILL_SID_OFFSET} for all `i` into
+// `store` in chunks, as they come from the backfiller: already serialized for
+// storage.
+void backfill_rows(btree_store_t<rdb_protocol_t> *store) {
+    const size_t rows_per_chunk = 100;
+    repli_timestamp_t recency = repli_timestamp_t::distant_past.next();
+    std::vector<rdb_protocol_details::backfill_atom_t> atoms;
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        std::string data = strprintf("{\"id\" : %d, \"sid\" : %d}",
+                                     i, i * i + BACKFILL_SID_OFFSET);
+        counted_t<const ql::datum_t> row
+            = make_counted<ql::datum_t>(scoped_cJSON_t(cJSON_Parse(data.c_str())));
+        write_message_t wm;
+        ql::serialize_for_storage(&wm, row);
+        vector_stream_t stream;
+        stream.reserve(wm.size());
+        int res = send_write_message(&stream, &wm);
+        guarantee(res == 0);
+
+        std::vector<char> value = stream.vector();
+        store_key_t pk(make_counted<const ql::datum_t>(static_cast<double>(i))->print_primary());
+        atoms.push_back(rdb_protocol_details::backfill_atom_t(
+            pk, std::move(value), recency));
+
+        if (atoms.size() == rows_per_chunk || i + 1 == TOTAL_KEYS_TO_INSERT) {
+            cond_t dummy_interruptor;
+            write_token_pair_t token_pair;
+            store->new_write_token_pair(&token_pair);
+            store->receive_backfill(
+                rdb_protocol_t::backfill_chunk_t::set_keys(std::move(atoms)),
+                &token_pair, &dummy_interruptor);
+            atoms.clear();
+        }
+    }
+}
+
+void check_rows_by_primary_key(btree_store_t<rdb_protocol_t> *store) {
+    cond_t dummy_interruptor;
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        read_token_pair_t token_pair;
+        store->new_read_token_pair(&token_pair);
+
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> super_block;
+        store->acquire_superblock_for_read(
+                &token_pair.main_read_token, &txn, &super_block,
+                &dummy_interruptor, true);
+
+        store_key_t pk(make_counted<const ql::datum_t>(static_cast<double>(i))->print_primary());
+        point_read_response_t response;
+        rdb_get(pk, store->btree.get(), super_block.get(), &response,
+                static_cast<profile::trace_t *>(NULL));
+
+        std::string expected_data = strprintf("{\"id\" : %d, \"sid\" : %d}",
+                                              i, i * i + BACKFILL_SID_OFFSET);
+        scoped_cJSON_t expected_value(cJSON_Parse(expected_data.c_str()));
+        ASSERT_TRUE(response.data.has());
+        ASSERT_EQ(ql::datum_t(expected_value.get()), *response.data);
+    }
+}
+
+// Backfills rows over a table that already has some of them, so that both new rows
+// and overwritten rows go through the path that copies the serialized rows
+// straight into the btree (without a secondary index) or decodes them (with one).
+void run_backfill_serialized_rows_test(bool with_sindex) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(
+        &file_opener,
+        standard_serializer_t::static_config_t());
+
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    rdb_protocol_t::store_t store(
+            &serializer,
+            "unit_test_store",
+            GIGABYTE,
+            NULL,
+            true,
+            &get_global_perfmon_collection(),
+            NULL,
+            &io_backender,
+            base_path_t("."));
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT / 2, &store);
+
+    std::string sindex_id;
+    if (with_sindex) {
+        sindex_id = create_sindex(&store);
+        bring_sindexes_up_to_date(&store, sindex_id);
+    }
+
+    backfill_rows(&store);
+
+    check_rows_by_primary_key(&store);
+    if (with_sindex) {
+        // Every row has to be in the sindex exactly once, under its new value, and
+        // the overwritten rows must have had their old entries removed.
+        check_keys_are_present(&store, sindex_id, BACKFILL_SID_OFFSET);
+        check_keys_are_NOT_present(&store, sindex_id);
+    }
+}
+
+TPTEST(RDBBtree, BackfillSerializedRows) {
+    run_backfill_serialized_rows_test(false);
+}
+
+TPTEST(RDBBtree, BackfillSerializedRowsWithSindex) {
+    run_backfill_serialized_rows_test(true);
+}
+
+void set_row(btree_store_t<rdb_protocol_t> *store, int id, const std::string &data) {
+    cond_t dummy_interruptor;
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    write_token_pair_t token_pair;
+    store->new_write_token_pair(&token_pair);
+    store->acquire_superblock_for_write(
+        repli_timestamp_t::invalid,
+        1, write_durability_t::SOFT,
+        &token_pair, &txn, &superblock, &dummy_interruptor);
+
+    store_key_t pk(make_counted<const ql::datum_t>(static_cast<double>(id))->print_primary());
+    point_write_response_t response;
+    rdb_modification_info_t mod_info;
+    rdb_set(pk,
+            make_counted<ql::datum_t>(scoped_cJSON_t(cJSON_Parse(data.c_str()))),
+            false, store->btree.get(), repli_timestamp_t::invalid,
+            superblock.get(), &response, &mod_info,
+            static_cast<profile::trace_t *>(NULL));
+}
+
+counted_t<const ql::datum_t> get_row_fields(btree_store_t<rdb_protocol_t> *store,
+                                            int id,
+                                            const std::set<std::string> &fields) {
+    cond_t dummy_interruptor;
+    read_token_pair_t token_pair;
+    store->new_read_token_pair(&token_pair);
+
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> super_block;
+    store->acquire_superblock_for_read(
+            &token_pair.main_read_token, &txn, &super_block,
+            &dummy_interruptor, true);
+
+    store_key_t pk(make_counted<const ql::datum_t>(static_cast<double>(id))->print_primary());
+    keyvalue_location_t<rdb_value_t> kv_location;
+    find_keyvalue_location_for_read(super_block.get(), pk.btree_key(), &kv_location,
+                                    &store->btree->stats,
+                                    static_cast<profile::trace_t *>(NULL));
+    guarantee(kv_location.value.has());
+    return get_data_fields(kv_location.value.get(), buf_parent_t(&kv_location.buf),
+                           fields);
+}
+
+TPTEST(RDBBtree, GetDataFields) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    standard_serializer_t::create(
+        &file_opener,
+        standard_serializer_t::static_config_t());
+
+    standard_serializer_t serializer(
+        standard_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    rdb_protocol_t::store_t store(
+            &serializer,
+            "unit_test_store",
+            GIGABYTE,
+            NULL,
+            true,
+            &get_global_perfmon_collection(),
+            NULL,
+            &io_backender,
+            base_path_t("."));
+
+    // Row 0 is large enough to be stored in the indexed format, row 1 isn't.
+    const std::string big(1000, 'x');
+    set_row(&store, 0, strprintf("{\"id\" : 0, \"a\" : 1, \"big\" : \"%s\", "
+                                 "\"c\" : {\"d\" : 2}}", big.c_str()));
+    set_row(&store, 1, "{\"id\" : 1, \"a\" : 1, \"b\" : 2}");
+
+    std::set<std::string> fields;
+    fields.insert("a");
+    fields.insert("c");
+    fields.insert("missing");
+
+    // Only the requested fields that the row has are read.
+    scoped_cJSON_t expected_indexed(cJSON_Parse("{\"a\" : 1, \"c\" : {\"d\" : 2}}"));
+    ASSERT_EQ(ql::datum_t(expected_indexed.get()), *get_row_fields(&store, 0, fields));
+
+    // A row in the old format is loaded whole.
+    scoped_cJSON_t expected_whole(cJSON_Parse("{\"id\" : 1, \"a\" : 1, \"b\" : 2}"));
+    ASSERT_EQ(ql::datum_t(expected_whole.get()), *get_row_fields(&store, 1, fields));
+
+    // Asking for every field of the indexed row gives the whole row.
+    fields.insert("id");
+    fields.insert("big");
+    scoped_cJSON_t expected_all(cJSON_Parse(strprintf(
+        "{\"id\" : 0, \"a\" : 1, \"big\" : \"%s\", \"c\" : {\"d\" : 2}}",
+        big.c_str()).c_str()));
+    ASSERT_EQ(ql::datum_t(expected_all.get()), *get_row_fields(&store, 0, fields));
+}
+
 } //namespace unittest
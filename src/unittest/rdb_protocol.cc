@@ -75,12 +75,13 @@ void run_with_namespace_interface(boost::function<void(namespace_interface_t<rdb
     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > dummy_auth;
     rdb_protocol_t::context_t ctx(&extproc_pool, NULL, slm.get_root_view(),
                                   dummy_auth, &read_manager, generate_uuid(),
+                                  &io_backender, base_path_t("."),
                                   &get_global_perfmon_collection());
 
     for (size_t i = 0; i < store_shards.size(); ++i) {
         underlying_stores.push_back(
                 new rdb_protocol_t::store_t(serializers[i].get(),
-                    temp_files[i].name().permanent_path(), GIGABYTE, true,
+                    temp_files[i].name().permanent_path(), GIGABYTE, NULL, true,
                     &get_global_perfmon_collection(), &ctx,
                     &io_backender, base_path_t(".")));
     }
@@ -165,6 +166,68 @@ TEST(RDBProtocol, OvershardedGetSet) {
     run_in_thread_pool_with_namespace_interface(&run_get_set_test, true);
 }
 
+/* `MultiPointRead` reads several primary keys at once, from both shards, with one
+of them asked for twice and two of them missing. */
+void run_multi_point_read_test(namespace_interface_t<rdb_protocol_t> *nsi,
+                               order_source_t *osource) {
+    const std::vector<std::string> present = { "a", "c", "m", "o", "x" };
+    for (auto it = present.begin(); it != present.end(); ++it) {
+        std::shared_ptr<const scoped_cJSON_t> data(new scoped_cJSON_t(cJSON_Parse(
+            strprintf("{\"id\" : \"%s\"}", it->c_str()).c_str())));
+        ASSERT_TRUE(data->get());
+        rdb_protocol_t::write_t write(
+                rdb_protocol_t::point_write_t(store_key_t(*it),
+                                              make_counted<ql::datum_t>(*data)),
+                DURABILITY_REQUIREMENT_DEFAULT,
+                profile_bool_t::PROFILE);
+        rdb_protocol_t::write_response_t response;
+
+        cond_t interruptor;
+        nsi->write(write, &response,
+                   osource->check_in("unittest::run_multi_point_read_test(rdb_protocol.cc-A)"),
+                   &interruptor);
+    }
+
+    std::vector<store_key_t> keys;
+    keys.push_back(store_key_t("x"));
+    keys.push_back(store_key_t("a"));
+    keys.push_back(store_key_t("o"));
+    keys.push_back(store_key_t("a"));
+    keys.push_back(store_key_t("b"));
+    keys.push_back(store_key_t("m"));
+    keys.push_back(store_key_t("z"));
+    rdb_protocol_t::read_t read(rdb_protocol_t::multi_point_read_t(std::move(keys)),
+                                profile_bool_t::PROFILE);
+    rdb_protocol_t::read_response_t response;
+
+    cond_t interruptor;
+    nsi->read(read, &response,
+              osource->check_in("unittest::run_multi_point_read_test(rdb_protocol.cc-B)"),
+              &interruptor);
+
+    rdb_protocol_t::multi_point_read_response_t *mget_resp
+        = boost::get<rdb_protocol_t::multi_point_read_response_t>(&response.response);
+    ASSERT_TRUE(mget_resp != NULL);
+
+    /* Only the keys that exist come back, each of them once. */
+    std::vector<std::string> found;
+    for (auto it = mget_resp->rows.begin(); it != mget_resp->rows.end(); ++it) {
+        ASSERT_TRUE(it->second.has());
+        std::string id = it->second->get("id")->as_str().to_std();
+        ASSERT_EQ(key_to_unescaped_str(it->first), id);
+        found.push_back(id);
+    }
+    ASSERT_EQ((std::vector<std::string>{ "a", "m", "o", "x" }), found);
+}
+
+TEST(RDBProtocol, MultiPointRead) {
+    run_in_thread_pool_with_namespace_interface(&run_multi_point_read_test, false);
+}
+
+TEST(RDBProtocol, OvershardedMultiPointRead) {
+    run_in_thread_pool_with_namespace_interface(&run_multi_point_read_test, true);
+}
+
 std::string create_sindex(namespace_interface_t<rdb_protocol_t> *nsi,
                           order_source_t *osource) {
     std::string id = uuid_to_str(generate_uuid());
@@ -317,6 +380,68 @@ TEST(RDBProtocol, OvershardedSindexCreateDrop) {
     run_in_thread_pool_with_namespace_interface(&run_create_drop_sindex_test, true);
 }
 
+void run_multi_range_sindex_read_test(namespace_interface_t<rdb_protocol_t> *nsi,
+                                      order_source_t *osource) {
+    std::string id = create_sindex(nsi, osource);
+    nap(100);
+
+    /* Insert rows with `sid`s 0 through 9. */
+    for (int i = 0; i < 10; ++i) {
+        std::shared_ptr<const scoped_cJSON_t> data(new scoped_cJSON_t(cJSON_Parse(
+            strprintf("{\"id\" : %d, \"sid\" : %d}", i, i).c_str())));
+        ASSERT_TRUE(data->get());
+        counted_t<const ql::datum_t> d(
+            new ql::datum_t(cJSON_GetObjectItem(data->get(), "id")));
+        rdb_protocol_t::write_t write(
+            rdb_protocol_t::point_write_t(store_key_t(d->print_primary()),
+                                          make_counted<ql::datum_t>(*data)),
+            DURABILITY_REQUIREMENT_DEFAULT,
+            profile_bool_t::PROFILE);
+        rdb_protocol_t::write_response_t response;
+
+        cond_t interruptor;
+        nsi->write(write, &response,
+                   osource->check_in("unittest::run_multi_range_sindex_read_test"),
+                   &interruptor);
+    }
+
+    /* Read several values at once, one of them twice and one of them missing. */
+    std::vector<counted_t<const ql::datum_t> > keys;
+    keys.push_back(make_counted<ql::datum_t>(7.0));
+    keys.push_back(make_counted<ql::datum_t>(2.0));
+    keys.push_back(make_counted<ql::datum_t>(7.0));
+    keys.push_back(make_counted<ql::datum_t>(42.0));
+    rdb_protocol_t::read_t read = make_sindex_read(keys, id);
+    rdb_protocol_t::read_response_t response;
+
+    cond_t interruptor;
+    nsi->read(read, &response,
+              osource->check_in("unittest::run_multi_range_sindex_read_test"),
+              &interruptor);
+
+    rdb_protocol_t::rget_read_response_t *rget_resp
+        = boost::get<rdb_protocol_t::rget_read_response_t>(&response.response);
+    ASSERT_TRUE(rget_resp != NULL);
+    auto streams = boost::get<ql::grouped_t<ql::stream_t> >(&rget_resp->result);
+    ASSERT_TRUE(streams != NULL);
+    ASSERT_EQ(1, streams->size());
+    auto stream = &streams->begin()->second;
+
+    std::multiset<double> sids;
+    for (auto it = stream->begin(); it != stream->end(); ++it) {
+        sids.insert(it->data->get("sid")->as_num());
+    }
+    ASSERT_EQ((std::multiset<double>{2.0, 7.0, 7.0}), sids);
+}
+
+TEST(RDBProtocol, MultiRangeSindexRead) {
+    run_in_thread_pool_with_namespace_interface(&run_multi_range_sindex_read_test, false);
+}
+
+TEST(RDBProtocol, OvershardedMultiRangeSindexRead) {
+    run_in_thread_pool_with_namespace_interface(&run_multi_range_sindex_read_test, true);
+}
+
 std::set<std::string> list_sindexes(namespace_interface_t<rdb_protocol_t> *nsi, order_source_t *osource) {
     rdb_protocol_t::sindex_list_t l;
     rdb_protocol_t::read_t read(l, profile_bool_t::PROFILE);
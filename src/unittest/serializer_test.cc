@@ -1,7 +1,12 @@
 #include <functional>
 
+#include "arch/arch.hpp"
 #include "arch/runtime/starter.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "serializer/config.hpp"
+#include "serializer/log/static_header.hpp"
+#include "serializer/merger.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -83,5 +88,465 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+int64_t get_serializer_stat(perfmon_collection_t *stats, const std::string &name) {
+    void *ctx = stats->begin_stats();
+    pmap(get_num_threads(), [&](int i) {
+        on_thread_t th((threadnum_t(i)));
+        stats->visit_stats(ctx);
+    });
+    scoped_ptr_t<perfmon_result_t> result = stats->end_stats(ctx);
+    const perfmon_result_t *all_stats = result.get();
+    const perfmon_result_t *serializer_stats = all_stats->get_map()->at("serializer");
+    const perfmon_result_t *stat = serializer_stats->get_map()->at(name);
+    return strtoll(stat->get_string()->c_str(), NULL, 10);
+}
+
+void run_RewrittenBlocksGetSegregated() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::static_config_t static_config;
+    standard_serializer_t::create(&file_opener, static_config);
+    standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                              &file_opener,
+                              &get_global_perfmon_collection());
+
+    scoped_malloc_t<ser_buffer_t> buf = ser.allocate_buffer();
+    memset(buf->cache_data, 0, ser.max_block_size().value());
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    auto write_block = [&](block_id_t block_id) -> counted_t<standard_block_token_t> {
+        std::vector<buf_write_info_t> infos;
+        infos.push_back(buf_write_info_t(buf.get(), ser.max_block_size(), block_id));
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        std::vector<counted_t<standard_block_token_t> > tokens
+            = ser.block_writes(infos, account.get(), &cb);
+        cb.wait();
+
+        std::vector<index_write_op_t> write_ops;
+        write_ops.push_back(index_write_op_t(block_id, tokens[0], repli_timestamp_t::distant_past));
+        ser.index_write(write_ops, account.get());
+        return tokens[0];
+    };
+
+    // New blocks are written to the same extent...
+    counted_t<standard_block_token_t> first = write_block(0);
+    counted_t<standard_block_token_t> second = write_block(1);
+    ASSERT_EQ(static_config.extent_index(first->offset()),
+              static_config.extent_index(second->offset()));
+
+    // ... but a block that gets rewritten right away goes to a different one.
+    counted_t<standard_block_token_t> rewritten = write_block(0);
+    ASSERT_NE(static_config.extent_index(first->offset()),
+              static_config.extent_index(rewritten->offset()));
+
+    // New blocks keep going to the first extent.
+    counted_t<standard_block_token_t> third = write_block(2);
+    ASSERT_EQ(static_config.extent_index(first->offset()),
+              static_config.extent_index(third->offset()));
+}
+
+TEST(SerializerTest, RewrittenBlocksGetSegregated) {
+    run_in_thread_pool(run_RewrittenBlocksGetSegregated, 4);
+}
+
+void run_MixedTemperatureWritesGetGrouped() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    perfmon_collection_t stats;
+    standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                              &file_opener, &stats);
+
+    const block_size_t block_size = ser.max_block_size();
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    const block_id_t num_blocks = 8;
+
+    auto write_blocks = [&](const std::vector<block_id_t> &block_ids)
+            -> std::vector<counted_t<standard_block_token_t> > {
+        std::vector<scoped_malloc_t<ser_buffer_t> > bufs;
+        std::vector<buf_write_info_t> infos;
+        for (auto it = block_ids.begin(); it != block_ids.end(); ++it) {
+            bufs.push_back(ser.allocate_buffer());
+            memset(bufs.back()->cache_data, 'a' + *it, block_size.value());
+            infos.push_back(buf_write_info_t(bufs.back().get(), block_size, *it));
+        }
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        std::vector<counted_t<standard_block_token_t> > tokens
+            = ser.block_writes(infos, account.get(), &cb);
+        cb.wait();
+        return tokens;
+    };
+
+    // Blocks that have just been written are hot when they get rewritten.
+    std::vector<block_id_t> hot_ids;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        hot_ids.push_back(i);
+    }
+    std::vector<counted_t<standard_block_token_t> > hot_tokens = write_blocks(hot_ids);
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        write_ops.push_back(index_write_op_t(i, hot_tokens[i],
+                                             repli_timestamp_t::distant_past));
+    }
+    ser.index_write(write_ops, account.get());
+
+    // Rewriting them interleaved with new blocks, which are warm, still goes out in
+    // one write per extent.
+    std::vector<block_id_t> mixed_ids;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        mixed_ids.push_back(i);
+        mixed_ids.push_back(num_blocks + i);
+    }
+    const int64_t writes_before = get_serializer_stat(&stats, "serializer_data_writes");
+    std::vector<counted_t<standard_block_token_t> > mixed_tokens
+        = write_blocks(mixed_ids);
+    ASSERT_EQ(2, get_serializer_stat(&stats, "serializer_data_writes") - writes_before);
+
+    // The tokens come back in the order of the writes.
+    scoped_malloc_t<ser_buffer_t> buf = ser.allocate_buffer();
+    ASSERT_EQ(mixed_ids.size(), mixed_tokens.size());
+    for (size_t i = 0; i < mixed_ids.size(); ++i) {
+        ser.block_read(mixed_tokens[i], buf.get(), account.get());
+        for (uint32_t j = 0; j < block_size.value(); ++j) {
+            ASSERT_EQ(static_cast<char>('a' + mixed_ids[i]), buf->cache_data[j]);
+        }
+    }
+}
+
+TEST(SerializerTest, MixedTemperatureWritesGetGrouped) {
+    run_in_thread_pool(run_MixedTemperatureWritesGetGrouped, 4);
+}
+
+void run_CompressedBlocksRoundTrip() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    standard_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.compress_blocks = true;
+    standard_serializer_t ser(dynamic_config,
+                              &file_opener,
+                              &get_global_perfmon_collection());
+
+    const block_size_t block_size = ser.max_block_size();
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    // Block 0 compresses well, block 1 doesn't compress at all.
+    scoped_malloc_t<ser_buffer_t> bufs[2] = { ser.allocate_buffer(), ser.allocate_buffer() };
+    for (uint32_t i = 0; i < block_size.value(); ++i) {
+        bufs[0]->cache_data[i] = 'a' + i % 7;
+        bufs[1]->cache_data[i] = randint(256);
+    }
+
+    std::vector<buf_write_info_t> infos;
+    infos.push_back(buf_write_info_t(bufs[0].get(), block_size, 0));
+    infos.push_back(buf_write_info_t(bufs[1].get(), block_size, 1));
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = ser.block_writes(infos, account.get(), &cb);
+    cb.wait();
+    ASSERT_EQ(2u, tokens.size());
+
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t i = 0; i < 2; ++i) {
+        // Tokens have the size of the block as it was written, compressed or not.
+        ASSERT_EQ(block_size.ser_value(), tokens[i]->block_size().ser_value());
+        write_ops.push_back(index_write_op_t(i, tokens[i], repli_timestamp_t::distant_past));
+    }
+    ser.index_write(write_ops, account.get());
+    tokens.clear();
+
+    for (block_id_t i = 0; i < 2; ++i) {
+        counted_t<standard_block_token_t> token = ser.index_read(i);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(block_size.ser_value(), token->block_size().ser_value());
+
+        scoped_malloc_t<ser_buffer_t> buf = ser.allocate_buffer();
+        ser.block_read(token, buf.get(), account.get());
+        ASSERT_EQ(0, memcmp(bufs[i]->cache_data, buf->cache_data, block_size.value()));
+    }
+}
+
+TEST(SerializerTest, CompressedBlocksRoundTrip) {
+    run_in_thread_pool(run_CompressedBlocksRoundTrip, 4);
+}
+
+void run_MergedBlockWrites() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    perfmon_collection_t stats;
+    merger_serializer_t ser(
+        scoped_ptr_t<serializer_t>(
+            new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
+                                      &file_opener,
+                                      &stats)),
+        MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+        MERGER_SERIALIZER_BLOCK_WRITE_WINDOW_MS,
+        &stats);
+
+    const block_size_t block_size = ser.max_block_size();
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+    // Concurrent block writes of different sizes, which get written as one batch,
+    // each get back the tokens for their own blocks.
+    const int num_writers = 4;
+    std::vector<std::vector<counted_t<standard_block_token_t> > > tokens(num_writers);
+    pmap(num_writers, [&](int writer) {
+        std::vector<scoped_malloc_t<ser_buffer_t> > bufs;
+        std::vector<buf_write_info_t> infos;
+        for (int i = 0; i <= writer; ++i) {
+            bufs.push_back(ser.allocate_buffer());
+            memset(bufs.back()->cache_data, 'a' + writer, block_size.value());
+            infos.push_back(buf_write_info_t(bufs.back().get(), block_size,
+                                             writer * num_writers + i));
+        }
+        struct : public iocallback_t, public cond_t {
+            void on_io_complete() {
+                pulse();
+            }
+        } cb;
+        tokens[writer] = ser.block_writes(infos, account.get(), &cb);
+        cb.wait();
+    });
+
+    scoped_malloc_t<ser_buffer_t> buf = ser.allocate_buffer();
+    for (int writer = 0; writer < num_writers; ++writer) {
+        ASSERT_EQ(static_cast<size_t>(writer + 1), tokens[writer].size());
+        for (auto it = tokens[writer].begin(); it != tokens[writer].end(); ++it) {
+            ser.block_read(*it, buf.get(), account.get());
+            for (uint32_t i = 0; i < block_size.value(); ++i) {
+                ASSERT_EQ('a' + writer, buf->cache_data[i]);
+            }
+        }
+    }
+}
+
+TEST(SerializerTest, MergedBlockWrites) {
+    run_in_thread_pool(run_MergedBlockWrites, 4);
+}
+
+void fill_checkpoint_test_block(block_id_t block_id, block_size_t block_size,
+                                ser_buffer_t *buf) {
+    for (uint32_t i = 0; i < block_size.value(); ++i) {
+        buf->cache_data[i] = static_cast<char>(block_id * 7 + i);
+    }
+}
+
+// The LBA tests write data to blocks 0 to `lba_test_num_blocks - 1` once, and then
+// grow the LBA by touching the index entries of the blocks after them, which hold
+// no data.  So the only LBA entries that know where the data blocks are come from
+// before the LBA got checkpointed.
+const block_id_t lba_test_num_blocks = 1024;
+
+// Each shard's checkpoint and live LBA entries are as large as its share of the
+// index.  Touching the block before this makes that share as large as the smallest
+// checkpoint, so the LBA gets checkpointed well before it's big enough to be
+// garbage collected.
+const block_id_t lba_test_end_block_id = LBA_SHARD_FACTOR * LBA_CHECKPOINT_MIN_ENTRIES;
+
+// Adds `entries_per_shard` entries to every shard's LBA in a single index write.
+void grow_lba(standard_serializer_t *ser, int64_t entries_per_shard,
+              file_account_t *account) {
+    std::vector<index_write_op_t> write_ops;
+    for (int64_t i = 0; i < entries_per_shard * LBA_SHARD_FACTOR; ++i) {
+        write_ops.push_back(index_write_op_t(
+            lba_test_num_blocks + i % lba_test_num_blocks));
+    }
+    ser->index_write(write_ops, account);
+}
+
+// Every index write lets the LBA GC and checkpointing start, and waiting for its
+// metablock lets them make progress.
+void touch_lba(standard_serializer_t *ser, file_account_t *account) {
+    std::vector<index_write_op_t> write_ops;
+    write_ops.push_back(index_write_op_t(lba_test_num_blocks));
+    ser->index_write(write_ops, account);
+}
+
+// Writes the data blocks, and touches the index entry before
+// `lba_test_end_block_id`.
+void write_lba_test_blocks(standard_serializer_t *ser, file_account_t *account) {
+    const block_size_t block_size = ser->max_block_size();
+
+    std::vector<scoped_malloc_t<ser_buffer_t> > bufs;
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t i = 0; i < lba_test_num_blocks; ++i) {
+        bufs.push_back(ser->allocate_buffer());
+        fill_checkpoint_test_block(i, block_size, bufs.back().get());
+        infos.push_back(buf_write_info_t(bufs.back().get(), block_size, i));
+    }
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<standard_block_token_t> > tokens
+        = ser->block_writes(infos, account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t i = 0; i < lba_test_num_blocks; ++i) {
+        write_ops.push_back(index_write_op_t(i, tokens[i],
+                                             repli_timestamp_t::distant_past));
+    }
+    write_ops.push_back(index_write_op_t(lba_test_end_block_id - 1));
+    ser->index_write(write_ops, account);
+}
+
+// Writes the data blocks and waits until every shard's LBA has been checkpointed.
+void write_and_checkpoint_lba(standard_serializer_t *ser, perfmon_collection_t *stats) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    write_lba_test_blocks(ser, account.get());
+
+    // More entries than a checkpoint has, but fewer than it takes to garbage
+    // collect the LBA.
+    grow_lba(ser, LBA_CHECKPOINT_MIN_ENTRIES * 3 / 2, account.get());
+    while (get_serializer_stat(stats, "serializer_lba_checkpoints")
+           < LBA_SHARD_FACTOR) {
+        touch_lba(ser, account.get());
+    }
+    ASSERT_EQ(0, get_serializer_stat(stats, "serializer_lba_gcs"));
+}
+
+// Grows the LBA until it's big enough to be garbage collected, and starts the GC.
+void start_lba_gc(standard_serializer_t *ser, file_account_t *account) {
+    grow_lba(ser, LBA_CHECKPOINT_MIN_ENTRIES * 3, account);
+    touch_lba(ser, account);
+}
+
+// Starting up reads the checkpoint, if there is one, and replays the LBA after it.
+// Every data block has to come back.
+void check_lba_test_blocks(mock_file_opener_t *file_opener) {
+    standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                              file_opener, &get_global_perfmon_collection());
+    const block_size_t block_size = ser.max_block_size();
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    scoped_malloc_t<ser_buffer_t> expected = ser.allocate_buffer();
+    scoped_malloc_t<ser_buffer_t> buf = ser.allocate_buffer();
+    ASSERT_EQ(lba_test_end_block_id, ser.max_block_id());
+    for (block_id_t i = 0; i < lba_test_num_blocks; ++i) {
+        counted_t<standard_block_token_t> token = ser.index_read(i);
+        ASSERT_TRUE(token.has());
+        ser.block_read(token, buf.get(), account.get());
+        fill_checkpoint_test_block(i, block_size, expected.get());
+        ASSERT_EQ(0, memcmp(expected->cache_data, buf->cache_data, block_size.value()));
+    }
+}
+
+void run_LbaCheckpointReopen() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    {
+        perfmon_collection_t stats;
+        standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                                  &file_opener, &stats);
+        write_and_checkpoint_lba(&ser, &stats);
+    }
+    check_lba_test_blocks(&file_opener);
+}
+
+TEST(SerializerTest, LbaCheckpointReopen) {
+    run_in_thread_pool(run_LbaCheckpointReopen, 4);
+}
+
+void run_LbaCheckpointThenGcReopen() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    {
+        perfmon_collection_t stats;
+        standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                                  &file_opener, &stats);
+        write_and_checkpoint_lba(&ser, &stats);
+
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        start_lba_gc(&ser, account.get());
+        while (get_serializer_stat(&stats, "serializer_lba_gcs") < LBA_SHARD_FACTOR) {
+            touch_lba(&ser, account.get());
+        }
+    }
+    check_lba_test_blocks(&file_opener);
+}
+
+TEST(SerializerTest, LbaCheckpointThenGcReopen) {
+    run_in_thread_pool(run_LbaCheckpointThenGcReopen, 4);
+}
+
+void run_LbaGcShutdownReopen() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    {
+        perfmon_collection_t stats;
+        standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                                  &file_opener, &stats);
+        write_and_checkpoint_lba(&ser, &stats);
+
+        // Shutting down the serializer interrupts the GC after its first batch of
+        // LBA entries.
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        start_lba_gc(&ser, account.get());
+        ASSERT_GT(lba_test_end_block_id / LBA_SHARD_FACTOR,
+                  static_cast<block_id_t>(LBA_GC_BATCH_SIZE));
+    }
+    check_lba_test_blocks(&file_opener);
+}
+
+TEST(SerializerTest, LbaGcShutdownReopen) {
+    run_in_thread_pool(run_LbaGcShutdownReopen, 4);
+}
+
+// Reads the static header's version into `version_out`, or overwrites it with
+// `new_version` if that's not NULL.
+void access_serializer_version(mock_file_opener_t *file_opener,
+                               const char *new_version, std::string *version_out) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    scoped_malloc_t<static_header_t> header(
+        malloc_aligned(DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE));
+    co_read(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT);
+    if (new_version != NULL) {
+        bzero(header->version, sizeof(header->version));
+        memcpy(header->version, new_version, strlen(new_version) + 1);
+        co_write(file.get(), 0, DEVICE_BLOCK_SIZE, header.get(), DEFAULT_DISK_ACCOUNT,
+                 file_t::NO_DATASYNCS);
+    }
+    if (version_out != NULL) {
+        *version_out = header->version;
+    }
+}
+
+void run_PreviousVersionReopen() {
+    mock_file_opener_t file_opener;
+    standard_serializer_t::create(&file_opener, standard_serializer_t::static_config_t());
+    {
+        standard_serializer_t ser(standard_serializer_t::dynamic_config_t(),
+                                  &file_opener, &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_lba_test_blocks(&ser, account.get());
+    }
+
+    // The previous version's files differ only in that they have no checkpoints
+    // and no compressed blocks, so this is what they look like.
+    access_serializer_version(&file_opener, SERIALIZER_PREVIOUS_VERSION_STRING, NULL);
+    check_lba_test_blocks(&file_opener);
+
+    // Opening the file stamped it with the current version.
+    std::string version;
+    access_serializer_version(&file_opener, NULL, &version);
+    ASSERT_EQ(SERIALIZER_VERSION_STRING, version);
+    check_lba_test_blocks(&file_opener);
+}
+
+TEST(SerializerTest, PreviousVersionReopen) {
+    run_in_thread_pool(run_PreviousVersionReopen, 4);
+}
 
 }  // namespace unittest
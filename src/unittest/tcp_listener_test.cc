@@ -0,0 +1,234 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <set>
+
+#include <boost/bind.hpp>
+
+#include "arch/io/network.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "containers/scoped.hpp"
+#include "protob/protob.hpp"
+#include "rdb_protocol/counted_term.hpp"
+#include "rdb_protocol/pb_server.hpp"
+#include "rdb_protocol/ql2.pb.h"
+#include "rpc/semilattice/view.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static const int TCP_LISTENER_TEST_THREADS = 4;
+
+std::set<ip_address_t> loopback_addresses() {
+    std::set<ip_address_t> addresses;
+    addresses.insert(ip_address_t("127.0.0.1"));
+    return addresses;
+}
+
+// Counts the connections accepted on each thread.
+class accept_counter_t {
+public:
+    accept_counter_t() : counts(get_num_threads()) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i].value = 0;
+        }
+    }
+
+    void on_conn(UNUSED scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn) {
+        __sync_add_and_fetch(&counts[get_thread_id().threadnum].value, 1);
+    }
+
+    int64_t total() {
+        int64_t sum = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            sum += __atomic_load_n(&counts[i].value, __ATOMIC_RELAXED);
+        }
+        return sum;
+    }
+
+    int threads_used() {
+        int used = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (__atomic_load_n(&counts[i].value, __ATOMIC_RELAXED) > 0) {
+                ++used;
+            }
+        }
+        return used;
+    }
+
+    scoped_array_t<cache_line_padded_t<int64_t> > counts;
+};
+
+TPTEST_MULTITHREAD(TcpListener, PerThreadAccept, TCP_LISTENER_TEST_THREADS) {
+    accept_counter_t counter;
+    linux_per_thread_tcp_listener_t listener(
+        loopback_addresses(), ANY_PORT, TCP_LISTENER_TEST_THREADS,
+        boost::bind(&accept_counter_t::on_conn, &counter, _1));
+    ASSERT_NE(ANY_PORT, listener.get_port());
+
+    // With SO_REUSEPORT the kernel hashes each connection to one of the listeners,
+    // so 64 connections all landing on one thread would be a one in 4^63 chance.
+    const int num_conns = 64;
+    cond_t non_interruptor;
+    for (int i = 0; i < num_conns; ++i) {
+        linux_tcp_conn_t conn(ip_address_t("127.0.0.1"), listener.get_port(),
+                              &non_interruptor);
+    }
+    for (int i = 0; i < 100 && counter.total() < num_conns; ++i) {
+        nap(50);
+    }
+    EXPECT_EQ(num_conns, counter.total());
+    if (listener.num_listening_threads() > 1) {
+        EXPECT_EQ(TCP_LISTENER_TEST_THREADS, listener.num_listening_threads());
+        EXPECT_LT(1, counter.threads_used());
+    } else {
+        EXPECT_EQ(1, counter.threads_used());
+    }
+}
+
+TPTEST_MULTITHREAD(TcpListener, PerThreadPortInUse, TCP_LISTENER_TEST_THREADS) {
+    accept_counter_t counter;
+    linux_per_thread_tcp_listener_t first(
+        loopback_addresses(), ANY_PORT, TCP_LISTENER_TEST_THREADS,
+        boost::bind(&accept_counter_t::on_conn, &counter, _1));
+
+    // A second per-thread listener would set SO_REUSEPORT as well, which by itself
+    // would let it share the port.
+    EXPECT_THROW({
+            linux_per_thread_tcp_listener_t second(
+                loopback_addresses(), first.get_port(), TCP_LISTENER_TEST_THREADS,
+                boost::bind(&accept_counter_t::on_conn, &counter, _1));
+        }, address_in_use_exc_t);
+    EXPECT_THROW({
+            linux_tcp_listener_t second(
+                loopback_addresses(), first.get_port(),
+                boost::bind(&accept_counter_t::on_conn, &counter, _1));
+        }, address_in_use_exc_t);
+
+    // And the other way around.
+    linux_tcp_listener_t plain(loopback_addresses(), ANY_PORT,
+                               boost::bind(&accept_counter_t::on_conn, &counter, _1));
+    EXPECT_THROW({
+            linux_per_thread_tcp_listener_t second(
+                loopback_addresses(), plain.get_port(), TCP_LISTENER_TEST_THREADS,
+                boost::bind(&accept_counter_t::on_conn, &counter, _1));
+        }, address_in_use_exc_t);
+}
+
+// Like the real auth metadata views, this one may only be used on its home thread.
+class home_thread_auth_view_t
+    : public semilattice_readwrite_view_t<auth_semilattice_metadata_t> {
+public:
+    auth_semilattice_metadata_t get() {
+        guarantee(get_thread_id() == home_thread());
+        return auth_semilattice_metadata_t();
+    }
+    void join(const auth_semilattice_metadata_t &) {
+        unreachable();
+    }
+    void sync_from(peer_id_t, signal_t *)
+        THROWS_ONLY(interrupted_exc_t, sync_failed_exc_t) {
+        unreachable();
+    }
+    void sync_to(peer_id_t, signal_t *)
+        THROWS_ONLY(interrupted_exc_t, sync_failed_exc_t) {
+        unreachable();
+    }
+    publisher_t<boost::function<void()> > *get_publisher() {
+        unreachable();
+    }
+};
+
+struct driver_test_context_t {
+    driver_test_context_t() : interruptor(NULL) { }
+    static const int32_t no_auth_magic_number = VersionDummy::V0_1;
+    static const int32_t auth_magic_number = VersionDummy::V0_2;
+    signal_t *interruptor;
+};
+
+// Answers every query with an empty atom, counting the threads they're run on.
+class driver_query_counter_t : public accept_counter_t {
+public:
+    bool handle(ql::protob_t<Query> query, Response *response,
+                UNUSED driver_test_context_t *ctx) {
+        __sync_add_and_fetch(&counts[get_thread_id().threadnum].value, 1);
+        response->set_token(query->token());
+        response->set_type(Response::SUCCESS_ATOM);
+        return true;
+    }
+
+    static Response on_unparsable_query(UNUSED ql::protob_t<Query> query,
+                                        UNUSED std::string msg) {
+        Response response;
+        response.set_token(-1);
+        response.set_type(Response::CLIENT_ERROR);
+        return response;
+    }
+};
+
+TPTEST_MULTITHREAD(TcpListener, DriverConnsOnSeveralThreads, TCP_LISTENER_TEST_THREADS) {
+    driver_query_counter_t counter;
+    protob_server_t<ql::protob_t<Query>, Response, driver_test_context_t> server(
+        loopback_addresses(), ANY_PORT,
+        boost::bind(&driver_query_counter_t::handle, &counter, _1, _2, _3),
+        &driver_query_counter_t::on_unparsable_query,
+        boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> >(
+            new home_thread_auth_view_t),
+        CORO_UNORDERED);
+
+    // Every connection gets checked against the auth key, whichever thread it
+    // ends up on.
+    const int num_conns = 16;
+    cond_t non_interruptor;
+    for (int i = 0; i < num_conns; ++i) {
+        linux_tcp_conn_t conn(ip_address_t("127.0.0.1"), server.get_port(),
+                              &non_interruptor);
+        const int32_t magic_number = VersionDummy::V0_1;
+        conn.write(&magic_number, sizeof(magic_number), &non_interruptor);
+
+        Query query;
+        query.set_type(Query::START);
+        query.set_token(i);
+        std::string query_data;
+        ASSERT_TRUE(query.SerializeToString(&query_data));
+        const int32_t query_size = query_data.size();
+        conn.write(&query_size, sizeof(query_size), &non_interruptor);
+        conn.write(query_data.data(), query_data.size(), &non_interruptor);
+
+        int32_t response_size;
+        conn.read(&response_size, sizeof(response_size), &non_interruptor);
+        ASSERT_LE(0, response_size);
+        scoped_array_t<char> response_data(response_size);
+        conn.read(response_data.data(), response_size, &non_interruptor);
+        Response response;
+        ASSERT_TRUE(response.ParseFromArray(response_data.data(), response_size));
+        EXPECT_EQ(i, response.token());
+        EXPECT_EQ(Response::SUCCESS_ATOM, response.type());
+    }
+
+    // The connections get spread across the db threads either way.
+    EXPECT_EQ(num_conns, counter.total());
+    EXPECT_LT(1, counter.threads_used());
+}
+
+TEST(TcpListener, LeastLoadedThread) {
+    scoped_array_t<cache_line_padded_t<int64_t> > conns(4);
+    conns[0].value = 3;
+    conns[1].value = 1;
+    conns[2].value = 2;
+    conns[3].value = 1;
+    // The first of the least loaded threads, unless the preferred one ties.
+    EXPECT_EQ(1, least_loaded_thread(conns.data(), 4, 0));
+    EXPECT_EQ(3, least_loaded_thread(conns.data(), 4, 3));
+    EXPECT_EQ(1, least_loaded_thread(conns.data(), 4, 2));
+    // Only the first `num_threads` count.
+    EXPECT_EQ(1, least_loaded_thread(conns.data(), 3, 3));
+    EXPECT_EQ(0, least_loaded_thread(conns.data(), 1, 2));
+
+    conns[0].value = 0;
+    EXPECT_EQ(0, least_loaded_thread(conns.data(), 4, 3));
+}
+
+}  // namespace unittest
@@ -28,7 +28,7 @@ struct make_sindex_read_t {
                 rdb_protocol_t::sindex_rangespec_t(
                     id,
                     rdb_protocol_t::region_t(rng.to_sindex_keyrange()),
-                    rng),
+                    std::vector<datum_range_t>{rng}),
                 sorting_t::UNORDERED),
             profile_bool_t::PROFILE);
     }
@@ -39,6 +39,26 @@ rdb_protocol_t::read_t make_sindex_read(
     return make_sindex_read_t::make_sindex_read(key, id);
 }
 
+rdb_protocol_t::read_t make_sindex_read(
+        const std::vector<counted_t<const ql::datum_t> > &keys, const std::string &id) {
+    std::vector<datum_range_t> rngs;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        rngs.push_back(datum_range_t(*it));
+    }
+    return rdb_protocol_t::read_t(
+        rdb_protocol_t::rget_read_t(
+            rdb_protocol_t::region_t::universe(),
+            std::map<std::string, ql::wire_func_t>(),
+            ql::batchspec_t::user(ql::batch_type_t::NORMAL,
+                                  counted_t<const ql::datum_t>()),
+            std::vector<rdb_protocol_details::transform_variant_t>(),
+            boost::optional<rdb_protocol_details::terminal_variant_t>(),
+            rdb_protocol_t::sindex_rangespec_t(
+                id, rdb_protocol_t::region_t::universe(), rngs),
+            sorting_t::UNORDERED),
+        profile_bool_t::PROFILE);
+}
+
 serializer_filepath_t manual_serializer_filepath(const std::string &permanent_path,
                                                  const std::string &temporary_path) {
 
@@ -5,6 +5,7 @@
 #include <functional>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "arch/address.hpp"
 #include "containers/scoped.hpp"
@@ -37,6 +38,10 @@ void run_in_thread_pool(const std::function<void()> &fun, int num_workers = 1);
 rdb_protocol_t::read_t make_sindex_read(
     counted_t<const ql::datum_t> key, const std::string &id);
 
+// Reads the rows with any of `keys` in the sindex, all in one read.
+rdb_protocol_t::read_t make_sindex_read(
+    const std::vector<counted_t<const ql::datum_t> > &keys, const std::string &id);
+
 }  // namespace unittest
 
 